@@ -0,0 +1,186 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "betweenness.h"
+#include "compactGraph.h"
+#include "shortestPath.h"
+#include "../parallel/threadPool.h"
+#include "../random/prng.h"
+
+/* Per-worker workspace */
+typedef struct {
+  spSearch* search;
+  double*   dependency;
+  double*   centrality;
+} bcWorker;
+
+/* Shared state for the source loop */
+typedef struct {
+  cgGraph*  graph;
+  double*   weight;
+  size_t*   source;
+  bcWorker* worker;
+  size_t    workers;
+  double*   centrality;
+} bcJob;
+
+/* Search from each source and accumulate dependencies, back to front */
+static void accumulate(size_t from, size_t to, size_t worker, void* context) {
+  bcJob*    job    = (bcJob*)context;
+  cgGraph*  graph  = job->graph;
+  bcWorker* w      = job->worker + worker;
+  spSearch* search = w->search;
+  size_t    i, j, e;
+
+  for (i = from; i < to; i++) {
+    size_t s = job->source[i];
+
+    spRun(search, graph, job->weight, s);
+
+    for (j = search->settled; j--;) {
+      size_t v     = search->order[j];
+      double delta = 0;
+
+      for (e = graph->offset[v]; e < graph->offset[v + 1]; e++) {
+        size_t t = graph->target[e];
+
+        if (spOnPath(search, v, t, job->weight ? job->weight[e] : 1)) {
+          delta += search->paths[v] / search->paths[t] * (1 + w->dependency[t]);
+        }
+      }
+
+      w->dependency[v] = delta;
+      if (v != s) {
+        w->centrality[v] += delta;
+      }
+    }
+
+    /* Only what was reached needs clearing */
+    for (j = 0; j < search->settled; j++) {
+      w->dependency[search->order[j]] = 0;
+    }
+  }
+}
+
+/* Sum the workers' partial centralities */
+static void reduce(size_t from, size_t to, size_t worker, void* context) {
+  bcJob* job = (bcJob*)context;
+  size_t v, i;
+
+  for (v = from; v < to; v++) {
+    double sum = 0;
+
+    for (i = 0; i < job->workers; i++) {
+      sum += job->worker[i].centrality[v];
+    }
+
+    job->centrality[v] = sum;
+  }
+}
+
+static double* run(cgGraph* graph, double* weight, size_t* source, size_t sources, double scale, tpPool* pool) {
+  size_t  n = graph->nodes ? graph->nodes : 1;
+  bcJob   job;
+  size_t  i, v;
+  int     failed;
+
+  job.graph      = graph;
+  job.weight     = weight;
+  job.source     = source;
+  job.workers    = tpWorkers(pool);
+  job.worker     = calloc(job.workers, sizeof(bcWorker));
+  job.centrality = malloc(sizeof(double) * n);
+
+  failed = !job.worker || !job.centrality;
+
+  for (i = 0; !failed && i < job.workers; i++) {
+    bcWorker* w = job.worker + i;
+
+    w->search     = spCreate(graph->nodes);
+    w->dependency = calloc(n, sizeof(double));
+    w->centrality = calloc(n, sizeof(double));
+
+    failed = !w->search || !w->dependency || !w->centrality;
+  }
+
+  if (!failed) {
+    /* Each source is a whole search, so hand them out one at a time */
+    tpFor(pool, sources, 1, &accumulate, &job);
+    tpFor(pool, graph->nodes, 0, &reduce, &job);
+
+    for (v = 0; v < graph->nodes; v++) {
+      job.centrality[v] *= scale;
+    }
+  }
+
+  for (i = 0; job.worker && i < job.workers; i++) {
+    spNuke(job.worker[i].search);
+    free(job.worker[i].dependency);
+    free(job.worker[i].centrality);
+  }
+  free(job.worker);
+
+  if (failed) {
+    /* Memory allocation failure :P */
+    free(job.centrality);
+    return NULL;
+  }
+
+  return job.centrality;
+}
+
+double* bcBrandes(cgGraph* graph, double* weight, tpPool* pool) {
+  size_t* source = malloc(sizeof(size_t) * (graph->nodes ? graph->nodes : 1));
+  double* centrality;
+  size_t  v;
+
+  if (!source) { return NULL; }
+
+  for (v = 0; v < graph->nodes; v++) {
+    source[v] = v;
+  }
+
+  centrality = run(graph, weight, source, graph->nodes, 1, pool);
+
+  free(source);
+  return centrality;
+}
+
+double* bcSample(cgGraph* graph, double* weight, size_t samples, uint64_t seed, tpPool* pool) {
+  size_t*  source = malloc(sizeof(size_t) * (graph->nodes ? graph->nodes : 1));
+  rngState rng    = rngSeed(seed);
+  double*  centrality;
+  size_t   v;
+
+  if (!source) { return NULL; }
+
+  if (samples > graph->nodes) {
+    samples = graph->nodes;
+  }
+
+  for (v = 0; v < graph->nodes; v++) {
+    source[v] = v;
+  }
+
+  /* Partial Fisher-Yates: the first few entries are a uniform sample */
+  for (v = 0; v < samples; v++) {
+    size_t j   = v + rngBelow(&rng, graph->nodes - v);
+    size_t tmp = source[v];
+    source[v]  = source[j];
+    source[j]  = tmp;
+  }
+
+  centrality = run(graph, weight, source, samples, samples ? (double)graph->nodes / samples : 0, pool);
+
+  free(source);
+  return centrality;
+}
+
+size_t bcSamples(size_t nodes, double epsilon, double delta) {
+  if (!nodes || epsilon <= 0 || delta <= 0) {
+    return nodes;
+  }
+
+  return (size_t)ceil(log(2.0 * nodes / delta) / (2 * epsilon * epsilon));
+}
@@ -0,0 +1,85 @@
+/**
+  @file       betweenness.h
+  @brief      Betweenness centrality header file
+  @author     Christopher Harrison (Xophmeister)
+  @copyright  @ref license
+
+  Implements betweenness centrality over compact graphs using Brandes'
+  algorithm: a shortest path search from each source, followed by a
+  sweep back through the settled nodes accumulating each node's
+  dependency on the source. Sources are processed in parallel, each
+  worker keeping its own search workspace, dependency array and partial
+  sums, which are only combined at the end.
+
+  Betweenness is measured over directed paths and is not normalised;
+  divide by `(n - 1)(n - 2)` to normalise it.
+*/
+
+#ifndef BETWEENNESS_H
+#define BETWEENNESS_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include "compactGraph.h"
+#include "../parallel/threadPool.h"
+
+/**
+  @fn         double* bcBrandes(cgGraph* graph, double* weight, tpPool* pool)
+  @brief      Exact betweenness centrality
+  @param      graph   The compact graph
+  @param      weight  Array of positive edge weights, aligned with the
+                      compact graph's edges; or `NULL` for unweighted
+                      (hop count) shortest paths
+  @param      pool    Thread pool to run on; or `NULL` to run serially
+  @return     Array of betweenness centralities, by node identifier; or
+              `NULL` in the event of an allocation failure
+
+  Compute the betweenness of every node, with one search from every
+  source. This is `O(VE)` for unweighted graphs and
+  `O(VE + V^2 log V)` for weighted ones.
+
+  @note       The returned array must be freed by the caller
+*/
+extern double* bcBrandes(cgGraph*, double*, tpPool*);
+
+/**
+  @fn         double* bcSample(cgGraph* graph, double* weight, size_t samples, uint64_t seed, tpPool* pool)
+  @brief      Approximate betweenness centrality by sampling sources
+  @param      graph    The compact graph
+  @param      weight   Array of positive edge weights, aligned with the
+                       compact graph's edges; or `NULL` for unweighted
+                       shortest paths
+  @param      samples  Number of sources to sample
+  @param      seed     Seed for choosing the sources
+  @param      pool     Thread pool to run on; or `NULL` to run serially
+  @return     Array of estimated betweenness centralities, by node
+              identifier; or `NULL` in the event of an allocation
+              failure
+
+  Estimate betweenness from a uniform sample of distinct sources,
+  scaling the accumulated dependencies by `n / samples` so that the
+  estimate is unbiased. Use bcSamples() to choose a sample size that
+  meets a given error bound. The result is deterministic for a given
+  seed.
+
+  @note       If there are no more nodes than samples, this is exact
+  @note       The returned array must be freed by the caller
+*/
+extern double* bcSample(cgGraph*, double*, size_t, uint64_t, tpPool*);
+
+/**
+  @fn         size_t bcSamples(size_t nodes, double epsilon, double delta)
+  @brief      Number of samples sufficient for a given error bound
+  @param      nodes    Number of nodes in the graph
+  @param      epsilon  Permitted absolute error in normalised betweenness
+  @param      delta    Permitted probability of exceeding that error
+  @return     Number of sources to sample
+
+  By Hoeffding's inequality, and a union bound over the nodes, sampling
+  `ln(2n / delta) / (2 epsilon^2)` sources ensures that, with probability
+  at least `1 - delta`, every node's estimated betweenness normalised by
+  `n(n - 1)` is within `epsilon` of the true value.
+*/
+extern size_t bcSamples(size_t, double, double);
+
+#endif
@@ -0,0 +1,304 @@
+#include <stdlib.h>
+#include <stdatomic.h>
+
+#include "colouring.h"
+#include "compactGraph.h"
+#include "kCore.h"
+#include "../parallel/threadPool.h"
+
+/* Largest degree of a (symmetric) compact graph */
+static size_t largestDegree(cgGraph* graph) {
+  size_t most = 0, u;
+
+  for (u = 0; u < graph->nodes; u++) {
+    if (graph->offset[u + 1] - graph->offset[u] > most) {
+      most = graph->offset[u + 1] - graph->offset[u];
+    }
+  }
+
+  return most;
+}
+
+/* Fill vert with the nodes of the symmetric graph in colouring order */
+static int ordering(cgGraph* sym, gcOrder order, size_t* vert) {
+  size_t n = sym->nodes;
+  size_t u, i;
+
+  if (order == gcSmallestLast) {
+    size_t* core = kcCores(sym, kcUndirected, vert);
+
+    if (!core) { return 1; }
+    free(core);
+
+    /* Colour in the reverse of the peeling order */
+    for (i = 0; i < n / 2; i++) {
+      u               = vert[i];
+      vert[i]         = vert[n - 1 - i];
+      vert[n - 1 - i] = u;
+    }
+  } else if (order == gcLargestFirst) {
+    size_t  most = largestDegree(sym);
+    size_t* bin  = calloc(most + 2, sizeof(size_t));
+
+    if (!bin) { return 1; }
+
+    /* Stable bucket sort by decreasing degree */
+    for (u = 0; u < n; u++) {
+      ++bin[most - (sym->offset[u + 1] - sym->offset[u]) + 1];
+    }
+    for (i = 0; i <= most; i++) {
+      bin[i + 1] += bin[i];
+    }
+    for (u = 0; u < n; u++) {
+      vert[bin[most - (sym->offset[u + 1] - sym->offset[u])]++] = u;
+    }
+
+    free(bin);
+  } else {
+    for (u = 0; u < n; u++) {
+      vert[u] = u;
+    }
+  }
+
+  return 0;
+}
+
+/* Group a colouring into classes, taking ownership of the colours */
+static gcColouring* classes(size_t nodes, size_t* colour) {
+  gcColouring* newColouring = malloc(sizeof(gcColouring));
+  size_t       colours = 0;
+  size_t       u, c;
+
+  for (u = 0; u < nodes; u++) {
+    if (colour[u] + 1 > colours) { colours = colour[u] + 1; }
+  }
+
+  if (newColouring) {
+    newColouring->nodes   = nodes;
+    newColouring->colours = colours;
+    newColouring->colour  = colour;
+    newColouring->offset  = calloc(colours + 1, sizeof(size_t));
+    newColouring->member  = malloc(sizeof(size_t) * (nodes ? nodes : 1));
+
+    if (newColouring->offset && newColouring->member) {
+      for (u = 0; u < nodes; u++) {
+        ++newColouring->offset[colour[u] + 1];
+      }
+      for (c = 0; c < colours; c++) {
+        newColouring->offset[c + 1] += newColouring->offset[c];
+      }
+      for (u = 0; u < nodes; u++) {
+        newColouring->member[newColouring->offset[colour[u]]++] = u;
+      }
+
+      /* Counting moved each offset on to the next class; move them back */
+      for (c = colours; c; c--) {
+        newColouring->offset[c] = newColouring->offset[c - 1];
+      }
+      newColouring->offset[0] = 0;
+
+      return newColouring;
+    }
+
+    /* Memory allocation failure :P */
+    gcNuke(newColouring);
+    return NULL;
+  }
+
+  free(colour);
+  return NULL;
+}
+
+gcColouring* gcGreedy(cgGraph* graph, gcOrder order) {
+  cgGraph* sym    = cgSymmetrise(graph);
+  size_t   n      = graph->nodes ? graph->nodes : 1;
+  size_t*  colour = malloc(sizeof(size_t) * n);
+  size_t*  vert   = malloc(sizeof(size_t) * n);
+  size_t*  mark   = NULL;
+  size_t   most   = 0;
+  size_t   i, c, e;
+
+  if (sym) {
+    most = largestDegree(sym);
+    mark = malloc(sizeof(size_t) * (most + 1));
+  }
+
+  if (!sym || !colour || !vert || !mark || ordering(sym, order, vert)) {
+    /* Memory allocation failure :P */
+    cgNuke(sym);
+    free(colour);
+    free(vert);
+    free(mark);
+    return NULL;
+  }
+
+  for (i = 0; i < graph->nodes; i++) {
+    colour[i] = cgNone;
+  }
+  for (c = 0; c <= most; c++) {
+    mark[c] = cgNone;
+  }
+
+  for (i = 0; i < graph->nodes; i++) {
+    size_t u   = vert[i];
+    size_t deg = sym->offset[u + 1] - sym->offset[u];
+
+    /* Only colours up to the degree can be taken by neighbours */
+    for (e = sym->offset[u]; e < sym->offset[u + 1]; e++) {
+      c = colour[sym->target[e]];
+      if (c <= deg) { mark[c] = u; }
+    }
+
+    for (c = 0; mark[c] == u; c++);
+    colour[u] = c;
+  }
+
+  cgNuke(sym);
+  free(vert);
+  free(mark);
+
+  return classes(graph->nodes, colour);
+}
+
+/* Shared state for speculative colouring */
+typedef struct {
+  cgGraph*       sym;
+  atomic_size_t* colour;
+  size_t*        queue;
+  char*          conflict;
+  size_t**       mark;
+  size_t*        stamp;
+} gcJob;
+
+/* Tentatively colour a stretch of the queue */
+static void tentative(size_t from, size_t to, size_t worker, void* context) {
+  gcJob*   job   = (gcJob*)context;
+  cgGraph* sym   = job->sym;
+  size_t*  mark  = job->mark[worker];
+  size_t   stamp = job->stamp[worker];
+  size_t   i, c, e;
+
+  for (i = from; i < to; i++) {
+    size_t u   = job->queue[i];
+    size_t deg = sym->offset[u + 1] - sym->offset[u];
+
+    /* Stamps, rather than node identifiers, as nodes can be recoloured */
+    ++stamp;
+    for (e = sym->offset[u]; e < sym->offset[u + 1]; e++) {
+      c = atomic_load_explicit(job->colour + sym->target[e], memory_order_relaxed);
+      if (c <= deg) { mark[c] = stamp; }
+    }
+
+    for (c = 0; mark[c] == stamp; c++);
+    atomic_store_explicit(job->colour + u, c, memory_order_relaxed);
+  }
+
+  job->stamp[worker] = stamp;
+}
+
+/* Flag queued nodes that share a colour with a smaller neighbour */
+static void detect(size_t from, size_t to, size_t worker, void* context) {
+  gcJob*   job = (gcJob*)context;
+  cgGraph* sym = job->sym;
+  size_t   i, e;
+
+  for (i = from; i < to; i++) {
+    size_t u = job->queue[i];
+    size_t c = atomic_load_explicit(job->colour + u, memory_order_relaxed);
+
+    job->conflict[i] = 0;
+    for (e = sym->offset[u]; e < sym->offset[u + 1]; e++) {
+      size_t w = sym->target[e];
+
+      if (w < u && atomic_load_explicit(job->colour + w, memory_order_relaxed) == c) {
+        job->conflict[i] = 1;
+        break;
+      }
+    }
+  }
+}
+
+gcColouring* gcSpeculative(cgGraph* graph, gcOrder order, tpPool* pool) {
+  size_t  n       = graph->nodes ? graph->nodes : 1;
+  size_t  workers = tpWorkers(pool);
+  size_t* colour  = malloc(sizeof(size_t) * n);
+  size_t  pending = graph->nodes;
+  size_t  most    = 0;
+  gcJob   job;
+  size_t  i, c;
+  int     failed;
+
+  job.sym      = cgSymmetrise(graph);
+  job.colour   = malloc(sizeof(atomic_size_t) * n);
+  job.queue    = malloc(sizeof(size_t) * n);
+  job.conflict = malloc(n);
+  job.mark     = calloc(workers, sizeof(size_t*));
+  job.stamp    = calloc(workers, sizeof(size_t));
+
+  failed = !colour || !job.sym || !job.colour || !job.queue || !job.conflict || !job.mark || !job.stamp;
+
+  if (!failed) {
+    most = largestDegree(job.sym);
+
+    for (i = 0; !failed && i < workers; i++) {
+      job.mark[i] = calloc(most + 1, sizeof(size_t));
+      failed = !job.mark[i];
+    }
+  }
+
+  if (!failed) {
+    failed = ordering(job.sym, order, job.queue);
+  }
+
+  if (!failed) {
+    for (i = 0; i < graph->nodes; i++) {
+      atomic_init(job.colour + i, cgNone);
+    }
+
+    while (pending) {
+      size_t kept = 0;
+
+      tpFor(pool, pending, 0, &tentative, &job);
+      tpFor(pool, pending, 0, &detect, &job);
+
+      /* Requeue the conflicts, keeping their order */
+      for (i = 0; i < pending; i++) {
+        if (job.conflict[i]) {
+          job.queue[kept++] = job.queue[i];
+        }
+      }
+      pending = kept;
+    }
+
+    for (i = 0; i < graph->nodes; i++) {
+      colour[i] = atomic_load(job.colour + i);
+    }
+  }
+
+  for (c = 0; job.mark && c < workers; c++) {
+    free(job.mark[c]);
+  }
+  cgNuke(job.sym);
+  free(job.colour);
+  free(job.queue);
+  free(job.conflict);
+  free(job.mark);
+  free(job.stamp);
+
+  if (failed) {
+    /* Memory allocation failure :P */
+    free(colour);
+    return NULL;
+  }
+
+  return classes(graph->nodes, colour);
+}
+
+void gcNuke(gcColouring* colouring) {
+  if (colouring) {
+    free(colouring->colour);
+    free(colouring->offset);
+    free(colouring->member);
+    free(colouring);
+  }
+}
@@ -0,0 +1,110 @@
+/**
+  @file       colouring.h
+  @brief      Graph colouring header file
+  @author     Christopher Harrison (Xophmeister)
+  @copyright  @ref license
+
+  Implements vertex colouring of compact graphs, such that no two
+  neighbours share a colour. Link direction is ignored and self loops
+  are disregarded.
+
+  The result is grouped into colour classes, each of which is a set of
+  mutually non-adjacent nodes; so, for example, updates that must not
+  run concurrently with those of any neighbour can be scheduled as one
+  parallel loop per class (e.g., with tpFor()).
+*/
+
+#ifndef COLOURING_H
+#define COLOURING_H
+
+#include <stdlib.h>
+#include "compactGraph.h"
+#include "../parallel/threadPool.h"
+
+/**
+  @enum       gcOrder
+  @brief      Order in which nodes are greedily coloured
+  @var        gcOrder::gcNatural
+              By node identifier
+  @var        gcOrder::gcLargestFirst
+              By decreasing degree (Welsh and Powell)
+  @var        gcOrder::gcSmallestLast
+              By reverse degeneracy ordering (Matula and Beck), which
+              uses at most one more colour than the graph's degeneracy
+*/
+typedef enum {
+  gcNatural,
+  gcLargestFirst,
+  gcSmallestLast
+} gcOrder;
+
+/**
+  @struct     gcColouring
+  @brief      Colouring of a compact graph, grouped into colour classes
+  @var        gcColouring::nodes
+              Number of nodes
+  @var        gcColouring::colours
+              Number of colours used
+  @var        gcColouring::colour
+              Array of colours, by node identifier
+  @var        gcColouring::offset
+              Array of `colours + 1` offsets into the member array, such
+              that the nodes of colour `c` are `member[offset[c]]` up to,
+              but excluding, `member[offset[c + 1]]`
+  @var        gcColouring::member
+              Array of node identifiers, grouped by colour and ascending
+              within each colour
+*/
+typedef struct {
+  size_t  nodes;
+  size_t  colours;
+  size_t* colour;
+  size_t* offset;
+  size_t* member;
+} gcColouring;
+
+/**
+  @fn         gcColouring* gcGreedy(cgGraph* graph, gcOrder order)
+  @brief      Greedily colour a compact graph
+  @param      graph  The compact graph
+  @param      order  Order in which to colour the nodes
+  @return     Pointer to the colouring; or `NULL` in the event of an
+              allocation failure
+
+  Colour each node in turn, in the given order, with the smallest colour
+  not used by any of its neighbours. This is `O(V + E)` and never uses
+  more than one more colour than the graph's largest degree.
+*/
+extern gcColouring* gcGreedy(cgGraph*, gcOrder);
+
+/**
+  @fn         gcColouring* gcSpeculative(cgGraph* graph, gcOrder order, tpPool* pool)
+  @brief      Colour a compact graph in parallel
+  @param      graph  The compact graph
+  @param      order  Order in which to colour the nodes
+  @param      pool   Thread pool to run on; or `NULL` to run serially
+  @return     Pointer to the colouring; or `NULL` in the event of an
+              allocation failure
+
+  Colour the graph speculatively (Gebremedhin and Manne): every
+  uncoloured node is greedily coloured in parallel, seeing whatever
+  colours its neighbours have at the time; then, also in parallel, any
+  neighbours that ended up with the same colour are found, and the one
+  with the larger identifier is queued to be coloured again. This repeats
+  until there are no conflicts; as the smallest queued node is never
+  requeued, it always terminates, and conflicts are typically rare enough
+  that only a few rounds are needed.
+
+  Run serially, this is exactly gcGreedy(), but the colouring otherwise
+  depends on timing and so may differ from run to run.
+*/
+extern gcColouring* gcSpeculative(cgGraph*, gcOrder, tpPool*);
+
+/**
+  @fn         void gcNuke(gcColouring* colouring)
+  @brief      Free a colouring
+  @param      colouring  The colouring
+*/
+extern void gcNuke(gcColouring*);
+
+#endif
@@ -0,0 +1,556 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "community.h"
+#include "compactGraph.h"
+#include "../parallel/threadPool.h"
+
+/* Symmetric, weighted working graph; self loops carry twice their
+   weight, so that a node's degree is always the sum of its row */
+typedef struct {
+  size_t  nodes;
+  size_t* offset;
+  size_t* target;
+  double* weight;
+  double* degree;
+  double  total;
+} cmGraph;
+
+/* Per-worker scratch space for accumulating weights by community */
+typedef struct {
+  size_t* mark;
+  size_t* touched;
+  double* sum;
+} cmScratch;
+
+static void cmNuke(cmGraph* graph) {
+  if (graph) {
+    free(graph->offset);
+    free(graph->target);
+    free(graph->weight);
+    free(graph->degree);
+    free(graph);
+  }
+}
+
+static cmGraph* cmCreate(size_t nodes, size_t entries) {
+  cmGraph* newGraph = malloc(sizeof(cmGraph));
+
+  if (newGraph) {
+    newGraph->nodes  = nodes;
+    newGraph->total  = 0;
+    newGraph->offset = calloc(nodes + 1, sizeof(size_t));
+    newGraph->target = malloc(sizeof(size_t) * (entries ? entries : 1));
+    newGraph->weight = malloc(sizeof(double) * (entries ? entries : 1));
+    newGraph->degree = calloc(nodes ? nodes : 1, sizeof(double));
+
+    if (!newGraph->offset || !newGraph->target || !newGraph->weight || !newGraph->degree) {
+      /* Memory allocation failure :P */
+      cmNuke(newGraph);
+      newGraph = NULL;
+    }
+  }
+
+  return newGraph;
+}
+
+/* Coarsening job: merge the rows of each community's members */
+typedef struct {
+  cmGraph*   fine;
+  cmGraph*   coarse;
+  size_t*    map;
+  size_t*    memberOffset;
+  size_t*    member;
+  size_t*    length;
+  cmScratch* scratch;
+} cmCollapse;
+
+static void collapseRows(size_t from, size_t to, size_t worker, void* context) {
+  cmCollapse* job    = (cmCollapse*)context;
+  cmGraph*    fine   = job->fine;
+  cmGraph*    coarse = job->coarse;
+  size_t*     mark   = job->scratch[worker].mark;
+  size_t      c;
+
+  for (c = from; c < to; c++) {
+    size_t start = coarse->offset[c];
+    size_t write = start;
+    size_t m, e;
+
+    for (m = job->memberOffset[c]; m < job->memberOffset[c + 1]; m++) {
+      size_t u = job->member[m];
+
+      for (e = fine->offset[u]; e < fine->offset[u + 1]; e++) {
+        size_t d = job->map[fine->target[e]];
+
+        if (mark[d] == cgNone) {
+          mark[d] = write;
+          coarse->target[write] = d;
+          coarse->weight[write] = fine->weight[e];
+          ++write;
+        } else {
+          coarse->weight[mark[d]] += fine->weight[e];
+        }
+      }
+    }
+
+    for (e = start; e < write; e++) {
+      mark[coarse->target[e]] = cgNone;
+    }
+
+    job->length[c] = write - start;
+  }
+}
+
+/* Build the graph of communities, given a dense mapping of nodes */
+static cmGraph* collapse(cmGraph* fine, size_t* map, size_t nodes, cmScratch* scratch, tpPool* pool) {
+  cmGraph*   coarse = cmCreate(nodes, fine->offset[fine->nodes]);
+  cmCollapse job;
+  size_t     u, c, write;
+
+  if (!coarse) { return NULL; }
+
+  job.fine         = fine;
+  job.coarse       = coarse;
+  job.map          = map;
+  job.scratch      = scratch;
+  job.memberOffset = calloc(nodes + 1, sizeof(size_t));
+  job.member       = malloc(sizeof(size_t) * (fine->nodes ? fine->nodes : 1));
+  job.length       = malloc(sizeof(size_t) * (nodes ? nodes : 1));
+
+  if (!job.memberOffset || !job.member || !job.length) {
+    free(job.memberOffset);
+    free(job.member);
+    free(job.length);
+    cmNuke(coarse);
+    return NULL;
+  }
+
+  /* Bucket members by community; each community's rows are bounded by
+     the sum of its members' rows */
+  for (u = 0; u < fine->nodes; u++) {
+    ++job.memberOffset[map[u] + 1];
+    coarse->offset[map[u] + 1] += fine->offset[u + 1] - fine->offset[u];
+    coarse->degree[map[u]] += fine->degree[u];
+  }
+
+  for (c = 0; c < nodes; c++) {
+    job.memberOffset[c + 1] += job.memberOffset[c];
+    coarse->offset[c + 1]   += coarse->offset[c];
+  }
+
+  for (u = 0; u < fine->nodes; u++) {
+    job.member[job.memberOffset[map[u]]++] = u;
+  }
+
+  for (c = nodes; c; c--) {
+    job.memberOffset[c] = job.memberOffset[c - 1];
+  }
+  job.memberOffset[0] = 0;
+
+  tpFor(pool, nodes, 0, &collapseRows, &job);
+
+  /* Squeeze out the slack between rows */
+  for (c = 0, write = 0; c < nodes; c++) {
+    size_t start = coarse->offset[c];
+
+    memmove(coarse->target + write, coarse->target + start, sizeof(size_t) * job.length[c]);
+    memmove(coarse->weight + write, coarse->weight + start, sizeof(double) * job.length[c]);
+
+    coarse->offset[c] = write;
+    write += job.length[c];
+  }
+  coarse->offset[nodes] = write;
+  coarse->total         = fine->total;
+
+  free(job.memberOffset);
+  free(job.member);
+  free(job.length);
+
+  return coarse;
+}
+
+/* Symmetric working graph, with duplicate pairs merged */
+static cmGraph* symmetrise(cgGraph* graph, double* weight, cmScratch* scratch, tpPool* pool) {
+  cmGraph* raw = cmCreate(graph->nodes, graph->edges * 2);
+  cmGraph* merged;
+  size_t*  identity;
+  size_t   u, e;
+
+  if (!raw) { return NULL; }
+
+  for (u = 0; u < graph->nodes; u++) {
+    for (e = graph->offset[u]; e < graph->offset[u + 1]; e++) {
+      ++raw->offset[u + 1];
+      if (graph->target[e] != u) {
+        ++raw->offset[graph->target[e] + 1];
+      }
+    }
+  }
+
+  for (u = 0; u < graph->nodes; u++) {
+    raw->offset[u + 1] += raw->offset[u];
+  }
+
+  for (u = 0; u < graph->nodes; u++) {
+    for (e = graph->offset[u]; e < graph->offset[u + 1]; e++) {
+      size_t v = graph->target[e];
+      double w = weight ? weight[e] : 1.0;
+
+      if (v == u) {
+        raw->target[raw->offset[u]]   = u;
+        raw->weight[raw->offset[u]++] = 2 * w;
+      } else {
+        raw->target[raw->offset[u]]   = v;
+        raw->weight[raw->offset[u]++] = w;
+        raw->target[raw->offset[v]]   = u;
+        raw->weight[raw->offset[v]++] = w;
+      }
+
+      raw->degree[u] += w;
+      raw->degree[v] += w;
+      raw->total     += 2 * w;
+    }
+  }
+
+  for (u = graph->nodes; u; u--) {
+    raw->offset[u] = raw->offset[u - 1];
+  }
+  raw->offset[0] = 0;
+
+  identity = malloc(sizeof(size_t) * (graph->nodes ? graph->nodes : 1));
+  if (!identity) { cmNuke(raw); return NULL; }
+
+  for (u = 0; u < graph->nodes; u++) {
+    identity[u] = u;
+  }
+
+  merged = collapse(raw, identity, graph->nodes, scratch, pool);
+
+  free(identity);
+  cmNuke(raw);
+  return merged;
+}
+
+/* Local moving job: choose each node's best community from a snapshot */
+typedef struct {
+  cmGraph*   graph;
+  size_t*    community;
+  size_t*    next;
+  size_t*    size;
+  double*    total;
+  double     resolution;
+  cmScratch* scratch;
+} cmMove;
+
+static void chooseMoves(size_t from, size_t to, size_t worker, void* context) {
+  cmMove*  job     = (cmMove*)context;
+  cmGraph* graph   = job->graph;
+  size_t*  mark    = job->scratch[worker].mark;
+  size_t*  touched = job->scratch[worker].touched;
+  double*  sum     = job->scratch[worker].sum;
+  size_t   v;
+
+  for (v = from; v < to; v++) {
+    size_t own   = job->community[v];
+    size_t best  = own;
+    double scale = job->resolution * graph->degree[v] / graph->total;
+    double bestGain;
+    size_t n = 0;
+    size_t e, i;
+
+    for (e = graph->offset[v]; e < graph->offset[v + 1]; e++) {
+      size_t c = job->community[graph->target[e]];
+
+      if (graph->target[e] == v) { continue; }
+
+      if (mark[c] == cgNone) {
+        mark[c]    = n;
+        touched[n] = c;
+        sum[n++]   = 0;
+      }
+      sum[mark[c]] += graph->weight[e];
+    }
+
+    /* Gain of staying put, with v taken out of its own community */
+    bestGain = (mark[own] == cgNone ? 0 : sum[mark[own]]) - scale * (job->total[own] - graph->degree[v]);
+
+    for (i = 0; i < n; i++) {
+      size_t c = touched[i];
+
+      if (c != own) {
+        double gain = sum[i] - scale * job->total[c];
+
+        if (gain > bestGain || (gain == bestGain && best != own && c < best)) {
+          bestGain = gain;
+          best     = c;
+        }
+      }
+
+      mark[c] = cgNone;
+    }
+
+    /* Stop a pair of singletons from swapping places indefinitely */
+    if (best != own && job->size[own] == 1 && job->size[best] == 1 && best > own) {
+      best = own;
+    }
+
+    job->next[v] = best;
+  }
+}
+
+/* Modularity of the working graph under the given assignment */
+static double quality(cmGraph* graph, size_t* community, double* total, double resolution) {
+  double internal = 0;
+  double squares  = 0;
+  size_t v, e;
+
+  for (v = 0; v < graph->nodes; v++) {
+    for (e = graph->offset[v]; e < graph->offset[v + 1]; e++) {
+      if (community[graph->target[e]] == community[v]) {
+        internal += graph->weight[e];
+      }
+    }
+    squares += total[v] * total[v];
+  }
+
+  return internal / graph->total - resolution * squares / (graph->total * graph->total);
+}
+
+/* Recompute community totals and sizes from an assignment */
+static void tally(cmGraph* graph, size_t* community, double* total, size_t* size) {
+  size_t v;
+
+  for (v = 0; v < graph->nodes; v++) {
+    total[v] = 0;
+    size[v]  = 0;
+  }
+
+  for (v = 0; v < graph->nodes; v++) {
+    total[community[v]] += graph->degree[v];
+    ++size[community[v]];
+  }
+}
+
+/* Repeatedly sweep the nodes, moving them while modularity improves */
+static void moveNodes(cmMove* job, size_t* previous, tpPool* pool) {
+  cmGraph* graph = job->graph;
+  double   q;
+  size_t   sweep, v;
+
+  for (v = 0; v < graph->nodes; v++) {
+    job->community[v] = v;
+  }
+
+  if (graph->total <= 0) { return; }
+
+  tally(graph, job->community, job->total, job->size);
+  q = quality(graph, job->community, job->total, job->resolution);
+
+  for (sweep = 0; sweep < 64; sweep++) {
+    size_t moved = 0;
+    double r;
+
+    tpFor(pool, graph->nodes, 0, &chooseMoves, job);
+
+    memcpy(previous, job->community, sizeof(size_t) * graph->nodes);
+
+    for (v = 0; v < graph->nodes; v++) {
+      size_t own  = job->community[v];
+      size_t best = job->next[v];
+
+      if (best != own) {
+        job->total[own]  -= graph->degree[v];
+        job->total[best] += graph->degree[v];
+        --job->size[own];
+        ++job->size[best];
+        job->community[v] = best;
+        ++moved;
+      }
+    }
+
+    if (!moved) { break; }
+
+    r = quality(graph, job->community, job->total, job->resolution);
+
+    if (r <= q + 1e-12) {
+      /* Simultaneous moves can interfere; undo a sweep that didn't help */
+      memcpy(job->community, previous, sizeof(size_t) * graph->nodes);
+      tally(graph, job->community, job->total, job->size);
+      break;
+    }
+
+    q = r;
+  }
+}
+
+/* Split communities into connected components, labelling them densely */
+static size_t split(cmGraph* graph, size_t* community, size_t* label, size_t* queue) {
+  size_t components = 0;
+  size_t v;
+
+  for (v = 0; v < graph->nodes; v++) {
+    label[v] = cgNone;
+  }
+
+  for (v = 0; v < graph->nodes; v++) {
+    size_t head = 0, tail = 0;
+
+    if (label[v] != cgNone) { continue; }
+
+    label[v]      = components;
+    queue[tail++] = v;
+
+    while (head < tail) {
+      size_t u = queue[head++];
+      size_t e;
+
+      for (e = graph->offset[u]; e < graph->offset[u + 1]; e++) {
+        size_t t = graph->target[e];
+
+        if (label[t] == cgNone && community[t] == community[v]) {
+          label[t]      = components;
+          queue[tail++] = t;
+        }
+      }
+    }
+
+    ++components;
+  }
+
+  return components;
+}
+
+size_t* cmLouvain(cgGraph* graph, double* weight, double resolution, tpPool* pool, size_t* communities) {
+  size_t     workers = tpWorkers(pool);
+  size_t     n       = graph->nodes ? graph->nodes : 1;
+  size_t*    assignment = malloc(sizeof(size_t) * n);
+  size_t*    label      = malloc(sizeof(size_t) * n);
+  size_t*    previous   = malloc(sizeof(size_t) * n);
+  cmScratch* scratch    = calloc(workers, sizeof(cmScratch));
+  cmGraph*   working    = NULL;
+  cmMove     job;
+  size_t     count = graph->nodes;
+  size_t     i, v;
+  int        failed = 0;
+
+  job.community = malloc(sizeof(size_t) * n);
+  job.next      = malloc(sizeof(size_t) * n);
+  job.size      = malloc(sizeof(size_t) * n);
+  job.total     = malloc(sizeof(double) * n);
+  job.resolution = resolution;
+  job.scratch    = scratch;
+
+  failed = !assignment || !label || !previous || !scratch || !job.community || !job.next || !job.size || !job.total;
+
+  for (i = 0; !failed && i < workers; i++) {
+    scratch[i].mark    = malloc(sizeof(size_t) * n);
+    scratch[i].touched = malloc(sizeof(size_t) * n);
+    scratch[i].sum     = malloc(sizeof(double) * n);
+
+    if (scratch[i].mark && scratch[i].touched && scratch[i].sum) {
+      for (v = 0; v < n; v++) {
+        scratch[i].mark[v] = cgNone;
+      }
+    } else {
+      failed = 1;
+    }
+  }
+
+  if (!failed) {
+    working = symmetrise(graph, weight, scratch, pool);
+    failed  = !working;
+  }
+
+  for (v = 0; !failed && v < graph->nodes; v++) {
+    assignment[v] = v;
+  }
+
+  while (!failed) {
+    cmGraph* coarse;
+
+    job.graph = working;
+    moveNodes(&job, previous, pool);
+
+    count = split(working, job.community, label, previous);
+
+    for (v = 0; v < graph->nodes; v++) {
+      assignment[v] = label[assignment[v]];
+    }
+
+    if (count == working->nodes) { break; }
+
+    coarse = collapse(working, label, count, scratch, pool);
+    cmNuke(working);
+    working = coarse;
+    failed  = !working;
+  }
+
+  for (i = 0; scratch && i < workers; i++) {
+    free(scratch[i].mark);
+    free(scratch[i].touched);
+    free(scratch[i].sum);
+  }
+
+  cmNuke(working);
+  free(scratch);
+  free(label);
+  free(previous);
+  free(job.community);
+  free(job.next);
+  free(job.size);
+  free(job.total);
+
+  if (failed) {
+    /* Memory allocation failure :P */
+    free(assignment);
+    return NULL;
+  }
+
+  if (communities) {
+    *communities = count;
+  }
+
+  return assignment;
+}
+
+double cmModularity(cgGraph* graph, double* weight, double resolution, size_t* label) {
+  double  internal = 0;
+  double  total    = 0;
+  double  squares  = 0;
+  double* degree;
+  size_t  labels = 0;
+  size_t  u, e;
+
+  for (u = 0; u < graph->nodes; u++) {
+    if (label[u] + 1 > labels) { labels = label[u] + 1; }
+  }
+
+  degree = calloc(labels ? labels : 1, sizeof(double));
+  if (!degree) { return 0; }
+
+  for (u = 0; u < graph->nodes; u++) {
+    for (e = graph->offset[u]; e < graph->offset[u + 1]; e++) {
+      size_t v = graph->target[e];
+      double w = weight ? weight[e] : 1.0;
+
+      degree[label[u]] += w;
+      degree[label[v]] += w;
+      total            += 2 * w;
+
+      if (label[u] == label[v]) {
+        internal += 2 * w;
+      }
+    }
+  }
+
+  for (u = 0; u < labels; u++) {
+    squares += degree[u] * degree[u];
+  }
+
+  free(degree);
+
+  if (total <= 0) { return 0; }
+
+  return internal / total - resolution * squares / (total * total);
+}
@@ -0,0 +1,72 @@
+/**
+  @file       community.h
+  @brief      Community detection header file
+  @author     Christopher Harrison (Xophmeister)
+  @copyright  @ref license
+
+  Implements multilevel modularity optimisation (Louvain) over compact
+  graphs, with the Leiden guarantee that every community found is
+  connected.
+
+  Links are treated as undirected for the purposes of modularity: a
+  link from `u` to `v` contributes its weight to the pair regardless of
+  direction, and links in both directions accumulate.
+*/
+
+#ifndef COMMUNITY_H
+#define COMMUNITY_H
+
+#include <stdlib.h>
+#include "compactGraph.h"
+#include "../parallel/threadPool.h"
+
+/**
+  @fn         size_t* cmLouvain(cgGraph* graph, double* weight, double resolution, tpPool* pool, size_t* communities)
+  @brief      Partition a compact graph into communities
+  @param      graph        The compact graph
+  @param      weight       Array of edge weights, aligned with the
+                           compact graph's edges; or `NULL` for unit
+                           weights
+  @param      resolution   Modularity resolution parameter (`1.0` for
+                           standard modularity; higher values favour
+                           smaller communities)
+  @param      pool         Thread pool to run on; or `NULL` to run
+                           serially
+  @param      communities  Pointer to where the number of communities
+                           found will be written; or `NULL`
+  @return     Array of community labels, one per node identifier and
+              numbered densely from zero; or `NULL` in the event of an
+              allocation failure
+
+  Detect communities by repeatedly moving nodes to the neighbouring
+  community that most improves modularity, then coarsening each
+  community into a single node and repeating on the smaller graph until
+  nothing changes.
+
+  Node moves are evaluated in parallel against a snapshot of the
+  current assignment, using flat per-worker accumulator arrays indexed
+  by community (rather than hash maps), and then applied serially. This
+  makes the result deterministic regardless of the number of workers.
+  Before each coarsening, communities that are not connected are split
+  into their connected components.
+
+  @note       The returned array must be freed by the caller
+*/
+extern size_t* cmLouvain(cgGraph*, double*, double, tpPool*, size_t*);
+
+/**
+  @fn         double cmModularity(cgGraph* graph, double* weight, double resolution, size_t* label)
+  @brief      Modularity of a community assignment
+  @param      graph       The compact graph
+  @param      weight      Array of edge weights, aligned with the
+                          compact graph's edges; or `NULL` for unit
+                          weights
+  @param      resolution  Modularity resolution parameter
+  @param      label       Array of community labels, one per node
+                          identifier
+  @return     The modularity, in the range `[-0.5, 1]`; or zero for an
+              edgeless graph
+*/
+extern double cmModularity(cgGraph*, double*, double, size_t*);
+
+#endif
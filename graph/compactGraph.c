@@ -0,0 +1,427 @@
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "compactGraph.h"
+#include "directedGraph.h"
+#include "../indexed/dynamicArray.h"
+#include "../indexed/typedArray.h"
+
+/* Fibonacci hash of a node's address into a table of the given size */
+static size_t hashNode(dgNode* node, size_t slots) {
+  uint64_t key = (uint64_t)(uintptr_t)node;
+  return (size_t)((key >> 4) * UINT64_C(0x9E3779B97F4A7C15)) & (slots - 1);
+}
+
+/* Probe for the slot that holds (or would hold) the given node */
+static size_t probe(cgGraph* graph, dgNode* node) {
+  size_t slot = hashNode(node, graph->slots);
+
+  while (graph->lookup[slot] != cgNone && graph->node[graph->lookup[slot]] != node) {
+    slot = (slot + 1) & (graph->slots - 1);
+  }
+
+  return slot;
+}
+
+/* Resize the lookup table to fit the given number of nodes and rehash */
+static int rehash(cgGraph* graph, size_t nodes) {
+  size_t  slots  = 16;
+  size_t* lookup;
+  size_t  i;
+
+  while (slots < nodes * 2) { slots <<= 1; }
+
+  lookup = malloc(sizeof(size_t) * slots);
+  if (!lookup) { return 1; }
+
+  free(graph->lookup);
+  graph->slots  = slots;
+  graph->lookup = lookup;
+
+  for (i = 0; i < slots; i++) {
+    lookup[i] = cgNone;
+  }
+
+  for (i = 0; i < graph->nodes; i++) {
+    lookup[probe(graph, graph->node[i])] = i;
+  }
+
+  return 0;
+}
+
+cgGraph* cgCreate(size_t nodes, size_t edges) {
+  cgGraph* newGraph = malloc(sizeof(cgGraph));
+
+  if (newGraph) {
+    newGraph->nodes  = nodes;
+    newGraph->edges  = edges;
+    newGraph->slots  = 0;
+    newGraph->lookup = NULL;
+    newGraph->node   = malloc(sizeof(dgNode*) * (nodes ? nodes : 1));
+    newGraph->offset = calloc(nodes + 1, sizeof(size_t));
+    newGraph->target = malloc(sizeof(size_t) * (edges ? edges : 1));
+    newGraph->label  = malloc(sizeof(size_t) * (edges ? edges : 1));
+
+    if (newGraph->node && newGraph->offset && newGraph->target && newGraph->label) {
+      while (nodes--) {
+        newGraph->node[nodes] = NULL;
+      }
+    } else {
+      /* Memory allocation failure :P */
+      cgNuke(newGraph);
+      newGraph = NULL;
+    }
+  }
+
+  return newGraph;
+}
+
+/* Grow the node and offset arrays together */
+static int growNodes(cgGraph* graph, size_t* allocated) {
+  size_t   newAllocation = *allocated * 2;
+  dgNode** node   = realloc(graph->node, sizeof(dgNode*) * newAllocation);
+  size_t*  offset;
+
+  if (!node) { return 1; }
+  graph->node = node;
+
+  offset = realloc(graph->offset, sizeof(size_t) * (newAllocation + 1));
+  if (!offset) { return 1; }
+  graph->offset = offset;
+
+  *allocated = newAllocation;
+  return 0;
+}
+
+/* Grow the target and label arrays together */
+static int growEdges(cgGraph* graph, size_t* allocated) {
+  size_t  newAllocation = *allocated * 2;
+  size_t* target = realloc(graph->target, sizeof(size_t) * newAllocation);
+  size_t* label;
+
+  if (!target) { return 1; }
+  graph->target = target;
+
+  label = realloc(graph->label, sizeof(size_t) * newAllocation);
+  if (!label) { return 1; }
+  graph->label = label;
+
+  *allocated = newAllocation;
+  return 0;
+}
+
+cgGraph* cgFreeze(dgNode* root) {
+  cgGraph* graph = cgCreate(1, 1);
+  size_t   nodeAllocation = 1;
+  size_t   edgeAllocation = 1;
+  size_t   v;
+
+  if (!graph) { return NULL; }
+
+  graph->nodes = 0;
+  graph->edges = 0;
+
+  if (root) {
+    graph->node[0] = root;
+    graph->nodes   = 1;
+  }
+
+  if (rehash(graph, graph->nodes)) { cgNuke(graph); return NULL; }
+
+  /* The node array doubles as the breadth first queue */
+  for (v = 0; v < graph->nodes; v++) {
+    dynArray* links = graph->node[v]->links;
+    size_t    i;
+
+    graph->offset[v] = graph->edges;
+
+    for (i = 0; links && i < links->length; i++) {
+      dgNode* next = (dgNode*)*dynElement(links, i);
+      size_t  slot, id;
+
+      if (!next) { continue; }
+
+      slot = probe(graph, next);
+      id   = graph->lookup[slot];
+
+      if (id == cgNone) {
+        /* Newly discovered node */
+        if (graph->nodes == nodeAllocation && growNodes(graph, &nodeAllocation)) {
+          cgNuke(graph);
+          return NULL;
+        }
+
+        id = graph->nodes++;
+        graph->node[id]     = next;
+        graph->lookup[slot] = id;
+
+        if (graph->nodes * 2 > graph->slots && rehash(graph, graph->nodes * 2)) {
+          cgNuke(graph);
+          return NULL;
+        }
+      }
+
+      if (graph->edges == edgeAllocation && growEdges(graph, &edgeAllocation)) {
+        cgNuke(graph);
+        return NULL;
+      }
+
+      graph->target[graph->edges] = id;
+      graph->label[graph->edges]  = i;
+      ++graph->edges;
+    }
+  }
+
+  graph->offset[graph->nodes] = graph->edges;
+
+  return graph;
+}
+
+cgGraph* cgFromEdges(size_t nodes, tyArray* source, tyArray* target) {
+  size_t   edges = source->length < target->length ? source->length : target->length;
+  size_t*  from  = (size_t*)source->buffer;
+  size_t*  to    = (size_t*)target->buffer;
+  cgGraph* graph;
+  size_t   u, e;
+
+  /* Every identifier must be a node */
+  for (e = 0; e < edges; e++) {
+    if (from[e] >= nodes || to[e] >= nodes) { return NULL; }
+  }
+
+  if (!(graph = cgCreate(nodes, edges))) { return NULL; }
+
+  for (e = 0; e < edges; e++) {
+    ++graph->offset[from[e] + 1];
+  }
+
+  for (u = 0; u < nodes; u++) {
+    graph->offset[u + 1] += graph->offset[u];
+  }
+
+  /* Edges are visited in order, so each row's labels come out ascending */
+  for (e = 0; e < edges; e++) {
+    size_t slot = graph->offset[from[e]]++;
+    graph->target[slot] = to[e];
+    graph->label[slot]  = e;
+  }
+
+  for (u = nodes; u; u--) {
+    graph->offset[u] = graph->offset[u - 1];
+  }
+  graph->offset[0] = 0;
+
+  return graph;
+}
+
+int cgIndex(cgGraph* graph) {
+  return rehash(graph, graph->nodes);
+}
+
+size_t cgFind(cgGraph* graph, dgNode* node) {
+  if (graph && graph->lookup && node) {
+    return graph->lookup[probe(graph, node)];
+  } else {
+    return cgNone;
+  }
+}
+
+size_t cgEdge(cgGraph* graph, size_t node, size_t link) {
+  size_t lo = graph->offset[node];
+  size_t hi = graph->offset[node + 1];
+
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+
+    if (graph->label[mid] < link) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  return lo < graph->offset[node + 1] && graph->label[lo] == link ? lo : cgNone;
+}
+
+cgGraph* cgTranspose(cgGraph* graph) {
+  cgGraph* transposed = cgCreate(graph->nodes, graph->edges);
+  size_t   u, e;
+
+  if (!transposed) { return NULL; }
+
+  for (e = 0; e < graph->edges; e++) {
+    ++transposed->offset[graph->target[e] + 1];
+  }
+
+  for (u = 0; u < graph->nodes; u++) {
+    transposed->offset[u + 1] += transposed->offset[u];
+    transposed->node[u]        = graph->node[u];
+  }
+
+  /* Sources are visited in order, so each row comes out sorted */
+  for (u = 0; u < graph->nodes; u++) {
+    for (e = graph->offset[u]; e < graph->offset[u + 1]; e++) {
+      size_t slot = transposed->offset[graph->target[e]]++;
+      transposed->target[slot] = u;
+      transposed->label[slot]  = graph->label[e];
+    }
+  }
+
+  for (u = graph->nodes; u; u--) {
+    transposed->offset[u] = transposed->offset[u - 1];
+  }
+  transposed->offset[0] = 0;
+
+  if (graph->lookup && cgIndex(transposed)) {
+    cgNuke(transposed);
+    return NULL;
+  }
+
+  return transposed;
+}
+
+cgGraph* cgSymmetrise(cgGraph* graph) {
+  cgGraph* both = cgCreate(graph->nodes, graph->edges * 2);
+  cgGraph* sorted;
+  size_t   u, e, write;
+
+  if (!both) { return NULL; }
+
+  /* Union of the edges and their reverses... */
+  for (u = 0; u < graph->nodes; u++) {
+    for (e = graph->offset[u]; e < graph->offset[u + 1]; e++) {
+      ++both->offset[u + 1];
+      ++both->offset[graph->target[e] + 1];
+    }
+  }
+
+  for (u = 0; u < graph->nodes; u++) {
+    both->offset[u + 1] += both->offset[u];
+  }
+
+  for (u = 0; u < graph->nodes; u++) {
+    for (e = graph->offset[u]; e < graph->offset[u + 1]; e++) {
+      size_t v = graph->target[e];
+      both->target[both->offset[u]++] = v;
+      both->target[both->offset[v]++] = u;
+    }
+  }
+
+  for (u = graph->nodes; u; u--) {
+    both->offset[u] = both->offset[u - 1];
+  }
+  both->offset[0] = 0;
+
+  for (e = 0; e < both->edges; e++) {
+    both->label[e] = cgNone;
+  }
+
+  /* ...which is symmetric, so transposing it just sorts the rows */
+  sorted = cgTranspose(both);
+  cgNuke(both);
+
+  if (!sorted) { return NULL; }
+
+  /* Drop duplicates and self loops */
+  for (u = 0, write = 0; u < graph->nodes; u++) {
+    size_t start = sorted->offset[u];
+
+    sorted->offset[u] = write;
+
+    for (e = start; e < sorted->offset[u + 1]; e++) {
+      size_t v = sorted->target[e];
+
+      if (v != u && (write == sorted->offset[u] || sorted->target[write - 1] != v)) {
+        sorted->target[write++] = v;
+      }
+    }
+  }
+  sorted->offset[graph->nodes] = write;
+  sorted->edges = write;
+
+  for (u = 0; u < graph->nodes; u++) {
+    sorted->node[u] = graph->node[u];
+  }
+
+  if (graph->lookup && cgIndex(sorted)) {
+    cgNuke(sorted);
+    return NULL;
+  }
+
+  return sorted;
+}
+
+cgGraph* cgInduce(cgGraph* graph, char* keep, size_t* global) {
+  size_t*  local = malloc(sizeof(size_t) * (graph->nodes ? graph->nodes : 1));
+  size_t   nodes = 0, edges = 0;
+  cgGraph* induced;
+  size_t   u, e;
+
+  if (!local) { return NULL; }
+
+  for (u = 0; u < graph->nodes; u++) {
+    local[u] = keep[u] ? nodes++ : cgNone;
+  }
+
+  for (u = 0; u < graph->nodes; u++) {
+    if (keep[u]) {
+      for (e = graph->offset[u]; e < graph->offset[u + 1]; e++) {
+        if (keep[graph->target[e]]) { ++edges; }
+      }
+    }
+  }
+
+  induced = cgCreate(nodes, edges);
+
+  if (induced) {
+    for (u = 0, edges = 0; u < graph->nodes; u++) {
+      if (!keep[u]) { continue; }
+
+      induced->node[local[u]]   = graph->node[u];
+      induced->offset[local[u]] = edges;
+      if (global) { global[local[u]] = u; }
+
+      for (e = graph->offset[u]; e < graph->offset[u + 1]; e++) {
+        if (keep[graph->target[e]]) {
+          induced->target[edges]  = local[graph->target[e]];
+          induced->label[edges++] = graph->label[e];
+        }
+      }
+    }
+    induced->offset[nodes] = edges;
+
+    if (graph->lookup && cgIndex(induced)) {
+      cgNuke(induced);
+      induced = NULL;
+    }
+  }
+
+  free(local);
+  return induced;
+}
+
+tyArray* cgAttribute(cgGraph* graph, size_t width, cgAttributeCallback callback, void* context) {
+  tyArray* column = tyCreate(graph->edges, width);
+  size_t   u, e;
+
+  if (column && callback) {
+    for (u = 0; u < graph->nodes; u++) {
+      for (e = graph->offset[u]; e < graph->offset[u + 1]; e++) {
+        callback(graph->node[u], graph->label[e], graph->node[graph->target[e]], tyElement(column, e), context);
+      }
+    }
+  }
+
+  return column;
+}
+
+void cgNuke(cgGraph* graph) {
+  if (graph) {
+    free(graph->node);
+    free(graph->offset);
+    free(graph->target);
+    free(graph->label);
+    free(graph->lookup);
+    free(graph);
+  }
+}
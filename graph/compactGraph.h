@@ -0,0 +1,292 @@
+/**
+  @file       compactGraph.h
+  @brief      Compact graph header file
+  @author     Christopher Harrison (Xophmeister)
+  @copyright  @ref license
+
+  Implements a frozen, compact (compressed sparse row) representation
+  of a directed graph built from dgNode links. Each node is given a
+  dense integer identifier and the links of every node are stored
+  contiguously, so algorithms can walk the graph with array indexing
+  rather than chasing pointers.
+
+  This is an abstraction used to build more specific graph algorithms.
+*/
+
+#ifndef COMPACTGRAPH_H
+#define COMPACTGRAPH_H
+
+#include <stdlib.h>
+#include "directedGraph.h"
+#include "../indexed/typedArray.h"
+
+/**
+  @def        cgNone
+  @brief      Sentinel node identifier
+
+  Returned by functions that resolve a node identifier when there is no
+  such node.
+*/
+#define cgNone ((size_t)-1)
+
+/**
+  @struct     cgGraph
+  @brief      Compact graph
+  @var        cgGraph::nodes
+              Number of nodes
+  @var        cgGraph::edges
+              Number of edges
+  @var        cgGraph::node
+              Array mapping node identifiers to their dgNode
+  @var        cgGraph::offset
+              Array of `nodes + 1` offsets into the edge arrays; the
+              edges of node `v` lie in `[offset[v], offset[v + 1])`
+  @var        cgGraph::target
+              Array of edge target node identifiers
+  @var        cgGraph::label
+              Array of edge labels (i.e., the link index each edge was
+              derived from)
+  @var        cgGraph::slots
+              Number of slots in the lookup table
+  @var        cgGraph::lookup
+              Open addressed lookup table of node identifiers, keyed by
+              their dgNode address
+
+  @note       Only defined links become edges; `NULL` links are dropped,
+              but the original link index is preserved as the label
+  @warning    The compact graph is a snapshot: changes made to the
+              underlying dgNode graph after it was built will not be
+              reflected
+*/
+typedef struct {
+  size_t   nodes;
+  size_t   edges;
+  dgNode** node;
+  size_t*  offset;
+  size_t*  target;
+  size_t*  label;
+  size_t   slots;
+  size_t*  lookup;
+} cgGraph;
+
+/**
+  @fn         cgGraph* cgCreate(size_t nodes, size_t edges)
+  @brief      Allocate a compact graph of a given size
+  @param      nodes  Number of nodes
+  @param      edges  Number of edges
+  @return     Pointer to the newly created compact graph; or `NULL` in
+              the event of an allocation failure
+
+  Allocate the structure and arrays for a compact graph with the given
+  number of nodes and edges. The node array is initialised with `NULL`
+  pointers and the offsets are zeroed, but the edge arrays are left for
+  the caller to fill.
+
+  @note       The lookup table is not built; cgFind() will not resolve
+              any nodes until cgIndex() is called
+*/
+extern cgGraph* cgCreate(size_t, size_t);
+
+/**
+  @fn         cgGraph* cgFreeze(dgNode* root)
+  @brief      Build a compact graph from the nodes reachable from a given node
+  @param      root  Node to traverse from
+  @return     Pointer to the compact graph; or `NULL` in the event of an
+              allocation failure
+
+  Traverse the directed graph, breadth first, from the given node down
+  all links and build its compact representation. Nodes are numbered in
+  the order they are discovered, so the root node will always have the
+  identifier zero.
+
+  @note       Cycles are handled; each node is visited exactly once
+*/
+extern cgGraph* cgFreeze(dgNode*);
+
+/**
+  @fn         cgGraph* cgFromEdges(size_t nodes, tyArray* source, tyArray* target)
+  @brief      Build a compact graph from arrays of edges
+  @param      nodes   Number of nodes
+  @param      source  Typed array of edge source node identifiers
+                      (`size_t`)
+  @param      target  Typed array of edge target node identifiers
+                      (`size_t`)
+  @return     Pointer to the compact graph; or `NULL` if an identifier
+              is not less than the number of nodes, or in the event of
+              an allocation failure
+
+  Bulk build a compact graph, by counting sort of the edges into rows,
+  without going through dgNodes (e.g., from elRead()). Edges keep their
+  input order within each row and each edge is labelled with its index
+  in the input arrays, so any input aligned attribute (e.g., a weight)
+  of edge `e` is element `label[e]`, and cgEdge() finds an input edge.
+
+  @note       The node array is all `NULL` and no lookup table is built
+*/
+extern cgGraph* cgFromEdges(size_t, tyArray*, tyArray*);
+
+/**
+  @fn         int cgIndex(cgGraph* graph)
+  @brief      Build the node lookup table for a compact graph
+  @param      graph  The compact graph
+  @return     Zero on success; non-zero in the event of an allocation
+              failure
+
+  (Re)build the lookup table that resolves dgNode addresses to node
+  identifiers from the compact graph's node array.
+
+  @note       This is done automatically by cgFreeze()
+*/
+extern int cgIndex(cgGraph*);
+
+/**
+  @fn         size_t cgFind(cgGraph* graph, dgNode* node)
+  @brief      Resolve the identifier of a node in a compact graph
+  @param      graph  The compact graph
+  @param      node   The node to find
+  @return     The node's identifier; or cgNone if the node is not part
+              of the compact graph
+*/
+extern size_t cgFind(cgGraph*, dgNode*);
+
+/**
+  @fn         size_t cgEdge(cgGraph* graph, size_t node, size_t link)
+  @brief      Resolve the edge derived from a node's link
+  @param      graph  The compact graph
+  @param      node   The node's identifier
+  @param      link   The link index
+  @return     The edge's index; or cgNone if the link was not defined
+
+  Find the edge that a given link of a given node became, by binary
+  search of the node's labels. The edge index can then be used to look
+  up the link's attributes in any edge aligned array (e.g., one built
+  with cgAttribute()), rather than keying a side table on the pair of
+  dgNodes.
+
+  @note       Each row's labels must be ascending, as cgFreeze() and
+              cgInduce() leave them
+*/
+extern size_t cgEdge(cgGraph*, size_t, size_t);
+
+/**
+  @fn         cgGraph* cgTranspose(cgGraph* graph)
+  @brief      Reverse the edges of a compact graph
+  @param      graph  The compact graph
+  @return     Pointer to the transposed compact graph; or `NULL` in the
+              event of an allocation failure
+
+  Build the compact graph with the same nodes but every edge reversed,
+  so that each node's row lists the nodes that link to it. Labels are
+  carried with their edges and rows are sorted by target.
+*/
+extern cgGraph* cgTranspose(cgGraph*);
+
+/**
+  @fn         cgGraph* cgSymmetrise(cgGraph* graph)
+  @brief      Build the undirected, simple equivalent of a compact graph
+  @param      graph  The compact graph
+  @return     Pointer to the symmetrised compact graph; or `NULL` in the
+              event of an allocation failure
+
+  Build the compact graph with the same nodes, where `u` and `v` are
+  joined in both directions if there is an edge between them in either
+  direction. Each row is sorted by target, with duplicate edges and self
+  loops removed.
+
+  @note       As edges may be merged, all labels are cgNone
+*/
+extern cgGraph* cgSymmetrise(cgGraph*);
+
+/**
+  @fn         cgGraph* cgInduce(cgGraph* graph, char* keep, size_t* global)
+  @brief      Extract the subgraph induced by a subset of nodes
+  @param      graph   The compact graph
+  @param      keep    Array of flags, by node identifier, which are
+                      non-zero for the nodes to keep
+  @param      global  Array that will receive the original identifier
+                      of each node in the subgraph; or `NULL`
+  @return     Pointer to the induced compact graph; or `NULL` in the
+              event of an allocation failure
+
+  Build the compact graph of the kept nodes and the edges between them,
+  renumbering the nodes densely while preserving their relative order.
+
+  @note       The global array must have room for as many identifiers as
+              there are kept nodes
+*/
+extern cgGraph* cgInduce(cgGraph*, char*, size_t*);
+
+/**
+  @typedef    cgAttributeCallback
+  @brief      Function signature for cgAttribute() callbacks
+
+  The callback function for cgAttribute() must have the following
+  signature:
+
+  @code{.c}
+  void callback(dgNode* from, size_t link, dgNode* to, void* value, void* context)
+  @endcode
+
+  That is, on each edge, the callback is called with the following:
+
+  @param      from     The node the edge leaves
+  @param      link     The link index the edge was derived from
+  @param      to       The node the edge enters
+  @param      value    Pointer to the edge's (zeroed) attribute, to be
+                       written
+  @param      context  The context pointer given to cgAttribute()
+
+  For example, the following callback would weight each edge by its link
+  index:
+
+  @code{.c}
+  void linkWeight(dgNode* from, size_t link, dgNode* to, void* value, void* context) {
+    *(double*)value = 1.0 + link;
+  }
+  @endcode
+*/
+typedef void(*cgAttributeCallback)(dgNode*, size_t, dgNode*, void*, void*);
+
+/**
+  @fn         tyArray* cgAttribute(cgGraph* graph, size_t width, cgAttributeCallback callback, void* context)
+  @brief      Build an edge attribute array aligned with a compact graph
+  @param      graph     The compact graph
+  @param      width     Width of each attribute, in bytes
+  @param      callback  Function to compute each edge's attribute; or
+                        `NULL` to leave them zeroed
+  @param      context   Pointer passed through to the callback
+  @return     Pointer to a typed array of one attribute per edge; or
+              `NULL` in the event of an allocation failure
+
+  Build a column of edge attributes (e.g., weights) in structure of
+  arrays form: the attribute of edge `e` is element `e`, so it is read
+  sequentially alongside cgGraph::target when walking a node's edges.
+  The array's buffer can be passed directly to any function that takes
+  edge aligned weights; for example:
+
+  @code{.c}
+  tyArray* weight = cgAttribute(graph, sizeof(double), &linkWeight, NULL);
+  double*  centrality = bcBrandes(graph, (double*)weight->buffer, NULL);
+  @endcode
+
+  @note       The callback is given each edge's dgNodes from the compact
+              graph's node array, which are `NULL` for graphs that were
+              not built from dgNodes
+  @note       Graphs derived by cgTranspose(), cgSymmetrise() or
+              cgInduce() have their own edge order, so need their own
+              attribute arrays
+*/
+extern tyArray* cgAttribute(cgGraph*, size_t, cgAttributeCallback, void*);
+
+/**
+  @fn         void cgNuke(cgGraph* graph)
+  @brief      Free the memory allocated by the compact graph
+  @param      graph  The compact graph to free
+
+  Free the memory allocated by the compact graph and its arrays.
+
+  @note       The underlying dgNode graph will not be freed
+*/
+extern void cgNuke(cgGraph*);
+
+#endif
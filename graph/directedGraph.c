@@ -4,12 +4,21 @@
 #include "directedGraph.h"
 #include "../indexed/dynamicArray.h"
 
+/* Links stored with the node, before they spill to the heap */
+#define dgInline 4
+
+/* The node's own links array, which directly follows it */
+static dynArray* ownLinks(dgNode* node) {
+  return (dynArray*)(node + 1);
+}
+
 dgNode* dgCreateNode(void* payload, size_t links) {
-  dgNode* newNode = malloc(sizeof(dgNode));
+  /* Node, links array and its first few links in one allocation */
+  dgNode* newNode = malloc(sizeof(dgNode) + dynInlineSize(dgInline));
 
   if (newNode) {
     newNode->payload = payload;
-    newNode->links   = dynCreate(links);
+    newNode->links   = dynEmbed(ownLinks(newNode), links, dgInline);
 
     if (!newNode->links) {
       /* Memory allocation failure :P */
@@ -92,7 +101,13 @@ void dgNuke(dgNode* node) {
   if (node) {
     if (node->links) {
       dynForEach(node->links, &chainNuke);
-      dynNuke(node->links);
+
+      /* The node's own links array is freed with it */
+      if (node->links == ownLinks(node)) {
+        dynResize(node->links, 0);
+      } else {
+        dynNuke(node->links);
+      }
     }
     free(node);
   }
@@ -58,6 +58,10 @@ typedef enum {
 
   Create a directed graph node with the given contents, initialised (but
   not set) with the specified number of links.
+
+  @note       The node's links array is allocated together with the
+              node and stores up to four links inline (see dynEmbed()),
+              so typical nodes take a single allocation
 */
 extern dgNode* dgCreateNode(void*, size_t);
 
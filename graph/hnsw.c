@@ -0,0 +1,840 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <sched.h>
+#include <stdatomic.h>
+
+#if defined(__AVX__) || defined(__SSE__)
+#include <immintrin.h>
+#endif
+
+#include "hnsw.h"
+#include "compactGraph.h"
+#include "../shared/region.h"
+#include "../parallel/threadPool.h"
+#include "../random/prng.h"
+
+#define hnMaxLevel 31
+
+struct hnIndex {
+  size_t        dimension;
+  size_t        stride;    /* Dimension, padded to a multiple of eight */
+  hnMetric      metric;
+  size_t        links;
+  size_t        ef;
+  size_t        capacity;
+  double        scale;     /* Level normalisation, 1 / ln(links) */
+  rngState      seed;
+  atomic_size_t claimed;
+  atomic_size_t size;
+  size_t        entry;
+  size_t        top;
+  atomic_uchar  global;    /* Lock on the entry point and top layer */
+  shPointer     vectors;   /* capacity * stride floats */
+  shPointer     base;      /* Layer zero links: capacity * (1 + 2 * links) */
+  shPointer     upper;     /* Upper layer links, by node */
+  shPointer     lock;      /* Link lock, by node */
+  shPointer     live;      /* Whether each node was inserted */
+};
+
+typedef struct {
+  float  distance;
+  size_t id;
+} candidate;
+
+/* Binary max-heap of candidates */
+typedef struct {
+  size_t     length;
+  size_t     allocated;
+  candidate* data;
+} heap;
+
+/* Per-search working memory */
+typedef struct {
+  float*     query;
+  heap       candidates;  /* Nearest first, by negated distance */
+  heap       results;     /* Farthest first */
+  size_t     slots;
+  size_t     visited;
+  size_t*    seen;        /* Open addressed set of visited nodes */
+  size_t*    copy;        /* Links read under lock */
+  candidate* sorted;      /* Results, nearest first */
+  candidate* chosen;
+  candidate* list;        /* A full node's links, while pruning them */
+  candidate* pruned;
+  int        failed;
+} scratch;
+
+/* Distance kernels; the SIMD loops leave any tail to the scalar one */
+
+static float sum8(float* lanes) {
+  return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+}
+
+static float l2(float* a, float* b, size_t n) {
+  float  total = 0;
+  size_t i = 0;
+
+#if defined(__AVX__)
+  __m256 sum = _mm256_setzero_ps();
+  float  lanes[8];
+
+  for (; i + 8 <= n; i += 8) {
+    __m256 d = _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+    sum = _mm256_add_ps(sum, _mm256_mul_ps(d, d));
+  }
+  _mm256_storeu_ps(lanes, sum);
+  total = sum8(lanes);
+#elif defined(__SSE__)
+  __m128 low = _mm_setzero_ps(), high = _mm_setzero_ps();
+  float  lanes[8];
+
+  for (; i + 8 <= n; i += 8) {
+    __m128 d = _mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i));
+    __m128 e = _mm_sub_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4));
+    low  = _mm_add_ps(low, _mm_mul_ps(d, d));
+    high = _mm_add_ps(high, _mm_mul_ps(e, e));
+  }
+  _mm_storeu_ps(lanes, low);
+  _mm_storeu_ps(lanes + 4, high);
+  total = sum8(lanes);
+#endif
+
+  for (; i < n; i++) {
+    total += (a[i] - b[i]) * (a[i] - b[i]);
+  }
+
+  return total;
+}
+
+static float dot(float* a, float* b, size_t n) {
+  float  total = 0;
+  size_t i = 0;
+
+#if defined(__AVX__)
+  __m256 sum = _mm256_setzero_ps();
+  float  lanes[8];
+
+  for (; i + 8 <= n; i += 8) {
+    sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+  }
+  _mm256_storeu_ps(lanes, sum);
+  total = sum8(lanes);
+#elif defined(__SSE__)
+  __m128 low = _mm_setzero_ps(), high = _mm_setzero_ps();
+  float  lanes[8];
+
+  for (; i + 8 <= n; i += 8) {
+    low  = _mm_add_ps(low, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    high = _mm_add_ps(high, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+  }
+  _mm_storeu_ps(lanes, low);
+  _mm_storeu_ps(lanes + 4, high);
+  total = sum8(lanes);
+#endif
+
+  for (; i < n; i++) {
+    total += a[i] * b[i];
+  }
+
+  return total;
+}
+
+float hnDistance(hnMetric metric, float* a, float* b, size_t dimension) {
+  float norms;
+
+  switch (metric) {
+    case hnL2:
+      return l2(a, b, dimension);
+
+    case hnInner:
+      return 1 - dot(a, b, dimension);
+
+    default:
+      norms = sqrtf(dot(a, a, dimension) * dot(b, b, dimension));
+      return norms > 0 ? 1 - dot(a, b, dimension) / norms : 1;
+  }
+}
+
+/* Distance between stored (or padded query) vectors */
+static float distance(hnIndex* index, float* a, float* b) {
+  return index->metric == hnL2 ? l2(a, b, index->stride) : 1 - dot(a, b, index->stride);
+}
+
+static float* vectorOf(hnIndex* index, size_t id) {
+  return (float*)shGet(&index->vectors) + id * index->stride;
+}
+
+static size_t maxLinks(hnIndex* index, size_t layer) {
+  return layer ? index->links : 2 * index->links;
+}
+
+/* A node's link count, followed by its links, on a given layer */
+static size_t* linksOf(hnIndex* index, size_t id, size_t layer) {
+  if (!layer) {
+    return (size_t*)shGet(&index->base) + id * (1 + 2 * index->links);
+  }
+
+  return (size_t*)shGet((shPointer*)shGet(&index->upper) + id) + (layer - 1) * (1 + index->links);
+}
+
+static void acquire(atomic_uchar* lock) {
+  while (atomic_exchange_explicit(lock, 1, memory_order_acquire)) {
+    sched_yield();
+  }
+}
+
+static void release(atomic_uchar* lock) {
+  atomic_store_explicit(lock, 0, memory_order_release);
+}
+
+static atomic_uchar* lockOf(hnIndex* index, size_t id) {
+  return (atomic_uchar*)shGet(&index->lock) + id;
+}
+
+/* Copy a node's links, locking it if insertions may be running */
+static size_t* readLinks(hnIndex* index, scratch* work, size_t id, size_t layer, int locked) {
+  size_t* links = linksOf(index, id, layer);
+
+  if (!locked) { return links; }
+
+  acquire(lockOf(index, id));
+  memcpy(work->copy, links, sizeof(size_t) * (1 + links[0]));
+  release(lockOf(index, id));
+
+  return work->copy;
+}
+
+static void push(heap* h, float distance, size_t id, int* failed) {
+  size_t at = h->length++;
+
+  if (at == h->allocated) {
+    size_t     allocated = h->allocated ? h->allocated * 2 : 64;
+    candidate* data      = realloc(h->data, sizeof(candidate) * allocated);
+
+    if (!data) {
+      /* Memory allocation failure :P */
+      --h->length;
+      *failed = 1;
+      return;
+    }
+
+    h->data      = data;
+    h->allocated = allocated;
+  }
+
+  while (at && h->data[(at - 1) / 2].distance < distance) {
+    h->data[at] = h->data[(at - 1) / 2];
+    at = (at - 1) / 2;
+  }
+
+  h->data[at].distance = distance;
+  h->data[at].id       = id;
+}
+
+static candidate pop(heap* h) {
+  candidate top = h->data[0], last = h->data[--h->length];
+  size_t    at = 0, child;
+
+  while ((child = 2 * at + 1) < h->length) {
+    if (child + 1 < h->length && h->data[child + 1].distance > h->data[child].distance) { ++child; }
+    if (h->data[child].distance <= last.distance) { break; }
+
+    h->data[at] = h->data[child];
+    at = child;
+  }
+
+  if (h->length) { h->data[at] = last; }
+
+  return top;
+}
+
+/* Mark a node as visited; returns whether it already was */
+static int visit(scratch* work, size_t id) {
+  size_t slot;
+
+  if (2 * (work->visited + 1) > work->slots) {
+    size_t  slots = work->slots * 2, i;
+    size_t* seen  = malloc(sizeof(size_t) * slots);
+
+    if (!seen) {
+      /* Memory allocation failure :P */
+      work->failed = 1;
+      return 1;
+    }
+
+    memset(seen, 0xff, sizeof(size_t) * slots);
+    for (i = 0; i < work->slots; i++) {
+      if (work->seen[i] != cgNone) {
+        for (slot = (work->seen[i] * 0x9E3779B97F4A7C15ULL) & (slots - 1); seen[slot] != cgNone; slot = (slot + 1) & (slots - 1));
+        seen[slot] = work->seen[i];
+      }
+    }
+
+    free(work->seen);
+    work->seen  = seen;
+    work->slots = slots;
+  }
+
+  for (slot = (id * 0x9E3779B97F4A7C15ULL) & (work->slots - 1); work->seen[slot] != cgNone; slot = (slot + 1) & (work->slots - 1)) {
+    if (work->seen[slot] == id) { return 1; }
+  }
+
+  work->seen[slot] = id;
+  ++work->visited;
+  return 0;
+}
+
+static void scratchNuke(scratch* work) {
+  if (work) {
+    free(work->query);
+    free(work->candidates.data);
+    free(work->results.data);
+    free(work->seen);
+    free(work->copy);
+    free(work->sorted);
+    free(work->list);
+    free(work->chosen);
+    free(work->pruned);
+  }
+}
+
+static int scratchCreate(hnIndex* index, scratch* work) {
+  memset(work, 0, sizeof(scratch));
+
+  work->slots  = 256;
+  work->query  = malloc(sizeof(float) * index->stride);
+  work->seen   = malloc(sizeof(size_t) * work->slots);
+  work->copy   = malloc(sizeof(size_t) * (1 + 2 * index->links));
+  work->sorted = malloc(sizeof(candidate) * (1 + index->ef));
+  work->list   = malloc(sizeof(candidate) * (1 + 2 * index->links));
+  work->chosen = malloc(sizeof(candidate) * (1 + 2 * index->links));
+  work->pruned = malloc(sizeof(candidate) * (1 + 2 * index->links));
+
+  if (!work->query || !work->seen || !work->copy || !work->sorted || !work->list || !work->chosen || !work->pruned) {
+    /* Memory allocation failure :P */
+    scratchNuke(work);
+    return 1;
+  }
+
+  return 0;
+}
+
+/* Copy a vector into place, zero padded, normalising it for cosine */
+static void prepare(hnIndex* index, float* into, float* vector) {
+  size_t i;
+
+  memcpy(into, vector, sizeof(float) * index->dimension);
+  for (i = index->dimension; i < index->stride; i++) {
+    into[i] = 0;
+  }
+
+  if (index->metric == hnCosine) {
+    float norm = sqrtf(dot(into, into, index->stride));
+
+    if (norm > 0) {
+      for (i = 0; i < index->dimension; i++) {
+        into[i] /= norm;
+      }
+    }
+  }
+}
+
+/* Walk greedily to the nearest node on a layer */
+static size_t greedy(hnIndex* index, scratch* work, float* query, size_t current, float* nearest, size_t layer, int locked) {
+  int changed = 1;
+
+  while (changed) {
+    size_t* links = readLinks(index, work, current, layer, locked);
+    size_t  i;
+
+    changed = 0;
+    for (i = 1; i <= links[0]; i++) {
+      float d = distance(index, query, vectorOf(index, links[i]));
+
+      if (d < *nearest) {
+        *nearest = d;
+        current  = links[i];
+        changed  = 1;
+      }
+    }
+  }
+
+  return current;
+}
+
+/* Best first search of a layer, leaving the ef nearest in the results */
+static void searchLayer(hnIndex* index, scratch* work, float* query, size_t entry, float d, size_t ef, size_t layer, int locked) {
+  work->candidates.length = 0;
+  work->results.length    = 0;
+  work->visited           = 0;
+  memset(work->seen, 0xff, sizeof(size_t) * work->slots);
+
+  visit(work, entry);
+  push(&work->candidates, -d, entry, &work->failed);
+  push(&work->results, d, entry, &work->failed);
+
+  while (work->candidates.length && !work->failed) {
+    candidate nearest = pop(&work->candidates);
+    size_t*   links;
+    size_t    i;
+
+    if (work->results.length >= ef && -nearest.distance > work->results.data[0].distance) { break; }
+
+    links = readLinks(index, work, nearest.id, layer, locked);
+
+    for (i = 1; i <= links[0]; i++) {
+      size_t next = links[i];
+
+      if (!visit(work, next)) {
+        float e = distance(index, query, vectorOf(index, next));
+
+        if (work->results.length < ef || e < work->results.data[0].distance) {
+          push(&work->candidates, -e, next, &work->failed);
+          push(&work->results, e, next, &work->failed);
+
+          if (work->results.length > ef) { pop(&work->results); }
+        }
+      }
+    }
+  }
+}
+
+/* Keep candidates (ascending by distance) that are nearer the base than to any kept one */
+static size_t heuristic(hnIndex* index, candidate* list, size_t length, size_t most, candidate* chosen) {
+  size_t kept = 0, i, j;
+
+  for (i = 0; i < length && kept < most; i++) {
+    float* vector = vectorOf(index, list[i].id);
+
+    for (j = 0; j < kept; j++) {
+      if (distance(index, vector, vectorOf(index, chosen[j].id)) < list[i].distance) { break; }
+    }
+
+    if (j == kept) {
+      chosen[kept++] = list[i];
+    }
+  }
+
+  return kept;
+}
+
+static int ascending(const void* a, const void* b) {
+  float x = ((candidate*)a)->distance, y = ((candidate*)b)->distance;
+  return (x > y) - (x < y);
+}
+
+/* Add a link from a neighbour back to a new node, pruning if it is full */
+static void connect(hnIndex* index, scratch* work, size_t from, size_t to, size_t layer) {
+  size_t* links = linksOf(index, from, layer);
+  size_t  most  = maxLinks(index, layer);
+  float*  base  = vectorOf(index, from);
+  size_t  i, kept;
+
+  acquire(lockOf(index, from));
+
+  if (links[0] < most) {
+    links[++links[0]] = to;
+  } else {
+    for (i = 0; i < most; i++) {
+      work->list[i].id       = links[i + 1];
+      work->list[i].distance = distance(index, base, vectorOf(index, links[i + 1]));
+    }
+    work->list[most].id       = to;
+    work->list[most].distance = distance(index, base, vectorOf(index, to));
+
+    qsort(work->list, most + 1, sizeof(candidate), &ascending);
+    kept = heuristic(index, work->list, most + 1, most, work->pruned);
+
+    links[0] = kept;
+    for (i = 0; i < kept; i++) {
+      links[i + 1] = work->pruned[i].id;
+    }
+  }
+
+  release(lockOf(index, from));
+}
+
+static size_t insert(shRegion* region, hnIndex* index, scratch* work, float* vector) {
+  size_t     id    = atomic_load(&index->claimed);
+  shPointer* upper = shGet(&index->upper);
+  size_t     level, top, entry, current, layer, i, length, kept;
+  size_t*    block;
+  int        linked = 0;
+  float      nearest;
+  float*     stored;
+  rngState   rng;
+
+  /* Draw the next node's top layer and allocate its links, and only
+     then claim it, so that an allocation failure claims nothing */
+  for (;;) {
+    if (id >= index->capacity) { return cgNone; }
+
+    rng   = rngSplit(&index->seed, id);
+    level = (size_t)(-log(1 - rngDouble(&rng)) * index->scale);
+    if (level > hnMaxLevel) { level = hnMaxLevel; }
+
+    block = NULL;
+    if (level && !(block = shAlloc(region, sizeof(size_t) * level * (1 + index->links)))) {
+      /* Memory allocation failure :P */
+      return cgNone;
+    }
+
+    if (atomic_compare_exchange_weak(&index->claimed, &id, id + 1)) { break; }
+
+    /* Another thread took it; the next may have a different level */
+    shFree(region, block);
+  }
+
+  stored = vectorOf(index, id);
+  prepare(index, stored, vector);
+  linksOf(index, id, 0)[0] = 0;
+
+  if (level) {
+    shSet(upper + id, block);
+    for (layer = 1; layer <= level; layer++) {
+      linksOf(index, id, layer)[0] = 0;
+    }
+  }
+
+  /* Inserting above the top layer holds the global lock throughout */
+  acquire(&index->global);
+  entry = index->entry;
+  top   = index->top;
+
+  if (entry == cgNone) {
+    index->entry = id;
+    index->top   = level;
+    release(&index->global);
+    ((unsigned char*)shGet(&index->live))[id] = 1;
+    atomic_fetch_add(&index->size, 1);
+    return id;
+  }
+
+  if (level <= top) {
+    release(&index->global);
+  }
+
+  current = entry;
+  nearest = distance(index, stored, vectorOf(index, current));
+
+  for (layer = top; layer > level; layer--) {
+    current = greedy(index, work, stored, current, &nearest, layer, 1);
+  }
+
+  for (layer = level < top ? level : top; ; layer--) {
+    searchLayer(index, work, stored, current, nearest, index->ef, layer, 1);
+
+    if (work->failed) {
+      /* Unreachable so far, so give up; otherwise, others may already
+         have found the node, so link it with whatever was found */
+      if (!linked) { break; }
+      work->failed = 0;
+    }
+
+    /* The results, nearest first, seed the next layer down */
+    for (length = work->results.length, i = length; i; i--) {
+      work->sorted[i - 1] = pop(&work->results);
+    }
+
+    if (length) {
+      current = work->sorted[0].id;
+      nearest = work->sorted[0].distance;
+    }
+
+    kept    = heuristic(index, work->sorted, length, index->links, work->chosen);
+    linked |= kept > 0;
+
+    acquire(lockOf(index, id));
+    linksOf(index, id, layer)[0] = kept;
+    for (i = 0; i < kept; i++) {
+      linksOf(index, id, layer)[i + 1] = work->chosen[i].id;
+    }
+    release(lockOf(index, id));
+
+    for (i = 0; i < kept; i++) {
+      connect(index, work, work->chosen[i].id, id, layer);
+    }
+
+    if (!layer) { break; }
+  }
+
+  if (level > top) {
+    if (linked) {
+      index->entry = id;
+      index->top   = level;
+    }
+    release(&index->global);
+  }
+
+  /* The identifier is spent regardless, but the vector is not live */
+  if (!linked) { return cgNone; }
+
+  ((unsigned char*)shGet(&index->live))[id] = 1;
+  atomic_fetch_add(&index->size, 1);
+  return id;
+}
+
+size_t hnFootprint(size_t dimension, size_t links, size_t capacity) {
+  size_t stride  = (dimension + 7) & ~(size_t)7;
+  size_t perNode = sizeof(float) * stride + sizeof(size_t) * (1 + 2 * links) + sizeof(shPointer) + 2;
+  size_t block   = 16 + sizeof(size_t) * 2 * (1 + links);
+
+  /* Size classes are powers of two, so allow double */
+  return 4096 + 2 * (sizeof(hnIndex) + 5 * 16 + capacity * perNode) + 2 * (capacity / (links > 2 ? links - 1 : 1) + 1) * block;
+}
+
+hnIndex* hnCreate(shRegion* region, size_t dimension, hnMetric metric, size_t links, size_t ef, size_t capacity, uint64_t seed) {
+  hnIndex* newIndex;
+  void*    vectors;
+  void*    base;
+  void*    upper;
+  void*    lock;
+  void*    live;
+
+  if (links < 2) { links = 2; }
+
+  newIndex = shAlloc(region, sizeof(hnIndex));
+  if (!newIndex) { return NULL; }
+
+  newIndex->dimension = dimension;
+  newIndex->stride    = (dimension + 7) & ~(size_t)7;
+  newIndex->metric    = metric;
+  newIndex->links     = links;
+  newIndex->ef        = ef > links ? ef : links;
+  newIndex->capacity  = capacity;
+  newIndex->scale     = 1 / log((double)links);
+  newIndex->seed      = rngSeed(seed);
+  newIndex->entry     = cgNone;
+  newIndex->top       = 0;
+  atomic_init(&newIndex->claimed, 0);
+  atomic_init(&newIndex->size, 0);
+  atomic_init(&newIndex->global, 0);
+
+  vectors = shAlloc(region, sizeof(float) * newIndex->stride * (capacity ? capacity : 1));
+  base    = shAlloc(region, sizeof(size_t) * (1 + 2 * links) * (capacity ? capacity : 1));
+  upper   = shAlloc(region, sizeof(shPointer) * (capacity ? capacity : 1));
+  lock    = shAlloc(region, capacity ? capacity : 1);
+  live    = shAlloc(region, capacity ? capacity : 1);
+
+  if (!vectors || !base || !upper || !lock || !live) {
+    /* Region exhausted :P */
+    shFree(region, vectors);
+    shFree(region, base);
+    shFree(region, upper);
+    shFree(region, lock);
+    shFree(region, live);
+    shFree(region, newIndex);
+    return NULL;
+  }
+
+  memset(upper, 0, sizeof(shPointer) * (capacity ? capacity : 1));
+  memset(lock, 0, capacity ? capacity : 1);
+  memset(live, 0, capacity ? capacity : 1);
+
+  shSet(&newIndex->vectors, vectors);
+  shSet(&newIndex->base, base);
+  shSet(&newIndex->upper, upper);
+  shSet(&newIndex->lock, lock);
+  shSet(&newIndex->live, live);
+
+  return newIndex;
+}
+
+size_t hnInsert(shRegion* region, hnIndex* index, float* vector) {
+  scratch work;
+  size_t  id;
+
+  if (scratchCreate(index, &work)) { return cgNone; }
+
+  id = insert(region, index, &work, vector);
+  scratchNuke(&work);
+
+  return id;
+}
+
+typedef struct {
+  shRegion* region;
+  hnIndex*  index;
+  float*    vectors;
+  scratch*  work;
+  size_t*   inserted;
+} batchInsert;
+
+static void insertChunk(size_t from, size_t to, size_t worker, void* context) {
+  batchInsert* batch = (batchInsert*)context;
+  scratch*     work  = batch->work + worker;
+
+  for (; from < to; from++) {
+    work->failed = 0;
+
+    if (insert(batch->region, batch->index, work, batch->vectors + from * batch->index->dimension) != cgNone) {
+      ++batch->inserted[worker];
+    }
+  }
+}
+
+size_t hnInsertBatch(shRegion* region, hnIndex* index, float* vectors, size_t count, tpPool* pool) {
+  size_t      workers = tpWorkers(pool);
+  size_t      total = 0, ready, w;
+  batchInsert batch;
+
+  batch.region   = region;
+  batch.index    = index;
+  batch.vectors  = vectors;
+  batch.work     = malloc(sizeof(scratch) * workers);
+  batch.inserted = calloc(workers, sizeof(size_t));
+
+  for (ready = 0; batch.work && ready < workers; ready++) {
+    if (scratchCreate(index, batch.work + ready)) { break; }
+  }
+
+  if (batch.work && batch.inserted && ready == workers) {
+    tpFor(pool, count, 16, &insertChunk, &batch);
+
+    for (w = 0; w < workers; w++) {
+      total += batch.inserted[w];
+    }
+  }
+
+  for (w = 0; batch.work && w < ready; w++) {
+    scratchNuke(batch.work + w);
+  }
+  free(batch.work);
+  free(batch.inserted);
+
+  return total;
+}
+
+static size_t search(hnIndex* index, scratch* work, float* query, size_t k, size_t ef, size_t* ids, float* distances) {
+  size_t found = 0, layer, current, i;
+  float  nearest;
+
+  work->failed = 0;
+
+  for (i = 0; i < k; i++) {
+    ids[i] = cgNone;
+  }
+
+  if (index->entry == cgNone || !k) { return 0; }
+
+  prepare(index, work->query, query);
+
+  current = index->entry;
+  nearest = distance(index, work->query, vectorOf(index, current));
+
+  for (layer = index->top; layer; layer--) {
+    current = greedy(index, work, work->query, current, &nearest, layer, 0);
+  }
+
+  searchLayer(index, work, work->query, current, nearest, ef > k ? ef : k, 0, 0);
+  if (work->failed) { return cgNone; }
+
+  while (work->results.length > k) {
+    pop(&work->results);
+  }
+
+  for (found = work->results.length, i = found; i; i--) {
+    candidate next = pop(&work->results);
+
+    ids[i - 1] = next.id;
+    if (distances) {
+      distances[i - 1] = next.distance;
+    }
+  }
+
+  return found;
+}
+
+size_t hnSearch(hnIndex* index, float* query, size_t k, size_t ef, size_t* ids, float* distances) {
+  scratch work;
+  size_t  found;
+
+  if (scratchCreate(index, &work)) { return cgNone; }
+
+  found = search(index, &work, query, k, ef, ids, distances);
+  scratchNuke(&work);
+
+  return found;
+}
+
+typedef struct {
+  hnIndex* index;
+  float*   queries;
+  size_t   k;
+  size_t   ef;
+  size_t*  ids;
+  float*   distances;
+  scratch* work;
+} batchSearch;
+
+static void searchChunk(size_t from, size_t to, size_t worker, void* context) {
+  batchSearch* batch = (batchSearch*)context;
+
+  for (; from < to; from++) {
+    search(batch->index, batch->work + worker, batch->queries + from * batch->index->dimension,
+           batch->k, batch->ef, batch->ids + from * batch->k,
+           batch->distances ? batch->distances + from * batch->k : NULL);
+  }
+}
+
+void hnSearchBatch(hnIndex* index, float* queries, size_t count, size_t k, size_t ef, size_t* ids, float* distances, tpPool* pool) {
+  size_t      workers = tpWorkers(pool);
+  size_t      ready, w;
+  batchSearch batch;
+
+  batch.index     = index;
+  batch.queries   = queries;
+  batch.k         = k;
+  batch.ef        = ef;
+  batch.ids       = ids;
+  batch.distances = distances;
+  batch.work      = malloc(sizeof(scratch) * workers);
+
+  for (ready = 0; batch.work && ready < workers; ready++) {
+    if (scratchCreate(index, batch.work + ready)) { break; }
+  }
+
+  if (batch.work && ready == workers) {
+    tpFor(pool, count, 8, &searchChunk, &batch);
+  } else {
+    /* Memory allocation failure :P */
+    for (w = 0; w < count * k; w++) {
+      ids[w] = cgNone;
+    }
+  }
+
+  for (w = 0; batch.work && w < ready; w++) {
+    scratchNuke(batch.work + w);
+  }
+  free(batch.work);
+}
+
+size_t hnSize(hnIndex* index) {
+  return atomic_load(&index->size);
+}
+
+float* hnVector(hnIndex* index, size_t id) {
+  size_t claimed = atomic_load(&index->claimed);
+
+  return id < claimed && id < index->capacity && ((unsigned char*)shGet(&index->live))[id] ? vectorOf(index, id) : NULL;
+}
+
+void hnNuke(shRegion* region, hnIndex* index) {
+  if (index) {
+    shPointer* upper   = shGet(&index->upper);
+    size_t     claimed = atomic_load(&index->claimed), id;
+
+    for (id = 0; id < claimed && id < index->capacity; id++) {
+      shFree(region, shGet(upper + id));
+    }
+
+    shFree(region, shGet(&index->vectors));
+    shFree(region, shGet(&index->base));
+    shFree(region, upper);
+    shFree(region, shGet(&index->lock));
+    shFree(region, shGet(&index->live));
+    shFree(region, index);
+  }
+}
@@ -0,0 +1,215 @@
+/**
+  @file       hnsw.h
+  @brief      Hierarchical navigable small world index header file
+  @author     Christopher Harrison (Xophmeister)
+  @copyright  @ref license
+
+  Implements approximate nearest neighbour search over vectors with a
+  hierarchical navigable small world graph (Malkov and Yashunin). Each
+  vector is a node of a layered directed graph: every node is on layer
+  zero and, with exponentially decreasing probability, on the layers
+  above it, where it links to a bounded number of its near neighbours.
+  A search descends greedily through the sparse upper layers and then
+  explores layer zero best first.
+
+  The whole index lives in a shared memory region, linked with
+  self-relative pointers, so it is already persistent: an index built in
+  a named region can be searched by any other process that maps it, with
+  no loading or deserialisation; for example:
+
+  @code{.c}
+  shRegion* region = shOpen("/myIndex");
+  hnIndex*  index  = shRoot(region);
+
+  hnSearch(index, query, 10, 64, ids, distances);
+  @endcode
+
+  Vectors are stored contiguously, padded to a multiple of eight floats,
+  and distances are computed with SSE or AVX kernels where available.
+  Layer zero links are stored contiguously for all nodes, and each
+  node's upper layer links are stored contiguously together.
+*/
+
+#ifndef HNSW_H
+#define HNSW_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include "compactGraph.h"
+#include "../shared/region.h"
+#include "../parallel/threadPool.h"
+
+/**
+  @enum       hnMetric
+  @brief      Distance between vectors
+  @var        hnMetric::hnL2
+              Squared Euclidean distance
+  @var        hnMetric::hnInner
+              One minus the inner product
+  @var        hnMetric::hnCosine
+              One minus the cosine similarity (vectors are normalised on
+              insertion, so this is computed as hnInner)
+*/
+typedef enum {
+  hnL2,
+  hnInner,
+  hnCosine
+} hnMetric;
+
+/**
+  @struct     hnIndex
+  @brief      Hierarchical navigable small world index
+
+  @note       The index's structure is private to the implementation
+*/
+typedef struct hnIndex hnIndex;
+
+/**
+  @fn         size_t hnFootprint(size_t dimension, size_t links, size_t capacity)
+  @brief      Estimate the region size needed for an index
+  @param      dimension  Number of components of each vector
+  @param      links      Number of links per node on the upper layers
+  @param      capacity   Maximum number of vectors
+  @return     Number of bytes to create the region with
+
+  @note       The upper layers are random, so this allows generously for
+              them
+*/
+extern size_t hnFootprint(size_t, size_t, size_t);
+
+/**
+  @fn         hnIndex* hnCreate(shRegion* region, size_t dimension, hnMetric metric, size_t links, size_t ef, size_t capacity, uint64_t seed)
+  @brief      Create a new, empty index in a shared memory region
+  @param      region     The region to allocate from
+  @param      dimension  Number of components of each vector
+  @param      metric     The distance metric
+  @param      links      Number of links per node on the upper layers
+                         (twice as many are kept on layer zero); at least
+                         two
+  @param      ef         Size of the dynamic candidate list used when
+                         inserting; larger is slower but more accurate
+  @param      capacity   Maximum number of vectors
+  @param      seed       Seed for drawing each node's layer
+  @return     Pointer to the index; or `NULL` if the region is exhausted
+
+  @note       Make the index the region's root, with shSetRoot(), for
+              other processes to find it
+*/
+extern hnIndex* hnCreate(shRegion*, size_t, hnMetric, size_t, size_t, size_t, uint64_t);
+
+/**
+  @fn         size_t hnInsert(shRegion* region, hnIndex* index, float* vector)
+  @brief      Insert a vector into the index
+  @param      region  The region the index was created in
+  @param      index   The index
+  @param      vector  The vector, which is copied
+  @return     The vector's identifier; or cgNone if the index is full, or
+              the region is exhausted
+
+  Identifiers are allocated consecutively from zero. Once the vector is
+  linked into any layer, a later allocation failure only leaves it with
+  fewer links, and it is still inserted.
+
+  @note       A vector whose insertion fails may still have used up an
+              identifier, for which hnVector() returns `NULL`
+
+  @note       Insertion is thread safe: concurrent insertions only lock
+              the nodes whose links they are reading or updating
+*/
+extern size_t hnInsert(shRegion*, hnIndex*, float*);
+
+/**
+  @fn         size_t hnInsertBatch(shRegion* region, hnIndex* index, float* vectors, size_t count, tpPool* pool)
+  @brief      Insert many vectors into the index in parallel
+  @param      region   The region the index was created in
+  @param      index    The index
+  @param      vectors  Array of `count` vectors, contiguously
+  @param      count    Number of vectors
+  @param      pool     Thread pool to run on; or `NULL` to run serially
+  @return     Number of vectors inserted
+
+  @note       Insertions run concurrently, so identifiers are not
+              necessarily allocated in the order of the array
+*/
+extern size_t hnInsertBatch(shRegion*, hnIndex*, float*, size_t, tpPool*);
+
+/**
+  @fn         size_t hnSearch(hnIndex* index, float* query, size_t k, size_t ef, size_t* ids, float* distances)
+  @brief      Find the approximate nearest neighbours of a query vector
+  @param      index      The index
+  @param      query      The query vector
+  @param      k          Number of neighbours to find
+  @param      ef         Size of the dynamic candidate list, which is
+                         raised to `k` if smaller; larger is slower but
+                         more accurate
+  @param      ids        Array of `k` elements that will receive the
+                         neighbours' identifiers, nearest first
+  @param      distances  Array of `k` elements that will receive the
+                         neighbours' distances; or `NULL`
+  @return     Number of neighbours found, which is less than `k` only if
+              the index has fewer vectors; or cgNone in the event of an
+              allocation failure
+
+  @note       Unfound neighbours' identifiers are set to cgNone
+  @note       Searches do not lock, so must not run concurrently with
+              insertions
+*/
+extern size_t hnSearch(hnIndex*, float*, size_t, size_t, size_t*, float*);
+
+/**
+  @fn         void hnSearchBatch(hnIndex* index, float* queries, size_t count, size_t k, size_t ef, size_t* ids, float* distances, tpPool* pool)
+  @brief      Find the approximate nearest neighbours of many query vectors in parallel
+  @param      index      The index
+  @param      queries    Array of `count` query vectors, contiguously
+  @param      count      Number of queries
+  @param      k          Number of neighbours to find for each query
+  @param      ef         Size of the dynamic candidate list
+  @param      ids        Array of `count * k` elements that will receive
+                         each query's neighbours' identifiers
+  @param      distances  Array of `count * k` elements that will receive
+                         each query's neighbours' distances; or `NULL`
+  @param      pool       Thread pool to run on; or `NULL` to run serially
+
+  As hnSearch(), for each query in turn.
+*/
+extern void hnSearchBatch(hnIndex*, float*, size_t, size_t, size_t, size_t*, float*, tpPool*);
+
+/**
+  @fn         size_t hnSize(hnIndex* index)
+  @brief      Number of vectors in the index
+  @param      index  The index
+*/
+extern size_t hnSize(hnIndex*);
+
+/**
+  @fn         float* hnVector(hnIndex* index, size_t id)
+  @brief      The stored copy of a vector
+  @param      index  The index
+  @param      id     The vector's identifier
+  @return     Pointer to the vector; or `NULL` if there is no such vector,
+              or its insertion failed
+
+  @note       Cosine index vectors are stored normalised
+*/
+extern float* hnVector(hnIndex*, size_t);
+
+/**
+  @fn         float hnDistance(hnMetric metric, float* a, float* b, size_t dimension)
+  @brief      Distance between two vectors
+  @param      metric     The distance metric
+  @param      a          The first vector
+  @param      b          The second vector
+  @param      dimension  Number of components of each vector
+  @return     The distance
+*/
+extern float hnDistance(hnMetric, float*, float*, size_t);
+
+/**
+  @fn         void hnNuke(shRegion* region, hnIndex* index)
+  @brief      Free the memory allocated for the index
+  @param      region  The region the index was created in
+  @param      index   The index to free
+*/
+extern void hnNuke(shRegion*, hnIndex*);
+
+#endif
@@ -0,0 +1,241 @@
+#include <stdlib.h>
+
+#include "jumpIndex.h"
+#include "compactGraph.h"
+#include "directedGraph.h"
+#include "../indexed/dynamicArray.h"
+
+/* Lifting table for a single link index; level k maps each node to the
+   node 2^k hops away. Rows run to nodes + 1, where the extra entry is a
+   sink for routing failures, so lookups never need to branch. */
+typedef struct {
+  size_t   levels;
+  size_t** level;
+} jiTable;
+
+/* Number of levels required to resolve the given depth */
+static size_t levelsFor(size_t depth) {
+  size_t levels = 0;
+
+  while (depth) {
+    ++levels;
+    depth >>= 1;
+  }
+
+  return levels;
+}
+
+/* Single hop down a link index (the sink maps to itself) */
+static size_t successor(cgGraph* graph, size_t v, size_t link) {
+  if (v < graph->nodes) {
+    size_t e;
+
+    /* Edges are stored in ascending label order */
+    for (e = graph->offset[v]; e < graph->offset[v + 1]; e++) {
+      if (graph->label[e] == link) {
+        return graph->target[e];
+      } else if (graph->label[e] > link) {
+        break;
+      }
+    }
+  }
+
+  return graph->nodes;
+}
+
+/* Extend a table to the given number of levels */
+static int extend(cgGraph* graph, jiTable* table, size_t link, size_t levels) {
+  size_t   sink = graph->nodes;
+  size_t** level;
+
+  if (levels <= table->levels) { return 0; }
+
+  level = realloc(table->level, sizeof(size_t*) * levels);
+  if (!level) { return 1; }
+  table->level = level;
+
+  while (table->levels < levels) {
+    size_t  k   = table->levels;
+    size_t* row = malloc(sizeof(size_t) * (sink + 1));
+    size_t  v;
+
+    if (!row) { return 1; }
+
+    if (k) {
+      /* Double up the previous level */
+      size_t* half = level[k - 1];
+      for (v = 0; v <= sink; v++) {
+        row[v] = half[half[v]];
+      }
+    } else {
+      for (v = 0; v <= sink; v++) {
+        row[v] = successor(graph, v, link);
+      }
+    }
+
+    level[k] = row;
+    ++table->levels;
+  }
+
+  return 0;
+}
+
+/* Get the table for a link index, built to resolve the given depth */
+static jiTable* table(jumpIndex* index, size_t link, size_t depth) {
+  jiTable* t = NULL;
+
+  if (link < index->tables->length) {
+    t = (jiTable*)*dynElement(index->tables, link);
+  } else {
+    dynResize(index->tables, link + 1);
+    if (!index->tables->length) { return NULL; }
+  }
+
+  if (!t) {
+    t = malloc(sizeof(jiTable));
+    if (!t) { return NULL; }
+
+    t->levels = 0;
+    t->level  = NULL;
+    *dynElement(index->tables, link) = t;
+  }
+
+  if (extend(index->graph, t, link, levelsFor(depth))) {
+    return NULL;
+  }
+
+  return t;
+}
+
+/* Walk the links directly, for when the index can't help */
+static dgNode* walk(dgNode* node, size_t link, size_t depth) {
+  while (node && depth--) {
+    void** next = dynElement(node->links, link);
+    node = next ? (dgNode*)*next : NULL;
+  }
+
+  return node;
+}
+
+/* Resolve a node identifier through the table */
+static size_t jump(jiTable* t, size_t v, size_t depth) {
+  size_t k;
+
+  for (k = 0; depth; k++, depth >>= 1) {
+    if (depth & 1) {
+      v = t->level[k][v];
+    }
+  }
+
+  return v;
+}
+
+jumpIndex* jiCreate(cgGraph* graph) {
+  jumpIndex* newIndex = malloc(sizeof(jumpIndex));
+
+  if (newIndex) {
+    newIndex->graph  = graph;
+    newIndex->tables = dynCreate(0);
+
+    if (!newIndex->tables) {
+      /* Memory allocation failure :P */
+      free(newIndex);
+      newIndex = NULL;
+    }
+  }
+
+  return newIndex;
+}
+
+int jiPrepare(jumpIndex* index, size_t link, size_t depth) {
+  return table(index, link, depth) == NULL;
+}
+
+dgNode* jiTraverse(jumpIndex* index, dgNode* node, size_t link, size_t depth) {
+  size_t   v = cgFind(index->graph, node);
+  jiTable* t;
+
+  if (!depth) { return node; }
+
+  if (v != cgNone && (t = table(index, link, depth))) {
+    v = jump(t, v, depth);
+    return v < index->graph->nodes ? index->graph->node[v] : NULL;
+  } else {
+    return walk(node, link, depth);
+  }
+}
+
+dynArray* jiTraverseAll(jumpIndex* index, dynArray* nodes, size_t link, size_t depth) {
+  cgGraph*  graph    = index->graph;
+  dynArray* resolved = dynCreate(nodes->length);
+  size_t*   v;
+  jiTable*  t;
+  size_t    i, k;
+
+  if (!resolved || !nodes->length) { return resolved; }
+
+  t = depth ? table(index, link, depth) : NULL;
+  v = malloc(sizeof(size_t) * nodes->length);
+
+  if (!v || (depth && !t)) {
+    /* Fall back to one query at a time */
+    for (i = 0; i < nodes->length; i++) {
+      *dynElement(resolved, i) = jiTraverse(index, (dgNode*)*dynElement(nodes, i), link, depth);
+    }
+
+    free(v);
+    return resolved;
+  }
+
+  for (i = 0; i < nodes->length; i++) {
+    v[i] = cgFind(graph, (dgNode*)*dynElement(nodes, i));
+  }
+
+  /* Sweep the batch through one level at a time */
+  for (k = 0; depth >> k; k++) {
+    if ((depth >> k) & 1) {
+      size_t* row = t->level[k];
+
+      for (i = 0; i < nodes->length; i++) {
+        if (v[i] != cgNone) {
+          v[i] = row[v[i]];
+        }
+      }
+    }
+  }
+
+  for (i = 0; i < nodes->length; i++) {
+    dgNode* node = (dgNode*)*dynElement(nodes, i);
+
+    if (v[i] == cgNone) {
+      *dynElement(resolved, i) = depth ? walk(node, link, depth) : node;
+    } else if (v[i] < graph->nodes) {
+      *dynElement(resolved, i) = graph->node[v[i]];
+    }
+  }
+
+  free(v);
+  return resolved;
+}
+
+static int nukeTable(void** t, size_t i, dynArray* tables) {
+  if (*t) {
+    jiTable* table = (jiTable*)*t;
+
+    while (table->levels--) {
+      free(table->level[table->levels]);
+    }
+
+    free(table->level);
+    free(table);
+  }
+  return 0;
+}
+
+void jiNuke(jumpIndex* index) {
+  if (index) {
+    dynForEach(index->tables, &nukeTable);
+    dynNuke(index->tables);
+    free(index);
+  }
+}
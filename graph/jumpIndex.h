@@ -0,0 +1,125 @@
+/**
+  @file       jumpIndex.h
+  @brief      Jump pointer index header file
+  @author     Christopher Harrison (Xophmeister)
+  @copyright  @ref license
+
+  Implements an optional binary lifting (jump pointer) index over a
+  compact graph, so that deep homogeneous traversals down a fixed link
+  index (i.e., dgTraverse()) resolve in logarithmic, rather than
+  linear, time.
+
+  For each link index that is queried, a table is built lazily whose
+  `k`th level maps every node to the node `2^k` hops down that index. A
+  traversal of depth `d` then only needs one lookup per set bit of `d`.
+*/
+
+#ifndef JUMPINDEX_H
+#define JUMPINDEX_H
+
+#include <stdlib.h>
+#include "directedGraph.h"
+#include "compactGraph.h"
+#include "../indexed/dynamicArray.h"
+
+/**
+  @struct     jumpIndex
+  @brief      Jump pointer index
+  @var        jumpIndex::graph
+              The compact graph being indexed
+  @var        jumpIndex::tables
+              Dynamic array of lifting tables, by link index; tables
+              for link indices that have not yet been queried are `NULL`
+
+  @note       The tables' structure is private to the implementation
+*/
+typedef struct {
+  cgGraph*  graph;
+  dynArray* tables;
+} jumpIndex;
+
+/**
+  @fn         jumpIndex* jiCreate(cgGraph* graph)
+  @brief      Create a new, empty jump pointer index over a compact graph
+  @param      graph  The compact graph to index
+  @return     Pointer to the newly created index; or `NULL` in the event
+              of an allocation failure
+
+  Create a jump pointer index over the given compact graph. No tables
+  are built until they are first needed, so only the link indices that
+  are actually queried will cost any memory.
+
+  @note       The compact graph must outlive the index
+*/
+extern jumpIndex* jiCreate(cgGraph*);
+
+/**
+  @fn         int jiPrepare(jumpIndex* index, size_t link, size_t depth)
+  @brief      Eagerly build the table for a link index
+  @param      index  The jump pointer index
+  @param      link   The link index to build
+  @param      depth  The greatest depth expected to be queried
+  @return     Zero on success; non-zero in the event of an allocation
+              failure
+
+  Build (or extend) the lifting table for a given link index, such that
+  any traversal up to the given depth can be resolved without further
+  construction. This is useful for warming up "hot" link indices ahead
+  of time.
+
+  @note       A table with `L` levels costs `L * (nodes + 1)` words and
+              resolves any depth below `2^L`
+*/
+extern int jiPrepare(jumpIndex*, size_t, size_t);
+
+/**
+  @fn         dgNode* jiTraverse(jumpIndex* index, dgNode* node, size_t link, size_t depth)
+  @brief      Traverse the graph a given depth down a specified link index from the starting node
+  @param      index  The jump pointer index
+  @param      node   The starting node
+  @param      link   The link index to traverse
+  @param      depth  The distance to traverse from the starting node
+  @return     Pointer to the resolved node; or `NULL` in the event of a
+              routing failure
+
+  Equivalent to dgTraverse(), but resolved in `O(log depth)` using the
+  lifting table for the given link index, which is built (or extended)
+  on demand.
+
+  @note       If the starting node is not part of the indexed graph, or
+              the table cannot be built, this falls back to walking the
+              links directly
+*/
+extern dgNode* jiTraverse(jumpIndex*, dgNode*, size_t, size_t);
+
+/**
+  @fn         dynArray* jiTraverseAll(jumpIndex* index, dynArray* nodes, size_t link, size_t depth)
+  @brief      Traverse the graph from a batch of starting nodes
+  @param      index  The jump pointer index
+  @param      nodes  Dynamic array of starting nodes
+  @param      link   The link index to traverse
+  @param      depth  The distance to traverse from each starting node
+  @return     Pointer to a dynamic array of resolved nodes, positionally
+              matching the starting nodes; or `NULL` in the event of an
+              allocation failure
+
+  Batched equivalent of jiTraverse(). The whole batch is advanced one
+  table level at a time, so each level is only swept once rather than
+  once per query, which is considerably friendlier to the cache.
+
+  @note       Elements of the result are `NULL` where routing failed
+*/
+extern dynArray* jiTraverseAll(jumpIndex*, dynArray*, size_t, size_t);
+
+/**
+  @fn         void jiNuke(jumpIndex* index)
+  @brief      Free the memory allocated by the jump pointer index
+  @param      index  The jump pointer index to free
+
+  Free the memory allocated by the jump pointer index and its tables.
+
+  @note       The compact graph will not be freed
+*/
+extern void jiNuke(jumpIndex*);
+
+#endif
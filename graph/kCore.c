@@ -0,0 +1,292 @@
+#include <stdlib.h>
+#include <stdatomic.h>
+
+#include "kCore.h"
+#include "compactGraph.h"
+#include "../parallel/threadPool.h"
+
+/* The neighbourhood used for peeling: the rows of one or two graphs */
+typedef struct {
+  cgGraph* graph;
+  cgGraph* out;
+  cgGraph* in;
+} kcView;
+
+static int view(cgGraph* graph, kcDegree degree, kcView* v) {
+  v->graph = graph;
+
+  if (degree == kcUndirected) {
+    v->out = cgSymmetrise(graph);
+    v->in  = NULL;
+    return !v->out;
+  } else {
+    v->out = graph;
+    v->in  = cgTranspose(graph);
+    return !v->in;
+  }
+}
+
+static void release(kcView* v) {
+  if (v->out != v->graph) {
+    cgNuke(v->out);
+  }
+  cgNuke(v->in);
+}
+
+static size_t degreeOf(kcView* v, size_t u) {
+  size_t d = v->out->offset[u + 1] - v->out->offset[u];
+
+  if (v->in) {
+    d += v->in->offset[u + 1] - v->in->offset[u];
+  }
+
+  return d;
+}
+
+size_t* kcCores(cgGraph* graph, kcDegree degree, size_t* order) {
+  size_t  n    = graph->nodes ? graph->nodes : 1;
+  size_t* core = malloc(sizeof(size_t) * n);
+  size_t* pos  = malloc(sizeof(size_t) * n);
+  size_t* vert = order ? order : malloc(sizeof(size_t) * n);
+  size_t* bin  = NULL;
+  size_t  most = 0;
+  size_t  i, u, d;
+  kcView  v;
+
+  if (!core || !pos || !vert || view(graph, degree, &v)) {
+    /* Memory allocation failure :P */
+    free(core);
+    free(pos);
+    if (vert != order) { free(vert); }
+    return NULL;
+  }
+
+  for (u = 0; u < graph->nodes; u++) {
+    core[u] = degreeOf(&v, u);
+    if (core[u] > most) { most = core[u]; }
+  }
+
+  bin = calloc(most + 1, sizeof(size_t));
+
+  if (bin) {
+    /* Bucket sort the nodes by degree */
+    for (u = 0; u < graph->nodes; u++) {
+      ++bin[core[u]];
+    }
+
+    for (d = 0, i = 0; d <= most; d++) {
+      size_t count = bin[d];
+      bin[d] = i;
+      i     += count;
+    }
+
+    for (u = 0; u < graph->nodes; u++) {
+      pos[u]         = bin[core[u]]++;
+      vert[pos[u]]   = u;
+    }
+
+    for (d = most; d; d--) {
+      bin[d] = bin[d - 1];
+    }
+    bin[0] = 0;
+
+    /* Peel in order, keeping the remaining degrees bucket sorted */
+    for (i = 0; i < graph->nodes; i++) {
+      cgGraph* rows[2];
+      size_t   r, e;
+
+      u       = vert[i];
+      rows[0] = v.out;
+      rows[1] = v.in;
+
+      for (r = 0; r < 2 && rows[r]; r++) {
+        for (e = rows[r]->offset[u]; e < rows[r]->offset[u + 1]; e++) {
+          size_t w = rows[r]->target[e];
+
+          if (w != u && core[w] > core[u]) {
+            size_t dw    = core[w];
+            size_t first = bin[dw];
+            size_t x     = vert[first];
+
+            /* Swap w to the front of its bucket and shrink the bucket */
+            if (x != w) {
+              vert[pos[w]] = x;
+              pos[x]       = pos[w];
+              vert[first]  = w;
+              pos[w]       = first;
+            }
+
+            ++bin[dw];
+            --core[w];
+          }
+        }
+      }
+    }
+  }
+
+  release(&v);
+  free(pos);
+  if (vert != order) { free(vert); }
+
+  if (!bin) {
+    free(core);
+    return NULL;
+  }
+
+  free(bin);
+  return core;
+}
+
+/* Shared state for the level synchronous peel */
+typedef struct {
+  kcView*        view;
+  atomic_size_t* degree;
+  size_t*        core;
+  size_t         level;
+  size_t*        frontier;
+  size_t*        next;
+  atomic_size_t  tail;
+  size_t*        least;
+} kcPeel;
+
+/* Gather the remaining nodes of degree at most the current level,
+   noting the least degree of those that remain */
+static void scan(size_t from, size_t to, size_t worker, void* context) {
+  kcPeel* job   = (kcPeel*)context;
+  size_t  least = job->least[worker];
+  size_t  u;
+
+  for (u = from; u < to; u++) {
+    if (job->core[u] == cgNone) {
+      size_t d = atomic_load_explicit(job->degree + u, memory_order_relaxed);
+
+      if (d <= job->level) {
+        job->core[u] = job->level;
+        job->next[atomic_fetch_add(&job->tail, 1)] = u;
+      } else if (d < least) {
+        least = d;
+      }
+    }
+  }
+
+  job->least[worker] = least;
+}
+
+/* Remove the frontier, collecting neighbours that drop to the level */
+static void peel(size_t from, size_t to, size_t worker, void* context) {
+  kcPeel*  job = (kcPeel*)context;
+  cgGraph* rows[2];
+  size_t   i, r, e;
+
+  rows[0] = job->view->out;
+  rows[1] = job->view->in;
+
+  for (i = from; i < to; i++) {
+    size_t u = job->frontier[i];
+
+    for (r = 0; r < 2 && rows[r]; r++) {
+      for (e = rows[r]->offset[u]; e < rows[r]->offset[u + 1]; e++) {
+        size_t w = rows[r]->target[e];
+
+        /* Only the decrement that crosses the level claims the node */
+        if (w != u && atomic_fetch_sub(job->degree + w, 1) == job->level + 1) {
+          job->core[w] = job->level;
+          job->next[atomic_fetch_add(&job->tail, 1)] = w;
+        }
+      }
+    }
+  }
+}
+
+size_t* kcCoresParallel(cgGraph* graph, kcDegree degree, tpPool* pool) {
+  size_t  n       = graph->nodes ? graph->nodes : 1;
+  size_t  workers = tpWorkers(pool);
+  size_t  remaining = graph->nodes;
+  kcView  v;
+  kcPeel  job;
+  size_t  u, i;
+  int     failed;
+
+  job.degree   = malloc(sizeof(atomic_size_t) * n);
+  job.core     = malloc(sizeof(size_t) * n);
+  job.frontier = malloc(sizeof(size_t) * n);
+  job.next     = malloc(sizeof(size_t) * n);
+  job.least    = malloc(sizeof(size_t) * workers);
+  job.view     = &v;
+  job.level    = 0;
+
+  failed = !job.degree || !job.core || !job.frontier || !job.next || !job.least;
+
+  if (failed || view(graph, degree, &v)) {
+    /* Memory allocation failure :P */
+    free(job.degree);
+    free(job.core);
+    free(job.frontier);
+    free(job.next);
+    free(job.least);
+    return NULL;
+  }
+
+  for (u = 0; u < graph->nodes; u++) {
+    atomic_init(job.degree + u, degreeOf(&v, u));
+    job.core[u] = cgNone;
+  }
+
+  while (remaining) {
+    size_t least = cgNone;
+
+    for (i = 0; i < workers; i++) {
+      job.least[i] = cgNone;
+    }
+
+    atomic_store(&job.tail, 0);
+    tpFor(pool, graph->nodes, 0, &scan, &job);
+
+    if (!atomic_load(&job.tail)) {
+      /* Nothing at this level; skip ahead to the next occupied one */
+      for (i = 0; i < workers; i++) {
+        if (job.least[i] < least) { least = job.least[i]; }
+      }
+      job.level = least;
+      continue;
+    }
+
+    while ((i = atomic_load(&job.tail))) {
+      size_t* swap = job.frontier;
+
+      job.frontier = job.next;
+      job.next     = swap;
+      remaining   -= i;
+
+      atomic_store(&job.tail, 0);
+      tpFor(pool, i, 0, &peel, &job);
+    }
+
+    ++job.level;
+  }
+
+  release(&v);
+  free(job.degree);
+  free(job.frontier);
+  free(job.next);
+  free(job.least);
+
+  return job.core;
+}
+
+cgGraph* kcExtract(cgGraph* graph, size_t* core, size_t k, size_t* global) {
+  char*    keep = malloc(graph->nodes ? graph->nodes : 1);
+  cgGraph* extracted;
+  size_t   u;
+
+  if (!keep) { return NULL; }
+
+  for (u = 0; u < graph->nodes; u++) {
+    keep[u] = core[u] >= k;
+  }
+
+  extracted = cgInduce(graph, keep, global);
+
+  free(keep);
+  return extracted;
+}
@@ -0,0 +1,92 @@
+/**
+  @file       kCore.h
+  @brief      k-core decomposition header file
+  @author     Christopher Harrison (Xophmeister)
+  @copyright  @ref license
+
+  Implements k-core decomposition of compact graphs. The k-core of a
+  graph is its largest subgraph in which every node has degree at least
+  `k`; a node's core number is the largest `k` for which it belongs to
+  the k-core. Pruning everything outside a suitable k-core is a cheap
+  way to discard weakly connected nodes before expensive analysis.
+*/
+
+#ifndef KCORE_H
+#define KCORE_H
+
+#include <stdlib.h>
+#include "compactGraph.h"
+#include "../parallel/threadPool.h"
+
+/**
+  @enum       kcDegree
+  @brief      How node degree is measured
+  @var        kcDegree::kcUndirected
+              Number of distinct neighbours, ignoring link direction
+              (duplicate links and self loops are disregarded)
+  @var        kcDegree::kcInOut
+              Number of incoming plus outgoing links, counting
+              duplicates (a self loop counts twice)
+*/
+typedef enum {
+  kcUndirected,
+  kcInOut
+} kcDegree;
+
+/**
+  @fn         size_t* kcCores(cgGraph* graph, kcDegree degree, size_t* order)
+  @brief      Compute the core number of every node
+  @param      graph   The compact graph
+  @param      degree  How node degree is measured
+  @param      order   Array that will receive the node identifiers in the
+                      order they were peeled (i.e., a degeneracy
+                      ordering); or `NULL`
+  @return     Array of core numbers, by node identifier; or `NULL` in
+              the event of an allocation failure
+
+  Compute core numbers by repeatedly peeling the node of least remaining
+  degree, using bucket sorted degrees so that each step is constant
+  time; `O(V + E)` overall (Batagelj and Zaversnik).
+
+  @note       The returned array must be freed by the caller
+*/
+extern size_t* kcCores(cgGraph*, kcDegree, size_t*);
+
+/**
+  @fn         size_t* kcCoresParallel(cgGraph* graph, kcDegree degree, tpPool* pool)
+  @brief      Compute the core number of every node in parallel
+  @param      graph   The compact graph
+  @param      degree  How node degree is measured
+  @param      pool    Thread pool to run on; or `NULL` to run serially
+  @return     Array of core numbers, by node identifier; or `NULL` in
+              the event of an allocation failure
+
+  Compute the same core numbers as kcCores(), but level synchronously:
+  for each `k`, all the nodes of remaining degree at most `k` are peeled
+  at once, in parallel, updating their neighbours' degrees atomically,
+  until none remain. Empty levels are skipped.
+
+  @note       The returned array must be freed by the caller
+*/
+extern size_t* kcCoresParallel(cgGraph*, kcDegree, tpPool*);
+
+/**
+  @fn         cgGraph* kcExtract(cgGraph* graph, size_t* core, size_t k, size_t* global)
+  @brief      Extract the k-core of a compact graph
+  @param      graph   The compact graph
+  @param      core    Array of core numbers, by node identifier
+  @param      k       The core to extract
+  @param      global  Array that will receive the original identifier
+                      of each node in the k-core; or `NULL`
+  @return     Pointer to the k-core, as a new compact graph; or `NULL`
+              in the event of an allocation failure
+
+  Build the subgraph induced by the nodes with core number of at least
+  `k`, keeping the original (directed) edges between them.
+
+  @note       The global array must have room for every node in the
+              k-core; the original graph's size will always suffice
+*/
+extern cgGraph* kcExtract(cgGraph*, size_t*, size_t, size_t*);
+
+#endif
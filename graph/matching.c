@@ -0,0 +1,248 @@
+#include <stdlib.h>
+
+#include "matching.h"
+#include "compactGraph.h"
+
+/* Working state, with left nodes indexed by the graph and right nodes
+   by its transpose */
+typedef struct {
+  cgGraph* graph;
+  cgGraph* transposed;
+  size_t*  left;
+  size_t*  right;
+  size_t*  distance;
+  size_t*  cursor;
+  size_t*  stack;
+  size_t*  via;
+  size_t*  queue;
+  size_t   matched;
+} bmState;
+
+static void pair(bmState* m, size_t u, size_t v) {
+  m->left[u]  = v;
+  m->right[v] = u;
+  ++m->matched;
+}
+
+/* Greedy Karp-Sipser matching: match any node with a single remaining
+   candidate first, otherwise match arbitrarily. The queue holds left
+   nodes as themselves and right nodes offset by the node count. */
+static void karpSipser(bmState* m, size_t* leftDegree, size_t* rightDegree) {
+  cgGraph* g    = m->graph;
+  cgGraph* t    = m->transposed;
+  size_t   n    = g->nodes;
+  size_t   head = 0, tail = 0;
+  size_t   next = 0;
+  size_t   u, e;
+
+  for (u = 0; u < n; u++) {
+    leftDegree[u]  = g->offset[u + 1] - g->offset[u];
+    rightDegree[u] = t->offset[u + 1] - t->offset[u];
+
+    if (leftDegree[u] == 1)  { m->queue[tail++] = u; }
+    if (rightDegree[u] == 1) { m->queue[tail++] = n + u; }
+  }
+
+  while (1) {
+    size_t l = cgNone, r = cgNone;
+
+    if (head < tail) {
+      size_t x = m->queue[head++];
+
+      if (x < n) {
+        if (m->left[x] != cgNone) { continue; }
+        l = x;
+        for (e = g->offset[l]; e < g->offset[l + 1] && r == cgNone; e++) {
+          if (m->right[g->target[e]] == cgNone) { r = g->target[e]; }
+        }
+      } else {
+        r = x - n;
+        if (m->right[r] != cgNone) { continue; }
+        for (e = t->offset[r]; e < t->offset[r + 1] && l == cgNone; e++) {
+          if (m->left[t->target[e]] == cgNone) { l = t->target[e]; }
+        }
+      }
+
+      if (l == cgNone || r == cgNone) { continue; }
+    } else {
+      /* No forced moves left; match the next free left node greedily */
+      while (next < n && (m->left[next] != cgNone || !leftDegree[next])) { ++next; }
+      if (next == n) { break; }
+
+      l = next;
+      for (e = g->offset[l]; e < g->offset[l + 1] && r == cgNone; e++) {
+        if (m->right[g->target[e]] == cgNone) { r = g->target[e]; }
+      }
+
+      if (r == cgNone) {
+        leftDegree[l] = 0;
+        continue;
+      }
+    }
+
+    pair(m, l, r);
+
+    /* The pair's other candidates each lose an option; as degrees only
+       fall, each node is queued at most once per side */
+    for (e = g->offset[l]; e < g->offset[l + 1]; e++) {
+      size_t v = g->target[e];
+      if (m->right[v] == cgNone && rightDegree[v] && --rightDegree[v] == 1) {
+        m->queue[tail++] = n + v;
+      }
+    }
+    for (e = t->offset[r]; e < t->offset[r + 1]; e++) {
+      size_t w = t->target[e];
+      if (m->left[w] == cgNone && leftDegree[w] && --leftDegree[w] == 1) {
+        m->queue[tail++] = w;
+      }
+    }
+  }
+}
+
+/* Layer the graph from the free left nodes; returns the length of the
+   shortest augmenting paths, or cgNone if there are none */
+static size_t layer(bmState* m) {
+  cgGraph* g     = m->graph;
+  size_t   head  = 0, tail = 0;
+  size_t   limit = cgNone;
+  size_t   u, e;
+
+  for (u = 0; u < g->nodes; u++) {
+    if (m->left[u] == cgNone) {
+      m->distance[u]  = 0;
+      m->queue[tail++] = u;
+    } else {
+      m->distance[u] = cgNone;
+    }
+  }
+
+  while (head < tail) {
+    u = m->queue[head++];
+
+    /* Nothing beyond the first layer with a free right node is needed */
+    if (m->distance[u] >= limit) { continue; }
+
+    for (e = g->offset[u]; e < g->offset[u + 1]; e++) {
+      size_t w = m->right[g->target[e]];
+
+      if (w == cgNone) {
+        if (limit == cgNone) { limit = m->distance[u] + 1; }
+      } else if (m->distance[w] == cgNone) {
+        m->distance[w]   = m->distance[u] + 1;
+        m->queue[tail++] = w;
+      }
+    }
+  }
+
+  return limit;
+}
+
+/* Look for a shortest augmenting path from a free left node along the
+   layers, and flip it if one is found */
+static int augment(bmState* m, size_t root, size_t limit) {
+  cgGraph* g     = m->graph;
+  size_t   depth = 0;
+
+  m->stack[depth++] = root;
+
+  while (depth) {
+    size_t x = m->stack[depth - 1];
+
+    if (m->cursor[x] == g->offset[x + 1]) {
+      /* Dead end; don't visit it again this phase */
+      m->distance[x] = cgNone;
+      --depth;
+      continue;
+    }
+
+    {
+      size_t v = g->target[m->cursor[x]++];
+      size_t w = m->right[v];
+
+      if (w == cgNone) {
+        if (m->distance[x] + 1 == limit) {
+          size_t i;
+
+          m->via[x] = v;
+          for (i = depth; i--;) {
+            size_t y = m->stack[i];
+            m->left[y]          = m->via[y];
+            m->right[m->via[y]] = y;
+          }
+
+          ++m->matched;
+          return 1;
+        }
+      } else if (m->distance[w] != cgNone && m->distance[w] == m->distance[x] + 1) {
+        m->via[x]         = v;
+        m->stack[depth++] = w;
+      }
+    }
+  }
+
+  return 0;
+}
+
+size_t* bmMatch(cgGraph* graph, size_t* right, size_t* cardinality) {
+  size_t  n = graph->nodes ? graph->nodes : 1;
+  bmState m;
+  size_t  u;
+  int     failed;
+
+  m.graph      = graph;
+  m.matched    = 0;
+  m.transposed = cgTranspose(graph);
+  m.left       = malloc(sizeof(size_t) * n);
+  m.right      = right ? right : malloc(sizeof(size_t) * n);
+  m.distance   = malloc(sizeof(size_t) * n);
+  m.cursor     = malloc(sizeof(size_t) * n);
+  m.stack      = malloc(sizeof(size_t) * n);
+  m.via        = malloc(sizeof(size_t) * n);
+  m.queue      = malloc(sizeof(size_t) * n * 2);
+
+  failed = !m.transposed || !m.left || !m.right || !m.distance || !m.cursor || !m.stack || !m.via || !m.queue;
+
+  if (!failed) {
+    size_t limit;
+
+    for (u = 0; u < graph->nodes; u++) {
+      m.left[u]  = cgNone;
+      m.right[u] = cgNone;
+    }
+
+    /* The cursor and via arrays double as Karp-Sipser's degree counts */
+    karpSipser(&m, m.cursor, m.via);
+
+    while ((limit = layer(&m)) != cgNone) {
+      for (u = 0; u < graph->nodes; u++) {
+        m.cursor[u] = graph->offset[u];
+      }
+
+      for (u = 0; u < graph->nodes; u++) {
+        if (m.left[u] == cgNone && m.distance[u] == 0) {
+          augment(&m, u, limit);
+        }
+      }
+    }
+  }
+
+  cgNuke(m.transposed);
+  free(m.distance);
+  free(m.cursor);
+  free(m.stack);
+  free(m.via);
+  free(m.queue);
+  if (m.right != right) { free(m.right); }
+
+  if (failed) {
+    /* Memory allocation failure :P */
+    free(m.left);
+    return NULL;
+  }
+
+  if (cardinality) {
+    *cardinality = m.matched;
+  }
+
+  return m.left;
+}
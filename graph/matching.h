@@ -0,0 +1,52 @@
+/**
+  @file       matching.h
+  @brief      Bipartite matching header file
+  @author     Christopher Harrison (Xophmeister)
+  @copyright  @ref license
+
+  Implements maximum cardinality bipartite matching over compact graphs
+  (Hopcroft and Karp), seeded with a greedy Karp-Sipser matching.
+
+  The compact graph is read as a bipartite graph between "left" and
+  "right" copies of its nodes, where each edge joins its source on the
+  left to its target on the right. For a graph built from dgNodes whose
+  links only run from one side of an assignment problem (e.g., workers)
+  to the other (e.g., jobs), this is exactly that problem's bipartite
+  graph: nodes that are only ever linked to simply have no edges on the
+  left, and vice versa.
+*/
+
+#ifndef MATCHING_H
+#define MATCHING_H
+
+#include <stdlib.h>
+#include "compactGraph.h"
+
+/**
+  @fn         size_t* bmMatch(cgGraph* graph, size_t* right, size_t* cardinality)
+  @brief      Maximum cardinality bipartite matching
+  @param      graph        The compact graph
+  @param      right        Array that will receive the left mate of
+                           each node on the right, by node identifier;
+                           or `NULL`
+  @param      cardinality  Pointer to where the size of the matching
+                           will be written; or `NULL`
+  @return     Array of the right mate of each node on the left, by node
+              identifier, which is cgNone for unmatched nodes; or `NULL`
+              in the event of an allocation failure
+
+  Find a maximum matching, starting from a greedy Karp-Sipser matching
+  (which repeatedly matches nodes with only one remaining candidate, as
+  this is always safe) and then augmenting it in phases: a breadth first
+  search layers the graph from the unmatched left nodes, and a depth
+  first search then augments along a maximal set of disjoint shortest
+  paths. This takes `O(E sqrt(V))` time.
+
+  Both searches are iterative, with explicit stacks and queues, so even
+  very long augmenting paths cannot overflow the call stack.
+
+  @note       The returned array must be freed by the caller
+*/
+extern size_t* bmMatch(cgGraph*, size_t*, size_t*);
+
+#endif
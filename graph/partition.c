@@ -0,0 +1,999 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "partition.h"
+#include "compactGraph.h"
+#include "../indexed/dynamicArray.h"
+#include "../parallel/threadPool.h"
+
+/* Symmetric, weighted working graph without self loops, whose nodes
+   carry a mass (i.e., the number of original nodes they represent) */
+typedef struct {
+  size_t  nodes;
+  size_t* offset;
+  size_t* target;
+  double* weight;
+  size_t* mass;
+  size_t  total;
+} ptGraph;
+
+/* Binary max-heap entry for FM moves; stale entries are detected by
+   their stamp and skipped */
+typedef struct {
+  double gain;
+  size_t node;
+  size_t stamp;
+} ptMove;
+
+typedef struct {
+  size_t  length;
+  size_t  allocated;
+  ptMove* buffer;
+} ptHeap;
+
+static void ptgNuke(ptGraph* graph) {
+  if (graph) {
+    free(graph->offset);
+    free(graph->target);
+    free(graph->weight);
+    free(graph->mass);
+    free(graph);
+  }
+}
+
+static ptGraph* ptgCreate(size_t nodes, size_t entries) {
+  ptGraph* newGraph = malloc(sizeof(ptGraph));
+
+  if (newGraph) {
+    newGraph->nodes  = nodes;
+    newGraph->total  = 0;
+    newGraph->offset = calloc(nodes + 1, sizeof(size_t));
+    newGraph->target = malloc(sizeof(size_t) * (entries ? entries : 1));
+    newGraph->weight = malloc(sizeof(double) * (entries ? entries : 1));
+    newGraph->mass   = calloc(nodes ? nodes : 1, sizeof(size_t));
+
+    if (!newGraph->offset || !newGraph->target || !newGraph->weight || !newGraph->mass) {
+      /* Memory allocation failure :P */
+      ptgNuke(newGraph);
+      newGraph = NULL;
+    }
+  }
+
+  return newGraph;
+}
+
+/* Contraction job: merge the rows of each coarse node's members */
+typedef struct {
+  ptGraph* fine;
+  ptGraph* coarse;
+  size_t*  map;
+  size_t*  memberOffset;
+  size_t*  member;
+  size_t*  length;
+  size_t** mark;
+} ptContract;
+
+static void contractRows(size_t from, size_t to, size_t worker, void* context) {
+  ptContract* job    = (ptContract*)context;
+  ptGraph*    fine   = job->fine;
+  ptGraph*    coarse = job->coarse;
+  size_t*     mark   = job->mark[worker];
+  size_t      c;
+
+  for (c = from; c < to; c++) {
+    size_t start = coarse->offset[c];
+    size_t write = start;
+    size_t m, e;
+
+    for (m = job->memberOffset[c]; m < job->memberOffset[c + 1]; m++) {
+      size_t u = job->member[m];
+
+      for (e = fine->offset[u]; e < fine->offset[u + 1]; e++) {
+        size_t d = job->map[fine->target[e]];
+
+        if (d == c) { continue; }
+
+        if (mark[d] == cgNone) {
+          mark[d] = write;
+          coarse->target[write] = d;
+          coarse->weight[write] = fine->weight[e];
+          ++write;
+        } else {
+          coarse->weight[mark[d]] += fine->weight[e];
+        }
+      }
+    }
+
+    for (e = start; e < write; e++) {
+      mark[coarse->target[e]] = cgNone;
+    }
+
+    job->length[c] = write - start;
+  }
+}
+
+/* Contract the graph, given a dense mapping of its nodes */
+static ptGraph* contract(ptGraph* fine, size_t* map, size_t nodes, size_t** mark, tpPool* pool) {
+  ptGraph*   coarse = ptgCreate(nodes, fine->offset[fine->nodes]);
+  ptContract job;
+  size_t     u, c, write;
+
+  if (!coarse) { return NULL; }
+
+  job.fine         = fine;
+  job.coarse       = coarse;
+  job.map          = map;
+  job.mark         = mark;
+  job.memberOffset = calloc(nodes + 1, sizeof(size_t));
+  job.member       = malloc(sizeof(size_t) * (fine->nodes ? fine->nodes : 1));
+  job.length       = malloc(sizeof(size_t) * (nodes ? nodes : 1));
+
+  if (!job.memberOffset || !job.member || !job.length) {
+    free(job.memberOffset);
+    free(job.member);
+    free(job.length);
+    ptgNuke(coarse);
+    return NULL;
+  }
+
+  for (u = 0; u < fine->nodes; u++) {
+    ++job.memberOffset[map[u] + 1];
+    coarse->offset[map[u] + 1] += fine->offset[u + 1] - fine->offset[u];
+    coarse->mass[map[u]]       += fine->mass[u];
+  }
+
+  for (c = 0; c < nodes; c++) {
+    job.memberOffset[c + 1] += job.memberOffset[c];
+    coarse->offset[c + 1]   += coarse->offset[c];
+  }
+
+  for (u = 0; u < fine->nodes; u++) {
+    job.member[job.memberOffset[map[u]]++] = u;
+  }
+
+  for (c = nodes; c; c--) {
+    job.memberOffset[c] = job.memberOffset[c - 1];
+  }
+  job.memberOffset[0] = 0;
+
+  tpFor(pool, nodes, 0, &contractRows, &job);
+
+  /* Squeeze out the slack between rows */
+  for (c = 0, write = 0; c < nodes; c++) {
+    size_t start = coarse->offset[c];
+
+    memmove(coarse->target + write, coarse->target + start, sizeof(size_t) * job.length[c]);
+    memmove(coarse->weight + write, coarse->weight + start, sizeof(double) * job.length[c]);
+
+    coarse->offset[c] = write;
+    write += job.length[c];
+  }
+  coarse->offset[nodes] = write;
+  coarse->total         = fine->total;
+
+  free(job.memberOffset);
+  free(job.member);
+  free(job.length);
+
+  return coarse;
+}
+
+/* Symmetric working graph, with duplicate pairs merged */
+static ptGraph* symmetrise(cgGraph* graph, double* weight, size_t** mark, tpPool* pool) {
+  ptGraph* raw = ptgCreate(graph->nodes, graph->edges * 2);
+  ptGraph* merged;
+  size_t   u, e;
+
+  if (!raw) { return NULL; }
+
+  for (u = 0; u < graph->nodes; u++) {
+    for (e = graph->offset[u]; e < graph->offset[u + 1]; e++) {
+      if (!weight || weight[e] > 0) {
+        ++raw->offset[u + 1];
+        ++raw->offset[graph->target[e] + 1];
+      }
+    }
+  }
+
+  for (u = 0; u < graph->nodes; u++) {
+    raw->offset[u + 1] += raw->offset[u];
+    raw->mass[u] = 1;
+  }
+
+  for (u = 0; u < graph->nodes; u++) {
+    for (e = graph->offset[u]; e < graph->offset[u + 1]; e++) {
+      size_t v = graph->target[e];
+      double w = weight ? weight[e] : 1.0;
+
+      /* Non-positive weights can't contribute to the cut */
+      if (w <= 0) { continue; }
+
+      raw->target[raw->offset[u]]   = v;
+      raw->weight[raw->offset[u]++] = w;
+      raw->target[raw->offset[v]]   = u;
+      raw->weight[raw->offset[v]++] = w;
+    }
+  }
+
+  for (u = graph->nodes; u; u--) {
+    raw->offset[u] = raw->offset[u - 1];
+  }
+  raw->offset[0] = 0;
+  raw->total     = graph->nodes;
+
+  /* The identity contraction merges duplicates and drops self loops */
+  {
+    size_t* identity = malloc(sizeof(size_t) * (graph->nodes ? graph->nodes : 1));
+
+    if (!identity) { ptgNuke(raw); return NULL; }
+
+    for (u = 0; u < graph->nodes; u++) {
+      identity[u] = u;
+    }
+
+    merged = contract(raw, identity, graph->nodes, mark, pool);
+    free(identity);
+  }
+
+  ptgNuke(raw);
+  return merged;
+}
+
+/* xorshift64*, for shuffling the matching order reproducibly */
+static uint64_t nextRandom(uint64_t* state) {
+  *state ^= *state >> 12;
+  *state ^= *state << 25;
+  *state ^= *state >> 27;
+  return *state * UINT64_C(2685821657736338717);
+}
+
+/* Heavy edge matching; returns the number of coarse nodes */
+static size_t match(ptGraph* graph, size_t* map, size_t* order, size_t heaviest, uint64_t* state) {
+  size_t coarse = 0;
+  size_t i, e;
+
+  for (i = 0; i < graph->nodes; i++) {
+    size_t j = nextRandom(state) % (i + 1);
+    order[i] = order[j];
+    order[j] = i;
+    map[i]   = cgNone;
+  }
+
+  for (i = 0; i < graph->nodes; i++) {
+    size_t v    = order[i];
+    size_t mate = cgNone;
+    double best = 0;
+
+    if (map[v] != cgNone) { continue; }
+
+    for (e = graph->offset[v]; e < graph->offset[v + 1]; e++) {
+      size_t u = graph->target[e];
+
+      if (map[u] == cgNone && graph->mass[u] + graph->mass[v] <= heaviest) {
+        if (mate == cgNone || graph->weight[e] > best) {
+          mate = u;
+          best = graph->weight[e];
+        }
+      }
+    }
+
+    map[v] = coarse;
+    if (mate != cgNone) {
+      map[mate] = coarse;
+    }
+    ++coarse;
+  }
+
+  return coarse;
+}
+
+/* Greedily grow each partition breadth first from a seed node */
+static void grow(ptGraph* graph, size_t* part, size_t parts, size_t* queue, size_t first) {
+  size_t target = (graph->total + parts - 1) / parts;
+  size_t seed   = 0;
+  size_t p, v, e;
+
+  for (v = 0; v < graph->nodes; v++) {
+    part[v] = cgNone;
+  }
+
+  for (p = 0; p + 1 < parts; p++) {
+    size_t mass = 0;
+    size_t head = 0, tail = 0;
+
+    if (!p && first < graph->nodes) {
+      part[first]   = parts;
+      queue[tail++] = first;
+    }
+
+    while (mass < target) {
+      if (head == tail) {
+        /* Start again from the next unassigned node */
+        while (seed < graph->nodes && part[seed] != cgNone) { ++seed; }
+        if (seed == graph->nodes) { break; }
+        part[seed]    = parts;
+        queue[tail++] = seed;
+      }
+
+      v = queue[head++];
+      part[v] = p;
+      mass   += graph->mass[v];
+
+      for (e = graph->offset[v]; e < graph->offset[v + 1]; e++) {
+        size_t u = graph->target[e];
+
+        /* Mark queued nodes, so that nothing is queued twice */
+        if (part[u] == cgNone) {
+          part[u]       = parts;
+          queue[tail++] = u;
+        }
+      }
+    }
+
+    /* Release anything left queued */
+    while (head < tail) {
+      part[queue[head++]] = cgNone;
+    }
+  }
+
+  for (v = 0; v < graph->nodes; v++) {
+    if (part[v] == cgNone) { part[v] = parts - 1; }
+  }
+}
+
+/* Accumulate a node's connectivity to each partition */
+static size_t connect(ptGraph* graph, size_t* part, size_t v, double* conn, size_t* touched) {
+  size_t n = 0;
+  size_t e;
+
+  for (e = graph->offset[v]; e < graph->offset[v + 1]; e++) {
+    size_t p = part[graph->target[e]];
+
+    if (conn[p] == 0) { touched[n++] = p; }
+    conn[p] += graph->weight[e];
+  }
+
+  return n;
+}
+
+/* Best feasible move for a node, if it lies on the boundary */
+static size_t bestMove(ptGraph* graph, size_t* part, size_t* load, size_t limit, size_t v, double* conn, size_t* touched, double* gain) {
+  size_t own   = part[v];
+  size_t n     = connect(graph, part, v, conn, touched);
+  size_t best  = cgNone;
+  double inner = conn[own];
+  size_t i;
+
+  for (i = 0; i < n; i++) {
+    size_t p = touched[i];
+
+    if (p != own && load[p] + graph->mass[v] <= limit) {
+      double g = conn[p] - inner;
+
+      if (best == cgNone || g > *gain || (g == *gain && load[p] < load[best])) {
+        best  = p;
+        *gain = g;
+      }
+    }
+  }
+
+  for (i = 0; i < n; i++) {
+    conn[touched[i]] = 0;
+  }
+  conn[own] = 0;
+
+  return best;
+}
+
+static int push(ptHeap* heap, double gain, size_t node, size_t stamp) {
+  size_t i = heap->length++;
+
+  if (heap->length > heap->allocated) {
+    size_t  newAllocation = heap->allocated ? heap->allocated * 2 : 64;
+    ptMove* buffer        = realloc(heap->buffer, sizeof(ptMove) * newAllocation);
+
+    if (!buffer) { --heap->length; return 1; }
+
+    heap->buffer    = buffer;
+    heap->allocated = newAllocation;
+  }
+
+  while (i && heap->buffer[(i - 1) / 2].gain < gain) {
+    heap->buffer[i] = heap->buffer[(i - 1) / 2];
+    i = (i - 1) / 2;
+  }
+
+  heap->buffer[i].gain  = gain;
+  heap->buffer[i].node  = node;
+  heap->buffer[i].stamp = stamp;
+  return 0;
+}
+
+static ptMove pop(ptHeap* heap) {
+  ptMove top  = heap->buffer[0];
+  ptMove last = heap->buffer[--heap->length];
+  size_t i = 0;
+
+  while (2 * i + 1 < heap->length) {
+    size_t child = 2 * i + 1;
+
+    if (child + 1 < heap->length && heap->buffer[child + 1].gain > heap->buffer[child].gain) {
+      ++child;
+    }
+    if (heap->buffer[child].gain <= last.gain) { break; }
+
+    heap->buffer[i] = heap->buffer[child];
+    i = child;
+  }
+
+  if (heap->length) {
+    heap->buffer[i] = last;
+  }
+
+  return top;
+}
+
+/* Scratch space for refinement, sized for the finest graph */
+typedef struct {
+  size_t  parts;
+  size_t  limit;
+  size_t* load;
+  double* conn;
+  size_t* touched;
+  size_t* stamp;
+  char*   locked;
+  size_t* moved;
+  size_t* from;
+  ptHeap  heap;
+} ptRefine;
+
+/* Move nodes out of overweight partitions, as cheaply as possible */
+static void rebalance(ptGraph* graph, size_t* part, ptRefine* r) {
+  size_t p;
+
+  for (p = 0; p < r->parts; p++) {
+    while (r->load[p] > r->limit) {
+      size_t best = cgNone, to = cgNone;
+      double bestGain = 0;
+      size_t v, q;
+
+      for (v = 0; v < graph->nodes; v++) {
+        if (part[v] != p) { continue; }
+
+        for (q = 0; q < r->parts; q++) {
+          if (q != p && r->load[q] + graph->mass[v] <= r->limit) {
+            double g;
+            size_t e;
+
+            for (g = 0, e = graph->offset[v]; e < graph->offset[v + 1]; e++) {
+              if (part[graph->target[e]] == q) { g += graph->weight[e]; }
+              if (part[graph->target[e]] == p) { g -= graph->weight[e]; }
+            }
+
+            if (best == cgNone || g > bestGain) {
+              best     = v;
+              to       = q;
+              bestGain = g;
+            }
+          }
+        }
+      }
+
+      if (best == cgNone) { break; }
+
+      r->load[p]  -= graph->mass[best];
+      r->load[to] += graph->mass[best];
+      part[best]   = to;
+    }
+  }
+}
+
+/* Single FM pass; returns non-zero if the cut was improved */
+static int refinePass(ptGraph* graph, size_t* part, ptRefine* r) {
+  size_t moves = 0, bestIndex = 0, stale = 0;
+  size_t limit = 100 + graph->nodes / 100;
+  double total = 0, best = 0;
+  size_t v, e;
+
+  r->heap.length = 0;
+
+  for (v = 0; v < graph->nodes; v++) {
+    double gain;
+
+    if (bestMove(graph, part, r->load, r->limit, v, r->conn, r->touched, &gain) != cgNone) {
+      if (push(&r->heap, gain, v, r->stamp[v])) { return 0; }
+    }
+  }
+
+  while (r->heap.length) {
+    ptMove top = pop(&r->heap);
+    size_t to;
+    double gain;
+
+    v = top.node;
+    if (r->locked[v] || top.stamp != r->stamp[v]) { continue; }
+
+    to = bestMove(graph, part, r->load, r->limit, v, r->conn, r->touched, &gain);
+    if (to == cgNone) { continue; }
+
+    if (gain != top.gain) {
+      /* Loads have changed since this was queued */
+      push(&r->heap, gain, v, ++r->stamp[v]);
+      continue;
+    }
+
+    r->from[moves]     = part[v];
+    r->moved[moves++]  = v;
+    r->load[part[v]]  -= graph->mass[v];
+    r->load[to]       += graph->mass[v];
+    r->locked[v]       = 1;
+    part[v]            = to;
+    total             += gain;
+
+    if (total > best + 1e-9) {
+      best      = total;
+      bestIndex = moves;
+      stale     = 0;
+    } else if (++stale > limit) {
+      break;
+    }
+
+    for (e = graph->offset[v]; e < graph->offset[v + 1]; e++) {
+      size_t u = graph->target[e];
+
+      if (!r->locked[u]) {
+        ++r->stamp[u];
+        if (bestMove(graph, part, r->load, r->limit, u, r->conn, r->touched, &gain) != cgNone) {
+          push(&r->heap, gain, u, r->stamp[u]);
+        }
+      }
+    }
+  }
+
+  /* Roll back to the best prefix of moves */
+  while (moves > bestIndex) {
+    --moves;
+    v = r->moved[moves];
+    r->load[part[v]]       -= graph->mass[v];
+    r->load[r->from[moves]] += graph->mass[v];
+    part[v] = r->from[moves];
+  }
+
+  for (v = 0; v < graph->nodes; v++) {
+    r->locked[v] = 0;
+  }
+
+  return bestIndex > 0;
+}
+
+static void refine(ptGraph* graph, size_t* part, ptRefine* r) {
+  size_t pass, v;
+
+  for (v = 0; v < r->parts; v++) {
+    r->load[v] = 0;
+  }
+  for (v = 0; v < graph->nodes; v++) {
+    r->load[part[v]] += graph->mass[v];
+    r->stamp[v]       = 0;
+  }
+
+  rebalance(graph, part, r);
+
+  for (pass = 0; pass < 8 && refinePass(graph, part, r); pass++);
+}
+
+/* Build the shard for each partition */
+static int shard(ptPartition* partition, cgGraph* graph) {
+  size_t* local = malloc(sizeof(size_t) * (graph->nodes ? graph->nodes : 1));
+  size_t  p, v, e;
+
+  if (!local) { return 1; }
+
+  for (v = 0; v < graph->nodes; v++) {
+    local[v] = cgNone;
+  }
+
+  for (p = 0; p < partition->parts; p++) {
+    ptShard* s = partition->shard + p;
+    size_t   owned = 0, nodes, edges = 0;
+    cgGraph* g;
+
+    /* Number the owned nodes first, then the ghosts */
+    for (v = 0; v < graph->nodes; v++) {
+      if (partition->part[v] == p) {
+        local[v] = owned++;
+        edges   += graph->offset[v + 1] - graph->offset[v];
+      }
+    }
+
+    nodes = owned;
+    for (v = 0; v < graph->nodes; v++) {
+      if (partition->part[v] == p) {
+        for (e = graph->offset[v]; e < graph->offset[v + 1]; e++) {
+          if (local[graph->target[e]] == cgNone) {
+            local[graph->target[e]] = nodes++;
+          }
+        }
+      }
+    }
+
+    s->owned  = owned;
+    s->graph  = g = cgCreate(nodes, edges);
+    s->global = malloc(sizeof(size_t) * (nodes ? nodes : 1));
+
+    if (!g || !s->global) { free(local); return 1; }
+
+    for (v = 0, edges = 0; v < graph->nodes; v++) {
+      if (local[v] == cgNone) { continue; }
+
+      s->global[local[v]] = v;
+      g->node[local[v]]   = graph->node[v];
+
+      if (partition->part[v] == p) {
+        g->offset[local[v]] = edges;
+        for (e = graph->offset[v]; e < graph->offset[v + 1]; e++) {
+          g->target[edges]  = local[graph->target[e]];
+          g->label[edges++] = graph->label[e];
+        }
+      }
+    }
+
+    /* Ghost rows are empty */
+    for (v = owned; v <= nodes; v++) {
+      g->offset[v] = edges;
+    }
+
+    if (graph->lookup && cgIndex(g)) { free(local); return 1; }
+
+    for (v = 0; v < nodes; v++) {
+      local[s->global[v]] = cgNone;
+    }
+  }
+
+  free(local);
+  return 0;
+}
+
+static ptPartition* ptCreate(size_t nodes, size_t parts) {
+  ptPartition* newPartition = malloc(sizeof(ptPartition));
+
+  if (newPartition) {
+    newPartition->parts = parts;
+    newPartition->part  = malloc(sizeof(size_t) * (nodes ? nodes : 1));
+    newPartition->shard = calloc(parts, sizeof(ptShard));
+
+    if (!newPartition->part || !newPartition->shard) {
+      /* Memory allocation failure :P */
+      ptNuke(newPartition);
+      newPartition = NULL;
+    }
+  }
+
+  return newPartition;
+}
+
+static int nukeLevel(void** level, size_t i, dynArray* levels) {
+  ptgNuke((ptGraph*)*level);
+  return 0;
+}
+
+static int nukeMap(void** map, size_t i, dynArray* maps) {
+  free(*map);
+  return 0;
+}
+
+ptPartition* ptMultilevel(cgGraph* graph, double* weight, size_t parts, double imbalance, tpPool* pool) {
+  size_t       workers   = tpWorkers(pool);
+  size_t       n         = graph->nodes ? graph->nodes : 1;
+  size_t       threshold = parts * 30 > 60 ? parts * 30 : 60;
+  ptPartition* partition;
+  dynArray*    levels;
+  dynArray*    maps;
+  size_t**     mark;
+  size_t*      order;
+  size_t*      part;
+  ptGraph*     current;
+  ptRefine     r;
+  uint64_t     state = UINT64_C(0x9E3779B97F4A7C15);
+  size_t       i, v;
+  int          failed;
+
+  if (!parts) { return NULL; }
+
+  partition = ptCreate(graph->nodes, parts);
+  levels    = dynCreate(0);
+  maps      = dynCreate(0);
+  mark      = calloc(workers, sizeof(size_t*));
+  order     = malloc(sizeof(size_t) * n);
+  part      = malloc(sizeof(size_t) * n);
+
+  memset(&r, 0, sizeof(ptRefine));
+  r.parts   = parts;
+  r.load    = calloc(parts, sizeof(size_t));
+  r.conn    = calloc(parts, sizeof(double));
+  r.touched = malloc(sizeof(size_t) * parts);
+  r.stamp   = malloc(sizeof(size_t) * n);
+  r.locked  = calloc(n, sizeof(char));
+  r.moved   = malloc(sizeof(size_t) * n);
+  r.from    = malloc(sizeof(size_t) * n);
+
+  failed = !partition || !levels || !maps || !mark || !order || !part || !r.load || !r.conn || !r.touched || !r.stamp || !r.locked || !r.moved || !r.from;
+
+  for (i = 0; !failed && i < workers; i++) {
+    mark[i] = malloc(sizeof(size_t) * n);
+    if (!mark[i]) { failed = 1; break; }
+    for (v = 0; v < n; v++) {
+      mark[i][v] = cgNone;
+    }
+  }
+
+  current = failed ? NULL : symmetrise(graph, weight, mark, pool);
+  failed  = failed || !current;
+
+  if (!failed) {
+    size_t ideal    = (current->total + parts - 1) / parts;
+    size_t heaviest = (3 * current->total) / (2 * threshold);
+
+    r.limit = (size_t)(ideal * (1 + imbalance));
+    if (r.limit < ideal) { r.limit = ideal; }
+    if (heaviest < 1) { heaviest = 1; }
+
+    dynAppend(levels, current);
+
+    /* Coarsen */
+    while (current->nodes > threshold) {
+      size_t*  map = malloc(sizeof(size_t) * current->nodes);
+      ptGraph* coarse;
+      size_t   nodes;
+
+      if (!map) { failed = 1; break; }
+
+      nodes = match(current, map, order, heaviest, &state);
+
+      if (nodes * 10 > current->nodes * 9) {
+        /* Matching has stalled */
+        free(map);
+        break;
+      }
+
+      coarse = contract(current, map, nodes, mark, pool);
+      if (!coarse) { free(map); failed = 1; break; }
+
+      dynAppend(maps, map);
+      dynAppend(levels, coarse);
+      current = coarse;
+    }
+  }
+
+  if (!failed) {
+    /* Partition the coarsest graph from a few different seeds, keeping
+       the best, and project it back, refining as we go */
+    size_t* trial = malloc(sizeof(size_t) * current->nodes);
+    double  best  = -1;
+
+    for (i = 0; trial && i < 8; i++) {
+      double cut = 0;
+
+      grow(current, trial, parts, order, current->nodes ? nextRandom(&state) % current->nodes : 0);
+      refine(current, trial, &r);
+
+      for (v = 0; v < current->offset[current->nodes]; v++) {
+        cut += current->weight[v];
+      }
+      for (v = 0; v < current->nodes; v++) {
+        size_t e;
+        for (e = current->offset[v]; e < current->offset[v + 1]; e++) {
+          if (trial[v] == trial[current->target[e]]) { cut -= current->weight[e]; }
+        }
+      }
+
+      if (best < 0 || cut < best) {
+        best = cut;
+        memcpy(part, trial, sizeof(size_t) * current->nodes);
+      }
+    }
+
+    if (!trial) {
+      grow(current, part, parts, order, 0);
+      refine(current, part, &r);
+    }
+    free(trial);
+
+    for (i = levels->length - 1; i; i--) {
+      ptGraph* finer = (ptGraph*)*dynElement(levels, i - 1);
+      size_t*  map   = (size_t*)*dynElement(maps, i - 1);
+
+      for (v = 0; v < finer->nodes; v++) {
+        order[v] = part[map[v]];
+      }
+      memcpy(part, order, sizeof(size_t) * finer->nodes);
+
+      refine(finer, part, &r);
+    }
+
+    memcpy(partition->part, part, sizeof(size_t) * graph->nodes);
+    failed = shard(partition, graph);
+  }
+
+  if (levels) { dynForEach(levels, &nukeLevel); }
+  if (maps)   { dynForEach(maps, &nukeMap); }
+  dynNuke(levels);
+  dynNuke(maps);
+
+  for (i = 0; mark && i < workers; i++) {
+    free(mark[i]);
+  }
+
+  free(mark);
+  free(order);
+  free(part);
+  free(r.load);
+  free(r.conn);
+  free(r.touched);
+  free(r.stamp);
+  free(r.locked);
+  free(r.moved);
+  free(r.from);
+  free(r.heap.buffer);
+
+  if (failed) {
+    ptNuke(partition);
+    return NULL;
+  }
+
+  return partition;
+}
+
+ptPartition* ptStream(cgGraph* graph, size_t parts, double imbalance, size_t rounds) {
+  size_t       n = graph->nodes ? graph->nodes : 1;
+  ptPartition* partition;
+  ptGraph*     sym;
+  size_t*      mark = malloc(sizeof(size_t) * n);
+  size_t*      load = calloc(parts ? parts : 1, sizeof(size_t));
+  double*      conn = calloc(parts + 1, sizeof(double));
+  size_t*      touched = malloc(sizeof(size_t) * (parts + 1));
+  size_t*      part;
+  size_t       capacity, round, v, i;
+
+  if (!parts || !mark || !load || !conn || !touched) {
+    free(mark);
+    free(load);
+    free(conn);
+    free(touched);
+    return NULL;
+  }
+
+  for (v = 0; v < n; v++) {
+    mark[v] = cgNone;
+  }
+
+  partition = ptCreate(graph->nodes, parts);
+  sym       = partition ? symmetrise(graph, NULL, &mark, NULL) : NULL;
+
+  if (!sym) {
+    ptNuke(partition);
+    free(mark);
+    free(load);
+    free(conn);
+    free(touched);
+    return NULL;
+  }
+
+  part     = partition->part;
+  capacity = (size_t)((1 + imbalance) * ((graph->nodes + parts - 1) / parts));
+  if (capacity * parts < graph->nodes) { capacity = (graph->nodes + parts - 1) / parts; }
+
+  for (v = 0; v < graph->nodes; v++) {
+    part[v] = parts;
+  }
+
+  /* Linear deterministic greedy pass; unassigned neighbours are counted
+     against a phantom partition, which is never chosen */
+  for (v = 0; v < graph->nodes; v++) {
+    size_t best = 0;
+    double bestScore = 0;
+    size_t m = connect(sym, part, v, conn, touched);
+    size_t p;
+
+    /* Fall back to the least loaded partition */
+    for (p = 1; p < parts; p++) {
+      if (load[p] < load[best]) { best = p; }
+    }
+
+    for (i = 0; i < m; i++) {
+      p = touched[i];
+
+      if (p < parts && load[p] < capacity) {
+        double score = conn[p] * (1 - (double)load[p] / capacity);
+
+        if (score > bestScore || (score == bestScore && load[p] < load[best])) {
+          best      = p;
+          bestScore = score;
+        }
+      }
+    }
+
+    for (i = 0; i < m; i++) {
+      conn[touched[i]] = 0;
+    }
+
+    part[v] = best;
+    ++load[best];
+  }
+
+  /* Label propagation, subject to capacity */
+  for (round = 0; round < rounds; round++) {
+    size_t moved = 0;
+
+    for (v = 0; v < graph->nodes; v++) {
+      size_t own  = part[v];
+      size_t m    = connect(sym, part, v, conn, touched);
+      size_t best = own;
+
+      for (i = 0; i < m; i++) {
+        size_t p = touched[i];
+
+        if (p != own && load[p] < capacity && conn[p] > conn[best]) {
+          best = p;
+        }
+      }
+
+      for (i = 0; i < m; i++) {
+        conn[touched[i]] = 0;
+      }
+
+      if (best != own) {
+        --load[own];
+        ++load[best];
+        part[v] = best;
+        ++moved;
+      }
+    }
+
+    if (!moved) { break; }
+  }
+
+  ptgNuke(sym);
+  free(mark);
+  free(load);
+  free(conn);
+  free(touched);
+
+  if (shard(partition, graph)) {
+    ptNuke(partition);
+    return NULL;
+  }
+
+  return partition;
+}
+
+double ptCut(cgGraph* graph, double* weight, size_t* part) {
+  double cut = 0;
+  size_t v, e;
+
+  for (v = 0; v < graph->nodes; v++) {
+    for (e = graph->offset[v]; e < graph->offset[v + 1]; e++) {
+      if (part[v] != part[graph->target[e]]) {
+        cut += weight ? weight[e] : 1.0;
+      }
+    }
+  }
+
+  return cut;
+}
+
+void ptNuke(ptPartition* partition) {
+  if (partition) {
+    size_t p;
+
+    for (p = 0; partition->shard && p < partition->parts; p++) {
+      cgNuke(partition->shard[p].graph);
+      free(partition->shard[p].global);
+    }
+
+    free(partition->part);
+    free(partition->shard);
+    free(partition);
+  }
+}
@@ -0,0 +1,140 @@
+/**
+  @file       partition.h
+  @brief      Graph partitioning header file
+  @author     Christopher Harrison (Xophmeister)
+  @copyright  @ref license
+
+  Implements balanced k-way partitioning of compact graphs, for sharding
+  a graph across workers with as few cut edges as possible. Two
+  partitioners are provided:
+
+  - A multilevel partitioner, which coarsens the graph by heavy edge
+    matching, partitions the coarsest graph by greedy growing and then
+    projects the partition back, refining it with Fiduccia-Mattheyses
+    (FM) style moves at every level;
+
+  - A streaming partitioner, which assigns nodes in a single greedy
+    pass and then improves the result with a few rounds of capacity
+    constrained label propagation.
+
+  Both produce a partition id for every node and, for each partition, a
+  compact subgraph of the nodes it owns, together with "ghost" copies of
+  the nodes in other partitions that its nodes link to.
+
+  Links are treated as undirected when measuring the cut.
+*/
+
+#ifndef PARTITION_H
+#define PARTITION_H
+
+#include <stdlib.h>
+#include "compactGraph.h"
+#include "../parallel/threadPool.h"
+
+/**
+  @struct     ptShard
+  @brief      The subgraph belonging to a single partition
+  @var        ptShard::graph
+              Compact graph over local node identifiers; owned nodes
+              come first, followed by ghosts
+  @var        ptShard::owned
+              Number of owned nodes (i.e., ghosts have local
+              identifiers of at least this)
+  @var        ptShard::global
+              Array mapping local node identifiers to identifiers in
+              the original compact graph
+
+  @note       Only owned nodes have edges in the shard; the rows of
+              ghost nodes are empty
+*/
+typedef struct {
+  cgGraph* graph;
+  size_t   owned;
+  size_t*  global;
+} ptShard;
+
+/**
+  @struct     ptPartition
+  @brief      Partitioning of a compact graph
+  @var        ptPartition::parts
+              Number of partitions
+  @var        ptPartition::part
+              Array of partition ids, by node identifier
+  @var        ptPartition::shard
+              Array of shards, by partition id
+*/
+typedef struct {
+  size_t   parts;
+  size_t*  part;
+  ptShard* shard;
+} ptPartition;
+
+/**
+  @fn         ptPartition* ptMultilevel(cgGraph* graph, double* weight, size_t parts, double imbalance, tpPool* pool)
+  @brief      Partition a compact graph with the multilevel partitioner
+  @param      graph      The compact graph
+  @param      weight     Array of edge weights, aligned with the compact
+                         graph's edges; or `NULL` for unit weights
+  @param      parts      Number of partitions
+  @param      imbalance  Permitted imbalance, as a fraction of the
+                         ideal partition size (e.g., `0.03` allows
+                         partitions up to 3% larger than ideal)
+  @param      pool       Thread pool to run on; or `NULL` to run
+                         serially
+  @return     Pointer to the partitioning; or `NULL` in the event of an
+              allocation failure
+
+  Coarsen the graph by repeatedly contracting a heavy edge matching,
+  until it is small enough to partition directly by greedy growing, then
+  undo the contractions one level at a time, refining the partition
+  with FM passes at each level.
+
+  @note       The balance constraint is met whenever the node weights
+              allow it, but is not guaranteed for tiny graphs
+*/
+extern ptPartition* ptMultilevel(cgGraph*, double*, size_t, double, tpPool*);
+
+/**
+  @fn         ptPartition* ptStream(cgGraph* graph, size_t parts, double imbalance, size_t rounds)
+  @brief      Partition a compact graph with the streaming partitioner
+  @param      graph      The compact graph
+  @param      parts      Number of partitions
+  @param      imbalance  Permitted imbalance, as a fraction of the ideal
+                         partition size
+  @param      rounds     Number of label propagation rounds to apply
+                         after the initial pass
+  @return     Pointer to the partitioning; or `NULL` in the event of an
+              allocation failure
+
+  Assign nodes in identifier order to the partition that holds most of
+  their neighbours, penalised by how full it is (linear deterministic
+  greedy), then move nodes to the partition of most of their neighbours
+  while capacity allows.
+
+  This is much cheaper than ptMultilevel(), at the expense of a larger
+  cut.
+*/
+extern ptPartition* ptStream(cgGraph*, size_t, double, size_t);
+
+/**
+  @fn         double ptCut(cgGraph* graph, double* weight, size_t* part)
+  @brief      Weight of the edges cut by a partitioning
+  @param      graph   The compact graph
+  @param      weight  Array of edge weights, aligned with the compact
+                      graph's edges; or `NULL` for unit weights
+  @param      part    Array of partition ids, by node identifier
+  @return     Total weight of the edges whose ends lie in different
+              partitions
+*/
+extern double ptCut(cgGraph*, double*, size_t*);
+
+/**
+  @fn         void ptNuke(ptPartition* partition)
+  @brief      Free the memory allocated by the partitioning
+  @param      partition  The partitioning to free
+
+  Free the memory allocated by the partitioning, including its shards.
+*/
+extern void ptNuke(ptPartition*);
+
+#endif
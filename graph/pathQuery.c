@@ -0,0 +1,700 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+#include "pathQuery.h"
+#include "compactGraph.h"
+#include "../indexed/dynamicArray.h"
+#include "../parallel/threadPool.h"
+
+/* Symbol of an automaton edge that matches any link */
+#define rpAny ((size_t)-2)
+
+struct rpQuery {
+  size_t  states;
+  size_t  symbols;
+  size_t* literal;
+  size_t* delta;
+  char*   accept;
+};
+
+/* Thompson automaton, as it's built from the pattern: each state has at
+   most one symbol edge and two epsilon edges */
+typedef struct {
+  size_t  states;
+  size_t  allocated;
+  size_t* symbol;
+  size_t* next;
+  size_t* epsilon;
+  char*   cursor;
+  int     failed;
+} rpNfa;
+
+typedef struct {
+  size_t start;
+  size_t end;
+} rpFragment;
+
+static size_t newState(rpNfa* nfa) {
+  if (nfa->states == nfa->allocated) {
+    size_t  newAllocation = nfa->allocated * 2;
+    size_t* symbol  = realloc(nfa->symbol, sizeof(size_t) * newAllocation);
+    size_t* next    = symbol ? realloc(nfa->next, sizeof(size_t) * newAllocation) : NULL;
+    size_t* epsilon = next ? realloc(nfa->epsilon, sizeof(size_t) * 2 * newAllocation) : NULL;
+
+    if (symbol)  { nfa->symbol = symbol; }
+    if (next)    { nfa->next = next; }
+    if (epsilon) { nfa->epsilon = epsilon; }
+
+    if (!epsilon) {
+      /* Memory reallocation failed :P */
+      nfa->failed = 1;
+      return 0;
+    }
+
+    nfa->allocated = newAllocation;
+  }
+
+  nfa->symbol[nfa->states]          = cgNone;
+  nfa->next[nfa->states]            = cgNone;
+  nfa->epsilon[2 * nfa->states]     = cgNone;
+  nfa->epsilon[2 * nfa->states + 1] = cgNone;
+
+  return nfa->states++;
+}
+
+static void join(rpNfa* nfa, size_t from, size_t to) {
+  nfa->epsilon[2 * from + (nfa->epsilon[2 * from] != cgNone)] = to;
+}
+
+static char peek(rpNfa* nfa) {
+  while (*nfa->cursor == ' ' || *nfa->cursor == '\t' || *nfa->cursor == '\n') {
+    ++nfa->cursor;
+  }
+
+  return *nfa->cursor;
+}
+
+static rpFragment alternation(rpNfa* nfa);
+
+/* atom := number | '.' | '(' alternation ')' */
+static rpFragment atom(rpNfa* nfa) {
+  rpFragment f;
+  char       c = peek(nfa);
+
+  if (c == '(') {
+    ++nfa->cursor;
+    f = alternation(nfa);
+
+    if (peek(nfa) == ')') {
+      ++nfa->cursor;
+    } else {
+      nfa->failed = 1;
+    }
+
+    return f;
+  }
+
+  f.start = newState(nfa);
+  f.end   = newState(nfa);
+  nfa->next[f.start] = f.end;
+
+  if (c == '.') {
+    ++nfa->cursor;
+    nfa->symbol[f.start] = rpAny;
+  } else if (c >= '0' && c <= '9') {
+    size_t link = 0;
+
+    while (*nfa->cursor >= '0' && *nfa->cursor <= '9') {
+      size_t digit = (size_t)(*nfa->cursor++ - '0');
+
+      if (link > (rpAny - 1 - digit) / 10) {
+        /* Too large to be a link index */
+        nfa->failed = 1;
+      }
+      link = link * 10 + digit;
+    }
+
+    nfa->symbol[f.start] = link;
+  } else {
+    nfa->failed = 1;
+  }
+
+  return f;
+}
+
+/* repetition := atom ('*' | '+' | '?')* */
+static rpFragment repetition(rpNfa* nfa) {
+  rpFragment f = atom(nfa);
+  char       c;
+
+  while (!nfa->failed && ((c = peek(nfa)) == '*' || c == '+' || c == '?')) {
+    size_t start = c == '+' ? f.start : newState(nfa);
+    size_t end   = newState(nfa);
+
+    ++nfa->cursor;
+
+    if (c != '+') {
+      join(nfa, start, f.start);
+      join(nfa, start, end);
+    }
+    if (c != '?') {
+      join(nfa, f.end, f.start);
+    }
+    join(nfa, f.end, end);
+
+    f.start = start;
+    f.end   = end;
+  }
+
+  return f;
+}
+
+/* concatenation := repetition* */
+static rpFragment concatenation(rpNfa* nfa) {
+  rpFragment f;
+  char       c;
+  int        first = 1;
+
+  while (!nfa->failed && (c = peek(nfa)) != '\0' && c != '|' && c != ')') {
+    rpFragment g = repetition(nfa);
+
+    if (first) {
+      f     = g;
+      first = 0;
+    } else {
+      join(nfa, f.end, g.start);
+      f.end = g.end;
+    }
+  }
+
+  if (first) {
+    /* An empty sequence matches just the empty route */
+    f.start = f.end = newState(nfa);
+  }
+
+  return f;
+}
+
+/* alternation := concatenation ('|' concatenation)* */
+static rpFragment alternation(rpNfa* nfa) {
+  rpFragment f = concatenation(nfa);
+
+  while (!nfa->failed && peek(nfa) == '|') {
+    rpFragment g;
+    size_t     start, end;
+
+    ++nfa->cursor;
+    g     = concatenation(nfa);
+    start = newState(nfa);
+    end   = newState(nfa);
+
+    join(nfa, start, f.start);
+    join(nfa, start, g.start);
+    join(nfa, f.end, end);
+    join(nfa, g.end, end);
+
+    f.start = start;
+    f.end   = end;
+  }
+
+  return f;
+}
+
+static int compareSize(const void* a, const void* b) {
+  size_t x = *(const size_t*)a;
+  size_t y = *(const size_t*)b;
+  return (x > y) - (x < y);
+}
+
+/* Symbol class of a link index: its position amongst the pattern's
+   literals, or the number of literals for any other link */
+static size_t classOf(rpQuery* query, size_t link) {
+  size_t lo = 0, hi = query->symbols;
+
+  while (lo < hi) {
+    size_t mid = (lo + hi) / 2;
+
+    if (query->literal[mid] < link) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  return lo < query->symbols && query->literal[lo] == link ? lo : query->symbols;
+}
+
+/* Extend a set of automaton states by everything reachable by epsilon
+   edges */
+static void closure(rpNfa* nfa, uint64_t* set, size_t* stack) {
+  size_t depth = 0;
+  size_t s, i;
+
+  for (s = 0; s < nfa->states; s++) {
+    if (set[s / 64] >> (s % 64) & 1) {
+      stack[depth++] = s;
+    }
+  }
+
+  while (depth) {
+    s = stack[--depth];
+
+    for (i = 0; i < 2; i++) {
+      size_t t = nfa->epsilon[2 * s + i];
+
+      if (t != cgNone && !(set[t / 64] >> (t % 64) & 1)) {
+        set[t / 64] |= (uint64_t)1 << (t % 64);
+        stack[depth++] = t;
+      }
+    }
+  }
+}
+
+/* Determinise the automaton by subset construction */
+static int determinise(rpQuery* query, rpNfa* nfa, rpFragment f) {
+  size_t    words   = (nfa->states + 63) / 64;
+  size_t    classes = query->symbols + 1;
+  size_t    allocated = 8;
+  uint64_t* sets    = calloc(allocated * words, sizeof(uint64_t));
+  size_t*   sclass  = malloc(sizeof(size_t) * nfa->states);
+  size_t*   stack   = malloc(sizeof(size_t) * nfa->states);
+  size_t    q, c, s;
+  int       failed;
+
+  query->delta  = malloc(sizeof(size_t) * allocated * classes);
+  query->accept = malloc(allocated);
+  query->states = 1;
+
+  failed = !sets || !sclass || !stack || !query->delta || !query->accept;
+
+  if (!failed) {
+    for (s = 0; s < nfa->states; s++) {
+      sclass[s] = nfa->symbol[s] == cgNone || nfa->symbol[s] == rpAny ? nfa->symbol[s] : classOf(query, nfa->symbol[s]);
+    }
+
+    sets[f.start / 64] |= (uint64_t)1 << (f.start % 64);
+    closure(nfa, sets, stack);
+  }
+
+  for (q = 0; !failed && q < query->states; q++) {
+    query->accept[q] = sets[q * words + f.end / 64] >> (f.end % 64) & 1;
+
+    for (c = 0; !failed && c < classes; c++) {
+      uint64_t* moved;
+      size_t    r;
+      int       empty = 1;
+
+      if (query->states == allocated) {
+        size_t    newAllocation = allocated * 2;
+        uint64_t* newSets   = realloc(sets, sizeof(uint64_t) * newAllocation * words);
+        size_t*   newDelta  = newSets ? realloc(query->delta, sizeof(size_t) * newAllocation * classes) : NULL;
+        char*     newAccept = newDelta ? realloc(query->accept, newAllocation) : NULL;
+
+        if (newSets)   { sets = newSets; }
+        if (newDelta)  { query->delta = newDelta; }
+        if (newAccept) { query->accept = newAccept; }
+
+        if (!newAccept) {
+          failed = 1;
+          break;
+        }
+
+        allocated = newAllocation;
+      }
+
+      /* Build the candidate state in the next free slot */
+      moved = sets + query->states * words;
+      memset(moved, 0, sizeof(uint64_t) * words);
+
+      for (s = 0; s < nfa->states; s++) {
+        if ((sets[q * words + s / 64] >> (s % 64) & 1) && (sclass[s] == rpAny || sclass[s] == c)) {
+          moved[nfa->next[s] / 64] |= (uint64_t)1 << (nfa->next[s] % 64);
+          empty = 0;
+        }
+      }
+
+      if (empty) {
+        query->delta[q * classes + c] = cgNone;
+        continue;
+      }
+
+      closure(nfa, moved, stack);
+
+      for (r = 0; r < query->states; r++) {
+        if (!memcmp(sets + r * words, moved, sizeof(uint64_t) * words)) { break; }
+      }
+
+      query->delta[q * classes + c] = r;
+      if (r == query->states) {
+        ++query->states;
+      }
+    }
+  }
+
+  free(sets);
+  free(sclass);
+  free(stack);
+
+  return failed;
+}
+
+/* Cut transitions into states from which nothing can be accepted */
+static int prune(rpQuery* query) {
+  size_t classes = query->symbols + 1;
+  char*  live    = malloc(query->states);
+  size_t q, c;
+  int    changed = 1;
+
+  if (!live) { return 1; }
+
+  memcpy(live, query->accept, query->states);
+
+  while (changed) {
+    changed = 0;
+
+    for (q = 0; q < query->states; q++) {
+      for (c = 0; !live[q] && c < classes; c++) {
+        size_t r = query->delta[q * classes + c];
+
+        if (r != cgNone && live[r]) {
+          live[q] = 1;
+          changed = 1;
+        }
+      }
+    }
+  }
+
+  for (q = 0; q < query->states * classes; q++) {
+    if (query->delta[q] != cgNone && !live[query->delta[q]]) {
+      query->delta[q] = cgNone;
+    }
+  }
+
+  free(live);
+  return 0;
+}
+
+rpQuery* rpCompile(char* pattern) {
+  rpQuery*   newQuery = calloc(1, sizeof(rpQuery));
+  rpNfa      nfa;
+  rpFragment f;
+  size_t     s, k;
+  int        failed;
+
+  if (!newQuery) { return NULL; }
+
+  nfa.states    = 0;
+  nfa.allocated = 16;
+  nfa.symbol    = malloc(sizeof(size_t) * nfa.allocated);
+  nfa.next      = malloc(sizeof(size_t) * nfa.allocated);
+  nfa.epsilon   = malloc(sizeof(size_t) * 2 * nfa.allocated);
+  nfa.cursor    = pattern;
+  nfa.failed    = !nfa.symbol || !nfa.next || !nfa.epsilon;
+
+  if (!nfa.failed) {
+    f = alternation(&nfa);
+
+    /* Anything left over is an unbalanced parenthesis */
+    if (peek(&nfa) != '\0') {
+      nfa.failed = 1;
+    }
+  }
+
+  failed = nfa.failed;
+
+  if (!failed) {
+    /* The pattern's distinct link indices, sorted */
+    newQuery->literal = malloc(sizeof(size_t) * nfa.states);
+    failed = !newQuery->literal;
+
+    for (s = 0, k = 0; !failed && s < nfa.states; s++) {
+      if (nfa.symbol[s] != cgNone && nfa.symbol[s] != rpAny) {
+        newQuery->literal[k++] = nfa.symbol[s];
+      }
+    }
+
+    if (!failed) {
+      qsort(newQuery->literal, k, sizeof(size_t), &compareSize);
+
+      for (s = 0, newQuery->symbols = 0; s < k; s++) {
+        if (!s || newQuery->literal[s] != newQuery->literal[s - 1]) {
+          newQuery->literal[newQuery->symbols++] = newQuery->literal[s];
+        }
+      }
+    }
+  }
+
+  if (!failed) {
+    failed = determinise(newQuery, &nfa, f) || prune(newQuery);
+  }
+
+  free(nfa.symbol);
+  free(nfa.next);
+  free(nfa.epsilon);
+
+  if (failed) {
+    rpNuke(newQuery);
+    return NULL;
+  }
+
+  return newQuery;
+}
+
+/* Shared state for the product search */
+typedef struct {
+  rpQuery*               query;
+  cgGraph*               graph;
+  size_t*                frontier;
+  size_t*                next;
+  atomic_size_t          tail;
+  atomic_uint_least64_t* visited;
+  atomic_char*           matched;
+  atomic_size_t          count;
+  atomic_int             stop;
+  size_t                 limit;
+  size_t                 target;
+  size_t*                hit;
+  size_t*                parent;
+  size_t*                label;
+} rpSearch;
+
+/* Mark a search state as visited, returning whether it was unvisited */
+static int claim(rpSearch* job, size_t state) {
+  uint64_t bit = (uint64_t)1 << (state % 64);
+  return !(atomic_fetch_or_explicit(job->visited + state / 64, bit, memory_order_relaxed) & bit);
+}
+
+static void reached(rpSearch* job, size_t node, size_t state) {
+  if (!atomic_exchange(job->matched + node, 1)) {
+    size_t count = atomic_fetch_add(&job->count, 1) + 1;
+
+    if (job->hit) {
+      job->hit[node] = state;
+    }
+
+    if (node == job->target || (job->limit && count >= job->limit)) {
+      atomic_store(&job->stop, 1);
+    }
+  }
+}
+
+/* Expand a stretch of the frontier by one link */
+static void expand(size_t from, size_t to, size_t worker, void* context) {
+  rpSearch* job     = (rpSearch*)context;
+  rpQuery*  query   = job->query;
+  cgGraph*  graph   = job->graph;
+  size_t    n       = graph->nodes;
+  size_t    classes = query->symbols + 1;
+  size_t    i, e;
+
+  for (i = from; i < to; i++) {
+    size_t state = job->frontier[i];
+    size_t q     = state / n;
+    size_t v     = state % n;
+
+    if (atomic_load_explicit(&job->stop, memory_order_relaxed)) { return; }
+
+    for (e = graph->offset[v]; e < graph->offset[v + 1]; e++) {
+      size_t link = graph->label[e];
+      size_t r    = query->delta[q * classes + (link == cgNone ? query->symbols : classOf(query, link))];
+      size_t t, reach;
+
+      if (r == cgNone) { continue; }
+
+      t     = graph->target[e];
+      reach = r * n + t;
+
+      if (claim(job, reach)) {
+        if (job->parent) {
+          job->parent[reach] = state;
+          job->label[reach]  = link;
+        }
+
+        job->next[atomic_fetch_add_explicit(&job->tail, 1, memory_order_relaxed)] = reach;
+
+        if (query->accept[r]) {
+          reached(job, t, reach);
+        }
+      }
+    }
+  }
+}
+
+static rpResult* run(rpQuery* query, cgGraph* graph, size_t source, size_t limit, size_t target, int witness, tpPool* pool) {
+  size_t    n      = graph->nodes ? graph->nodes : 1;
+  size_t    total  = query->states * n;
+  rpResult* result = calloc(1, sizeof(rpResult));
+  rpSearch  job;
+  size_t    i, size;
+  int       failed;
+
+  job.query    = query;
+  job.graph    = graph;
+  job.limit    = limit;
+  job.target   = target;
+  job.frontier = malloc(sizeof(size_t) * total);
+  job.next     = malloc(sizeof(size_t) * total);
+  job.visited  = malloc(sizeof(atomic_uint_least64_t) * ((total + 63) / 64));
+  job.matched  = malloc(sizeof(atomic_char) * n);
+  job.hit      = witness ? malloc(sizeof(size_t) * n) : NULL;
+  job.parent   = witness ? malloc(sizeof(size_t) * total) : NULL;
+  job.label    = witness ? malloc(sizeof(size_t) * total) : NULL;
+
+  failed = !result || !job.frontier || !job.next || !job.visited || !job.matched;
+  failed = failed || (witness && (!job.hit || !job.parent || !job.label));
+
+  if (!failed) {
+    result->match = malloc(sizeof(size_t) * n);
+    failed = !result->match;
+  }
+
+  if (!failed) {
+    for (i = 0; i < (total + 63) / 64; i++) {
+      atomic_init(job.visited + i, 0);
+    }
+    for (i = 0; i < graph->nodes; i++) {
+      atomic_init(job.matched + i, 0);
+      if (job.hit) { job.hit[i] = cgNone; }
+    }
+    atomic_init(&job.count, 0);
+    atomic_init(&job.stop, 0);
+
+    /* Start from the source in the automaton's initial state */
+    claim(&job, source);
+    if (job.parent) {
+      job.parent[source] = cgNone;
+    }
+    job.frontier[0] = source;
+    size = 1;
+
+    if (query->accept[0]) {
+      reached(&job, source, source);
+    }
+
+    while (size && !atomic_load(&job.stop)) {
+      size_t* swap;
+
+      atomic_store(&job.tail, 0);
+      tpFor(pool, size, 0, &expand, &job);
+
+      swap         = job.frontier;
+      job.frontier = job.next;
+      job.next     = swap;
+      size         = atomic_load(&job.tail);
+    }
+
+    result->nodes  = graph->nodes;
+    result->hit    = job.hit;
+    result->parent = job.parent;
+    result->label  = job.label;
+
+    for (i = 0; i < graph->nodes && (!limit || result->matches < limit); i++) {
+      if (atomic_load(job.matched + i)) {
+        result->match[result->matches++] = i;
+      }
+    }
+  }
+
+  free(job.frontier);
+  free(job.next);
+  free(job.visited);
+  free(job.matched);
+
+  if (failed) {
+    /* Memory allocation failure :P */
+    free(job.hit);
+    free(job.parent);
+    free(job.label);
+    if (result) { free(result->match); }
+    free(result);
+    return NULL;
+  }
+
+  return result;
+}
+
+rpResult* rpEvaluate(rpQuery* query, cgGraph* graph, size_t source, size_t limit, int witness, tpPool* pool) {
+  return run(query, graph, source, limit, cgNone, witness, pool);
+}
+
+int rpReaches(rpQuery* query, cgGraph* graph, size_t source, size_t target, tpPool* pool) {
+  rpResult* result = run(query, graph, source, 0, target, 0, pool);
+  size_t    i;
+  int       reaches = 0;
+
+  if (!result) { return -1; }
+
+  for (i = 0; i < result->matches && !reaches; i++) {
+    reaches = result->match[i] == target;
+  }
+
+  rpNukeResult(result);
+  return reaches;
+}
+
+dynArray* rpWitness(rpResult* result, size_t node) {
+  size_t    length = 0;
+  size_t    i;
+  size_t*   block;
+  dynArray* route;
+  size_t    state;
+
+  if (!result->hit || node >= result->nodes || result->hit[node] == cgNone) {
+    return NULL;
+  }
+
+  for (state = result->hit[node]; result->parent[state] != cgNone; state = result->parent[state]) {
+    ++length;
+  }
+
+  if (!length) {
+    return dynCreate(0);
+  }
+
+  /* The route's elements all point into one block */
+  block = malloc(sizeof(size_t) * length);
+  if (!block) { return NULL; }
+
+  for (i = length, state = result->hit[node]; i--; state = result->parent[state]) {
+    block[i] = result->label[state];
+  }
+
+  route = dynProject(block, length, sizeof(size_t));
+
+  if (!route) {
+    /* Memory allocation failure :P */
+    free(block);
+  }
+
+  return route;
+}
+
+void rpNukeRoute(dynArray* route) {
+  if (route) {
+    if (route->length) {
+      free(*dynElement(route, 0));
+    }
+    dynNuke(route);
+  }
+}
+
+void rpNukeResult(rpResult* result) {
+  if (result) {
+    free(result->match);
+    free(result->hit);
+    free(result->parent);
+    free(result->label);
+    free(result);
+  }
+}
+
+void rpNuke(rpQuery* query) {
+  if (query) {
+    free(query->literal);
+    free(query->delta);
+    free(query->accept);
+    free(query);
+  }
+}
@@ -0,0 +1,180 @@
+/**
+  @file       pathQuery.h
+  @brief      Regular path query header file
+  @author     Christopher Harrison (Xophmeister)
+  @copyright  @ref license
+
+  Implements regular path queries over compact graphs: finding every
+  node reachable from a source by a route whose sequence of link indices
+  matches a regular expression. Where dgRoute() follows exactly one
+  route, a query such as `(0|1)* 2` follows every route of any number of
+  link 0s and 1s, followed by a single link 2.
+
+  Patterns are written over link indices, as decimal numbers, with the
+  following operators (in increasing order of precedence):
+
+  - `a | b` matches either `a` or `b`;
+  - `a b` (juxtaposition) matches `a` followed by `b`;
+  - `a*`, `a+` and `a?` match zero or more, one or more, and zero or
+    one `a`s, respectively;
+  - `(a)` groups and `.` matches any single link.
+
+  Whitespace is otherwise ignored, but is needed to separate consecutive
+  link indices (i.e., `12` is link twelve, whereas `1 2` is link one
+  followed by link two). An empty pattern matches only the empty route.
+
+  Patterns are compiled to a deterministic automaton, which is run in
+  lockstep with a breadth first search of the graph; that is, a search
+  of the product of the graph and the automaton, where each (node,
+  automaton state) pair is visited at most once. The compact graph must
+  keep the link index of each edge as its label, as cgFreeze() does.
+*/
+
+#ifndef PATHQUERY_H
+#define PATHQUERY_H
+
+#include <stdlib.h>
+#include "compactGraph.h"
+#include "../indexed/dynamicArray.h"
+#include "../parallel/threadPool.h"
+
+/**
+  @struct     rpQuery
+  @brief      Compiled regular path query
+
+  @note       The query's structure is private to the implementation
+*/
+typedef struct rpQuery rpQuery;
+
+/**
+  @struct     rpResult
+  @brief      Result of a regular path query
+  @var        rpResult::matches
+              Number of nodes matched
+  @var        rpResult::match
+              Array of the matched node identifiers, ascending
+  @var        rpResult::nodes
+              Number of nodes in the queried graph
+  @var        rpResult::hit
+              Array of the search state at which each node was first
+              matched, by node identifier; or `NULL` if witness routes
+              were not requested
+  @var        rpResult::parent
+              Array of the search state from which each search state was
+              reached; or `NULL` if witness routes were not requested
+  @var        rpResult::label
+              Array of the link index by which each search state was
+              reached; or `NULL` if witness routes were not requested
+
+  @note       Search states combine a node identifier with an automaton
+              state as `state * nodes + node`. They need not be used
+              directly, as rpWitness() reconstructs routes from them.
+*/
+typedef struct {
+  size_t  matches;
+  size_t* match;
+  size_t  nodes;
+  size_t* hit;
+  size_t* parent;
+  size_t* label;
+} rpResult;
+
+/**
+  @fn         rpQuery* rpCompile(char* pattern)
+  @brief      Compile a regular path query
+  @param      pattern  The pattern, as a null terminated string
+  @return     Pointer to the compiled query; or `NULL` if the pattern is
+              malformed or in the event of an allocation failure
+
+  Parse the pattern into a nondeterministic automaton (Thompson) and
+  determinise it (by subset construction), discarding any states from
+  which no route can match. A compiled query can be evaluated any number
+  of times, over any graph, concurrently.
+*/
+extern rpQuery* rpCompile(char*);
+
+/**
+  @fn         rpResult* rpEvaluate(rpQuery* query, cgGraph* graph, size_t source, size_t limit, int witness, tpPool* pool)
+  @brief      Find the nodes reachable from a source by a matching route
+  @param      query    The compiled query
+  @param      graph    The compact graph
+  @param      source   Identifier of the node to start from
+  @param      limit    Number of matches after which to stop searching;
+                       or zero to find them all
+  @param      witness  Whether to record witness routes (see
+                       rpWitness())
+  @param      pool     Thread pool to run on; or `NULL` to run serially
+  @return     Pointer to the result; or `NULL` in the event of an
+              allocation failure
+
+  Search the product of the graph and the query's automaton, level by
+  level, expanding each level's frontier in parallel. Visited search
+  states are kept in a bitset and claimed atomically, so each is
+  expanded exactly once. With a limit, the search stops as soon as
+  enough nodes have matched and the result holds the first `limit` of
+  them by identifier; which nodes those are can then vary from run to
+  run when run in parallel.
+
+  The source itself matches if the pattern matches the empty route.
+
+  @note       Witness routes need two words of memory per search state,
+              which is the number of nodes times the number of automaton
+              states; the visited bitset needs only one bit per state
+*/
+extern rpResult* rpEvaluate(rpQuery*, cgGraph*, size_t, size_t, int, tpPool*);
+
+/**
+  @fn         int rpReaches(rpQuery* query, cgGraph* graph, size_t source, size_t target, tpPool* pool)
+  @brief      Check if a target is reachable from a source by a matching route
+  @param      query   The compiled query
+  @param      graph   The compact graph
+  @param      source  Identifier of the node to start from
+  @param      target  Identifier of the node to reach
+  @param      pool    Thread pool to run on; or `NULL` to run serially
+  @return     Whether the target is reachable; or `-1` in the event of
+              an allocation failure
+
+  Search as rpEvaluate() does, but stop as soon as the target matches.
+*/
+extern int rpReaches(rpQuery*, cgGraph*, size_t, size_t, tpPool*);
+
+/**
+  @fn         dynArray* rpWitness(rpResult* result, size_t node)
+  @brief      A matching route to a matched node
+  @param      result  The result, evaluated with witness routes
+  @param      node    Identifier of the matched node
+  @return     Pointer to a dynamic array of link indices, in the format
+              taken by dgRoute(); or `NULL` if the node was not matched,
+              witness routes were not recorded, or in the event of an
+              allocation failure
+
+  Reconstruct a matching route from the query's source to the given
+  node, which is one of the shortest such routes. Following it from the
+  source node with dgRoute() will arrive at the matched node.
+
+  @note       The route must be freed with rpNukeRoute()
+*/
+extern dynArray* rpWitness(rpResult*, size_t);
+
+/**
+  @fn         void rpNukeRoute(dynArray* route)
+  @brief      Free a witness route
+  @param      route  The route
+*/
+extern void rpNukeRoute(dynArray*);
+
+/**
+  @fn         void rpNukeResult(rpResult* result)
+  @brief      Free a query result
+  @param      result  The result
+*/
+extern void rpNukeResult(rpResult*);
+
+/**
+  @fn         void rpNuke(rpQuery* query)
+  @brief      Free a compiled query
+  @param      query  The compiled query
+*/
+extern void rpNuke(rpQuery*);
+
+#endif
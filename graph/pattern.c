@@ -0,0 +1,439 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "pattern.h"
+#include "compactGraph.h"
+#include "../parallel/threadPool.h"
+
+typedef struct {
+  cgGraph*        graph;
+  cgGraph*        pattern;
+  int             induced;
+  size_t          k;
+  size_t*         order;     /* Pattern nodes in binding order */
+  size_t*         position;  /* Binding position, by pattern node */
+  size_t*         degree;    /* Pattern degree, by pattern node */
+  char*           joined;    /* Pattern adjacency matrix */
+  char*           less;      /* less[a * k + b] requires match[a] < match[b] */
+  pmMatchCallback callback;
+  void*           context;
+  size_t*         match;     /* Per-worker partial matches */
+  size_t*         found;     /* Per-worker match counts */
+} search;
+
+/* Automorphisms collected while preparing pmDistinct */
+typedef struct {
+  size_t  k;
+  size_t  count;
+  size_t  allocated;
+  size_t* map;
+  int     failed;
+} automorphisms;
+
+static size_t degreeOf(cgGraph* graph, size_t u) {
+  return graph->offset[u + 1] - graph->offset[u];
+}
+
+/* Index of the first element of a sorted row not less than value */
+static size_t lowerBound(size_t* row, size_t length, size_t value) {
+  size_t lo = 0, hi = length;
+
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+
+    if (row[mid] < value) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  return lo;
+}
+
+/* Whether u and v are joined, searching the shorter of their rows */
+static int adjacent(cgGraph* graph, size_t u, size_t v) {
+  size_t  length, at;
+  size_t* row;
+
+  if (degreeOf(graph, v) < degreeOf(graph, u)) {
+    size_t swap = u;
+    u = v;
+    v = swap;
+  }
+
+  row    = graph->target + graph->offset[u];
+  length = degreeOf(graph, u);
+
+  at     = lowerBound(row, length, v);
+
+  return at < length && row[at] == v;
+}
+
+/* Whether v can be bound to pattern node u, given the shorter row it came from */
+static int feasible(search* s, size_t* match, size_t depth, size_t u, size_t v, size_t from) {
+  size_t i;
+
+  if (degreeOf(s->graph, v) < s->degree[u]) { return 0; }
+
+  for (i = 0; i < depth; i++) {
+    size_t w = s->order[i];
+
+    if (match[w] == v) { return 0; }
+
+    if (s->joined[u * s->k + w]) {
+      if (match[w] != from && !adjacent(s->graph, v, match[w])) { return 0; }
+    } else if (s->induced && adjacent(s->graph, v, match[w])) {
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+/* Bind the pattern node at the given depth and recurse */
+static size_t extend(search* s, size_t* match, size_t depth, size_t worker) {
+  cgGraph* graph = s->graph;
+  cgGraph* pattern = s->pattern;
+  size_t   lo = 0, hi = graph->nodes, from = cgNone, found = 0;
+  size_t   u, i, e, begin, end;
+  size_t*  row = NULL;
+
+  if (depth == s->k) {
+    if (s->callback) {
+      s->callback(match, worker, s->context);
+    }
+    return 1;
+  }
+
+  u = s->order[depth];
+
+  /* Symmetry breaking bounds the candidates' identifiers... */
+  for (i = 0; i < depth; i++) {
+    size_t w = s->order[i];
+
+    if (s->less[w * s->k + u] && match[w] + 1 > lo) { lo = match[w] + 1; }
+    if (s->less[u * s->k + w] && match[w] < hi)     { hi = match[w]; }
+  }
+
+  /* ...and they are drawn from the shortest row of a bound neighbour */
+  for (e = pattern->offset[u]; e < pattern->offset[u + 1]; e++) {
+    size_t w = pattern->target[e];
+
+    if (s->position[w] < depth && (from == cgNone || degreeOf(graph, match[w]) < degreeOf(graph, from))) {
+      from = match[w];
+    }
+  }
+
+  if (from != cgNone) {
+    row   = graph->target + graph->offset[from];
+    begin = lowerBound(row, degreeOf(graph, from), lo);
+    end   = lowerBound(row, degreeOf(graph, from), hi);
+  } else {
+    begin = lo;
+    end   = hi;
+  }
+
+  for (i = begin; i < end; i++) {
+    size_t v = row ? row[i] : i;
+
+    if (feasible(s, match, depth, u, v, from)) {
+      match[u] = v;
+      found += extend(s, match, depth + 1, worker);
+    }
+  }
+
+  return found;
+}
+
+static void matchChunk(size_t from, size_t to, size_t worker, void* context) {
+  search* s     = (search*)context;
+  size_t* match = s->match + worker * s->k;
+  size_t  u     = s->order[0];
+  size_t  found = 0;
+
+  for (; from < to; from++) {
+    if (degreeOf(s->graph, from) >= s->degree[u]) {
+      match[u] = from;
+      found += extend(s, match, 1, worker);
+    }
+  }
+
+  s->found[worker] += found;
+}
+
+/* Graph nodes that could match a pattern node, by degree; duplicate
+   edges can take the pattern node's degree past k */
+static size_t candidatesOf(search* s, size_t* candidates, size_t u) {
+  return candidates[s->degree[u] < s->k ? s->degree[u] : s->k];
+}
+
+/* Choose the binding order from candidate counts */
+static int plan(search* s) {
+  size_t  k = s->k;
+  size_t* candidates = calloc(k + 1, sizeof(size_t));
+  size_t* bound      = calloc(k, sizeof(size_t));
+  size_t  u, v, e, i;
+
+  if (!candidates || !bound) {
+    /* Memory allocation failure :P */
+    free(candidates);
+    free(bound);
+    return 1;
+  }
+
+  for (u = 0; u < k; u++) {
+    s->degree[u]   = degreeOf(s->pattern, u);
+    s->position[u] = cgNone;
+
+    for (e = s->pattern->offset[u]; e < s->pattern->offset[u + 1]; e++) {
+      s->joined[u * k + s->pattern->target[e]] = 1;
+    }
+  }
+
+  /* Number of graph nodes of at least each degree, up to k */
+  for (v = 0; v < s->graph->nodes; v++) {
+    ++candidates[degreeOf(s->graph, v) < k ? degreeOf(s->graph, v) : k];
+  }
+  for (i = k; i; i--) {
+    candidates[i - 1] += candidates[i];
+  }
+
+  for (i = 0; i < k; i++) {
+    size_t best = cgNone;
+
+    for (u = 0; u < k; u++) {
+      if (s->position[u] != cgNone) { continue; }
+
+      if (best == cgNone
+          || bound[u] > bound[best]
+          || (bound[u] == bound[best] && candidatesOf(s, candidates, u) < candidatesOf(s, candidates, best))) {
+        best = u;
+      }
+    }
+
+    s->order[i]       = best;
+    s->position[best] = i;
+
+    for (e = s->pattern->offset[best]; e < s->pattern->offset[best + 1]; e++) {
+      ++bound[s->pattern->target[e]];
+    }
+  }
+
+  free(candidates);
+  free(bound);
+  return 0;
+}
+
+static void collect(size_t* match, size_t worker, void* context) {
+  automorphisms* found = (automorphisms*)context;
+
+  if (found->failed) { return; }
+
+  if (found->count == found->allocated) {
+    size_t  allocated = found->allocated ? found->allocated * 2 : 16;
+    size_t* map       = realloc(found->map, sizeof(size_t) * found->k * allocated);
+
+    if (!map) {
+      found->failed = 1;
+      return;
+    }
+
+    found->map       = map;
+    found->allocated = allocated;
+  }
+
+  memcpy(found->map + found->count++ * found->k, match, sizeof(size_t) * found->k);
+}
+
+/* Derive symmetry breaking constraints from the pattern's automorphisms */
+static int breakSymmetry(cgGraph* pattern, char* less) {
+  automorphisms found = { pattern->nodes, 0, 0, NULL, 0 };
+  size_t        k = pattern->nodes;
+  char*         seen;
+  size_t        a, u, w, alive;
+
+  if (pmMatch(pattern, pattern, 0, &collect, &found, NULL) == cgNone || found.failed) {
+    free(found.map);
+    return 1;
+  }
+
+  if (!(seen = malloc(k))) {
+    free(found.map);
+    return 1;
+  }
+
+  for (alive = found.count;;) {
+    size_t best = cgNone, largest = 1;
+
+    /* Find the largest orbit under the remaining automorphisms */
+    for (u = 0; u < k; u++) {
+      size_t size = 0;
+
+      memset(seen, 0, k);
+      for (a = 0; a < alive; a++) {
+        w = found.map[a * k + u];
+        if (!seen[w]) {
+          seen[w] = 1;
+          ++size;
+        }
+      }
+
+      if (size > largest) {
+        best    = u;
+        largest = size;
+      }
+    }
+
+    if (best == cgNone) { break; }
+
+    /* Its representative takes the smallest identifier in its orbit... */
+    for (a = 0; a < alive; a++) {
+      w = found.map[a * k + best];
+      if (w != best) {
+        less[best * k + w] = 1;
+      }
+    }
+
+    /* ...then only automorphisms that fix it remain */
+    for (a = 0, w = 0; a < alive; a++) {
+      if (found.map[a * k + best] == best) {
+        memmove(found.map + w++ * k, found.map + a * k, sizeof(size_t) * k);
+      }
+    }
+    alive = w;
+  }
+
+  free(seen);
+  free(found.map);
+  return 0;
+}
+
+size_t pmMatch(cgGraph* graph, cgGraph* pattern, int flags, pmMatchCallback callback, void* context, tpPool* pool) {
+  size_t workers = tpWorkers(pool);
+  size_t k       = pattern->nodes;
+  size_t total   = 0, i;
+  search s;
+
+  if (!k) { return 0; }
+
+  s.graph    = graph;
+  s.pattern  = pattern;
+  s.induced  = flags & pmInduced;
+  s.k        = k;
+  s.callback = callback;
+  s.context  = context;
+  s.order    = malloc(sizeof(size_t) * k);
+  s.position = malloc(sizeof(size_t) * k);
+  s.degree   = malloc(sizeof(size_t) * k);
+  s.joined   = calloc(k * k, 1);
+  s.less     = calloc(k * k, 1);
+  s.match    = malloc(sizeof(size_t) * k * workers);
+  s.found    = calloc(workers, sizeof(size_t));
+
+  if (!s.order || !s.position || !s.degree || !s.joined || !s.less || !s.match || !s.found
+      || plan(&s)
+      || ((flags & pmDistinct) && breakSymmetry(pattern, s.less))) {
+    /* Memory allocation failure :P */
+    total = cgNone;
+  } else {
+    tpFor(pool, graph->nodes, 16, &matchChunk, &s);
+
+    for (i = 0; i < workers; i++) {
+      total += s.found[i];
+    }
+  }
+
+  free(s.order);
+  free(s.position);
+  free(s.degree);
+  free(s.joined);
+  free(s.less);
+  free(s.match);
+  free(s.found);
+
+  return total;
+}
+
+cgGraph* pmPattern(size_t nodes, size_t edges, size_t* pairs) {
+  cgGraph* directed = cgCreate(nodes, edges);
+  cgGraph* pattern;
+  size_t   u, e;
+
+  if (!directed) { return NULL; }
+
+  for (e = 0; e < edges; e++) {
+    ++directed->offset[pairs[2 * e] + 1];
+  }
+  for (u = 0; u < nodes; u++) {
+    directed->offset[u + 1] += directed->offset[u];
+  }
+  for (e = 0; e < edges; e++) {
+    directed->target[directed->offset[pairs[2 * e]]++] = pairs[2 * e + 1];
+  }
+  for (u = nodes; u; u--) {
+    directed->offset[u] = directed->offset[u - 1];
+  }
+  directed->offset[0] = 0;
+
+  pattern = cgSymmetrise(directed);
+  cgNuke(directed);
+
+  return pattern;
+}
+
+cgGraph* pmPath(size_t nodes) {
+  size_t*  pairs = malloc(sizeof(size_t) * 2 * (nodes ? nodes : 1));
+  cgGraph* pattern = NULL;
+  size_t   i;
+
+  if (pairs) {
+    for (i = 0; i + 1 < nodes; i++) {
+      pairs[2 * i]     = i;
+      pairs[2 * i + 1] = i + 1;
+    }
+
+    pattern = pmPattern(nodes, nodes ? nodes - 1 : 0, pairs);
+    free(pairs);
+  }
+
+  return pattern;
+}
+
+cgGraph* pmStar(size_t leaves) {
+  size_t*  pairs = malloc(sizeof(size_t) * 2 * (leaves ? leaves : 1));
+  cgGraph* pattern = NULL;
+  size_t   i;
+
+  if (pairs) {
+    for (i = 0; i < leaves; i++) {
+      pairs[2 * i]     = 0;
+      pairs[2 * i + 1] = i + 1;
+    }
+
+    pattern = pmPattern(leaves + 1, leaves, pairs);
+    free(pairs);
+  }
+
+  return pattern;
+}
+
+cgGraph* pmCycle(size_t nodes) {
+  size_t*  pairs;
+  cgGraph* pattern = NULL;
+  size_t   i;
+
+  if (nodes < 3) { return NULL; }
+
+  if ((pairs = malloc(sizeof(size_t) * 2 * nodes))) {
+    for (i = 0; i < nodes; i++) {
+      pairs[2 * i]     = i;
+      pairs[2 * i + 1] = (i + 1) % nodes;
+    }
+
+    pattern = pmPattern(nodes, nodes, pairs);
+    free(pairs);
+  }
+
+  return pattern;
+}
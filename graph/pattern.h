@@ -0,0 +1,151 @@
+/**
+  @file       pattern.h
+  @brief      Subgraph pattern matching header file
+  @author     Christopher Harrison (Xophmeister)
+  @copyright  @ref license
+
+  Implements subgraph matching of small patterns (e.g., paths, stars and
+  cycles) against a compact graph. Patterns are themselves compact
+  graphs, so any motif can be searched for; pmPath(), pmStar() and
+  pmCycle() build the common ones.
+
+  Matching is a worst-case optimal join (Ngo et al.'s "generic join"):
+  pattern nodes are bound one at a time, in an order derived from their
+  candidate counts, and the candidates for each are the intersection of
+  the sorted neighbour rows of its already bound neighbours, found by
+  walking the shortest row and binary searching the rest. This never
+  enumerates partial matches that cannot be extended by an edge, unlike
+  backtracking over each node's links in turn.
+
+  Both the graph and the pattern are taken to be undirected and simple;
+  that is, symmetric with sorted rows, as built by cgSymmetrise().
+*/
+
+#ifndef PATTERN_H
+#define PATTERN_H
+
+#include <stdlib.h>
+#include "compactGraph.h"
+#include "../parallel/threadPool.h"
+
+/**
+  @enum       pmFlags
+  @brief      Matching options, which may be combined with bitwise OR
+  @var        pmFlags::pmInduced
+              Only match where the graph has no edges between the
+              matched nodes other than those of the pattern (otherwise,
+              extra edges are allowed)
+  @var        pmFlags::pmDistinct
+              Report each matching subgraph once, rather than once for
+              each of the pattern's automorphisms (e.g., a triangle
+              would otherwise be matched six times)
+*/
+typedef enum {
+  pmInduced  = 1,
+  pmDistinct = 2
+} pmFlags;
+
+/**
+  @typedef    pmMatchCallback
+  @brief      Function signature for pmMatch() callbacks
+
+  The callback function for pmMatch() must have the following signature:
+
+  @code{.c}
+  void callback(size_t* match, size_t worker, void* context)
+  @endcode
+
+  That is, on each match, the callback is called with the following:
+
+  @param      match    Array of the graph node identifiers matched to
+                       each pattern node, by pattern node identifier
+  @param      worker   The identifier of the worker that found the match
+  @param      context  The context pointer given to pmMatch()
+
+  @note       The match array is reused, so must be copied if it is to
+              be kept
+  @note       As with tpFor(), the worker identifier can be used to
+              index per-worker state without any locking
+*/
+typedef void(*pmMatchCallback)(size_t*, size_t, void*);
+
+/**
+  @fn         size_t pmMatch(cgGraph* graph, cgGraph* pattern, int flags, pmMatchCallback callback, void* context, tpPool* pool)
+  @brief      Find every occurrence of a pattern in a compact graph
+  @param      graph     The compact graph
+  @param      pattern   The pattern
+  @param      flags     Combination of pmFlags; or zero
+  @param      callback  Pointer to callback function; or `NULL` to just
+                        count the matches
+  @param      context   Pointer passed through to each callback
+  @param      pool      Thread pool to run on; or `NULL` to run serially
+  @return     Number of matches; or cgNone in the event of an
+              allocation failure
+
+  Match the pattern injectively, so that distinct pattern nodes are
+  matched to distinct graph nodes and every pattern edge to a graph edge.
+
+  The first pattern node bound is the one with the fewest candidates
+  (graph nodes of at least its degree) and each subsequent node is the
+  one with the most already bound neighbours, breaking ties by fewest
+  candidates, so that intersections are as selective as possible. The
+  graph nodes matched to the first pattern node are split between the
+  workers.
+
+  With pmDistinct, the pattern's automorphisms are enumerated up front
+  and broken with ordering constraints on the matched identifiers
+  (Grochow and Kellis), so that only one of each set of equivalent
+  matches is ever explored.
+
+  @note       The pattern should be connected; any pattern node without
+              a bound neighbour is matched against every graph node
+  @note       With pmDistinct, a pattern with a very large automorphism
+              group (e.g., a star with many leaves) can take a while to
+              prepare
+*/
+extern size_t pmMatch(cgGraph*, cgGraph*, int, pmMatchCallback, void*, tpPool*);
+
+/**
+  @fn         cgGraph* pmPattern(size_t nodes, size_t edges, size_t* pairs)
+  @brief      Build a pattern from a list of edges
+  @param      nodes  Number of pattern nodes
+  @param      edges  Number of edges
+  @param      pairs  Array of `2 * edges` node identifiers, with each
+                     consecutive pair joined by an edge
+  @return     Pointer to the pattern; or `NULL` in the event of an
+              allocation failure
+
+  @note       The pattern has no underlying dgNodes, so its node array
+              is all `NULL`
+*/
+extern cgGraph* pmPattern(size_t, size_t, size_t*);
+
+/**
+  @fn         cgGraph* pmPath(size_t nodes)
+  @brief      Build a path pattern
+  @param      nodes  Number of nodes on the path
+  @return     Pointer to the pattern; or `NULL` in the event of an
+              allocation failure
+*/
+extern cgGraph* pmPath(size_t);
+
+/**
+  @fn         cgGraph* pmStar(size_t leaves)
+  @brief      Build a star pattern
+  @param      leaves  Number of leaves, each joined to the centre node
+                      (whose identifier is zero)
+  @return     Pointer to the pattern; or `NULL` in the event of an
+              allocation failure
+*/
+extern cgGraph* pmStar(size_t);
+
+/**
+  @fn         cgGraph* pmCycle(size_t nodes)
+  @brief      Build a cycle pattern
+  @param      nodes  Number of nodes on the cycle, at least three
+  @return     Pointer to the pattern; or `NULL` if there are fewer than
+              three nodes, or in the event of an allocation failure
+*/
+extern cgGraph* pmCycle(size_t);
+
+#endif
@@ -0,0 +1,180 @@
+#include <stdlib.h>
+#include <math.h>
+
+#include "shortestPath.h"
+#include "compactGraph.h"
+
+/* Distances equal to within rounding */
+static int same(double a, double b) {
+  return fabs(a - b) <= 1e-9 * (fabs(a) > 1 ? fabs(a) : 1);
+}
+
+spSearch* spCreate(size_t nodes) {
+  spSearch* newSearch = malloc(sizeof(spSearch));
+  size_t    n = nodes ? nodes : 1;
+
+  if (newSearch) {
+    newSearch->nodes    = nodes;
+    newSearch->settled  = 0;
+    newSearch->distance = malloc(sizeof(double) * n);
+    newSearch->paths    = malloc(sizeof(double) * n);
+    newSearch->parent   = malloc(sizeof(size_t) * n);
+    newSearch->order    = malloc(sizeof(size_t) * n);
+    newSearch->heap     = malloc(sizeof(size_t) * n);
+    newSearch->slot     = malloc(sizeof(size_t) * n);
+
+    if (newSearch->distance && newSearch->paths && newSearch->parent && newSearch->order && newSearch->heap && newSearch->slot) {
+      while (nodes--) {
+        newSearch->distance[nodes] = HUGE_VAL;
+        newSearch->paths[nodes]    = 0;
+        newSearch->parent[nodes]   = cgNone;
+        newSearch->slot[nodes]     = cgNone;
+      }
+    } else {
+      /* Memory allocation failure :P */
+      spNuke(newSearch);
+      newSearch = NULL;
+    }
+  }
+
+  return newSearch;
+}
+
+/* Sift a heap entry towards the root */
+static void siftUp(spSearch* search, size_t i) {
+  size_t v = search->heap[i];
+
+  while (i && search->distance[search->heap[(i - 1) / 2]] > search->distance[v]) {
+    search->heap[i] = search->heap[(i - 1) / 2];
+    search->slot[search->heap[i]] = i;
+    i = (i - 1) / 2;
+  }
+
+  search->heap[i] = v;
+  search->slot[v] = i;
+}
+
+/* Sift a heap entry towards the leaves */
+static void siftDown(spSearch* search, size_t i, size_t length) {
+  size_t v = search->heap[i];
+
+  while (2 * i + 1 < length) {
+    size_t child = 2 * i + 1;
+
+    if (child + 1 < length && search->distance[search->heap[child + 1]] < search->distance[search->heap[child]]) {
+      ++child;
+    }
+    if (search->distance[search->heap[child]] >= search->distance[v]) { break; }
+
+    search->heap[i] = search->heap[child];
+    search->slot[search->heap[i]] = i;
+    i = child;
+  }
+
+  search->heap[i] = v;
+  search->slot[v] = i;
+}
+
+static void breadthFirst(spSearch* search, cgGraph* graph) {
+  size_t head = 0;
+
+  while (head < search->settled) {
+    size_t v = search->order[head++];
+    double d = search->distance[v] + 1;
+    size_t e;
+
+    for (e = graph->offset[v]; e < graph->offset[v + 1]; e++) {
+      size_t w = graph->target[e];
+
+      if (search->distance[w] == HUGE_VAL) {
+        search->distance[w] = d;
+        search->parent[w]   = v;
+        search->order[search->settled++] = w;
+      }
+
+      if (search->distance[w] == d) {
+        search->paths[w] += search->paths[v];
+      }
+    }
+  }
+}
+
+static void dijkstra(spSearch* search, cgGraph* graph, double* weight, size_t source) {
+  size_t length = 1;
+
+  search->settled = 0;
+  search->heap[0] = source;
+  search->slot[source] = 0;
+
+  while (length) {
+    size_t v = search->heap[0];
+    size_t e;
+
+    /* Pop the nearest node and settle it */
+    search->slot[v] = cgNone;
+    if (--length) {
+      search->heap[0] = search->heap[length];
+      siftDown(search, 0, length);
+    }
+    search->order[search->settled++] = v;
+
+    for (e = graph->offset[v]; e < graph->offset[v + 1]; e++) {
+      size_t w = graph->target[e];
+      double d = search->distance[v] + weight[e];
+
+      if (search->distance[w] == HUGE_VAL) {
+        search->distance[w] = d;
+        search->paths[w]    = search->paths[v];
+        search->parent[w]   = v;
+        search->heap[length] = w;
+        siftUp(search, length++);
+      } else if (same(d, search->distance[w])) {
+        search->paths[w] += search->paths[v];
+      } else if (d < search->distance[w]) {
+        search->distance[w] = d;
+        search->paths[w]    = search->paths[v];
+        search->parent[w]   = v;
+        siftUp(search, search->slot[w]);
+      }
+    }
+  }
+}
+
+void spRun(spSearch* search, cgGraph* graph, double* weight, size_t source) {
+  size_t i;
+
+  /* Only reset what the last run touched */
+  for (i = 0; i < search->settled; i++) {
+    size_t v = search->order[i];
+    search->distance[v] = HUGE_VAL;
+    search->paths[v]    = 0;
+    search->parent[v]   = cgNone;
+  }
+
+  search->distance[source] = 0;
+  search->paths[source]    = 1;
+  search->order[0]         = source;
+  search->settled          = 1;
+
+  if (weight) {
+    dijkstra(search, graph, weight, source);
+  } else {
+    breadthFirst(search, graph);
+  }
+}
+
+int spOnPath(spSearch* search, size_t from, size_t to, double length) {
+  return search->distance[from] != HUGE_VAL && same(search->distance[from] + length, search->distance[to]);
+}
+
+void spNuke(spSearch* search) {
+  if (search) {
+    free(search->distance);
+    free(search->paths);
+    free(search->parent);
+    free(search->order);
+    free(search->heap);
+    free(search->slot);
+    free(search);
+  }
+}
@@ -0,0 +1,106 @@
+/**
+  @file       shortestPath.h
+  @brief      Single source shortest path header file
+  @author     Christopher Harrison (Xophmeister)
+  @copyright  @ref license
+
+  Implements single source shortest paths over compact graphs: breadth
+  first search for unweighted graphs and Dijkstra's algorithm (with a
+  binary heap) for weighted ones. Besides distances, each search counts
+  the number of distinct shortest paths to every node and records the
+  order in which nodes were settled, which is everything that path
+  counting algorithms (e.g., betweenness centrality) need.
+
+  A search's workspace is reusable: running it again only resets the
+  nodes the previous run reached, so many searches over a large graph
+  from sources in small components stay cheap.
+*/
+
+#ifndef SHORTESTPATH_H
+#define SHORTESTPATH_H
+
+#include <stdlib.h>
+#include "compactGraph.h"
+
+/**
+  @struct     spSearch
+  @brief      Shortest path search workspace and results
+  @var        spSearch::nodes
+              Number of nodes the workspace was created for
+  @var        spSearch::distance
+              Array of distances from the source, by node identifier;
+              `HUGE_VAL` for unreachable nodes
+  @var        spSearch::paths
+              Array of the number of shortest paths from the source, by
+              node identifier (as a double, to avoid overflow)
+  @var        spSearch::parent
+              Array of the predecessor of each node on one of its
+              shortest paths, by node identifier; cgNone for the source
+              and unreachable nodes
+  @var        spSearch::order
+              Array of the reached node identifiers, in non-decreasing
+              order of distance
+  @var        spSearch::settled
+              Number of reached nodes (i.e., the length of the order)
+  @var        spSearch::heap
+              Private heap storage
+  @var        spSearch::slot
+              Private heap positions
+*/
+typedef struct {
+  size_t  nodes;
+  double* distance;
+  double* paths;
+  size_t* parent;
+  size_t* order;
+  size_t  settled;
+  size_t* heap;
+  size_t* slot;
+} spSearch;
+
+/**
+  @fn         spSearch* spCreate(size_t nodes)
+  @brief      Create a shortest path search workspace
+  @param      nodes  Number of nodes in the graphs to be searched
+  @return     Pointer to the newly created workspace; or `NULL` in the
+              event of an allocation failure
+*/
+extern spSearch* spCreate(size_t);
+
+/**
+  @fn         void spRun(spSearch* search, cgGraph* graph, double* weight, size_t source)
+  @brief      Find the shortest paths from a source node
+  @param      search  The search workspace
+  @param      graph   The compact graph
+  @param      weight  Array of edge weights, aligned with the compact
+                      graph's edges; or `NULL` for an unweighted search
+  @param      source  The source node identifier
+
+  Find the shortest distances and path counts from the source to every
+  reachable node, following edges in their given direction.
+
+  @note       Weights must be positive; paths whose lengths are equal
+              to within a relative tolerance of `1e-9` are considered to
+              be equally short
+*/
+extern void spRun(spSearch*, cgGraph*, double*, size_t);
+
+/**
+  @fn         int spOnPath(spSearch* search, size_t from, size_t to, double length)
+  @brief      Whether an edge lies on a shortest path from the source
+  @param      search  The search workspace, after spRun()
+  @param      from    The edge's source node identifier
+  @param      to      The edge's target node identifier
+  @param      length  The edge's length (one, for an unweighted search)
+  @return     Non-zero if the edge lies on some shortest path
+*/
+extern int spOnPath(spSearch*, size_t, size_t, double);
+
+/**
+  @fn         void spNuke(spSearch* search)
+  @brief      Free the memory allocated by the search workspace
+  @param      search  The search workspace to free
+*/
+extern void spNuke(spSearch*);
+
+#endif
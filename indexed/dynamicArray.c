@@ -13,11 +13,59 @@ static void nullElements(dynArray* array, size_t from, size_t to) {
   }
 }
 
+/* Inline element storage, which directly follows the header */
+static void** inlineBuffer(dynArray* array) {
+  return (void**)(array + 1);
+}
+
+static int isInline(dynArray* array) {
+  return array->inlined && array->buffer == inlineBuffer(array);
+}
+
+/* Free any heap buffer and return to the empty (inline) state */
+static void release(dynArray* array) {
+  if (array->buffer && !isInline(array)) {
+    free(array->buffer);
+  }
+
+  array->length    = 0;
+  array->allocated = array->inlined;
+  array->buffer    = array->inlined ? inlineBuffer(array) : NULL;
+}
+
+/* Move the elements to a heap buffer of the given allocation */
+static int reallocate(dynArray* array, size_t allocation) {
+  void** buffer;
+
+  if (isInline(array)) {
+    /* Spill out of the header, taking every slot (a gap buffer keeps
+       elements past the length) */
+    buffer = malloc(sizeof(void*) * allocation);
+
+    if (buffer) {
+      memcpy(buffer, array->buffer, sizeof(void*) * array->allocated);
+    }
+  } else {
+    buffer = realloc(array->buffer, sizeof(void*) * allocation);
+  }
+
+  if (!buffer) {
+    /* Memory (re)allocation failed :P */
+    release(array);
+    return 1;
+  }
+
+  array->buffer    = buffer;
+  array->allocated = allocation;
+  return 0;
+}
+
 dynArray* dynCreate(size_t length) {
   dynArray* newArray = malloc(sizeof(dynArray));
   
   if (newArray) {
-    newArray->length = length;
+    newArray->length  = length;
+    newArray->inlined = 0;
 
     /* Allocate data buffer */
     if (length) {
@@ -41,69 +89,61 @@ dynArray* dynCreate(size_t length) {
   return newArray;
 }
 
+dynArray* dynEmbed(void* memory, size_t length, size_t inlined) {
+  dynArray* newArray = (dynArray*)memory;
+
+  newArray->length    = 0;
+  newArray->inlined   = inlined;
+  newArray->allocated = inlined;
+  newArray->buffer    = inlined ? inlineBuffer(newArray) : NULL;
+
+  dynResize(newArray, length);
+
+  /* Memory allocation failure :P */
+  return newArray->length == length ? newArray : NULL;
+}
+
+dynArray* dynCreateInline(size_t length, size_t inlined) {
+  dynArray* newArray = malloc(dynInlineSize(inlined));
+
+  if (newArray && !dynEmbed(newArray, length, inlined)) {
+    free(newArray);
+    newArray = NULL;
+  }
+
+  return newArray;
+}
+
 void dynResize(dynArray* array, size_t length) {
   if (array) {
     if (length) {
       size_t oldLength = array->length;
-      array->length    = length;
 
-      if (length > array->allocated) {
-        if (oldLength) {
-          array->buffer = realloc(array->buffer, sizeof(void*) * length);
-        } else {
-          array->buffer = malloc(sizeof(void*) * length);
-        }
-        array->allocated = length;
+      if (length > array->allocated && reallocate(array, length)) {
+        return;
       }
+
+      array->length = length;
         
-      if (array->buffer) {
-        /* NULLify newly created space */
-        if (length > oldLength) {
-          nullElements(array, oldLength, length - 1);
-        }
-      } else {
-        /* Memory (re)allocation failed :P */
-        array->length    = 0;
-        array->allocated = 0;
+      /* NULLify newly created space */
+      if (length > oldLength) {
+        nullElements(array, oldLength, length - 1);
       }
     } else {
-      array->length    = 0;
-      array->allocated = 0;
-
-      if (array->buffer) {
-        free(array->buffer);
-      }
-      array->buffer = NULL;
+      release(array);
     }
   }
 }
 
 void dynAppend(dynArray* array, void* payload) {
-  if (array->allocated > array->length) {
-    *(array->buffer + (array->length++)) = payload;
-  } else {
-    if (array->length) {
-      /* Double buffer's allocation */
-      size_t newAllocation = array->length * 2;
-      array->buffer = realloc(array->buffer, sizeof(void*) * newAllocation);
-      if (array->buffer) {
-        *(array->buffer + (array->length++)) = payload;
-        array->allocated = newAllocation;
-      } else {
-        /* Memory reallocation failed :P */
-        array->length    = 0;
-        array->allocated = 0;
-      }
-    } else {
-      /* Create single element buffer */
-      array->buffer = malloc(sizeof(void*));
-      if (array->buffer) {
-        array->length    = 1;
-        array->allocated = 1;
-        *(array->buffer) = payload;
-      }
+  if (array->allocated == array->length) {
+    /* Double buffer's allocation */
+    if (reallocate(array, array->length ? array->length * 2 : 1)) {
+      return;
     }
   }
+
+  *(array->buffer + (array->length++)) = payload;
 }
 
 void** dynElement(dynArray* array, size_t index) {
@@ -114,6 +154,121 @@ void** dynElement(dynArray* array, size_t index) {
   }
 }
 
+/* Ensure the buffer has room for the given number of elements */
+static int reserve(dynArray* array, size_t length) {
+  if (length > array->allocated) {
+    return reallocate(array, array->allocated * 2 > length ? array->allocated * 2 : length);
+  }
+
+  return 0;
+}
+
+void dynInsert(dynArray* array, size_t index, void* payload) {
+  dynInsertRange(array, index, &payload, 1);
+}
+
+void dynInsertRange(dynArray* array, size_t index, void** payloads, size_t count) {
+  if (array && count && index <= array->length && !reserve(array, array->length + count)) {
+    memmove(array->buffer + index + count, array->buffer + index, sizeof(void*) * (array->length - index));
+    memcpy(array->buffer + index, payloads, sizeof(void*) * count);
+    array->length += count;
+  }
+}
+
+void dynErase(dynArray* array, size_t from, size_t to) {
+  if (array && to >= from && to < array->length) {
+    memmove(array->buffer + from, array->buffer + to + 1, sizeof(void*) * (array->length - (to + 1)));
+    array->length -= (to + 1) - from;
+  }
+}
+
+dynGap* dynGapOpen(dynArray* array, size_t cursor) {
+  dynGap* newGap;
+
+  if (cursor > array->length || !(newGap = malloc(sizeof(dynGap)))) {
+    return NULL;
+  }
+
+  /* The gap starts as the buffer's unused tail */
+  newGap->array  = array;
+  newGap->length = array->length;
+  newGap->cursor = array->length;
+  newGap->end    = array->allocated;
+
+  dynGapMove(newGap, cursor);
+  return newGap;
+}
+
+void dynGapMove(dynGap* gap, size_t cursor) {
+  void** buffer = gap->array->buffer;
+
+  if (cursor < gap->cursor) {
+    size_t n  = gap->cursor - cursor;
+    gap->end -= n;
+    memmove(buffer + gap->end, buffer + cursor, sizeof(void*) * n);
+    gap->cursor = cursor;
+  } else if (cursor > gap->cursor && cursor <= gap->length) {
+    size_t n = cursor - gap->cursor;
+    memmove(buffer + gap->cursor, buffer + gap->end, sizeof(void*) * n);
+    gap->end   += n;
+    gap->cursor = cursor;
+  }
+}
+
+void dynGapInsert(dynGap* gap, void* payload) {
+  dynArray* array = gap->array;
+
+  if (gap->cursor == gap->end) {
+    /* Grow the buffer and move the elements after the gap to its end */
+    size_t tail = array->allocated - gap->end;
+
+    if (reserve(array, array->allocated + 1)) {
+      gap->length = 0;
+      gap->cursor = 0;
+      gap->end    = 0;
+      return;
+    }
+
+    memmove(array->buffer + array->allocated - tail, array->buffer + gap->end, sizeof(void*) * tail);
+    gap->end = array->allocated - tail;
+  }
+
+  *(array->buffer + (gap->cursor++)) = payload;
+  ++gap->length;
+}
+
+void dynGapErase(dynGap* gap, size_t before, size_t after) {
+  if (before > gap->cursor) {
+    before = gap->cursor;
+  }
+
+  if (after > gap->length - gap->cursor) {
+    after = gap->length - gap->cursor;
+  }
+
+  gap->cursor -= before;
+  gap->end    += after;
+  gap->length -= before + after;
+}
+
+void** dynGapElement(dynGap* gap, size_t index) {
+  if (index < gap->cursor) {
+    return gap->array->buffer + index;
+  } else if (index < gap->length) {
+    return gap->array->buffer + index + (gap->end - gap->cursor);
+  } else {
+    return NULL;
+  }
+}
+
+void dynGapClose(dynGap* gap) {
+  if (gap) {
+    dynGapMove(gap, gap->length);
+    gap->array->length = gap->length;
+    free(gap);
+  }
+}
+
 dynArray* dynProject(void* array, size_t length, size_t width) {
   dynArray* projected = dynCreate(length);
   
@@ -240,9 +395,154 @@ dynArray* dynZipWith(dynArray* arrayAlpha, dynArray* arrayBeta, dynZipWithCallba
   return zipped;
 }
 
+/* Set a target array's length, keeping its allocation */
+static int fit(dynArray* into, size_t length) {
+  if (length) {
+    dynResize(into, length);
+    return into->length != length;
+  }
+
+  into->length = 0;
+  return 0;
+}
+
+void dynMapInto(dynArray* array, dynArray* into, dynMapCallback callback) {
+  size_t n = array ? array->length : 0;
+
+  if (!fit(into, n)) {
+    while (n--) {
+      *dynElement(into, n) = callback(*dynElement(array, n), n, array);
+    }
+  }
+}
+
+void dynFilterInto(dynArray* array, dynArray* into, dynFilterCallback callback) {
+  if (into == array) {
+    dynFilterInPlace(array, callback);
+  } else {
+    into->length = 0;
+
+    if (array && array->length) {
+      size_t i;
+      size_t n = array->length;
+
+      for (i = 0; i < n ; i++) {
+        void* e = *dynElement(array, i);
+        if (callback(e, i, array)) {
+          dynAppend(into, e);
+
+          /* Memory reallocation failed :P */
+          if (!into->length) { break; }
+        }
+      }
+    }
+  }
+}
+
+void dynZipWithInto(dynArray* arrayAlpha, dynArray* arrayBeta, dynArray* into, dynZipWithCallback callback) {
+  size_t n = 0;
+
+  if (arrayAlpha && arrayBeta) {
+    n = arrayAlpha->length > arrayBeta->length ? arrayBeta->length : arrayAlpha->length;
+  }
+
+  if (!fit(into, n)) {
+    while (n--) {
+      *dynElement(into, n) = callback(*dynElement(arrayAlpha, n), *dynElement(arrayBeta, n), n, arrayAlpha, arrayBeta);
+    }
+  }
+}
+
+void dynMapInPlace(dynArray* array, dynMapCallback callback) {
+  if (array && array->length) {
+    size_t n = array->length;
+
+    while (n--) {
+      void** e = dynElement(array, n);
+      *e = callback(*e, n, array);
+    }
+  }
+}
+
+void dynFilterInPlace(dynArray* array, dynFilterCallback callback) {
+  if (array && array->length) {
+    size_t i, kept = 0;
+    size_t n = array->length;
+
+    for (i = 0; i < n; i++) {
+      void* e = *(array->buffer + i);
+      if (callback(e, i, array)) {
+        *(array->buffer + kept++) = e;
+      }
+    }
+
+    array->length = kept;
+  }
+}
+
+/* Result array pointing to consecutive slots, either in the arena or
+   allocated after its inline buffer, so they are freed together */
+static dynArray* slotted(size_t length, size_t width, void* arena) {
+  dynArray* result;
+  char*     slot;
+  size_t    i;
+
+  if (arena) {
+    result = dynCreate(length);
+    slot   = (char*)arena;
+  } else {
+    /* Round the header up, so any slot type is aligned */
+    size_t header = (dynInlineSize(length) + 15) & ~(size_t)15;
+
+    if ((result = malloc(header + length * width))) {
+      dynEmbed(result, length, length);
+    }
+
+    slot = (char*)result + header;
+  }
+
+  if (result) {
+    for (i = 0; i < length; i++) {
+      *(result->buffer + i) = slot + i * width;
+    }
+  }
+
+  return result;
+}
+
+dynArray* dynMapSlots(dynArray* array, size_t width, void* arena, dynMapSlotCallback callback) {
+  size_t    n         = array ? array->length : 0;
+  dynArray* transform = slotted(n, width, arena);
+
+  if (transform) {
+    while (n--) {
+      callback(*dynElement(array, n), *dynElement(transform, n), n, array);
+    }
+  }
+
+  return transform;
+}
+
+dynArray* dynZipWithSlots(dynArray* arrayAlpha, dynArray* arrayBeta, size_t width, void* arena, dynZipWithSlotCallback callback) {
+  size_t    n = 0;
+  dynArray* zipped;
+
+  if (arrayAlpha && arrayBeta) {
+    n = arrayAlpha->length > arrayBeta->length ? arrayBeta->length : arrayAlpha->length;
+  }
+
+  if ((zipped = slotted(n, width, arena))) {
+    while (n--) {
+      callback(*dynElement(arrayAlpha, n), *dynElement(arrayBeta, n), *dynElement(zipped, n), n, arrayAlpha, arrayBeta);
+    }
+  }
+
+  return zipped;
+}
+
 void dynNuke(dynArray* array) {
   if (array) {
-    if (array->buffer) {
+    if (array->buffer && !isInline(array)) {
       free(array->buffer);
     }
     free(array);
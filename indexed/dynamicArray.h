@@ -20,6 +20,10 @@
               Actual number of elements currently allocated
   @var        dynArray::buffer
               Array's data buffer
+  @var        dynArray::inlined
+              Number of elements that can be stored inline, directly
+              after the structure, before spilling to the heap (see
+              dynCreateInline()); zero for ordinary arrays
 
   @warning    dynArray::length and dynArray::allocated are not write
               protected
@@ -28,8 +32,47 @@ typedef struct {
   size_t length;
   size_t allocated;
   void** buffer;
+  size_t inlined;
 } dynArray;
 
+/**
+  @def        dynInlineSize(inlined)
+  @brief      Bytes needed for a dynamic array with inline storage
+  @param      inlined  Number of elements to store inline
+
+  The size of the memory block to give dynEmbed(), for a dynamic array
+  and its inline elements.
+*/
+#define dynInlineSize(inlined) (sizeof(dynArray) + sizeof(void*) * (inlined))
+
+/**
+  @struct     dynGap
+  @brief      Dynamic array in gap buffer mode
+  @var        dynGap::array
+              The dynamic array whose buffer is being edited
+  @var        dynGap::length
+              Number of elements in the array
+  @var        dynGap::cursor
+              Index at which elements are inserted, which is where the
+              gap starts in the buffer
+  @var        dynGap::end
+              Buffer offset of the first element after the gap
+
+  The unused part of the array's buffer is kept at the cursor, rather
+  than at its end, so inserting or erasing at the cursor is O(1) and
+  moving the cursor costs only the distance moved. This suits clustered
+  edits (e.g., typing into a text editor's buffer).
+
+  @warning    dynGap::length, dynGap::cursor and dynGap::end are not
+              write protected
+*/
+typedef struct {
+  dynArray* array;
+  size_t    length;
+  size_t    cursor;
+  size_t    end;
+} dynGap;
+
 /**
   @typedef    dynForEachCallback
   @brief      Function signature for dynForEach() callbacks
@@ -212,6 +255,75 @@ typedef void(*dynFoldCallback)(void* const, void* const, size_t, dynArray*);
 */
 typedef void*(*dynZipWithCallback)(void* const, void* const, size_t, dynArray*, dynArray*);
 
+/**
+  @typedef    dynMapSlotCallback
+  @brief      Function signature for dynMapSlots() callbacks
+  
+  The callback function for dynMapSlots() (and tyMap()) must have the
+  following signature:
+
+  @code{.c}
+  void callback(void* const element, void* slot, size_t index, dynArray* array)
+  @endcode
+
+  That is, on each element, the callback is called with the following:
+
+  @param      element  The pointer to the current element
+  @param      slot     The pointer to the space for the transformed
+                       element, of the requested width
+  @param      index    The current index
+  @param      array    The dynamic array
+
+  The callback function must write the transformed element into the
+  slot. For example, if the dynamic array contained only integers, the
+  following callback would have the effect of doubling them:
+
+  @code{.c}
+  void doubleInt(void* const e, void* slot, size_t i, dynArray* array) {
+ *  *(int*)slot = *(int*)e * 2;
+  }
+  @endcode
+
+  @note       Unlike dynMapCallback, the callback need not allocate
+              anything
+*/
+typedef void(*dynMapSlotCallback)(void* const, void*, size_t, dynArray*);
+
+/**
+  @typedef    dynZipWithSlotCallback
+  @brief      Function signature for dynZipWithSlots() callbacks
+  
+  The callback function for dynZipWithSlots() (and tyZipWith()) must
+  have the following signature:
+
+  @code{.c}
+  void callback(void* const elementAlpha, void* const elementBeta, void* slot, size_t index, dynArray* arrayAlpha, dynArray* arrayBeta)
+  @endcode
+
+  That is, on each element, the callback is called with the following:
+
+  @param      elementAlpha  The pointer to the current element from the
+                            first dynamic array
+  @param      elementBeta   The pointer to the current element from the
+                            second dynamic array
+  @param      slot          The pointer to the space for the zipped
+                            result, of the requested width
+  @param      index         The current index
+  @param      arrayAlpha    The first dynamic array
+  @param      arrayBeta     The second dynamic array
+
+  The callback function must write the zipped result into the slot. For
+  example, if the two dynamic arrays contained only integers, the
+  following callback would have the effect of adding them together:
+
+  @code{.c}
+  void sumPair(void* const e1, void* const e2, void* slot, size_t i, dynArray* a1, dynArray* a2) {
+ *  *(int*)slot = *(int*)e1 + *(int*)e2;
+  }
+  @endcode
+*/
+typedef void(*dynZipWithSlotCallback)(void* const, void* const, void*, size_t, dynArray*, dynArray*);
+
 /**
   @fn         dynArray* dynCreate(size_t length)
   @brief      Create a dynamic array of a given size
@@ -226,6 +338,43 @@ typedef void*(*dynZipWithCallback)(void* const, void* const, size_t, dynArray*,
 */
 extern dynArray* dynCreate(size_t);
 
+/**
+  @fn         dynArray* dynCreateInline(size_t length, size_t inlined)
+  @brief      Create a dynamic array with inline storage for small sizes
+  @param      length   Number of elements to initially allocate
+  @param      inlined  Number of elements to store inline
+  @return     Pointer to new dynamic array structure; or `NULL` in the
+              event of an allocation failure
+
+  Create a dynamic array, with all elements initialised with `NULL`
+  pointers, whose structure has room for a number of elements directly
+  after it. While the array fits, its buffer is that space, so it takes
+  one allocation rather than two and its elements share a cache line
+  with its header; it spills to a heap buffer only when it outgrows it.
+
+  @note       Inline arrays can be used with every dynamic array function
+*/
+extern dynArray* dynCreateInline(size_t, size_t);
+
+/**
+  @fn         dynArray* dynEmbed(void* memory, size_t length, size_t inlined)
+  @brief      Create a dynamic array with inline storage in given memory
+  @param      memory   Memory for the structure and its inline elements,
+                       of at least dynInlineSize() bytes
+  @param      length   Number of elements to initially allocate
+  @param      inlined  Number of elements to store inline
+  @return     Pointer to the dynamic array (i.e., the memory); or `NULL`
+              in the event of an allocation failure
+
+  As dynCreateInline(), but in memory that is part of a larger
+  allocation (e.g., the structure that owns the array), to save even the
+  header's allocation.
+
+  @warning    Free the array with dynResize() to zero, which frees any
+              spilled buffer, not with dynNuke()
+*/
+extern dynArray* dynEmbed(void*, size_t, size_t);
+
 /**
   @fn         void dynResize(dynArray* array, size_t length)
   @brief      Resize the array to the given number of elements
@@ -271,6 +420,153 @@ extern void dynAppend(dynArray*, void*);
 */
 extern void** dynElement(dynArray*, size_t);
 
+/**
+  @fn         void dynInsert(dynArray* array, size_t index, void* payload)
+  @brief      Insert an element into the array at the given index
+  @param      array    The dynamic array to insert into
+  @param      index    The index the new element will have
+  @param      payload  Pointer to the new element
+
+  Shift the elements from the given index onwards up by one, in place,
+  and put the element in the space. An index equal to the array's length
+  appends the element.
+
+  @note       Nothing is done in the event of a bounds error
+  @note       Memory will be over-allocated if there is not enough free
+              space in the buffer
+  @warning    In the event of a reallocation failure, the original array
+              will be lost and the length reset to zero
+*/
+extern void dynInsert(dynArray*, size_t, void*);
+
+/**
+  @fn         void dynInsertRange(dynArray* array, size_t index, void** payloads, size_t count)
+  @brief      Insert a number of elements into the array at the given index
+  @param      array     The dynamic array to insert into
+  @param      index     The index the first new element will have
+  @param      payloads  Array of pointers to the new elements
+  @param      count     Number of new elements
+
+  Shift the elements from the given index onwards up by the number of
+  new elements, in one move, and copy the new elements into the space.
+
+  @note       Nothing is done in the event of a bounds error
+  @note       Memory will be over-allocated if there is not enough free
+              space in the buffer
+  @warning    The new elements must not be taken from the array's own
+              buffer, which may be reallocated
+  @warning    In the event of a reallocation failure, the original array
+              will be lost and the length reset to zero
+*/
+extern void dynInsertRange(dynArray*, size_t, void**, size_t);
+
+/**
+  @fn         void dynErase(dynArray* array, size_t from, size_t to)
+  @brief      Remove the elements between two indices from the array
+  @param      array  The dynamic array to erase from
+  @param      from   The initial index
+  @param      to     The final index
+
+  Shift the elements after the final index down over the erased ones,
+  in place.
+
+  @note       The terminal indices are both erased, as in dynSlice()
+  @note       Nothing is done in the event of a bounds error
+  @note       The allocation is not reduced
+  @note       The erased elements will not be freed
+*/
+extern void dynErase(dynArray*, size_t, size_t);
+
+/**
+  @fn         dynGap* dynGapOpen(dynArray* array, size_t cursor)
+  @brief      Put a dynamic array into gap buffer mode
+  @param      array   The dynamic array to edit
+  @param      cursor  The initial cursor index
+  @return     Pointer to the gap buffer; or `NULL` if the cursor is out
+              of bounds, or in the event of an allocation failure
+
+  Move the array's unused space to the cursor, so that it can be edited
+  with dynGapInsert(), dynGapErase() and dynGapMove() until dynGapClose()
+  is called. For example, to type and then correct a word:
+
+  @code{.c}
+  dynGap* gap = dynGapOpen(text, text->length);
+  dynGapInsert(gap, h); dynGapInsert(gap, w);
+  dynGapErase(gap, 1, 0);
+  dynGapInsert(gap, i);
+  dynGapClose(gap);
+  @endcode
+
+  @warning    The array must not otherwise be used until the gap buffer
+              is closed, as its elements are not contiguous and its
+              length is not kept up to date
+*/
+extern dynGap* dynGapOpen(dynArray*, size_t);
+
+/**
+  @fn         void dynGapMove(dynGap* gap, size_t cursor)
+  @brief      Move a gap buffer's cursor
+  @param      gap     The gap buffer
+  @param      cursor  The new cursor index
+
+  Move the elements between the old and new cursors across the gap,
+  which costs time in proportion to the distance moved.
+
+  @note       Nothing is done in the event of a bounds error
+*/
+extern void dynGapMove(dynGap*, size_t);
+
+/**
+  @fn         void dynGapInsert(dynGap* gap, void* payload)
+  @brief      Insert an element at a gap buffer's cursor
+  @param      gap      The gap buffer
+  @param      payload  Pointer to the new element
+
+  Put the element at the start of the gap and advance the cursor past
+  it, in amortised O(1) time.
+
+  @note       If the gap is full, the buffer's allocation is doubled
+  @warning    In the event of a reallocation failure, the original array
+              will be lost and the length reset to zero
+*/
+extern void dynGapInsert(dynGap*, void*);
+
+/**
+  @fn         void dynGapErase(dynGap* gap, size_t before, size_t after)
+  @brief      Remove elements on either side of a gap buffer's cursor
+  @param      gap     The gap buffer
+  @param      before  Number of elements to erase before the cursor
+                      (i.e., backspace)
+  @param      after   Number of elements to erase after the cursor
+                      (i.e., delete)
+
+  Widen the gap over the erased elements, in O(1) time.
+
+  @note       The counts are limited to the elements that exist
+  @note       The erased elements will not be freed
+*/
+extern void dynGapErase(dynGap*, size_t, size_t);
+
+/**
+  @fn         void** dynGapElement(dynGap* gap, size_t index)
+  @brief      Get the pointer to a gap buffer's element at the given index
+  @param      gap    The gap buffer
+  @param      index  The element offset, ignoring the gap
+  @return     Pointer to the pointer to the specified element; or `NULL`
+              in the event of a bounds error
+*/
+extern void** dynGapElement(dynGap*, size_t);
+
+/**
+  @fn         void dynGapClose(dynGap* gap)
+  @brief      Return a dynamic array to normal mode
+  @param      gap  The gap buffer
+
+  Move the gap back to the end of the array's buffer, update its length
+  and free the gap buffer.
+*/
+extern void dynGapClose(dynGap*);
+
 /**
   @fn         dynArray* dynProject(void* array, size_t length, size_t width)
   @brief      Project a regular array into a dynamic one
@@ -408,6 +704,140 @@ extern void dynFold(dynArray*, void*, dynFoldCallback);
 */
 extern dynArray* dynZipWith(dynArray*, dynArray*, dynZipWithCallback);
 
+/**
+  @fn         void dynMapInto(dynArray* array, dynArray* into, dynMapCallback callback)
+  @brief      Map the elements of a dynamic array into an existing array
+  @param      array     The dynamic array to iterate over
+  @param      into      The dynamic array to write the results to
+  @param      callback  Pointer to callback function
+
+  As dynMap(), but the results replace the contents of a caller supplied
+  dynamic array, which is resized to match; so repeated maps into the
+  same array reuse its allocation, rather than creating a new array each
+  time.
+
+  @note       The target array may be the source array, to map in place
+  @note       The target's allocation is never reduced
+  @warning    In the event of a reallocation failure, the target's
+              original contents will be lost and its length reset to
+              zero
+*/
+extern void dynMapInto(dynArray*, dynArray*, dynMapCallback);
+
+/**
+  @fn         void dynFilterInto(dynArray* array, dynArray* into, dynFilterCallback callback)
+  @brief      Filter the elements of a dynamic array into an existing array
+  @param      array     The dynamic array to filter
+  @param      into      The dynamic array to write the passing elements to
+  @param      callback  Pointer to callback function
+
+  As dynFilter(), but the elements which pass replace the contents of a
+  caller supplied dynamic array, reusing its allocation.
+
+  @note       The target array may be the source array, to filter in
+              place (see dynFilterInPlace())
+  @note       The target's allocation is never reduced
+  @warning    In the event of a reallocation failure, the target's
+              original contents will be lost and its length reset to
+              zero
+*/
+extern void dynFilterInto(dynArray*, dynArray*, dynFilterCallback);
+
+/**
+  @fn         void dynZipWithInto(dynArray* arrayAlpha, dynArray* arrayBeta, dynArray* into, dynZipWithCallback callback)
+  @brief      Zip two dynamic arrays' elements pairwise into an existing array
+  @param      arrayAlpha  The first dynamic array
+  @param      arrayBeta   The second dynamic array
+  @param      into        The dynamic array to write the results to
+  @param      callback    Pointer to callback function
+
+  As dynZipWith(), but the results replace the contents of a caller
+  supplied dynamic array, which is resized to match the shorter input
+  array, reusing its allocation.
+
+  @note       The target array may be either input array
+  @note       The target's allocation is never reduced
+  @warning    In the event of a reallocation failure, the target's
+              original contents will be lost and its length reset to
+              zero
+*/
+extern void dynZipWithInto(dynArray*, dynArray*, dynArray*, dynZipWithCallback);
+
+/**
+  @fn         void dynMapInPlace(dynArray* array, dynMapCallback callback)
+  @brief      Replace the elements of a dynamic array by mapping them through a function
+  @param      array     The dynamic array to transform
+  @param      callback  Pointer to callback function
+
+  Replace each element with the result of applying the specified
+  callback function to it, without allocating anything.
+*/
+extern void dynMapInPlace(dynArray*, dynMapCallback);
+
+/**
+  @fn         void dynFilterInPlace(dynArray* array, dynFilterCallback callback)
+  @brief      Remove the elements which fail the callback from a dynamic array
+  @param      array     The dynamic array to filter
+  @param      callback  Pointer to callback function
+
+  Test each element against the specified callback function and move
+  those which pass down over those which fail, in a single pass, keeping
+  their order. Nothing is allocated.
+
+  @note       The callback is given each element's original index
+  @note       The allocation is not reduced
+  @warning    The array is compacted as it is filtered, so the callback
+              must not read other elements of the array
+*/
+extern void dynFilterInPlace(dynArray*, dynFilterCallback);
+
+/**
+  @fn         dynArray* dynMapSlots(dynArray* array, size_t width, void* arena, dynMapSlotCallback callback)
+  @brief      Map the elements of a dynamic array into fixed width slots
+  @param      array     The dynamic array to iterate over
+  @param      width     Width of each transformed element, in bytes
+  @param      arena     Memory for the transformed elements, of at least
+                        the array's length times the width bytes; or
+                        `NULL` to allocate it with the result
+  @param      callback  Pointer to callback function
+  @return     Pointer to the transformed dynamic array; or `NULL` in the
+              event of an allocation failure
+
+  Creates a new dynamic array whose elements point to consecutive slots
+  of the given width, which the callback fills from each element of the
+  original; so no element is allocated individually. For example:
+
+  @code{.c}
+  dynArray* doubled = dynMapSlots(ints, sizeof(int), NULL, &doubleInt);
+  ...
+  dynNuke(doubled);
+  @endcode
+
+  @note       Without an arena, the slots are allocated in one block
+              with the result array, so are all freed by dynNuke()
+  @warning    Without an arena, the slots are freed with the result
+              array, so must not be referenced after it is nuked
+*/
+extern dynArray* dynMapSlots(dynArray*, size_t, void*, dynMapSlotCallback);
+
+/**
+  @fn         dynArray* dynZipWithSlots(dynArray* arrayAlpha, dynArray* arrayBeta, size_t width, void* arena, dynZipWithSlotCallback callback)
+  @brief      Zip two arrays' elements pairwise into fixed width slots
+  @param      arrayAlpha  The first dynamic array
+  @param      arrayBeta   The second dynamic array
+  @param      width       Width of each zipped result, in bytes
+  @param      arena       Memory for the zipped results, of at least
+                          the shorter array's length times the width
+                          bytes; or `NULL` to allocate it with the result
+  @param      callback    Pointer to callback function
+  @return     Pointer to the zipped dynamic array; or `NULL` in the
+              event of an allocation failure
+
+  As dynMapSlots(), but through the specified callback function applied
+  to successive element pairs, as in dynZipWith().
+*/
+extern dynArray* dynZipWithSlots(dynArray*, dynArray*, size_t, void*, dynZipWithSlotCallback);
+
 /**
   @fn         void dynNuke(dynArray* array)
   @brief      Free the memory allocated by the dynamic array
@@ -0,0 +1,472 @@
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "ndArray.h"
+#include "typedArray.h"
+#include "../parallel/threadPool.h"
+
+/* Edge length below which copied blocks are no longer divided */
+#define ndLeaf 16
+
+/* Edge length of the top level blocks copied by each task */
+#define ndBlock 256
+
+/* Number of accumulators advanced together by a reduction */
+#define ndBatch 256
+
+typedef struct {
+  ndArray* target;
+  ndArray* source;
+  size_t   rows, cols, down, across;
+} copying;
+
+typedef struct {
+  ndArray*      target;
+  ndArray*      source;
+  ndMapCallback callback;
+  void*         context;
+  size_t        cols;
+} mapping;
+
+typedef struct {
+  ndArray*         target;
+  ndArray*         source;
+  size_t           axis;
+  ndReduceCallback callback;
+  void*            identity;
+  void*            context;
+} reducing;
+
+/* Allocate the structure and per axis arrays, without any elements */
+static ndArray* allocate(size_t rank, size_t width, size_t tile) {
+  ndArray* newArray = malloc(sizeof(ndArray));
+
+  if (newArray) {
+    newArray->rank    = rank;
+    newArray->width   = width;
+    newArray->tile    = tile;
+    newArray->data    = NULL;
+    newArray->storage = NULL;
+    newArray->shape   = malloc(sizeof(size_t) * (rank ? rank : 1));
+    newArray->stride  = malloc(sizeof(ptrdiff_t) * (rank ? rank : 1));
+    newArray->jump    = malloc(sizeof(ptrdiff_t) * (rank ? rank : 1));
+
+    if (!newArray->shape || !newArray->stride || !newArray->jump) {
+      /* Memory allocation failure :P */
+      ndNuke(newArray);
+      newArray = NULL;
+    }
+  }
+
+  return newArray;
+}
+
+/* Bytes from the start of an axis to the element at an index along it */
+static ptrdiff_t offset(ndArray* array, size_t axis, size_t index) {
+  if (array->tile) {
+    return (ptrdiff_t)(index / array->tile) * array->jump[axis]
+         + (ptrdiff_t)(index % array->tile) * array->stride[axis];
+  }
+
+  return (ptrdiff_t)index * array->stride[axis];
+}
+
+/* Offsets along the last two axes, which are absent in low ranks */
+static ptrdiff_t rowOffset(ndArray* array, size_t row) {
+  return array->rank >= 2 ? offset(array, array->rank - 2, row) : 0;
+}
+
+static ptrdiff_t colOffset(ndArray* array, size_t col) {
+  return array->rank >= 1 ? offset(array, array->rank - 1, col) : 0;
+}
+
+/* Address of a row major position over the first axes, less one */
+static char* locate(ndArray* array, size_t axes, size_t skip, size_t position) {
+  char* at = array->data;
+
+  while (axes--) {
+    if (axes != skip) {
+      at       += offset(array, axes, position % array->shape[axes]);
+      position /= array->shape[axes];
+    }
+  }
+
+  return at;
+}
+
+/* Number of elements in the first axes */
+static size_t count(ndArray* array, size_t axes) {
+  size_t total = 1, k;
+
+  for (k = 0; k < axes; k++) {
+    total *= array->shape[k];
+  }
+
+  return total;
+}
+
+static void copyElement(char* target, char* source, size_t width) {
+  /* Let the common widths be single moves */
+  switch (width) {
+    case 4:  memcpy(target, source, 4); break;
+    case 8:  memcpy(target, source, 8); break;
+    default: memcpy(target, source, width);
+  }
+}
+
+ndArray* ndCreate(size_t rank, size_t* shape, size_t width, size_t tile) {
+  ndArray* newArray;
+  size_t   elements = 1, k = rank;
+
+  if (rank < 2) { tile = 0; }
+
+  if (!(newArray = allocate(rank, width, tile))) { return NULL; }
+
+  for (k = 0; k < rank; k++) {
+    newArray->shape[k] = shape[k];
+  }
+
+  k = rank;
+
+  if (tile) {
+    size_t down   = (shape[rank - 2] + tile - 1) / tile;
+    size_t across = (shape[rank - 1] + tile - 1) / tile;
+
+    newArray->stride[rank - 1] = (ptrdiff_t)width;
+    newArray->jump[rank - 1]   = (ptrdiff_t)(tile * tile * width);
+    newArray->stride[rank - 2] = (ptrdiff_t)(tile * width);
+    newArray->jump[rank - 2]   = (ptrdiff_t)(across * tile * tile * width);
+
+    if (__builtin_mul_overflow(down * across, tile * tile, &elements)) { goto overflow; }
+    k -= 2;
+  }
+
+  /* Row major over the (remaining) axes */
+  while (k--) {
+    newArray->stride[k] = (ptrdiff_t)(elements * width);
+    newArray->jump[k]   = (ptrdiff_t)tile * newArray->stride[k];
+
+    if (__builtin_mul_overflow(elements, shape[k], &elements)) { goto overflow; }
+  }
+
+  if (!(newArray->storage = tyCreate(elements, width))) {
+    /* Memory allocation failure :P */
+    ndNuke(newArray);
+    return NULL;
+  }
+
+  newArray->data = newArray->storage->buffer;
+  return newArray;
+
+overflow:
+  ndNuke(newArray);
+  return NULL;
+}
+
+ndArray* ndWrap(tyArray* storage, size_t rank, size_t* shape) {
+  ndArray* newView = allocate(rank, storage->width, 0);
+  size_t   elements = 1, k = rank;
+
+  if (!newView) { return NULL; }
+
+  while (k--) {
+    newView->shape[k]  = shape[k];
+    newView->stride[k] = (ptrdiff_t)(elements * storage->width);
+    newView->jump[k]   = 0;
+
+    if (__builtin_mul_overflow(elements, shape[k], &elements)) { elements = (size_t)-1; }
+  }
+
+  if (elements > storage->length) {
+    ndNuke(newView);
+    return NULL;
+  }
+
+  newView->data = storage->buffer;
+  return newView;
+}
+
+void* ndElement(ndArray* array, size_t* index) {
+  char*  at = array->data;
+  size_t k;
+
+  for (k = 0; k < array->rank; k++) {
+    if (index[k] >= array->shape[k]) {
+      /* Bounds error */
+      return NULL;
+    }
+
+    at += offset(array, k, index[k]);
+  }
+
+  return at;
+}
+
+ndArray* ndView(ndArray* array, size_t* from, size_t* to, size_t* step) {
+  ndArray* newView = allocate(array->rank, array->width, array->tile);
+  size_t   tile = array->tile, k;
+
+  if (!newView) { return NULL; }
+
+  newView->data = array->data;
+
+  for (k = 0; k < array->rank; k++) {
+    size_t by    = step ? step[k] : 1;
+    int    tiled = tile && array->jump[k] != (ptrdiff_t)tile * array->stride[k];
+
+    if (!by || from[k] > to[k] || to[k] > array->shape[k] || (tiled && (from[k] % tile || by != 1))) {
+      ndNuke(newView);
+      return NULL;
+    }
+
+    newView->shape[k]  = (to[k] - from[k] + by - 1) / by;
+    newView->stride[k] = array->stride[k] * (ptrdiff_t)by;
+    newView->jump[k]   = tiled ? array->jump[k] : (ptrdiff_t)tile * newView->stride[k];
+
+    /* An empty slice may start off the end */
+    if (from[k] < array->shape[k]) {
+      newView->data += offset(array, k, from[k]);
+    }
+  }
+
+  return newView;
+}
+
+ndArray* ndPermute(ndArray* array, size_t* axes) {
+  ndArray* newView = allocate(array->rank, array->width, array->tile);
+  char*    seen = calloc(array->rank ? array->rank : 1, 1);
+  size_t   k;
+
+  if (!newView || !seen) {
+    /* Memory allocation failure :P */
+    ndNuke(newView);
+    free(seen);
+    return NULL;
+  }
+
+  for (k = 0; k < array->rank; k++) {
+    if (axes[k] >= array->rank || seen[axes[k]]) {
+      ndNuke(newView);
+      free(seen);
+      return NULL;
+    }
+
+    seen[axes[k]]      = 1;
+    newView->shape[k]  = array->shape[axes[k]];
+    newView->stride[k] = array->stride[axes[k]];
+    newView->jump[k]   = array->jump[axes[k]];
+  }
+
+  newView->data = array->data;
+
+  free(seen);
+  return newView;
+}
+
+ndArray* ndTranspose(ndArray* array) {
+  size_t*  axes = malloc(sizeof(size_t) * (array->rank ? array->rank : 1));
+  ndArray* newView;
+  size_t   k;
+
+  if (!axes) { return NULL; }
+
+  for (k = 0; k < array->rank; k++) {
+    axes[k] = k;
+  }
+
+  if (array->rank >= 2) {
+    axes[array->rank - 2] = array->rank - 1;
+    axes[array->rank - 1] = array->rank - 2;
+  }
+
+  newView = ndPermute(array, axes);
+
+  free(axes);
+  return newView;
+}
+
+/* Copy a block of a matrix by halving its longer side */
+static void copyBlock(copying* copy, char* target, char* source, size_t row, size_t col, size_t rows, size_t cols) {
+  if (rows <= ndLeaf && cols <= ndLeaf) {
+    size_t width = copy->source->width, i, j;
+
+    for (i = row; i < row + rows; i++) {
+      char* to   = target + rowOffset(copy->target, i);
+      char* from = source + rowOffset(copy->source, i);
+
+      if (copy->target->tile || copy->source->tile) {
+        for (j = col; j < col + cols; j++) {
+          copyElement(to + colOffset(copy->target, j), from + colOffset(copy->source, j), width);
+        }
+      } else {
+        /* Strided rows can be walked by pointer */
+        ptrdiff_t toStep   = colOffset(copy->target, 1);
+        ptrdiff_t fromStep = colOffset(copy->source, 1);
+
+        to   += (ptrdiff_t)col * toStep;
+        from += (ptrdiff_t)col * fromStep;
+
+        for (j = 0; j < cols; j++, to += toStep, from += fromStep) {
+          copyElement(to, from, width);
+        }
+      }
+    }
+  } else if (rows >= cols) {
+    copyBlock(copy, target, source, row, col, rows / 2, cols);
+    copyBlock(copy, target, source, row + rows / 2, col, rows - rows / 2, cols);
+  } else {
+    copyBlock(copy, target, source, row, col, rows, cols / 2);
+    copyBlock(copy, target, source, row, col + cols / 2, rows, cols - cols / 2);
+  }
+}
+
+static void copyTasks(size_t from, size_t to, size_t worker, void* context) {
+  copying* copy   = (copying*)context;
+  size_t   blocks = copy->down * copy->across;
+  size_t   outer  = copy->source->rank >= 2 ? copy->source->rank - 2 : 0;
+
+  for (; from < to; from++) {
+    size_t matrix = from / blocks;
+    size_t row    = (from % blocks) / copy->across * ndBlock;
+    size_t col    = (from % blocks) % copy->across * ndBlock;
+    size_t rows   = copy->rows - row < ndBlock ? copy->rows - row : ndBlock;
+    size_t cols   = copy->cols - col < ndBlock ? copy->cols - col : ndBlock;
+
+    copyBlock(copy, locate(copy->target, outer, outer, matrix), locate(copy->source, outer, outer, matrix), row, col, rows, cols);
+  }
+}
+
+ndArray* ndCopy(ndArray* array, size_t tile, tpPool* pool) {
+  ndArray* newArray = ndCreate(array->rank, array->shape, array->width, tile);
+  size_t   rank = array->rank;
+  copying  copy;
+
+  if (!newArray) { return NULL; }
+
+  copy.target = newArray;
+  copy.source = array;
+  copy.rows   = rank >= 2 ? array->shape[rank - 2] : 1;
+  copy.cols   = rank >= 1 ? array->shape[rank - 1] : 1;
+  copy.down   = (copy.rows + ndBlock - 1) / ndBlock;
+  copy.across = (copy.cols + ndBlock - 1) / ndBlock;
+
+  if (count(array, rank)) {
+    tpFor(pool, count(array, rank >= 2 ? rank - 2 : 0) * copy.down * copy.across, 1, &copyTasks, &copy);
+  }
+
+  return newArray;
+}
+
+static void mapRange(size_t from, size_t to, size_t worker, void* context) {
+  mapping* map  = (mapping*)context;
+  size_t   rows = map->source->rank ? map->source->rank - 1 : 0;
+
+  while (from < to) {
+    size_t row    = from / map->cols;
+    size_t col    = from % map->cols;
+    size_t end    = to - row * map->cols < map->cols ? to - row * map->cols : map->cols;
+    char*  target = locate(map->target, rows, rows, row);
+    char*  source = locate(map->source, rows, rows, row);
+
+    for (; col < end; col++) {
+      map->callback(target + colOffset(map->target, col), source + colOffset(map->source, col), map->context);
+    }
+
+    from = row * map->cols + end;
+  }
+}
+
+int ndMap(ndArray* target, ndArray* source, ndMapCallback callback, void* context, tpPool* pool) {
+  mapping map;
+  size_t  k;
+
+  if (target->rank != source->rank) { return 1; }
+
+  for (k = 0; k < source->rank; k++) {
+    if (target->shape[k] != source->shape[k]) { return 1; }
+  }
+
+  map.target   = target;
+  map.source   = source;
+  map.callback = callback;
+  map.context  = context;
+  map.cols     = source->rank ? source->shape[source->rank - 1] : 1;
+
+  if (map.cols) {
+    tpFor(pool, count(source, source->rank), 4096, &mapRange, &map);
+  }
+
+  return 0;
+}
+
+static void reduceRange(size_t from, size_t to, size_t worker, void* context) {
+  reducing* reduce = (reducing*)context;
+  ndArray*  source = reduce->source;
+  size_t    width  = source->width, length = source->shape[reduce->axis];
+  char*     base[ndBatch];
+
+  for (; from < to; from += ndBatch) {
+    size_t batch = to - from < ndBatch ? to - from : ndBatch, i, k;
+    char*  accumulator = reduce->target->data + from * width;
+
+    for (i = 0; i < batch; i++) {
+      base[i] = locate(source, source->rank, reduce->axis, from + i);
+      memcpy(accumulator + i * width, reduce->identity, width);
+    }
+
+    /* Advance the batch along the axis together */
+    for (k = 0; k < length; k++) {
+      ptrdiff_t along = offset(source, reduce->axis, k);
+
+      for (i = 0; i < batch; i++) {
+        reduce->callback(accumulator + i * width, base[i] + along, reduce->context);
+      }
+    }
+  }
+}
+
+ndArray* ndReduce(ndArray* array, size_t axis, ndReduceCallback callback, void* identity, void* context, tpPool* pool) {
+  ndArray* newArray;
+  size_t*  shape;
+  size_t   k, j;
+  reducing reduce;
+
+  if (axis >= array->rank) { return NULL; }
+
+  if (!(shape = malloc(sizeof(size_t) * array->rank))) { return NULL; }
+
+  for (k = 0, j = 0; k < array->rank; k++) {
+    if (k != axis) {
+      shape[j++] = array->shape[k];
+    }
+  }
+
+  newArray = ndCreate(array->rank - 1, shape, array->width, 0);
+  free(shape);
+
+  if (!newArray) { return NULL; }
+
+  reduce.target   = newArray;
+  reduce.source   = array;
+  reduce.axis     = axis;
+  reduce.callback = callback;
+  reduce.identity = identity;
+  reduce.context  = context;
+
+  if (count(newArray, newArray->rank)) {
+    tpFor(pool, count(newArray, newArray->rank), ndBatch, &reduceRange, &reduce);
+  }
+
+  return newArray;
+}
+
+void ndNuke(ndArray* array) {
+  if (array) {
+    tyNuke(array->storage);
+    free(array->shape);
+    free(array->stride);
+    free(array->jump);
+    free(array);
+  }
+}
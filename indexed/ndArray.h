@@ -0,0 +1,319 @@
+/**
+  @file       ndArray.h
+  @brief      N-dimensional array header file
+  @author     Christopher Harrison (Xophmeister)
+  @copyright  @ref license
+
+  Implements a homogeneous, N-dimensional array (e.g., a matrix) over
+  one contiguous typed array, addressed by a stride per axis. Where a
+  dynamic array of row arrays takes two indirections to reach every
+  element and scatters its rows across the heap, an N-dimensional array
+  computes each element's address directly.
+
+  Because elements are found by strides, slicing, permuting axes and
+  transposing are done without copying, by creating a view that shares
+  the original's storage with different shape and strides. A view can
+  be materialised (e.g., to make a transpose contiguous) with ndCopy(),
+  which copies in a cache oblivious order.
+
+  Optionally, the last two axes can be stored in square tiles, so that
+  elements that are close in either direction are close in memory; this
+  suits blocked algorithms that walk down columns as much as along rows.
+*/
+
+#ifndef NDARRAY_H
+#define NDARRAY_H
+
+#include <stdlib.h>
+#include <stddef.h>
+#include "typedArray.h"
+#include "../parallel/threadPool.h"
+
+/**
+  @struct     ndArray
+  @brief      N-dimensional array
+  @var        ndArray::rank
+              Number of axes
+  @var        ndArray::width
+              Width of each element, in bytes
+  @var        ndArray::tile
+              Edge length of the tiles the array is stored in; or zero
+              if it is not tiled
+  @var        ndArray::shape
+              Array of the length of each axis
+  @var        ndArray::stride
+              Array of the distance, in bytes, between consecutive
+              elements along each axis (within a tile, if tiled)
+  @var        ndArray::jump
+              Array of the distance, in bytes, between consecutive tiles
+              along each axis; only used if the array is tiled
+  @var        ndArray::data
+              Address of the first element
+  @var        ndArray::storage
+              Typed array that holds the elements, if owned; or `NULL`
+              for views
+
+  @note       In a tiled array, the element at index `k` along an axis
+              is `(k / tile) * jump + (k % tile) * stride` bytes along
+              it; otherwise it is `k * stride` bytes along
+  @warning    None of the fields are write protected
+*/
+typedef struct {
+  size_t     rank;
+  size_t     width;
+  size_t     tile;
+  size_t*    shape;
+  ptrdiff_t* stride;
+  ptrdiff_t* jump;
+  char*      data;
+  tyArray*   storage;
+} ndArray;
+
+/**
+  @typedef    ndMapCallback
+  @brief      Function signature for ndMap() callbacks
+
+  The callback function for ndMap() must have the following signature:
+
+  @code{.c}
+  void callback(void* const target, void* const source, void* context)
+  @endcode
+
+  That is, on each element, the callback is called with the following:
+
+  @param      target   Pointer to the element to write
+  @param      source   Pointer to the corresponding element to read
+  @param      context  The context pointer given to ndMap()
+
+  For example, the following callback would scale an array of `double`s
+  by a factor given as the context:
+
+  @code{.c}
+  void scale(void* const target, void* const source, void* context) {
+    *(double*)target = *(double*)source * *(double*)context;
+  }
+  @endcode
+
+  @note       The callback is run concurrently, on different elements
+*/
+typedef void(*ndMapCallback)(void* const, void* const, void*);
+
+/**
+  @typedef    ndReduceCallback
+  @brief      Function signature for ndReduce() callbacks
+
+  The callback function for ndReduce() must have the following
+  signature:
+
+  @code{.c}
+  void callback(void* const accumulator, void* const element, void* context)
+  @endcode
+
+  That is, on each element, the callback is called with the following:
+
+  @param      accumulator  Pointer to the accumulator
+  @param      element      Pointer to the current element
+  @param      context      The context pointer given to ndReduce()
+
+  For example, the following callback would sum along an axis of
+  `double`s:
+
+  @code{.c}
+  void sum(void* const accumulator, void* const element, void* context) {
+    *(double*)accumulator += *(double*)element;
+  }
+  @endcode
+
+  @note       The callback is run concurrently, on different
+              accumulators
+*/
+typedef void(*ndReduceCallback)(void* const, void* const, void*);
+
+/**
+  @fn         ndArray* ndCreate(size_t rank, size_t* shape, size_t width, size_t tile)
+  @brief      Create an N-dimensional array of a given shape
+  @param      rank   Number of axes
+  @param      shape  Array of the length of each axis
+  @param      width  Width of each element, in bytes
+  @param      tile   Edge length of the tiles to store the last two axes
+                     in; or zero to store the array in row major order
+  @return     Pointer to the new N-dimensional array; or `NULL` in the
+              event of an allocation failure
+
+  Create an N-dimensional array with all elements' bytes initialised to
+  zero. If tiled, the last two axes are divided into `tile` by `tile`
+  blocks, each of which is stored contiguously in row major order, with
+  the blocks themselves in row major order.
+
+  @note       Arrays of rank less than two are never tiled
+  @note       Tiles on the edges are padded, so a tiled array may take
+              more memory than its elements need
+*/
+extern ndArray* ndCreate(size_t, size_t*, size_t, size_t);
+
+/**
+  @fn         ndArray* ndWrap(tyArray* storage, size_t rank, size_t* shape)
+  @brief      View a typed array as an N-dimensional array
+  @param      storage  The typed array
+  @param      rank     Number of axes
+  @param      shape    Array of the length of each axis
+  @return     Pointer to the view; or `NULL` if the typed array is too
+              short for the shape, or in the event of an allocation
+              failure
+
+  Create a row major view of the typed array's elements, with their
+  width, so existing data (e.g., a column of attributes) can be used as
+  a matrix without copying.
+
+  @warning    The view is invalidated by any operation that reallocates
+              the typed array's buffer
+*/
+extern ndArray* ndWrap(tyArray*, size_t, size_t*);
+
+/**
+  @fn         void* ndElement(ndArray* array, size_t* index)
+  @brief      Get a pointer to the indexed element
+  @param      array  The N-dimensional array
+  @param      index  Array of the element's index along each axis
+  @return     Pointer to the element; or `NULL` in the event of a
+              bounds error
+*/
+extern void* ndElement(ndArray*, size_t*);
+
+/**
+  @fn         ndArray* ndView(ndArray* array, size_t* from, size_t* to, size_t* step)
+  @brief      Create a view of a slice of an N-dimensional array
+  @param      array  The N-dimensional array (or view)
+  @param      from   Array of the first index to take along each axis
+  @param      to     Array of one past the last index to take along each
+                     axis
+  @param      step   Array of the (positive) step along each axis; or
+                     `NULL` to take every element
+  @return     Pointer to the view; or `NULL` if the slice is out of
+              bounds or has a zero step, or in the event of an
+              allocation failure
+
+  Create an N-dimensional array that shares the given array's elements,
+  with the same rank and the shape of the slice. Writing to the view
+  writes to the original array.
+
+  @note       Slices of tiled arrays must start on a tile boundary of
+              the tiled axes and take every element along them
+  @warning    The view must be freed with ndNuke(), before the array it
+              views
+*/
+extern ndArray* ndView(ndArray*, size_t*, size_t*, size_t*);
+
+/**
+  @fn         ndArray* ndPermute(ndArray* array, size_t* axes)
+  @brief      Create a view of an N-dimensional array with its axes reordered
+  @param      array  The N-dimensional array (or view)
+  @param      axes   Array of the original axis that becomes each axis
+                     of the view
+  @return     Pointer to the view; or `NULL` if the axes are not a
+              permutation, or in the event of an allocation failure
+
+  Permute the axes, without copying, by permuting the shape and strides;
+  axis `k` of the view is axis `axes[k]` of the original.
+
+  @warning    The view must be freed with ndNuke(), before the array it
+              views
+*/
+extern ndArray* ndPermute(ndArray*, size_t*);
+
+/**
+  @fn         ndArray* ndTranspose(ndArray* array)
+  @brief      Create a transposed view of an N-dimensional array
+  @param      array  The N-dimensional array (or view)
+  @return     Pointer to the view; or `NULL` in the event of an
+              allocation failure
+
+  Swap the last two axes, without copying, with ndPermute(). (Arrays of
+  rank less than two are their own transpose.)
+
+  @note       Walking a transposed view steps through memory by rows;
+              use ndCopy() to materialise it if it will be read often
+  @warning    The view must be freed with ndNuke(), before the array it
+              views
+*/
+extern ndArray* ndTranspose(ndArray*);
+
+/**
+  @fn         ndArray* ndCopy(ndArray* array, size_t tile, tpPool* pool)
+  @brief      Copy an N-dimensional array (or view) into new storage
+  @param      array  The N-dimensional array (or view)
+  @param      tile   Edge length of the tiles of the copy; or zero for
+                     row major order
+  @param      pool   Thread pool to run on; or `NULL` to run serially
+  @return     Pointer to the copy; or `NULL` in the event of an
+              allocation failure
+
+  Copy the elements into a new N-dimensional array of the same shape,
+  with the given layout. The last two axes are copied in blocks, which
+  are recursively halved along their longer side until they are small;
+  so whatever the source's strides, both it and the copy are walked in
+  cache sized pieces without the cache size being known (i.e., the copy
+  is cache oblivious). This makes copying a transposed view an efficient
+  out of place transpose.
+
+  @note       Top level blocks are shared between the pool's workers
+*/
+extern ndArray* ndCopy(ndArray*, size_t, tpPool*);
+
+/**
+  @fn         int ndMap(ndArray* target, ndArray* source, ndMapCallback callback, void* context, tpPool* pool)
+  @brief      Apply a function to every element of an N-dimensional array
+  @param      target    The N-dimensional array (or view) to write
+  @param      source    The N-dimensional array (or view) to read
+  @param      callback  Function to apply to each element
+  @param      context   Pointer passed through to the callback
+  @param      pool      Thread pool to run on; or `NULL` to run serially
+  @return     Zero on success; non-zero if the arrays' shapes differ
+
+  Call the callback on each pair of corresponding elements, splitting
+  the elements between the pool's workers. The target and source may
+  have different layouts and widths (e.g., to convert a tiled array of
+  `double`s to a row major array of `float`s), or be the same array, to
+  map in place.
+
+  @warning    Overlapping target and source arrays, other than the same
+              array, give undefined results
+*/
+extern int ndMap(ndArray*, ndArray*, ndMapCallback, void*, tpPool*);
+
+/**
+  @fn         ndArray* ndReduce(ndArray* array, size_t axis, ndReduceCallback callback, void* identity, void* context, tpPool* pool)
+  @brief      Reduce an N-dimensional array along an axis
+  @param      array     The N-dimensional array (or view)
+  @param      axis      The axis to reduce along
+  @param      callback  Function to fold each element into its
+                        accumulator
+  @param      identity  Pointer to the value each accumulator starts
+                        from, of the array's width
+  @param      context   Pointer passed through to the callback
+  @param      pool      Thread pool to run on; or `NULL` to run serially
+  @return     Pointer to a new, row major N-dimensional array of one
+              less rank, with that axis removed; or `NULL` if there is
+              no such axis, or in the event of an allocation failure
+
+  Fold the elements along the given axis, in order, into one accumulator
+  per position of the other axes. Accumulators are split between the
+  pool's workers and batches of them are advanced along the axis in
+  step, so memory is read in order whichever axis is reduced.
+
+  @note       Reducing an array of rank one gives an array of rank zero,
+              which has one element
+*/
+extern ndArray* ndReduce(ndArray*, size_t, ndReduceCallback, void*, void*, tpPool*);
+
+/**
+  @fn         void ndNuke(ndArray* array)
+  @brief      Free the memory allocated by the N-dimensional array
+  @param      array  The N-dimensional array (or view)
+
+  @note       The elements are only freed if the array owns them (i.e.,
+              it is not a view)
+*/
+extern void ndNuke(ndArray*);
+
+#endif
@@ -0,0 +1,305 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "symbolTable.h"
+
+/* Bytes per arena chunk; longer strings get a chunk of their own */
+#define symChunk (1 << 16)
+
+/* Symbols are kept in segments that double in size, from 64, so they
+   never move; 27 segments is enough for every identifier */
+#define symFirst    6
+#define symSegments 27
+
+/* The text is published last, so a reader that sees it sees the rest */
+typedef struct {
+  _Atomic(char*) text;
+  size_t         length;
+} entry;
+
+typedef struct chunk {
+  struct chunk* next;
+} chunk;
+
+typedef struct {
+  pthread_mutex_t lock;
+  uint64_t*       slot;    /* Hash in the high word, identifier + 1 in the low */
+  size_t          slots;
+  size_t          count;
+  chunk*          chunks;
+  char*           free;    /* Unused space in the current chunk */
+  size_t          left;
+} shard;
+
+struct symTable {
+  size_t          shards;
+  int             concurrent;
+  atomic_size_t   next;
+  _Atomic(entry*) segment[symSegments];
+  shard*          shard;
+};
+
+/* 64-bit hash of a string, eight bytes at a time */
+static uint64_t hashBytes(char* text, size_t length) {
+  uint64_t          hash = UINT64_C(0x9E3779B97F4A7C15) ^ (length * UINT64_C(0xBF58476D1CE4E5B9));
+  uint64_t          word;
+  unsigned __int128 product;
+
+  for (; length >= 8; text += 8, length -= 8) {
+    memcpy(&word, text, 8);
+    product = (unsigned __int128)(word ^ UINT64_C(0xA0761D6478BD642F)) * (hash ^ UINT64_C(0xE7037ED1A0B428DB));
+    hash    = (uint64_t)product ^ (uint64_t)(product >> 64);
+  }
+
+  if (length) {
+    word = 0;
+    memcpy(&word, text, length);
+    product = (unsigned __int128)(word ^ UINT64_C(0xA0761D6478BD642F)) * (hash ^ UINT64_C(0xE7037ED1A0B428DB));
+    hash    = (uint64_t)product ^ (uint64_t)(product >> 64);
+  }
+
+  /* SplitMix64 finaliser */
+  hash = (hash ^ (hash >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+  hash = (hash ^ (hash >> 27)) * UINT64_C(0x94D049BB133111EB);
+  return hash ^ (hash >> 31);
+}
+
+/* Segment and offset of a symbol's entry */
+static size_t segmentOf(symId symbol, size_t* offset) {
+  uint64_t n = (uint64_t)symbol + ((uint64_t)1 << symFirst);
+  size_t   k = 63 - (size_t)__builtin_clzll(n);
+
+  *offset = (size_t)(n - ((uint64_t)1 << k));
+  return k - symFirst;
+}
+
+static entry* entryOf(symTable* table, symId symbol) {
+  size_t offset, k = segmentOf(symbol, &offset);
+  entry* segment = atomic_load_explicit(table->segment + k, memory_order_acquire);
+
+  return segment ? segment + offset : NULL;
+}
+
+/* Entry for a new symbol, allocating its segment if need be */
+static entry* claimEntry(symTable* table, symId symbol) {
+  size_t offset, k = segmentOf(symbol, &offset);
+  entry* segment = atomic_load_explicit(table->segment + k, memory_order_acquire);
+
+  if (!segment) {
+    entry* expected = NULL;
+
+    /* Zeroed, so entries not yet filled in have no text */
+    if (!(segment = calloc((size_t)1 << (k + symFirst), sizeof(entry)))) {
+      /* Memory allocation failure :P */
+      return NULL;
+    }
+
+    /* Another shard may have got there first */
+    if (!atomic_compare_exchange_strong_explicit(table->segment + k, &expected, segment, memory_order_acq_rel, memory_order_acquire)) {
+      free(segment);
+      segment = expected;
+    }
+  }
+
+  return segment + offset;
+}
+
+/* Copy a string, NUL terminated, into a shard's arena */
+static char* store(shard* s, char* text, size_t length) {
+  char* copy;
+
+  if (length + 1 > s->left) {
+    size_t size     = length + 1 > symChunk ? length + 1 : symChunk;
+    chunk* newChunk = malloc(sizeof(chunk) + size);
+
+    if (!newChunk) {
+      /* Memory allocation failure :P */
+      return NULL;
+    }
+
+    newChunk->next = s->chunks;
+    s->chunks      = newChunk;
+
+    /* Keep what is left of the current chunk if this string fills its own */
+    if (size == symChunk) {
+      s->free = (char*)(newChunk + 1);
+      s->left = size;
+    } else {
+      copy = (char*)(newChunk + 1);
+      memcpy(copy, text, length);
+      copy[length] = '\0';
+      return copy;
+    }
+  }
+
+  copy = s->free;
+  memcpy(copy, text, length);
+  copy[length] = '\0';
+
+  s->free += length + 1;
+  s->left -= length + 1;
+  return copy;
+}
+
+/* Double a shard's hash table */
+static int grow(shard* s) {
+  size_t    slots = s->slots ? s->slots * 2 : 64, i;
+  uint64_t* slot  = calloc(slots, sizeof(uint64_t));
+
+  if (!slot) {
+    /* Memory allocation failure :P */
+    return 1;
+  }
+
+  for (i = 0; i < s->slots; i++) {
+    if (s->slot[i]) {
+      size_t j = (size_t)(s->slot[i] >> 32) & (slots - 1);
+
+      while (slot[j]) { j = (j + 1) & (slots - 1); }
+      slot[j] = s->slot[i];
+    }
+  }
+
+  free(s->slot);
+  s->slot  = slot;
+  s->slots = slots;
+  return 0;
+}
+
+/* Find, or if asked, create the symbol for a string */
+static symId lookup(symTable* table, char* text, size_t length, int create) {
+  uint64_t hash   = hashBytes(text, length);
+  uint32_t low    = (uint32_t)hash;
+  shard*   s      = table->shard + ((size_t)(hash >> 32) & (table->shards - 1));
+  symId    symbol = symNone;
+  size_t   i, claimed;
+  entry*   e;
+  char*    copy;
+
+  if (table->concurrent) { pthread_mutex_lock(&s->lock); }
+
+  if (s->slots) {
+    for (i = low & (s->slots - 1); s->slot[i]; i = (i + 1) & (s->slots - 1)) {
+      if ((uint32_t)(s->slot[i] >> 32) == low) {
+        e = entryOf(table, (symId)(s->slot[i] - 1));
+
+        /* Written under this shard's lock, so needs no ordering */
+        if (e->length == length && !memcmp(atomic_load_explicit(&e->text, memory_order_relaxed), text, length)) {
+          symbol = (symId)(s->slot[i] - 1);
+          goto done;
+        }
+      }
+    }
+  }
+
+  if (!create) { goto done; }
+
+  /* Keep the table at most half full */
+  if ((s->count + 1) * 2 > s->slots) {
+    if (grow(s)) { goto done; }
+  }
+
+  if (!(copy = store(s, text, length))) { goto done; }
+
+  /* Only take the next identifier once its entry exists, so that a
+     failure leaves no gap in the identifiers */
+  claimed = atomic_load_explicit(&table->next, memory_order_relaxed);
+
+  do {
+    if (claimed >= symNone || !(e = claimEntry(table, (symId)claimed))) {
+      /* Out of identifiers, or memory allocation failure :P */
+      goto done;
+    }
+  } while (!atomic_compare_exchange_weak_explicit(&table->next, &claimed, claimed + 1, memory_order_relaxed, memory_order_relaxed));
+
+  symbol    = (symId)claimed;
+  e->length = length;
+  atomic_store_explicit(&e->text, copy, memory_order_release);
+
+  for (i = low & (s->slots - 1); s->slot[i]; i = (i + 1) & (s->slots - 1));
+  s->slot[i] = ((uint64_t)low << 32) | ((uint64_t)symbol + 1);
+  ++s->count;
+
+done:
+  if (table->concurrent) { pthread_mutex_unlock(&s->lock); }
+
+  return symbol;
+}
+
+symTable* symCreate(size_t shards) {
+  symTable* newTable = malloc(sizeof(symTable));
+  size_t    i;
+
+  if (!newTable) { return NULL; }
+
+  newTable->concurrent = shards > 0;
+  for (newTable->shards = 1; newTable->shards < shards; newTable->shards *= 2);
+
+  atomic_init(&newTable->next, 0);
+  for (i = 0; i < symSegments; i++) {
+    atomic_init(newTable->segment + i, NULL);
+  }
+
+  if (!(newTable->shard = calloc(newTable->shards, sizeof(shard)))) {
+    /* Memory allocation failure :P */
+    free(newTable);
+    return NULL;
+  }
+
+  for (i = 0; i < newTable->shards; i++) {
+    pthread_mutex_init(&newTable->shard[i].lock, NULL);
+  }
+
+  return newTable;
+}
+
+symId symIntern(symTable* table, char* text, size_t length) {
+  return lookup(table, text, length, 1);
+}
+
+symId symFind(symTable* table, char* text, size_t length) {
+  return lookup(table, text, length, 0);
+}
+
+char* symString(symTable* table, symId symbol) {
+  entry* e = symbol < symCount(table) ? entryOf(table, symbol) : NULL;
+  return e ? atomic_load_explicit(&e->text, memory_order_acquire) : NULL;
+}
+
+size_t symLength(symTable* table, symId symbol) {
+  entry* e = symbol < symCount(table) ? entryOf(table, symbol) : NULL;
+  return e && atomic_load_explicit(&e->text, memory_order_acquire) ? e->length : 0;
+}
+
+size_t symCount(symTable* table) {
+  return atomic_load_explicit(&table->next, memory_order_relaxed);
+}
+
+void symNuke(symTable* table) {
+  size_t i;
+
+  if (table) {
+    for (i = 0; i < table->shards; i++) {
+      chunk* c = table->shard[i].chunks;
+
+      while (c) {
+        chunk* next = c->next;
+        free(c);
+        c = next;
+      }
+
+      free(table->shard[i].slot);
+      pthread_mutex_destroy(&table->shard[i].lock);
+    }
+
+    for (i = 0; i < symSegments; i++) {
+      free(atomic_load(table->segment + i));
+    }
+
+    free(table->shard);
+    free(table);
+  }
+}
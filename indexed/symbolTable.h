@@ -0,0 +1,142 @@
+/**
+  @file       symbolTable.h
+  @brief      String interning symbol table header file
+  @author     Christopher Harrison (Xophmeister)
+  @copyright  @ref license
+
+  Implements a string interner: each distinct string is stored once, in
+  an append only arena, and is given a small integer symbol identifier.
+  Interning the same bytes again returns the same identifier, so strings
+  can be compared for equality with an integer comparison, rather than
+  with `strcmp` through an @ref ordering, and stored as identifiers in
+  typed arrays (e.g., a column of a parsed table).
+
+  Strings are found through an open addressed hash table, which keeps 32
+  bits of each string's hash alongside its identifier, so strings are
+  only compared when their hashes agree.
+
+  In concurrent mode, the hash table and arena are split into shards,
+  chosen by hash, each with its own lock; so threads interning different
+  strings rarely contend, and any number can intern at once (e.g., from
+  tpFor() callbacks).
+*/
+
+#ifndef SYMBOLTABLE_H
+#define SYMBOLTABLE_H
+
+#include <stdlib.h>
+#include <stdint.h>
+
+/**
+  @typedef    symId
+  @brief      Symbol identifier
+*/
+typedef uint32_t symId;
+
+/**
+  @def        symNone
+  @brief      Sentinel symbol identifier
+
+  Returned by functions that resolve a symbol when there is no such
+  symbol, or in the event of an allocation failure.
+*/
+#define symNone ((symId)-1)
+
+/**
+  @typedef    symTable
+  @brief      Symbol table
+
+  The symbol table's structure is private; it must be created with
+  symCreate() and freed with symNuke().
+*/
+typedef struct symTable symTable;
+
+/**
+  @fn         symTable* symCreate(size_t shards)
+  @brief      Create an empty symbol table
+  @param      shards  Number of shards for concurrent use, which will be
+                      rounded up to a power of two; or zero for single
+                      threaded use, without locking
+  @return     Pointer to the new symbol table; or `NULL` in the event of
+              an allocation failure
+
+  @note       A few times the number of threads that will intern at once
+              is a reasonable number of shards
+*/
+extern symTable* symCreate(size_t);
+
+/**
+  @fn         symId symIntern(symTable* table, char* text, size_t length)
+  @brief      Intern a string
+  @param      table   The symbol table
+  @param      text    The string's bytes, which need not be NUL
+                      terminated and may contain NULs
+  @param      length  Number of bytes
+  @return     The string's symbol identifier; or symNone in the event of
+              an allocation failure
+
+  Find the symbol for the given bytes or, if there is none, copy them
+  into the arena and create one. In single threaded mode, identifiers
+  are given out densely, in order, from zero.
+
+  @note       In concurrent mode, identifiers are still dense, but their
+              order depends on how the threads interleave
+  @note       An allocation failure consumes no identifier, so they stay
+              dense regardless
+*/
+extern symId symIntern(symTable*, char*, size_t);
+
+/**
+  @fn         symId symFind(symTable* table, char* text, size_t length)
+  @brief      Find a string's symbol, without interning it
+  @param      table   The symbol table
+  @param      text    The string's bytes
+  @param      length  Number of bytes
+  @return     The string's symbol identifier; or symNone if it has not
+              been interned
+*/
+extern symId symFind(symTable*, char*, size_t);
+
+/**
+  @fn         char* symString(symTable* table, symId symbol)
+  @brief      Get the string of a symbol
+  @param      table   The symbol table
+  @param      symbol  The symbol identifier
+  @return     Pointer to the interned, NUL terminated copy of the
+              string; or `NULL` if there is no such symbol (or, in
+              concurrent mode, it is still being interned)
+
+  @note       Interned strings never move, so the pointer is valid until
+              the symbol table is freed
+  @warning    The string must not be modified
+*/
+extern char* symString(symTable*, symId);
+
+/**
+  @fn         size_t symLength(symTable* table, symId symbol)
+  @brief      Get the length of a symbol's string
+  @param      table   The symbol table
+  @param      symbol  The symbol identifier
+  @return     Number of bytes in the string; or zero if there is no such
+              symbol (or, in concurrent mode, it is still being interned)
+*/
+extern size_t symLength(symTable*, symId);
+
+/**
+  @fn         size_t symCount(symTable* table)
+  @brief      Get the number of symbols in a symbol table
+  @param      table  The symbol table
+  @return     Number of symbols; all identifiers are less than this
+*/
+extern size_t symCount(symTable*);
+
+/**
+  @fn         void symNuke(symTable* table)
+  @brief      Free the memory allocated by the symbol table
+  @param      table  The symbol table
+
+  @note       This frees all the interned strings
+*/
+extern void symNuke(symTable*);
+
+#endif
@@ -0,0 +1,146 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "typedArray.h"
+#include "dynamicArray.h"
+
+tyArray* tyCreate(size_t length, size_t width) {
+  tyArray* newArray = malloc(sizeof(tyArray));
+
+  if (newArray) {
+    newArray->length    = length;
+    newArray->allocated = length;
+    newArray->width     = width;
+    newArray->buffer    = NULL;
+
+    /* Unlike pointers, all-bits-zero is the zero value we want */
+    if (length) {
+      newArray->buffer = calloc(length, width);
+
+      if (!newArray->buffer) {
+        /* Memory allocation failure :P */
+        free(newArray);
+        newArray = NULL;
+      }
+    }
+  }
+
+  return newArray;
+}
+
+void tyResize(tyArray* array, size_t length) {
+  if (array) {
+    if (length) {
+      size_t oldLength = array->length;
+
+      if (length > array->allocated) {
+        void* buffer = realloc(array->buffer, array->width * length);
+
+        if (!buffer) {
+          /* Memory reallocation failed :P */
+          free(array->buffer);
+          array->buffer    = NULL;
+          array->length    = 0;
+          array->allocated = 0;
+          return;
+        }
+
+        array->buffer    = buffer;
+        array->allocated = length;
+      }
+
+      array->length = length;
+
+      /* Zero newly created space */
+      if (length > oldLength) {
+        memset((char*)array->buffer + oldLength * array->width, 0, (length - oldLength) * array->width);
+      }
+    } else {
+      free(array->buffer);
+      array->buffer    = NULL;
+      array->length    = 0;
+      array->allocated = 0;
+    }
+  }
+}
+
+void tyAppend(tyArray* array, void* element) {
+  if (array->allocated == array->length) {
+    /* Double buffer's allocation */
+    size_t newAllocation = array->length ? array->length * 2 : 1;
+    void*  buffer        = realloc(array->buffer, array->width * newAllocation);
+
+    if (!buffer) {
+      /* Memory reallocation failed :P */
+      free(array->buffer);
+      array->buffer    = NULL;
+      array->length    = 0;
+      array->allocated = 0;
+      return;
+    }
+
+    array->buffer    = buffer;
+    array->allocated = newAllocation;
+  }
+
+  memcpy((char*)array->buffer + array->length++ * array->width, element, array->width);
+}
+
+void* tyElement(tyArray* array, size_t index) {
+  if (index < array->length) {
+    return (char*)array->buffer + index * array->width;
+  } else {
+    return NULL;
+  }
+}
+
+tyArray* tyProject(void* array, size_t length, size_t width) {
+  tyArray* projected = tyCreate(length, width);
+
+  if (projected && length) {
+    memcpy(projected->buffer, array, length * width);
+  }
+
+  return projected;
+}
+
+dynArray* tyView(tyArray* array) {
+  return dynProject(array->buffer, array->length, array->width);
+}
+
+tyArray* tyMap(dynArray* array, size_t width, dynMapSlotCallback callback) {
+  size_t   n         = array ? array->length : 0;
+  tyArray* transform = tyCreate(n, width);
+
+  if (transform) {
+    while (n--) {
+      callback(*dynElement(array, n), (char*)transform->buffer + n * width, n, array);
+    }
+  }
+
+  return transform;
+}
+
+tyArray* tyZipWith(dynArray* arrayAlpha, dynArray* arrayBeta, size_t width, dynZipWithSlotCallback callback) {
+  size_t   n = 0;
+  tyArray* zipped;
+
+  if (arrayAlpha && arrayBeta) {
+    n = arrayAlpha->length > arrayBeta->length ? arrayBeta->length : arrayAlpha->length;
+  }
+
+  if ((zipped = tyCreate(n, width))) {
+    while (n--) {
+      callback(*dynElement(arrayAlpha, n), *dynElement(arrayBeta, n), (char*)zipped->buffer + n * width, n, arrayAlpha, arrayBeta);
+    }
+  }
+
+  return zipped;
+}
+
+void tyNuke(tyArray* array) {
+  if (array) {
+    free(array->buffer);
+    free(array);
+  }
+}
@@ -0,0 +1,207 @@
+/**
+  @file       typedArray.h
+  @brief      Typed array header file
+  @author     Christopher Harrison (Xophmeister)
+  @copyright  @ref license
+
+  Implements a homogeneous, dynamically allocated array, where each
+  element is stored by value in one contiguous buffer. Where a dynamic
+  array holds a pointer per element, a typed array of, say, `double`s
+  holds the `double`s themselves; so it can be handed directly to code
+  that expects a plain C array and is read sequentially without any
+  pointer chasing.
+
+  This makes typed arrays suitable for columns of attributes that sit
+  alongside other arrays (e.g., edge weights aligned with a compact
+  graph's edges; see cgAttribute()).
+*/
+
+#ifndef TYPEDARRAY_H
+#define TYPEDARRAY_H
+
+#include <stdlib.h>
+#include "dynamicArray.h"
+
+/**
+  @struct     tyArray
+  @brief      Typed array
+  @var        tyArray::length
+              Number of elements in the array
+  @var        tyArray::allocated
+              Actual number of elements currently allocated
+  @var        tyArray::width
+              Width of each element, in bytes
+  @var        tyArray::buffer
+              Array's data buffer
+
+  @warning    tyArray::length, tyArray::allocated and tyArray::width are
+              not write protected
+*/
+typedef struct {
+  size_t length;
+  size_t allocated;
+  size_t width;
+  void*  buffer;
+} tyArray;
+
+/**
+  @def        tyAt(array, type, index)
+  @brief      Access an element of a typed array by value
+  @param      array  The typed array
+  @param      type   The type of its elements
+  @param      index  The index of the element
+
+  Expands to an lvalue for the element at the given index, so it can be
+  both read and assigned. For example:
+
+  @code{.c}
+  tyArray* weight = tyCreate(8, sizeof(double));
+  tyAt(weight, double, 3) = 1.5;
+  @endcode
+
+  @warning    No bounds checking is done; use tyElement() for that
+*/
+#define tyAt(array, type, index) (((type*)(array)->buffer)[index])
+
+/**
+  @fn         tyArray* tyCreate(size_t length, size_t width)
+  @brief      Create a typed array of a given size
+  @param      length  Number of elements to initially allocate
+  @param      width   Width of each element, in bytes
+  @return     Pointer to new typed array structure; or `NULL` in the
+              event of an allocation failure
+
+  Create a typed array of a given size, with all elements' bytes
+  initialised to zero.
+
+  @note       The allocation size will match the requested size
+*/
+extern tyArray* tyCreate(size_t, size_t);
+
+/**
+  @fn         void tyResize(tyArray* array, size_t length)
+  @brief      Resize the array to the given number of elements
+  @param      array   The typed array to resize
+  @param      length  The new length
+
+  Enlarge or reduce the size of a typed array to a given length. Any new
+  elements are zeroed.
+
+  @note       If a typed array is reduced in length, any tail elements
+              will be unrecoverable
+  @warning    In the event of a reallocation failure, the original array
+              will be lost and the length reset to zero
+*/
+extern void tyResize(tyArray*, size_t);
+
+/**
+  @fn         void tyAppend(tyArray* array, void* element)
+  @brief      Append a copy of an element to the array
+  @param      array    The typed array to append to
+  @param      element  Pointer to the element to copy
+
+  Copy the array's width of bytes from the given pointer onto the end of
+  the typed array, updating its structure appropriately.
+
+  @note       Memory will be over-allocated if there is not enough free
+              space in the buffer
+  @warning    In the event of a reallocation failure, the original array
+              will be lost and the length reset to zero
+*/
+extern void tyAppend(tyArray*, void*);
+
+/**
+  @fn         void* tyElement(tyArray* array, size_t index)
+  @brief      Get a pointer to the indexed element
+  @param      array  The typed array
+  @param      index  The index of the element
+  @return     Pointer to the element within the buffer; or `NULL` in the
+              event of a bounds error
+
+  Get the pointer to the specific element, which can be cast and
+  dereferenced to read or write the element's value.
+
+  @warning    Pointers into the buffer are invalidated by any operation
+              that reallocates it (i.e., tyResize() and tyAppend())
+*/
+extern void* tyElement(tyArray*, size_t);
+
+/**
+  @fn         tyArray* tyProject(void* array, size_t length, size_t width)
+  @brief      Copy a regular array into a typed one
+  @param      array   The array
+  @param      length  The array's length
+  @param      width   Each element's width
+  @return     Pointer to the new typed array; or `NULL` in the event of
+              an allocation failure
+
+  Unlike dynProject(), the elements are copied, so the original array
+  need not outlive the typed array.
+*/
+extern tyArray* tyProject(void*, size_t, size_t);
+
+/**
+  @fn         dynArray* tyView(tyArray* array)
+  @brief      View a typed array as a dynamic one
+  @param      array  The typed array
+  @return     Pointer to a dynamic array of pointers to each element;
+              or `NULL` in the event of an allocation failure
+
+  Project the typed array's buffer into a dynamic array, so the dynamic
+  array functions (e.g., dynMap()) can be applied to it.
+
+  @note       The view must be freed with dynNuke(), which will not
+              affect the typed array
+  @warning    The view is invalidated by any operation that reallocates
+              the typed array's buffer
+*/
+extern dynArray* tyView(tyArray*);
+
+/**
+  @fn         tyArray* tyMap(dynArray* array, size_t width, dynMapSlotCallback callback)
+  @brief      Map the elements of a dynamic array into a typed array
+  @param      array     The dynamic array to iterate over
+  @param      width     Width of each transformed element, in bytes
+  @param      callback  Pointer to callback function
+  @return     Pointer to the typed array of transformed elements; or
+              `NULL` in the event of an allocation failure
+
+  Creates a new typed array by having the specified callback function
+  write the transformed value of each element from the dynamic array
+  directly into the typed array's buffer. For example:
+
+  @code{.c}
+  tyArray* doubled = tyMap(ints, sizeof(int), &doubleInt);
+  @endcode
+
+  @note       The callback is called with the slot for each element
+              (see dynMapSlotCallback)
+*/
+extern tyArray* tyMap(dynArray*, size_t, dynMapSlotCallback);
+
+/**
+  @fn         tyArray* tyZipWith(dynArray* arrayAlpha, dynArray* arrayBeta, size_t width, dynZipWithSlotCallback callback)
+  @brief      Zip two dynamic arrays' elements pairwise into a typed array
+  @param      arrayAlpha  The first dynamic array
+  @param      arrayBeta   The second dynamic array
+  @param      width       Width of each zipped result, in bytes
+  @param      callback    Pointer to callback function
+  @return     Pointer to the typed array of zipped results; or `NULL` in
+              the event of an allocation failure
+
+  As tyMap(), but through the specified callback function applied to
+  successive element pairs, as in dynZipWith().
+
+  @note       The length of the typed array will match that of the
+              shorter input array
+*/
+extern tyArray* tyZipWith(dynArray*, dynArray*, size_t, dynZipWithSlotCallback);
+
+/**
+  @fn         void tyNuke(tyArray* array)
+  @brief      Free the memory allocated by the typed array
+  @param      array  The typed array
+*/
+extern void tyNuke(tyArray*);
+
+#endif
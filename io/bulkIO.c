@@ -0,0 +1,689 @@
+/* For O_DIRECT */
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+
+#include "bulkIO.h"
+#include "../indexed/typedArray.h"
+
+/* Defaults */
+#define bkDepth (32)
+#define bkBlock (1 << 20)
+
+/* At most this many threads, when falling back */
+#define bkThreadLimit (16)
+
+/* File format */
+#define bkMagic "cs101ty1"
+
+typedef struct {
+  char     magic[8];
+  uint64_t width;
+  uint64_t length;
+} header;
+
+/* A queued transfer, split into blocks */
+typedef struct transfer {
+  int              fd;
+  int              write;
+  size_t           align;     /* Bytes each block is padded to */
+  char*            data;
+  size_t           length;
+  off_t            offset;
+  size_t           issued;    /* Bytes handed to blocks so far */
+  size_t           inflight;  /* Blocks not yet completed */
+  size_t           done;      /* Bytes transferred */
+  ssize_t          error;
+  bkCallback       callback;
+  void*            context;
+  struct transfer* next;
+} transfer;
+
+/* A block in flight, staged through the buffer of the same index */
+typedef struct {
+  transfer* owner;
+  char*     data;    /* The caller's memory for the block */
+  size_t    length;  /* Bytes of the caller's memory */
+  size_t    size;    /* Bytes requested, after padding */
+  off_t     offset;
+  ssize_t   result;  /* Set by the thread that served it */
+} request;
+
+/* Mapped io_uring queues */
+typedef struct {
+  int                  fd;
+  int                  fixed;  /* Whether the buffers are registered */
+  unsigned             unsubmitted;
+  void*                sqRing;
+  size_t               sqSize;
+  void*                cqRing;
+  size_t               cqSize;
+  struct io_uring_sqe* sqe;
+  size_t               sqeSize;
+  atomic_uint*         sqTail;
+  unsigned             sqMask;
+  unsigned*            sqArray;
+  atomic_uint*         cqHead;
+  atomic_uint*         cqTail;
+  unsigned             cqMask;
+  struct io_uring_cqe* cqe;
+} uring;
+
+struct bkEngine {
+  size_t          depth;
+  size_t          block;
+  char*           staging;
+  request*        slot;
+  size_t*         idle;         /* Stack of free slots */
+  size_t          idles;
+  transfer*       head;         /* Transfers with blocks still to issue */
+  transfer*       tail;
+  size_t          outstanding;
+
+  /* io_uring backend, if ring.fd >= 0 */
+  uring           ring;
+
+  /* Thread backend, otherwise */
+  size_t          threads;
+  pthread_t*      thread;
+  pthread_mutex_t lock;
+  pthread_cond_t  work;
+  pthread_cond_t  served;
+  int             stopping;
+  size_t*         pending;      /* Queue of slots to serve */
+  size_t          pendingHead;
+  size_t          pendingCount;
+  size_t*         finished;     /* Slots served, but not yet completed */
+  size_t          finishedCount;
+  size_t*         reaped;
+};
+
+static char* stage(bkEngine* engine, size_t slot) {
+  return engine->staging + slot * engine->block;
+}
+
+/* io_uring ******************************************************************/
+
+static void uringClose(uring* ring) {
+  if (ring->sqe)                    { munmap(ring->sqe, ring->sqeSize); }
+  if (ring->cqRing && ring->cqSize) { munmap(ring->cqRing, ring->cqSize); }
+  if (ring->sqRing)                 { munmap(ring->sqRing, ring->sqSize); }
+  if (ring->fd >= 0)                { close(ring->fd); }
+
+  memset(ring, 0, sizeof(uring));
+  ring->fd = -1;
+}
+
+static int uringOpen(bkEngine* engine) {
+  uring*                 ring = &engine->ring;
+  struct io_uring_params params;
+  struct iovec*          buffer;
+  char*                  sq;
+  char*                  cq;
+  size_t                 i;
+
+  memset(&params, 0, sizeof(params));
+  ring->fd = (int)syscall(__NR_io_uring_setup, (unsigned)engine->depth, &params);
+
+  /* Not supported, or not permitted */
+  if (ring->fd < 0) { return -1; }
+
+  ring->sqSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  ring->cqSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+
+  /* Both rings may share one mapping */
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    if (ring->cqSize > ring->sqSize) { ring->sqSize = ring->cqSize; }
+    ring->cqSize = 0;
+  }
+
+  sq = mmap(NULL, ring->sqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+  if (sq == MAP_FAILED) { goto failed; }
+  ring->sqRing = sq;
+
+  if (ring->cqSize) {
+    cq = mmap(NULL, ring->cqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+    if (cq == MAP_FAILED) { goto failed; }
+  } else {
+    cq = sq;
+  }
+  ring->cqRing = cq;
+
+  ring->sqeSize = params.sq_entries * sizeof(struct io_uring_sqe);
+  ring->sqe     = mmap(NULL, ring->sqeSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+  if (ring->sqe == MAP_FAILED) { ring->sqe = NULL; goto failed; }
+
+  ring->sqTail  = (atomic_uint*)(sq + params.sq_off.tail);
+  ring->sqMask  = *(unsigned*)(sq + params.sq_off.ring_mask);
+  ring->sqArray = (unsigned*)(sq + params.sq_off.array);
+  ring->cqHead  = (atomic_uint*)(cq + params.cq_off.head);
+  ring->cqTail  = (atomic_uint*)(cq + params.cq_off.tail);
+  ring->cqMask  = *(unsigned*)(cq + params.cq_off.ring_mask);
+  ring->cqe     = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+
+  /* Register the staging buffers, if the locked memory limit allows */
+  if ((buffer = malloc(sizeof(struct iovec) * engine->depth))) {
+    for (i = 0; i < engine->depth; i++) {
+      buffer[i].iov_base = stage(engine, i);
+      buffer[i].iov_len  = engine->block;
+    }
+
+    ring->fixed = !syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_BUFFERS, buffer, (unsigned)engine->depth);
+    free(buffer);
+  }
+
+  return 0;
+
+failed:
+  uringClose(ring);
+  return -1;
+}
+
+static void uringSubmit(bkEngine* engine, size_t slot) {
+  uring*               ring  = &engine->ring;
+  request*             b     = engine->slot + slot;
+  unsigned             tail  = atomic_load_explicit(ring->sqTail, memory_order_relaxed);
+  unsigned             index = tail & ring->sqMask;
+  struct io_uring_sqe* sqe   = ring->sqe + index;
+
+  memset(sqe, 0, sizeof(struct io_uring_sqe));
+
+  if (ring->fixed) {
+    sqe->opcode    = b->owner->write ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+    sqe->buf_index = (uint16_t)slot;
+  } else {
+    sqe->opcode    = b->owner->write ? IORING_OP_WRITE : IORING_OP_READ;
+  }
+
+  sqe->fd        = b->owner->fd;
+  sqe->off       = (uint64_t)b->offset;
+  sqe->addr      = (uint64_t)(uintptr_t)stage(engine, slot);
+  sqe->len       = (uint32_t)b->size;
+  sqe->user_data = slot;
+
+  ring->sqArray[index] = index;
+  atomic_store_explicit(ring->sqTail, tail + 1, memory_order_release);
+  ++ring->unsubmitted;
+}
+
+/* Hand the kernel any new requests, optionally waiting for a completion */
+static void uringEnter(uring* ring, int wait) {
+  if (ring->unsubmitted || wait) {
+    int submitted = (int)syscall(__NR_io_uring_enter, ring->fd, ring->unsubmitted, wait ? 1 : 0, wait ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+
+    /* Interrupted; the caller will come round again */
+    if (submitted > 0) { ring->unsubmitted -= (unsigned)submitted; }
+  }
+}
+
+/* Threads *******************************************************************/
+
+static ssize_t serve(bkEngine* engine, size_t slot) {
+  request* b     = engine->slot + slot;
+  char*    data  = stage(engine, slot);
+  size_t   moved = 0;
+
+  while (moved < b->size) {
+    ssize_t n = b->owner->write ? pwrite(b->owner->fd, data + moved, b->size - moved, b->offset + (off_t)moved)
+                                : pread(b->owner->fd, data + moved, b->size - moved, b->offset + (off_t)moved);
+
+    if (n < 0) {
+      if (errno == EINTR) { continue; }
+      return -errno;
+    }
+
+    /* End of file */
+    if (!n) { break; }
+
+    moved += (size_t)n;
+  }
+
+  return (ssize_t)moved;
+}
+
+static void* work(void* argument) {
+  bkEngine* engine = (bkEngine*)argument;
+
+  pthread_mutex_lock(&engine->lock);
+
+  while (1) {
+    size_t slot;
+
+    while (!engine->pendingCount && !engine->stopping) {
+      pthread_cond_wait(&engine->work, &engine->lock);
+    }
+
+    if (!engine->pendingCount) { break; }
+
+    slot = engine->pending[engine->pendingHead];
+    engine->pendingHead = (engine->pendingHead + 1) % engine->depth;
+    --engine->pendingCount;
+    pthread_mutex_unlock(&engine->lock);
+
+    engine->slot[slot].result = serve(engine, slot);
+
+    pthread_mutex_lock(&engine->lock);
+    engine->finished[engine->finishedCount++] = slot;
+    pthread_cond_signal(&engine->served);
+  }
+
+  pthread_mutex_unlock(&engine->lock);
+  return NULL;
+}
+
+static void threadsClose(bkEngine* engine) {
+  size_t i;
+
+  pthread_mutex_lock(&engine->lock);
+  engine->stopping = 1;
+  pthread_cond_broadcast(&engine->work);
+  pthread_mutex_unlock(&engine->lock);
+
+  for (i = 0; i < engine->threads; i++) {
+    pthread_join(engine->thread[i], NULL);
+  }
+
+  pthread_mutex_destroy(&engine->lock);
+  pthread_cond_destroy(&engine->work);
+  pthread_cond_destroy(&engine->served);
+}
+
+static int threadsOpen(bkEngine* engine) {
+  size_t threads = engine->depth < bkThreadLimit ? engine->depth : bkThreadLimit;
+
+  engine->thread   = malloc(sizeof(pthread_t) * threads);
+  engine->pending  = malloc(sizeof(size_t) * engine->depth);
+  engine->finished = malloc(sizeof(size_t) * engine->depth);
+  engine->reaped   = malloc(sizeof(size_t) * engine->depth);
+
+  if (!engine->thread || !engine->pending || !engine->finished || !engine->reaped) {
+    return -1;
+  }
+
+  pthread_mutex_init(&engine->lock, NULL);
+  pthread_cond_init(&engine->work, NULL);
+  pthread_cond_init(&engine->served, NULL);
+
+  for (engine->threads = 0; engine->threads < threads; engine->threads++) {
+    if (pthread_create(engine->thread + engine->threads, NULL, &work, engine)) {
+      threadsClose(engine);
+      engine->threads = 0;
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+static void threadsSubmit(bkEngine* engine, size_t slot) {
+  pthread_mutex_lock(&engine->lock);
+  engine->pending[(engine->pendingHead + engine->pendingCount++) % engine->depth] = slot;
+  pthread_cond_signal(&engine->work);
+  pthread_mutex_unlock(&engine->lock);
+}
+
+/* Engine ********************************************************************/
+
+static void finish(bkEngine* engine, transfer* t) {
+  --engine->outstanding;
+  t->callback(t->error ? t->error : (ssize_t)t->done, t->context);
+  free(t);
+}
+
+static void complete(bkEngine* engine, size_t slot, ssize_t result) {
+  request*  b = engine->slot + slot;
+  transfer* t = b->owner;
+
+  if (result < 0) {
+    if (!t->error) { t->error = result; }
+
+  } else if (t->write) {
+    if ((size_t)result < b->size) {
+      if (!t->error) { t->error = -EIO; }
+    } else {
+      t->done += b->length;
+    }
+
+  } else {
+    /* Short reads are the end of the file */
+    size_t n = (size_t)result < b->length ? (size_t)result : b->length;
+    memcpy(b->data, stage(engine, slot), n);
+    t->done += n;
+  }
+
+  engine->idle[engine->idles++] = slot;
+
+  if (!--t->inflight && t->issued == t->length) {
+    finish(engine, t);
+  }
+}
+
+/* Start the queued transfers' blocks in any free slots */
+static void issue(bkEngine* engine) {
+  while (engine->head && engine->idles) {
+    transfer* t      = engine->head;
+    size_t    slot   = engine->idle[--engine->idles];
+    request*  b      = engine->slot + slot;
+    size_t    length = t->length - t->issued;
+
+    if (length > engine->block) { length = engine->block; }
+
+    b->owner  = t;
+    b->data   = t->data + t->issued;
+    b->length = length;
+    b->offset = t->offset + (off_t)t->issued;
+    b->size   = (length + t->align - 1) / t->align * t->align;
+
+    if (t->write) {
+      memcpy(stage(engine, slot), b->data, length);
+      memset(stage(engine, slot) + length, 0, b->size - length);
+    }
+
+    t->issued += length;
+    ++t->inflight;
+
+    if (t->issued == t->length) {
+      engine->head = t->next;
+      if (!engine->head) { engine->tail = NULL; }
+    }
+
+    if (engine->ring.fd >= 0) {
+      uringSubmit(engine, slot);
+    } else {
+      threadsSubmit(engine, slot);
+    }
+  }
+
+  if (engine->ring.fd >= 0) {
+    uringEnter(&engine->ring, 0);
+  }
+}
+
+/* Complete whatever blocks have finished, optionally waiting for one */
+static void reap(bkEngine* engine, int wait) {
+  if (engine->ring.fd >= 0) {
+    uring*   ring = &engine->ring;
+    unsigned head, tail;
+
+    uringEnter(ring, wait);
+
+    head = atomic_load_explicit(ring->cqHead, memory_order_relaxed);
+    tail = atomic_load_explicit(ring->cqTail, memory_order_acquire);
+
+    while (head != tail) {
+      struct io_uring_cqe* cqe = ring->cqe + (head++ & ring->cqMask);
+      complete(engine, (size_t)cqe->user_data, cqe->res);
+    }
+
+    atomic_store_explicit(ring->cqHead, head, memory_order_release);
+
+  } else {
+    size_t i, count;
+
+    pthread_mutex_lock(&engine->lock);
+
+    while (wait && !engine->finishedCount) {
+      pthread_cond_wait(&engine->served, &engine->lock);
+    }
+
+    count = engine->finishedCount;
+    memcpy(engine->reaped, engine->finished, sizeof(size_t) * count);
+    engine->finishedCount = 0;
+    pthread_mutex_unlock(&engine->lock);
+
+    for (i = 0; i < count; i++) {
+      complete(engine, engine->reaped[i], engine->slot[engine->reaped[i]].result);
+    }
+  }
+}
+
+static int start(bkEngine* engine, int write, int fd, void* data, size_t length, off_t offset, bkCallback callback, void* context) {
+  transfer* t;
+  int       flags;
+
+  if (!length) {
+    callback(0, context);
+    return 0;
+  }
+
+  /* Memory allocation failure :P */
+  if (!(t = malloc(sizeof(transfer)))) { return -1; }
+
+  flags = fcntl(fd, F_GETFL);
+
+  t->fd       = fd;
+  t->write    = write;
+  t->align    = flags != -1 && (flags & O_DIRECT) ? bkAlign : 1;
+  t->data     = (char*)data;
+  t->length   = length;
+  t->offset   = offset;
+  t->issued   = 0;
+  t->inflight = 0;
+  t->done     = 0;
+  t->error    = 0;
+  t->callback = callback;
+  t->context  = context;
+  t->next     = NULL;
+
+  if (engine->tail) {
+    engine->tail->next = t;
+  } else {
+    engine->head = t;
+  }
+  engine->tail = t;
+
+  ++engine->outstanding;
+  issue(engine);
+
+  return 0;
+}
+
+bkEngine* bkCreate(size_t depth, size_t block, bkBackend backend) {
+  bkEngine* newEngine = calloc(1, sizeof(bkEngine));
+  void*     staging;
+  size_t    i;
+
+  if (!newEngine) { return NULL; }
+
+  newEngine->depth   = depth ? depth : bkDepth;
+  newEngine->block   = ((block ? block : bkBlock) + bkAlign - 1) / bkAlign * bkAlign;
+  newEngine->ring.fd = -1;
+
+  if (posix_memalign(&staging, bkAlign, newEngine->depth * newEngine->block)) {
+    free(newEngine);
+    return NULL;
+  }
+
+  newEngine->staging = staging;
+  newEngine->slot    = calloc(newEngine->depth, sizeof(request));
+  newEngine->idle    = malloc(sizeof(size_t) * newEngine->depth);
+
+  if (!newEngine->slot || !newEngine->idle) { goto failed; }
+
+  /* Slots are taken from the top */
+  for (i = 0; i < newEngine->depth; i++) {
+    newEngine->idle[i] = newEngine->depth - 1 - i;
+  }
+  newEngine->idles = newEngine->depth;
+
+  if (backend == bkThreads || uringOpen(newEngine)) {
+    if (backend == bkUring || threadsOpen(newEngine)) { goto failed; }
+  }
+
+  return newEngine;
+
+failed:
+  /* Memory allocation failure (or no backend) :P */
+  free(newEngine->thread);
+  free(newEngine->pending);
+  free(newEngine->finished);
+  free(newEngine->reaped);
+  free(newEngine->idle);
+  free(newEngine->slot);
+  free(newEngine->staging);
+  free(newEngine);
+
+  return NULL;
+}
+
+int bkIsUring(bkEngine* engine) {
+  return engine->ring.fd >= 0;
+}
+
+int bkRead(bkEngine* engine, int fd, void* data, size_t length, off_t offset, bkCallback callback, void* context) {
+  return start(engine, 0, fd, data, length, offset, callback, context);
+}
+
+int bkWrite(bkEngine* engine, int fd, void* data, size_t length, off_t offset, bkCallback callback, void* context) {
+  return start(engine, 1, fd, data, length, offset, callback, context);
+}
+
+size_t bkPoll(bkEngine* engine) {
+  reap(engine, 0);
+  issue(engine);
+
+  return engine->outstanding;
+}
+
+void bkWait(bkEngine* engine) {
+  while (engine->outstanding) {
+    reap(engine, 1);
+    issue(engine);
+  }
+}
+
+/* Blocking wrappers *********************************************************/
+
+static void record(ssize_t result, void* context) {
+  *(ssize_t*)context = result;
+}
+
+/* Open with O_DIRECT, if asked for and the file system allows it */
+static int openFile(char* path, int flags, int direct) {
+  int fd = -1;
+
+  if (direct) {
+    fd = open(path, flags | O_DIRECT, 0644);
+  }
+
+  if (fd < 0 && (!direct || errno == EINVAL)) {
+    fd = open(path, flags, 0644);
+  }
+
+  return fd;
+}
+
+int bkSave(bkEngine* engine, tyArray* array, char* path, int direct) {
+  bkEngine* own    = engine ? NULL : bkCreate(0, 0, bkAuto);
+  size_t    bytes  = array->length * array->width;
+  ssize_t   first  = -1, rest = -1;
+  char      page[bkAlign];
+  header    head;
+  int       fd, failed;
+
+  if (!engine && !(engine = own)) { return -1; }
+
+  if ((fd = openFile(path, O_WRONLY | O_CREAT | O_TRUNC, direct)) < 0) {
+    bkNuke(own);
+    return -1;
+  }
+
+  memcpy(head.magic, bkMagic, sizeof(head.magic));
+  head.width  = array->width;
+  head.length = array->length;
+
+  memset(page, 0, bkAlign);
+  memcpy(page, &head, sizeof(header));
+
+  /* The memory must outlive the transfers, even if one fails to start */
+  failed = bkWrite(engine, fd, page, bkAlign, 0, &record, &first)
+        || bkWrite(engine, fd, array->buffer, bytes, bkAlign, &record, &rest);
+  bkWait(engine);
+
+  failed = failed || first != bkAlign || rest != (ssize_t)bytes;
+
+  /* Drop any O_DIRECT padding */
+  failed = ftruncate(fd, (off_t)(bkAlign + bytes)) || failed;
+  failed = close(fd) || failed;
+
+  bkNuke(own);
+  return failed;
+}
+
+tyArray* bkLoad(bkEngine* engine, char* path, int direct) {
+  bkEngine* own   = engine ? NULL : bkCreate(0, 0, bkAuto);
+  tyArray*  array = NULL;
+  ssize_t   got   = -1;
+  char      page[bkAlign];
+  header    head;
+  int       fd;
+
+  if (!engine && !(engine = own)) { return NULL; }
+
+  if ((fd = openFile(path, O_RDONLY, direct)) < 0) {
+    bkNuke(own);
+    return NULL;
+  }
+
+  if (!bkRead(engine, fd, page, bkAlign, 0, &record, &got)) {
+    bkWait(engine);
+  }
+
+  memcpy(&head, page, sizeof(header));
+
+  if (got == bkAlign
+   && !memcmp(head.magic, bkMagic, sizeof(head.magic))
+   && head.width
+   && head.length <= SIZE_MAX / head.width
+   && (array = tyCreate((size_t)head.length, (size_t)head.width))) {
+    size_t bytes = (size_t)(head.length * head.width);
+
+    got = -1;
+    if (!bkRead(engine, fd, array->buffer, bytes, bkAlign, &record, &got)) {
+      bkWait(engine);
+    }
+
+    /* Truncated, or unreadable */
+    if (got != (ssize_t)bytes) {
+      tyNuke(array);
+      array = NULL;
+    }
+  }
+
+  close(fd);
+  bkNuke(own);
+
+  return array;
+}
+
+void bkNuke(bkEngine* engine) {
+  if (engine) {
+    bkWait(engine);
+
+    if (engine->ring.fd >= 0) {
+      uringClose(&engine->ring);
+    } else {
+      threadsClose(engine);
+    }
+
+    free(engine->thread);
+    free(engine->pending);
+    free(engine->finished);
+    free(engine->reaped);
+    free(engine->idle);
+    free(engine->slot);
+    free(engine->staging);
+    free(engine);
+  }
+}
@@ -0,0 +1,229 @@
+/**
+  @file       bulkIO.h
+  @brief      Asynchronous bulk file I/O header file
+  @author     Christopher Harrison (Xophmeister)
+  @copyright  @ref license
+
+  Implements asynchronous reading and writing of large, contiguous
+  regions of memory, keeping many requests in flight so that storage is
+  never left waiting on the CPU (or vice versa), together with a simple
+  file format for saving and loading typed arrays with it.
+
+  Transfers are split into blocks, each of which is staged through one
+  of a fixed set of aligned buffers owned by the engine. Where io_uring
+  is available, it is driven directly through its system calls and the
+  staging buffers are registered with the kernel, so they are not mapped
+  afresh for each request; otherwise, a small pool of threads issues
+  blocking `pread` and `pwrite` calls instead. Because the staging
+  buffers are aligned, files may be opened with `O_DIRECT`, bypassing
+  the page cache, regardless of the alignment of the caller's memory.
+*/
+
+#ifndef BULKIO_H
+#define BULKIO_H
+
+#include <stdlib.h>
+#include <sys/types.h>
+#include "../indexed/typedArray.h"
+
+/**
+  @def        bkAlign
+  @brief      Alignment of staging buffers, block sizes and file format
+              offsets, in bytes, which satisfies `O_DIRECT`
+*/
+#define bkAlign 4096
+
+/**
+  @struct     bkEngine
+  @brief      Bulk I/O engine
+
+  @note       The engine's structure is private to the implementation
+  @warning    An engine must only be used by one thread at a time
+*/
+typedef struct bkEngine bkEngine;
+
+/**
+  @enum       bkBackend
+  @brief      How an engine issues its requests
+  @var        bkBackend::bkAuto
+              io_uring, if the kernel allows it; otherwise threads
+  @var        bkBackend::bkUring
+              io_uring only
+  @var        bkBackend::bkThreads
+              A pool of threads issuing `pread` and `pwrite`
+*/
+typedef enum {
+  bkAuto,
+  bkUring,
+  bkThreads
+} bkBackend;
+
+/**
+  @typedef    bkCallback
+  @brief      Function signature for transfer completion callbacks
+
+  The callback function for bkRead() and bkWrite() must have the
+  following signature:
+
+  @code{.c}
+  void callback(ssize_t result, void* context)
+  @endcode
+
+  That is, once a transfer has completed, the callback is called with
+  the following:
+
+  @param      result   The number of bytes transferred; or a negated
+                       `errno` value if any block failed
+  @param      context  The context pointer given to bkRead() or bkWrite()
+
+  @note       Callbacks are run on the thread that calls bkPoll() or
+              bkWait(), never concurrently
+*/
+typedef void(*bkCallback)(ssize_t, void*);
+
+/**
+  @fn         bkEngine* bkCreate(size_t depth, size_t block, bkBackend backend)
+  @brief      Create a new bulk I/O engine
+  @param      depth    Maximum number of blocks in flight; zero for the
+                       default (32)
+  @param      block    Size of each block, in bytes, rounded up to a
+                       multiple of bkAlign; zero for the default (1MiB)
+  @param      backend  How to issue requests
+  @return     Pointer to the newly created engine; or `NULL` if the
+              requested backend is unavailable, or in the event of an
+              allocation or thread creation failure
+
+  Allocate `depth` aligned staging buffers of `block` bytes and set up
+  the backend. With io_uring, the buffers are registered with the kernel
+  if its locked memory limit allows, and plain (unregistered) requests
+  are used if not.
+*/
+extern bkEngine* bkCreate(size_t, size_t, bkBackend);
+
+/**
+  @fn         int bkIsUring(bkEngine* engine)
+  @brief      Whether an engine uses io_uring
+  @param      engine  The engine
+  @return     Non-zero if the engine uses io_uring; zero if it uses
+              threads
+*/
+extern int bkIsUring(bkEngine*);
+
+/**
+  @fn         int bkRead(bkEngine* engine, int fd, void* data, size_t length, off_t offset, bkCallback callback, void* context)
+  @brief      Start reading a region of a file into memory
+  @param      engine    The engine
+  @param      fd        The file descriptor to read
+  @param      data      Where to read to
+  @param      length    Number of bytes to read
+  @param      offset    Offset in the file to read from
+  @param      callback  Pointer to completion callback function
+  @param      context   Pointer passed through to the callback
+  @return     Zero on success; non-zero in the event of an allocation
+              failure
+
+  Queue the transfer and issue as many of its blocks as there are free
+  staging buffers. Transfers are issued in the order they are queued,
+  but their blocks may complete in any order. Reading past the end of
+  the file is not an error; the callback is given the number of bytes
+  actually read.
+
+  @note       A zero length transfer completes immediately, calling the
+              callback from within bkRead()
+  @warning    With `O_DIRECT`, the offset must be a multiple of bkAlign
+  @warning    The memory must remain valid until the callback is run
+*/
+extern int bkRead(bkEngine*, int, void*, size_t, off_t, bkCallback, void*);
+
+/**
+  @fn         int bkWrite(bkEngine* engine, int fd, void* data, size_t length, off_t offset, bkCallback callback, void* context)
+  @brief      Start writing a region of memory to a file
+  @param      engine    The engine
+  @param      fd        The file descriptor to write
+  @param      data      Where to write from
+  @param      length    Number of bytes to write
+  @param      offset    Offset in the file to write to
+  @param      callback  Pointer to completion callback function
+  @param      context   Pointer passed through to the callback
+  @return     Zero on success; non-zero in the event of an allocation
+              failure
+
+  As bkRead(), in the other direction. A short write is reported as an
+  error (`-EIO`).
+
+  @note       A zero length transfer completes immediately, calling the
+              callback from within bkWrite()
+  @warning    With `O_DIRECT`, the offset must be a multiple of bkAlign
+              and the last block is padded with zeros to a multiple of
+              bkAlign, so the file may need truncating afterwards
+  @warning    The memory must remain valid until the callback is run
+*/
+extern int bkWrite(bkEngine*, int, void*, size_t, off_t, bkCallback, void*);
+
+/**
+  @fn         size_t bkPoll(bkEngine* engine)
+  @brief      Process any completed blocks, without waiting
+  @param      engine  The engine
+  @return     Number of transfers still outstanding
+
+  Copy out completed reads, issue queued blocks into the freed staging
+  buffers and run the callbacks of finished transfers.
+*/
+extern size_t bkPoll(bkEngine*);
+
+/**
+  @fn         void bkWait(bkEngine* engine)
+  @brief      Wait for every outstanding transfer to complete
+  @param      engine  The engine
+
+  As bkPoll(), but blocking until there are no outstanding transfers.
+*/
+extern void bkWait(bkEngine*);
+
+/**
+  @fn         int bkSave(bkEngine* engine, tyArray* array, char* path, int direct)
+  @brief      Save a typed array to a file
+  @param      engine  The engine; or `NULL` to create a temporary one
+  @param      array   The typed array
+  @param      path    The file's path
+  @param      direct  Non-zero to open the file with `O_DIRECT`, where
+                      the file system supports it
+  @return     Zero on success; non-zero if the file could not be written,
+              or in the event of an allocation failure
+
+  Write the array as a bkAlign byte header, holding its element width
+  and length, followed by its elements; then wait for the transfers to
+  complete.
+
+  @note       Any transfers already outstanding on the engine are waited
+              for too
+*/
+extern int bkSave(bkEngine*, tyArray*, char*, int);
+
+/**
+  @fn         tyArray* bkLoad(bkEngine* engine, char* path, int direct)
+  @brief      Load a typed array from a file
+  @param      engine  The engine; or `NULL` to create a temporary one
+  @param      path    The file's path
+  @param      direct  Non-zero to open the file with `O_DIRECT`, where
+                      the file system supports it
+  @return     Pointer to the loaded typed array; or `NULL` if the file
+              could not be read or was not written by bkSave(), or in the
+              event of an allocation failure
+
+  @note       Any transfers already outstanding on the engine are waited
+              for too
+*/
+extern tyArray* bkLoad(bkEngine*, char*, int);
+
+/**
+  @fn         void bkNuke(bkEngine* engine)
+  @brief      Stop and free the bulk I/O engine
+  @param      engine  The engine
+
+  Wait for any outstanding transfers, then release the backend and the
+  staging buffers.
+*/
+extern void bkNuke(bkEngine*);
+
+#endif
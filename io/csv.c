@@ -0,0 +1,496 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "csv.h"
+#include "number.h"
+#include "textFile.h"
+#include "../indexed/typedArray.h"
+#include "../indexed/symbolTable.h"
+#include "../parallel/threadPool.h"
+
+/* Bit masks of a block's quotes, delimiters and newlines */
+typedef struct {
+  uint64_t quote;
+  uint64_t delimiter;
+  uint64_t newline;
+} block;
+
+/* Structural bytes of the text, a block at a time */
+typedef struct {
+  char*    data;
+  size_t   at;          /* Offset of the current block */
+  size_t   end;
+  char     delimiter;
+  uint64_t structural;  /* Unvisited structural bytes of the block */
+  uint64_t newline;     /* Structural newlines of the block */
+  uint64_t inside;      /* All ones if the last block ended in quotes */
+} scanner;
+
+typedef struct {
+  char*     data;
+  size_t    length;
+  char      delimiter;
+  size_t    columns;
+  csvType*  type;
+  tyArray** column;
+  symTable* symbols;
+  size_t*   at;           /* Chunk boundaries, at the start of rows */
+  size_t*   slot;         /* First output row of each chunk */
+  size_t*   parsed;       /* Rows parsed by each chunk */
+  size_t*   bad;          /* Malformed fields in each chunk */
+  char**    scratch;      /* Unescaping space for each worker */
+  size_t*   scratchSize;
+} parsing;
+
+static size_t typeWidth(csvType type) {
+  switch (type) {
+    case csvInteger: return sizeof(int64_t);
+    case csvReal:    return sizeof(double);
+    case csvSymbol:  return sizeof(symId);
+    default:         return 0;
+  }
+}
+
+/* Compare 64 bytes against each structural byte */
+static void compare(char* data, char delimiter, block* b) {
+#if defined(__AVX2__)
+  __m256i quote = _mm256_set1_epi8('"');
+  __m256i delim = _mm256_set1_epi8(delimiter);
+  __m256i line  = _mm256_set1_epi8('\n');
+  int     i;
+
+  b->quote = b->delimiter = b->newline = 0;
+
+  for (i = 0; i < 2; i++) {
+    __m256i bytes = _mm256_loadu_si256((__m256i*)(data + 32 * i));
+    b->quote     |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, quote)) << (32 * i);
+    b->delimiter |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, delim)) << (32 * i);
+    b->newline   |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, line)) << (32 * i);
+  }
+#elif defined(__SSE2__)
+  __m128i quote = _mm_set1_epi8('"');
+  __m128i delim = _mm_set1_epi8(delimiter);
+  __m128i line  = _mm_set1_epi8('\n');
+  int     i;
+
+  b->quote = b->delimiter = b->newline = 0;
+
+  for (i = 0; i < 4; i++) {
+    __m128i bytes = _mm_loadu_si128((__m128i*)(data + 16 * i));
+    b->quote     |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, quote)) << (16 * i);
+    b->delimiter |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, delim)) << (16 * i);
+    b->newline   |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, line)) << (16 * i);
+  }
+#else
+  int i;
+
+  b->quote = b->delimiter = b->newline = 0;
+
+  for (i = 0; i < 64; i++) {
+    b->quote     |= (uint64_t)(data[i] == '"') << i;
+    b->delimiter |= (uint64_t)(data[i] == delimiter) << i;
+    b->newline   |= (uint64_t)(data[i] == '\n') << i;
+  }
+#endif
+}
+
+/* Each bit becomes the parity of it and all the bits below it */
+static uint64_t prefixXor(uint64_t bits) {
+#if defined(__PCLMUL__)
+  /* Carry-less multiplication by all ones */
+  return (uint64_t)_mm_cvtsi128_si64(_mm_clmulepi64_si128(_mm_set_epi64x(0, (long long)bits), _mm_set1_epi8((char)0xFF), 0));
+#else
+  bits ^= bits << 1;
+  bits ^= bits << 2;
+  bits ^= bits << 4;
+  bits ^= bits << 8;
+  bits ^= bits << 16;
+  bits ^= bits << 32;
+  return bits;
+#endif
+}
+
+static void scanBlock(scanner* s) {
+  size_t   length = s->end - s->at < 64 ? s->end - s->at : 64;
+  uint64_t quoted;
+  block    b;
+
+  if (length == 64) {
+    compare(s->data + s->at, s->delimiter, &b);
+  } else {
+    /* Never read past the end of the text */
+    char     padded[64];
+    uint64_t mask = ((uint64_t)1 << length) - 1;
+
+    memset(padded, 0, sizeof(padded));
+    memcpy(padded, s->data + s->at, length);
+    compare(padded, s->delimiter, &b);
+
+    b.quote     &= mask;
+    b.delimiter &= mask;
+    b.newline   &= mask;
+  }
+
+  /* Bytes from an opening quote up to (not including) its closing one */
+  quoted = prefixXor(b.quote) ^ s->inside;
+
+  s->inside     = (uint64_t)((int64_t)quoted >> 63);
+  s->structural = (b.delimiter | b.newline) & ~quoted;
+  s->newline    = b.newline & ~quoted;
+}
+
+static void scanFrom(scanner* s, char* data, size_t at, size_t end, char delimiter) {
+  s->data       = data;
+  s->at         = at;
+  s->end        = end;
+  s->delimiter  = delimiter;
+  s->inside     = 0;
+  s->structural = s->newline = 0;
+
+  if (at < end) { scanBlock(s); }
+}
+
+/* Find the next structural byte, if any, noting whether it is a newline */
+static char* nextStructural(scanner* s, int* newline) {
+  unsigned bit;
+
+  while (!s->structural) {
+    if (s->end - s->at <= 64) { return NULL; }
+
+    s->at += 64;
+    scanBlock(s);
+  }
+
+  bit            = (unsigned)__builtin_ctzll(s->structural);
+  s->structural &= s->structural - 1;
+  *newline       = (int)(s->newline >> bit) & 1;
+
+  return s->data + s->at + bit;
+}
+
+/* Start of the first row after a position, given whether it is quoted */
+static size_t rowStart(char* data, size_t length, size_t at, int inside) {
+  for (; at < length; at++) {
+    if (data[at] == '"') {
+      inside ^= 1;
+    } else if (data[at] == '\n' && !inside) {
+      return at + 1;
+    }
+  }
+
+  return length;
+}
+
+static int isBlank(char c) {
+  return c == ' ' || c == '\t';
+}
+
+/* Drop surrounding blanks and quotes from a numeric field */
+static void trim(char** text, char** end) {
+  while (*text < *end && isBlank(**text))     { ++*text; }
+  while (*end > *text && isBlank(*(*end - 1))) { --*end; }
+
+  if (*end - *text >= 2 && **text == '"' && *(*end - 1) == '"') {
+    ++*text;
+    --*end;
+  }
+}
+
+/* Intern a field's string, unquoting it; non-zero on failure */
+static int intern(parsing* parse, size_t worker, char* text, char* end, symId* symbol) {
+  if (text < end && *text == '"') {
+    char*  closing = end - 1 > text && *(end - 1) == '"' ? end - 1 : end;
+    size_t length  = (size_t)(closing - text - 1);
+
+    ++text;
+
+    /* Doubled quotes need collapsing */
+    if (memchr(text, '"', length)) {
+      char*  out;
+      size_t i, n = 0;
+
+      if (length > parse->scratchSize[worker]) {
+        char* grown = realloc(parse->scratch[worker], length);
+
+        /* Memory allocation failure :P */
+        if (!grown) { return 1; }
+
+        parse->scratch[worker]     = grown;
+        parse->scratchSize[worker] = length;
+      }
+
+      out = parse->scratch[worker];
+
+      for (i = 0; i < length; i++) {
+        out[n++] = text[i];
+        if (text[i] == '"' && i + 1 < length && text[i + 1] == '"') { ++i; }
+      }
+
+      *symbol = symIntern(parse->symbols, out, n);
+    } else {
+      *symbol = symIntern(parse->symbols, text, length);
+    }
+  } else {
+    *symbol = symIntern(parse->symbols, text, (size_t)(end - text));
+  }
+
+  return *symbol == symNone;
+}
+
+/* Store a field, or its default if text is NULL; non-zero if malformed */
+static int store(parsing* parse, size_t worker, size_t column, size_t row, char* text, char* end) {
+  tyArray* target = parse->column[column];
+  char*    next;
+
+  switch (parse->type[column]) {
+    case csvInteger:
+      if (text) { trim(&text, &end); }
+
+      if (!text || !(next = nmSigned(text, end, &tyAt(target, int64_t, row))) || next != end) {
+        tyAt(target, int64_t, row) = 0;
+        return 1;
+      }
+      break;
+
+    case csvReal:
+      if (text) { trim(&text, &end); }
+
+      if (!text || !(next = nmDouble(text, end, &tyAt(target, double, row))) || next != end) {
+        tyAt(target, double, row) = NAN;
+        return 1;
+      }
+      break;
+
+    case csvSymbol:
+      if (!text) {
+        tyAt(target, symId, row) = symNone;
+        return 1;
+      }
+
+      return intern(parse, worker, text, end, &tyAt(target, symId, row));
+
+    default:
+      /* Skipped, but missing all the same */
+      return !text;
+  }
+
+  return 0;
+}
+
+static void quoteParity(size_t from, size_t to, size_t worker, void* context) {
+  parsing* parse = (parsing*)context;
+
+  for (; from < to; from++) {
+    size_t start = parse->at[from];
+
+    /* Borrow the parsed counts until the boundaries are final */
+    parse->parsed[from] = txCount(parse->data + start, parse->at[from + 1] - start, '"') & 1;
+  }
+}
+
+static void countChunk(size_t from, size_t to, size_t worker, void* context) {
+  parsing* parse = (parsing*)context;
+
+  for (; from < to; from++) {
+    scanner s;
+    size_t  rows = 0;
+
+    scanFrom(&s, parse->data, parse->at[from], parse->at[from + 1], parse->delimiter);
+
+    while (s.at < s.end) {
+      rows += (size_t)__builtin_popcountll(s.newline);
+      if (s.end - s.at <= 64) { break; }
+
+      s.at += 64;
+      scanBlock(&s);
+    }
+
+    parse->slot[from + 1] = rows + 1;
+  }
+}
+
+static void parseChunk(size_t from, size_t to, size_t worker, void* context) {
+  parsing* parse = (parsing*)context;
+
+  for (; from < to; from++) {
+    char*   end    = parse->data + parse->at[from + 1];
+    char*   field  = parse->data + parse->at[from];
+    size_t  slot   = parse->slot[from];
+    size_t  rows   = 0, bad = 0, column = 0;
+    scanner s;
+
+    scanFrom(&s, parse->data, parse->at[from], parse->at[from + 1], parse->delimiter);
+
+    while (field < end || column) {
+      int   newline = 0;
+      char* stop    = nextStructural(&s, &newline);
+      char* last    = stop ? stop : end;
+      int   rowEnds = newline || !stop;
+
+      if (rowEnds && last > field && *(last - 1) == '\r') { --last; }
+
+      if (rowEnds && !column && last == field) {
+        /* Blank line */
+      } else {
+        if (column < parse->columns) {
+          bad += store(parse, worker, column, slot + rows, field, last);
+        } else {
+          ++bad;
+        }
+        ++column;
+
+        if (rowEnds) {
+          for (; column < parse->columns; column++) {
+            bad += store(parse, worker, column, slot + rows, NULL, NULL);
+          }
+
+          column = 0;
+          ++rows;
+        }
+      }
+
+      if (!stop) { break; }
+      field = stop + 1;
+    }
+
+    parse->parsed[from] = rows;
+    parse->bad[from]    = bad;
+  }
+}
+
+csvTable* csvParse(char* data, size_t length, char delimiter, int header, size_t columns, csvType* types, tpPool* pool) {
+  csvTable* newTable = calloc(1, sizeof(csvTable));
+  size_t    workers  = tpWorkers(pool);
+  size_t    chunks   = txChunkCount(length, workers);
+  size_t    slots, i, c;
+  int       inside = 0, symbols = 0;
+  parsing   parse;
+
+  if (!newTable) { return NULL; }
+
+  memset(&parse, 0, sizeof(parsing));
+  parse.data        = data;
+  parse.length      = length;
+  parse.delimiter   = delimiter;
+  parse.columns     = columns;
+  parse.type        = types;
+  parse.at          = malloc(sizeof(size_t) * (chunks + 1));
+  parse.slot        = malloc(sizeof(size_t) * (chunks + 1));
+  parse.parsed      = malloc(sizeof(size_t) * chunks);
+  parse.bad         = malloc(sizeof(size_t) * chunks);
+  parse.scratch     = calloc(workers, sizeof(char*));
+  parse.scratchSize = calloc(workers, sizeof(size_t));
+
+  newTable->columns = columns;
+  newTable->column  = calloc(columns ? columns : 1, sizeof(tyArray*));
+
+  if (!parse.at || !parse.slot || !parse.parsed || !parse.bad || !parse.scratch || !parse.scratchSize || !newTable->column) {
+    goto failed;
+  }
+
+  /* Split evenly and find which chunks start inside quotes... */
+  for (i = 0; i <= chunks; i++) {
+    parse.at[i] = (size_t)(((unsigned __int128)length * i) / chunks);
+  }
+
+  tpFor(pool, chunks, 1, &quoteParity, &parse);
+
+  /* ...then move each boundary up to the start of a row */
+  parse.at[0] = header ? rowStart(data, length, 0, 0) : 0;
+
+  for (i = 1; i < chunks; i++) {
+    size_t at = parse.at[i];
+
+    inside ^= (int)parse.parsed[i - 1];
+
+    if (at) {
+      at = rowStart(data, length, at - 1, inside ^ (data[at - 1] == '"'));
+    }
+
+    parse.at[i] = at < parse.at[i - 1] ? parse.at[i - 1] : at;
+  }
+
+  tpFor(pool, chunks, 1, &countChunk, &parse);
+  slots = txSlots(parse.slot, chunks);
+
+  for (c = 0; c < columns; c++) {
+    if (typeWidth(types[c])) {
+      if (!(newTable->column[c] = tyCreate(slots, typeWidth(types[c])))) { goto failed; }
+      symbols |= types[c] == csvSymbol;
+    }
+  }
+
+  if (symbols) {
+    if (!(newTable->symbols = parse.symbols = symCreate(pool ? 4 * workers : 0))) { goto failed; }
+  }
+
+  parse.column = newTable->column;
+
+  tpFor(pool, chunks, 1, &parseChunk, &parse);
+
+  for (i = 0; i < chunks; i++) {
+    newTable->malformed += parse.bad[i];
+  }
+
+  newTable->rows = txCompact(newTable->column, columns, parse.slot, parse.parsed, chunks);
+
+  for (i = 0; i < workers; i++) {
+    free(parse.scratch[i]);
+  }
+
+  free(parse.at);
+  free(parse.slot);
+  free(parse.parsed);
+  free(parse.bad);
+  free(parse.scratch);
+  free(parse.scratchSize);
+
+  return newTable;
+
+failed:
+  /* Memory allocation failure :P */
+  free(parse.at);
+  free(parse.slot);
+  free(parse.parsed);
+  free(parse.bad);
+  free(parse.scratch);
+  free(parse.scratchSize);
+  csvNuke(newTable);
+
+  return NULL;
+}
+
+csvTable* csvRead(char* path, char delimiter, int header, size_t columns, csvType* types, tpPool* pool) {
+  txFile*   file = txOpen(path);
+  csvTable* table;
+
+  if (!file) { return NULL; }
+
+  table = csvParse(file->data, file->length, delimiter, header, columns, types, pool);
+  txClose(file);
+
+  return table;
+}
+
+void csvNuke(csvTable* table) {
+  size_t c;
+
+  if (table) {
+    if (table->column) {
+      for (c = 0; c < table->columns; c++) {
+        tyNuke(table->column[c]);
+      }
+
+      free(table->column);
+    }
+
+    symNuke(table->symbols);
+    free(table);
+  }
+}
@@ -0,0 +1,139 @@
+/**
+  @file       csv.h
+  @brief      Delimited text (CSV/TSV) parser header file
+  @author     Christopher Harrison (Xophmeister)
+  @copyright  @ref license
+
+  Implements parallel parsing of delimited text (e.g., comma or tab
+  separated values) straight into one typed array per column, rather
+  than a structure per row; for example:
+
+  @code{.c}
+  csvType   types[3] = {csvInteger, csvSymbol, csvReal};
+  csvTable* table    = csvRead("sales.csv", ',', 1, 3, types, pool);
+  double    total    = 0;
+
+  for (size_t i = 0; i < table->rows; i++) {
+    total += tyAt(table->column[2], double, i);
+  }
+  @endcode
+
+  Fields may be quoted with double quotes, in which case they may
+  contain delimiters, newlines and doubled (i.e., escaped) quotes, as in
+  RFC 4180. Blank lines are skipped, as are Windows line endings.
+
+  The text is scanned sixty-four bytes at a time: vector comparisons
+  give bit masks of its quotes, delimiters and newlines, and a prefix
+  XOR over the quote mask marks every byte that is inside quotes, so the
+  structural delimiters and newlines are found without examining bytes
+  one by one. Numeric fields are then converted with the word at a time
+  routines in number.h. To split the text between threads, the quotes
+  in each chunk are counted first, so that each chunk knows whether it
+  starts inside quotes and can find its first whole row.
+*/
+
+#ifndef CSV_H
+#define CSV_H
+
+#include <stdlib.h>
+#include "../indexed/typedArray.h"
+#include "../indexed/symbolTable.h"
+#include "../parallel/threadPool.h"
+
+/**
+  @enum       csvType
+  @brief      The type of a column
+  @var        csvType::csvSkip
+              Not parsed; its typed array is `NULL`
+  @var        csvType::csvInteger
+              Signed integers (`int64_t`)
+  @var        csvType::csvReal
+              Floating point numbers (`double`)
+  @var        csvType::csvSymbol
+              Strings, interned as symbols (@ref symId)
+*/
+typedef enum {
+  csvSkip,
+  csvInteger,
+  csvReal,
+  csvSymbol
+} csvType;
+
+/**
+  @struct     csvTable
+  @brief      Parsed table
+  @var        csvTable::columns
+              Number of columns
+  @var        csvTable::rows
+              Number of rows, excluding any header
+  @var        csvTable::column
+              Array of a typed array per column, in file order; or
+              `NULL` for skipped columns
+  @var        csvTable::symbols
+              Symbol table of the symbol columns' strings; or `NULL` if
+              there are none
+  @var        csvTable::malformed
+              Number of numeric fields that were empty or could not be
+              parsed, which are stored as zero (or NaN, if real), plus the
+              number of fields that were missing from or in excess of
+              their rows
+
+  @warning    None of the fields are write protected
+*/
+typedef struct {
+  size_t    columns;
+  size_t    rows;
+  tyArray** column;
+  symTable* symbols;
+  size_t    malformed;
+} csvTable;
+
+/**
+  @fn         csvTable* csvParse(char* data, size_t length, char delimiter, int header, size_t columns, csvType* types, tpPool* pool)
+  @brief      Parse delimited text into columns
+  @param      data       The text
+  @param      length     Length of the text, in bytes
+  @param      delimiter  The field delimiter (e.g., `','` or `'\t'`)
+  @param      header     Non-zero if the first row is a header, to skip
+  @param      columns    Number of columns
+  @param      types      Array of the type of each column
+  @param      pool       Thread pool to run on; or `NULL` to run serially
+  @return     Pointer to the parsed table; or `NULL` in the event of an
+              allocation failure
+
+  Split the text into chunks at row boundaries, count each chunk's rows
+  to give it a range of output rows, then parse every chunk's fields at
+  once into the columns' typed arrays.
+
+  @note       When run on a pool, symbol identifiers are given in the
+              order that the workers intern them, not in file order
+  @note       The text is not modified and need not be NUL terminated
+*/
+extern csvTable* csvParse(char*, size_t, char, int, size_t, csvType*, tpPool*);
+
+/**
+  @fn         csvTable* csvRead(char* path, char delimiter, int header, size_t columns, csvType* types, tpPool* pool)
+  @brief      Map and parse a delimited text file
+  @param      path       The file's path
+  @param      delimiter  The field delimiter
+  @param      header     Non-zero if the first row is a header, to skip
+  @param      columns    Number of columns
+  @param      types      Array of the type of each column
+  @param      pool       Thread pool to run on; or `NULL` to run serially
+  @return     Pointer to the parsed table; or `NULL` if the file could not
+              be opened, or in the event of an allocation failure
+
+  Map the file with txOpen() and parse it with csvParse().
+*/
+extern csvTable* csvRead(char*, char, int, size_t, csvType*, tpPool*);
+
+/**
+  @fn         void csvNuke(csvTable* table)
+  @brief      Free the memory allocated by the parsed table
+  @param      table  The parsed table
+
+  @note       This frees the columns' typed arrays and the symbol table
+*/
+extern void csvNuke(csvTable*);
+
+#endif
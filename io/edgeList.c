@@ -0,0 +1,218 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "edgeList.h"
+#include "number.h"
+#include "textFile.h"
+#include "../indexed/typedArray.h"
+#include "../parallel/threadPool.h"
+
+typedef struct {
+  char*   data;
+  size_t* boundary;  /* Chunk boundaries in the text */
+  size_t* slot;      /* First output slot of each chunk */
+  size_t* parsed;    /* Edges parsed by each chunk */
+  size_t* largest;   /* Largest identifier seen by each chunk, plus one */
+  size_t* bad;       /* Malformed lines in each chunk */
+  char*   weighted;  /* Whether each chunk had a weight */
+  size_t* source;
+  size_t* target;
+  double* weight;
+} parsing;
+
+static int isBlank(char c) {
+  return c == ' ' || c == '\t' || c == '\r';
+}
+
+static char* skipBlanks(char* cursor, char* end) {
+  while (cursor < end && isBlank(*cursor)) {
+    cursor++;
+  }
+
+  return cursor;
+}
+
+static void countChunk(size_t from, size_t to, size_t worker, void* context) {
+  parsing* parse = (parsing*)context;
+
+  for (; from < to; from++) {
+    size_t length = parse->boundary[from + 1] - parse->boundary[from];
+
+    /* An unterminated last line still needs a slot */
+    parse->slot[from + 1] = txCount(parse->data + parse->boundary[from], length, '\n') + 1;
+  }
+}
+
+static void parseChunk(size_t from, size_t to, size_t worker, void* context) {
+  parsing* parse = (parsing*)context;
+
+  for (; from < to; from++) {
+    char*   cursor   = parse->data + parse->boundary[from];
+    char*   end      = parse->data + parse->boundary[from + 1];
+    size_t* source   = parse->source + parse->slot[from];
+    size_t* target   = parse->target + parse->slot[from];
+    double* weight   = parse->weight + parse->slot[from];
+    size_t  edges    = 0, largest = 0, bad = 0;
+    char    weighted = 0;
+
+    while (cursor < end) {
+      uint64_t u, v;
+      double   w = 1;
+      char*    next;
+
+      cursor = skipBlanks(cursor, end);
+
+      if (cursor == end || *cursor == '\n' || *cursor == '#' || *cursor == '%') {
+        goto nextLine;
+      }
+
+      /* source, blank, target */
+      if (!(next = nmUnsigned(cursor, end, &u)) || next == end || !isBlank(*next)) { goto malformed; }
+      cursor = skipBlanks(next, end);
+
+      if (!(next = nmUnsigned(cursor, end, &v))) { goto malformed; }
+      cursor = skipBlanks(next, end);
+
+      /* Optional weight */
+      if (cursor < end && *cursor != '\n') {
+        if (cursor == next || !(next = nmDouble(cursor, end, &w))) { goto malformed; }
+        cursor   = skipBlanks(next, end);
+        weighted = 1;
+      }
+
+      if (cursor < end && *cursor != '\n') { goto malformed; }
+
+      source[edges] = (size_t)u;
+      target[edges] = (size_t)v;
+      weight[edges] = w;
+      ++edges;
+
+      if (u + 1 > largest) { largest = (size_t)u + 1; }
+      if (v + 1 > largest) { largest = (size_t)v + 1; }
+
+      goto nextLine;
+
+    malformed:
+      ++bad;
+
+    nextLine:
+      next   = memchr(cursor, '\n', (size_t)(end - cursor));
+      cursor = next ? next + 1 : end;
+    }
+
+    parse->parsed[from]   = edges;
+    parse->largest[from]  = largest;
+    parse->bad[from]      = bad;
+    parse->weighted[from] = weighted;
+  }
+}
+
+elEdges* elParse(char* data, size_t length, tpPool* pool) {
+  elEdges* newEdges = malloc(sizeof(elEdges));
+  size_t   chunks   = txChunkCount(length, tpWorkers(pool));
+  size_t   slots, i;
+  char     weighted = 0;
+  tyArray* arrays[3];
+  parsing  parse;
+
+  if (!newEdges) { return NULL; }
+
+  memset(&parse, 0, sizeof(parsing));
+  parse.data     = data;
+  parse.boundary = txChunks(data, length, chunks);
+  parse.slot     = malloc(sizeof(size_t) * (chunks + 1));
+  parse.parsed   = malloc(sizeof(size_t) * chunks);
+  parse.largest  = malloc(sizeof(size_t) * chunks);
+  parse.bad      = malloc(sizeof(size_t) * chunks);
+  parse.weighted = malloc(chunks);
+
+  newEdges->nodes     = 0;
+  newEdges->edges     = 0;
+  newEdges->malformed = 0;
+  newEdges->source    = NULL;
+  newEdges->target    = NULL;
+  newEdges->weight    = NULL;
+
+  if (!parse.boundary || !parse.slot || !parse.parsed || !parse.largest || !parse.bad || !parse.weighted) {
+    goto failed;
+  }
+
+  tpFor(pool, chunks, 1, &countChunk, &parse);
+  slots = txSlots(parse.slot, chunks);
+
+  newEdges->source = tyCreate(slots, sizeof(size_t));
+  newEdges->target = tyCreate(slots, sizeof(size_t));
+  newEdges->weight = tyCreate(slots, sizeof(double));
+
+  if (!newEdges->source || !newEdges->target || !newEdges->weight) {
+    goto failed;
+  }
+
+  parse.source = (size_t*)newEdges->source->buffer;
+  parse.target = (size_t*)newEdges->target->buffer;
+  parse.weight = (double*)newEdges->weight->buffer;
+
+  tpFor(pool, chunks, 1, &parseChunk, &parse);
+
+  for (i = 0; i < chunks; i++) {
+    newEdges->malformed += parse.bad[i];
+    weighted            |= parse.weighted[i];
+
+    if (parse.largest[i] > newEdges->nodes) { newEdges->nodes = parse.largest[i]; }
+  }
+
+  /* An unweighted list has no weights to keep */
+  if (!weighted) {
+    tyNuke(newEdges->weight);
+    newEdges->weight = NULL;
+  }
+
+  arrays[0] = newEdges->source;
+  arrays[1] = newEdges->target;
+  arrays[2] = newEdges->weight;
+
+  newEdges->edges = txCompact(arrays, 3, parse.slot, parse.parsed, chunks);
+
+  free(parse.boundary);
+  free(parse.slot);
+  free(parse.parsed);
+  free(parse.largest);
+  free(parse.bad);
+  free(parse.weighted);
+
+  return newEdges;
+
+failed:
+  /* Memory allocation failure :P */
+  free(parse.boundary);
+  free(parse.slot);
+  free(parse.parsed);
+  free(parse.largest);
+  free(parse.bad);
+  free(parse.weighted);
+  elNuke(newEdges);
+
+  return NULL;
+}
+
+elEdges* elRead(char* path, tpPool* pool) {
+  txFile*  file = txOpen(path);
+  elEdges* edges;
+
+  if (!file) { return NULL; }
+
+  edges = elParse(file->data, file->length, pool);
+  txClose(file);
+
+  return edges;
+}
+
+void elNuke(elEdges* edges) {
+  if (edges) {
+    tyNuke(edges->source);
+    tyNuke(edges->target);
+    tyNuke(edges->weight);
+    free(edges);
+  }
+}
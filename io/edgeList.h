@@ -0,0 +1,95 @@
+/**
+  @file       edgeList.h
+  @brief      Edge list parser header file
+  @author     Christopher Harrison (Xophmeister)
+  @copyright  @ref license
+
+  Implements parallel parsing of text edge lists, with one edge per line
+  as `source target [weight]`, into typed arrays that can be handed
+  straight to cgFromEdges(); for example:
+
+  @code{.c}
+  elEdges* edges = elRead("graph.txt", pool);
+  cgGraph* graph = cgFromEdges(edges->nodes, edges->source, edges->target);
+  @endcode
+
+  Fields are separated by spaces or tabs; blank lines and lines starting
+  with `#` or `%` (as used by SNAP and Matrix Market) are skipped, as are
+  Windows line endings.
+*/
+
+#ifndef EDGELIST_H
+#define EDGELIST_H
+
+#include <stdlib.h>
+#include "../indexed/typedArray.h"
+#include "../parallel/threadPool.h"
+
+/**
+  @struct     elEdges
+  @brief      Parsed edge list
+  @var        elEdges::nodes
+              Number of nodes; that is, one more than the largest node
+              identifier
+  @var        elEdges::edges
+              Number of edges
+  @var        elEdges::source
+              Typed array of source node identifiers (`size_t`), in file
+              order
+  @var        elEdges::target
+              Typed array of target node identifiers (`size_t`)
+  @var        elEdges::weight
+              Typed array of edge weights (`double`), where edges without
+              a weight have weight one; or `NULL` if no edge had a weight
+  @var        elEdges::malformed
+              Number of lines that were not valid edges, which are
+              skipped
+*/
+typedef struct {
+  size_t   nodes;
+  size_t   edges;
+  tyArray* source;
+  tyArray* target;
+  tyArray* weight;
+  size_t   malformed;
+} elEdges;
+
+/**
+  @fn         elEdges* elParse(char* data, size_t length, tpPool* pool)
+  @brief      Parse an edge list from a buffer
+  @param      data    The text, which need not be NUL terminated
+  @param      length  Length of the text, in bytes
+  @param      pool    Thread pool to run on; or `NULL` to run serially
+  @return     Pointer to the parsed edges; or `NULL` in the event of an
+              allocation failure
+
+  Split the text into chunks at line boundaries and count each chunk's
+  lines, to give every chunk its own slice of the output arrays. Then
+  parse the chunks in parallel, each directly into its slice, and close
+  the gaps left by skipped lines.
+
+  @note       Identifiers are parsed eight digits at a time, with
+              nmUnsigned(), and weights with nmDouble()
+*/
+extern elEdges* elParse(char*, size_t, tpPool*);
+
+/**
+  @fn         elEdges* elRead(char* path, tpPool* pool)
+  @brief      Parse an edge list from a file
+  @param      path  The file's path
+  @param      pool  Thread pool to run on; or `NULL` to run serially
+  @return     Pointer to the parsed edges; or `NULL` if the file could not
+              be read, or in the event of an allocation failure
+
+  Map the file into memory with txOpen() and parse it with elParse().
+*/
+extern elEdges* elRead(char*, tpPool*);
+
+/**
+  @fn         void elNuke(elEdges* edges)
+  @brief      Free the memory allocated for the parsed edges
+  @param      edges  The parsed edges
+*/
+extern void elNuke(elEdges*);
+
+#endif
@@ -0,0 +1,173 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "number.h"
+
+static const uint64_t power[] = {
+  UINT64_C(1), UINT64_C(10), UINT64_C(100), UINT64_C(1000), UINT64_C(10000),
+  UINT64_C(100000), UINT64_C(1000000), UINT64_C(10000000), UINT64_C(100000000)
+};
+
+static const double exact[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static int isDigit(char c) {
+  return (unsigned char)(c - '0') < 10;
+}
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+/* Number of leading digit bytes in a word, in memory order */
+static unsigned digitRun(uint64_t word) {
+  uint64_t high = word & UINT64_C(0xF0F0F0F0F0F0F0F0);
+  uint64_t low  = ((word + UINT64_C(0x0606060606060606)) & UINT64_C(0xF0F0F0F0F0F0F0F0)) >> 4;
+  uint64_t off  = (high | low) ^ UINT64_C(0x3333333333333333);
+
+  /* Digits are exactly the bytes that became 0x33 */
+  return off ? (unsigned)__builtin_ctzll(off) / 8 : 8;
+}
+
+/* Value of the first count (1 to 8) digits of a word */
+static uint64_t digitValue(uint64_t word, unsigned count) {
+  word <<= 8 * (8 - count);
+  word &= UINT64_C(0x0F0F0F0F0F0F0F0F);
+
+  word = word * 10 + (word >> 8);
+  word = (((word & UINT64_C(0x000000FF000000FF)) * UINT64_C(0x000F424000000064))
+         + (((word >> 16) & UINT64_C(0x000000FF000000FF)) * UINT64_C(0x0000271000000001))) >> 32;
+
+  return word;
+}
+#endif
+
+/* Accumulate a run of digits, counting them and noting any overflow */
+static char* digits(char* cursor, char* end, uint64_t* value, size_t* count, int* overflow) {
+  uint64_t total = *value;
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  while (end - cursor >= 8) {
+    uint64_t word;
+    unsigned run;
+
+    memcpy(&word, cursor, 8);
+    if (!(run = digitRun(word))) { break; }
+
+    if (__builtin_mul_overflow(total, power[run], &total)
+        || __builtin_add_overflow(total, digitValue(word, run), &total)) {
+      *overflow = 1;
+    }
+
+    cursor += run;
+    *count += run;
+
+    if (run < 8) {
+      *value = total;
+      return cursor;
+    }
+  }
+#endif
+
+  for (; cursor < end && isDigit(*cursor); cursor++, ++*count) {
+    if (__builtin_mul_overflow(total, 10, &total)
+        || __builtin_add_overflow(total, (uint64_t)(*cursor - '0'), &total)) {
+      *overflow = 1;
+    }
+  }
+
+  *value = total;
+  return cursor;
+}
+
+char* nmUnsigned(char* cursor, char* end, uint64_t* value) {
+  uint64_t total = 0;
+  size_t   count = 0;
+  int      overflow = 0;
+
+  cursor = digits(cursor, end, &total, &count, &overflow);
+
+  if (!count || overflow) { return NULL; }
+
+  *value = total;
+  return cursor;
+}
+
+char* nmSigned(char* cursor, char* end, int64_t* value) {
+  uint64_t magnitude;
+  int      negative = 0;
+
+  if (cursor < end && (*cursor == '-' || *cursor == '+')) {
+    negative = *cursor++ == '-';
+  }
+
+  if (!(cursor = nmUnsigned(cursor, end, &magnitude))) { return NULL; }
+
+  if (negative) {
+    if (magnitude > (uint64_t)INT64_MAX + 1) { return NULL; }
+    *value = magnitude ? -(int64_t)(magnitude - 1) - 1 : 0;
+  } else {
+    if (magnitude > (uint64_t)INT64_MAX) { return NULL; }
+    *value = (int64_t)magnitude;
+  }
+
+  return cursor;
+}
+
+/* Hand the text to strtod, as a terminated copy */
+static char* slowDouble(char* cursor, char* end, double* value) {
+  char   buffer[512];
+  char*  stop;
+  size_t length = (size_t)(end - cursor) < sizeof(buffer) - 1 ? (size_t)(end - cursor) : sizeof(buffer) - 1;
+
+  memcpy(buffer, cursor, length);
+  buffer[length] = '\0';
+
+  *value = strtod(buffer, &stop);
+  return stop == buffer ? NULL : cursor + (stop - buffer);
+}
+
+char* nmDouble(char* cursor, char* end, double* value) {
+  char*    start = cursor;
+  uint64_t mantissa = 0;
+  size_t   count = 0, whole;
+  int      overflow = 0, negative = 0;
+  int64_t  exponent = 0, scale;
+
+  if (cursor < end && (*cursor == '-' || *cursor == '+')) {
+    negative = *cursor++ == '-';
+  }
+
+  cursor = digits(cursor, end, &mantissa, &count, &overflow);
+  whole  = count;
+
+  if (cursor < end && *cursor == '.') {
+    cursor   = digits(cursor + 1, end, &mantissa, &count, &overflow);
+    exponent = -(int64_t)(count - whole);
+  }
+
+  if (!count) {
+    /* Perhaps "inf" or "nan" */
+    return slowDouble(start, end, value);
+  }
+
+  if (cursor < end && (*cursor == 'e' || *cursor == 'E')) {
+    char* after = nmSigned(cursor + 1, end, &scale);
+
+    if (after) {
+      cursor    = after;
+      exponent += scale;
+    }
+  }
+
+  /* Clinger's fast path: both operands are exact doubles */
+  if (overflow || count > 19 || mantissa > (UINT64_C(1) << 53) || exponent < -22 || exponent > 22) {
+    char* stop = slowDouble(start, end, value);
+    return stop ? stop : cursor;
+  }
+
+  *value = exponent < 0 ? (double)mantissa / exact[-exponent] : (double)mantissa * exact[exponent];
+  if (negative) { *value = -*value; }
+
+  return cursor;
+}
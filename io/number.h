@@ -0,0 +1,66 @@
+/**
+  @file       number.h
+  @brief      Fast number parsing header file
+  @author     Christopher Harrison (Xophmeister)
+  @copyright  @ref license
+
+  Implements parsing of decimal numbers from bounded, unterminated text
+  (e.g., a memory mapped file), as a faster alternative to the `strto*`
+  family, which need NUL terminated input and handle locales.
+
+  Integers are converted eight digits at a time: eight bytes are loaded
+  into a 64-bit word, the length of the run of digits is found with a
+  handful of bitwise operations and the digits are combined pairwise by
+  three multiplications (SWAR, "SIMD within a register"). Each function
+  returns the position just after the number, so calls can be chained
+  along a line.
+*/
+
+#ifndef NUMBER_H
+#define NUMBER_H
+
+#include <stdlib.h>
+#include <stdint.h>
+
+/**
+  @fn         char* nmUnsigned(char* cursor, char* end, uint64_t* value)
+  @brief      Parse an unsigned decimal integer
+  @param      cursor  Start of the number
+  @param      end     End of the text, which is never read
+  @param      value   Pointer that will receive the number
+  @return     Position just after the number's last digit; or `NULL` if
+              there is no digit at the cursor, or the number overflows
+
+  @note       No sign or leading whitespace is accepted
+*/
+extern char* nmUnsigned(char*, char*, uint64_t*);
+
+/**
+  @fn         char* nmSigned(char* cursor, char* end, int64_t* value)
+  @brief      Parse a signed decimal integer
+  @param      cursor  Start of the number, which may have a sign
+  @param      end     End of the text, which is never read
+  @param      value   Pointer that will receive the number
+  @return     Position just after the number's last digit; or `NULL` if
+              there is no number at the cursor, or it overflows
+*/
+extern char* nmSigned(char*, char*, int64_t*);
+
+/**
+  @fn         char* nmDouble(char* cursor, char* end, double* value)
+  @brief      Parse a decimal floating point number
+  @param      cursor  Start of the number, which may have a sign, a
+                      fractional part and an exponent
+  @param      end     End of the text, which is never read
+  @param      value   Pointer that will receive the number
+  @return     Position just after the number; or `NULL` if there is no
+              number at the cursor
+
+  Numbers whose significand has no more than nineteen digits and whose
+  conversion is exact in double precision (Clinger's fast path) are
+  computed directly; anything else, including infinities and NaNs, is
+  handed to `strtod`, so the result is always correctly rounded.
+*/
+extern char* nmDouble(char*, char*, double*);
+
+#endif
@@ -0,0 +1,411 @@
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "recordStream.h"
+#include "../parallel/threadPool.h"
+
+/* Default chunk size */
+#define rsChunk (1 << 24)
+
+/* Double buffered reader, filled ahead by a background thread */
+typedef struct {
+  int             fd;
+  rsFormat        format;
+  char*           buffer[2];
+  size_t          valid[2];  /* Bytes of whole records in each buffer */
+  int             full[2];
+  int             last[2];   /* Whether each buffer ends the file */
+  int             failed;
+  int             stopping;
+  pthread_t       thread;
+  pthread_mutex_t lock;
+  pthread_cond_t  changed;
+} reader;
+
+/* Processes one chunk's worth of whole records */
+typedef int(*chunkCallback)(char*, size_t, void*);
+
+/* Find the end of a buffer's last whole record */
+static size_t boundary(rsFormat* format, char* data, size_t length, int eof) {
+  if (format->width) {
+    return length - length % format->width;
+  }
+
+  if (!eof) {
+    while (length && data[length - 1] != format->delimiter) {
+      --length;
+    }
+  }
+
+  return length;
+}
+
+/* Find the record at the cursor, returning where the next one starts */
+static char* nextRecord(rsFormat* format, char* cursor, char* end, size_t* length) {
+  char* stop;
+
+  if (format->width) {
+    *length = format->width;
+    return cursor + format->width;
+  }
+
+  if (!(stop = memchr(cursor, format->delimiter, (size_t)(end - cursor)))) {
+    *length = (size_t)(end - cursor);
+    return end;
+  }
+
+  *length = (size_t)(stop - cursor);
+  return stop + 1;
+}
+
+/* Split whole records into roughly even pieces */
+static void split(rsFormat* format, char* data, size_t valid, size_t pieces, size_t* at) {
+  size_t i;
+
+  at[0]      = 0;
+  at[pieces] = valid;
+
+  for (i = 1; i < pieces; i++) {
+    size_t cut = valid / pieces * i;
+
+    if (format->width) {
+      cut -= cut % format->width;
+    } else if (cut) {
+      char* stop = memchr(data + cut - 1, format->delimiter, valid - cut + 1);
+      cut = stop ? (size_t)(stop - data) + 1 : valid;
+    }
+
+    at[i] = cut < at[i - 1] ? at[i - 1] : cut;
+  }
+}
+
+static void* readAhead(void* argument) {
+  reader* r       = (reader*)argument;
+  char*   carry   = NULL;
+  size_t  carried = 0;
+  int     i = 0, eof = 0, failed = 0;
+
+  while (!eof) {
+    size_t filled, valid;
+    int    stopping;
+
+    pthread_mutex_lock(&r->lock);
+    while (r->full[i] && !r->stopping) {
+      pthread_cond_wait(&r->changed, &r->lock);
+    }
+    stopping = r->stopping;
+    pthread_mutex_unlock(&r->lock);
+
+    if (stopping) { break; }
+
+    /* The other buffer's partial record, which it no longer needs */
+    if (carried) {
+      memcpy(r->buffer[i], carry, carried);
+    }
+
+    for (filled = carried; filled < r->format.chunk; ) {
+      ssize_t n = read(r->fd, r->buffer[i] + filled, r->format.chunk - filled);
+
+      if (n < 0) {
+        if (errno == EINTR) { continue; }
+        failed = eof = 1;
+        break;
+      }
+
+      if (!n) { eof = 1; break; }
+      filled += (size_t)n;
+    }
+
+    valid = boundary(&r->format, r->buffer[i], filled, eof);
+
+    /* A record longer than a chunk */
+    if (!eof && !valid) {
+      failed = eof = 1;
+    }
+
+    carry   = r->buffer[i] + valid;
+    carried = filled - valid;
+
+    pthread_mutex_lock(&r->lock);
+    r->valid[i] = failed ? 0 : valid;
+    r->last[i]  = eof;
+    r->failed   = failed;
+    r->full[i]  = 1;
+    pthread_cond_broadcast(&r->changed);
+    pthread_mutex_unlock(&r->lock);
+
+    i ^= 1;
+  }
+
+  return NULL;
+}
+
+/* Feed each chunk of a file to the callback, reading ahead */
+static int drive(char* path, rsFormat* format, chunkCallback callback, void* context) {
+  reader r;
+  int    i = 0, last = 0, failed = 0;
+
+  memset(&r, 0, sizeof(reader));
+  r.format = *format;
+
+  if (!r.format.chunk) { r.format.chunk = rsChunk; }
+
+  if (r.format.width) {
+    if (r.format.chunk < r.format.width) { r.format.chunk = r.format.width; }
+    r.format.chunk -= r.format.chunk % r.format.width;
+  }
+
+  if ((r.fd = open(path, O_RDONLY)) < 0) { return -1; }
+
+  posix_fadvise(r.fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+  r.buffer[0] = malloc(r.format.chunk);
+  r.buffer[1] = malloc(r.format.chunk);
+
+  pthread_mutex_init(&r.lock, NULL);
+  pthread_cond_init(&r.changed, NULL);
+
+  if (!r.buffer[0] || !r.buffer[1] || pthread_create(&r.thread, NULL, &readAhead, &r)) {
+    /* Memory allocation failure :P */
+    failed = 1;
+    goto finished;
+  }
+
+  while (!last && !failed) {
+    size_t valid;
+
+    pthread_mutex_lock(&r.lock);
+    while (!r.full[i]) {
+      pthread_cond_wait(&r.changed, &r.lock);
+    }
+    valid  = r.valid[i];
+    last   = r.last[i];
+    failed = last && r.failed;
+    pthread_mutex_unlock(&r.lock);
+
+    if (!failed && valid) {
+      failed = callback(r.buffer[i], valid, context);
+    }
+
+    pthread_mutex_lock(&r.lock);
+    r.full[i] = 0;
+    pthread_cond_broadcast(&r.changed);
+    pthread_mutex_unlock(&r.lock);
+
+    i ^= 1;
+  }
+
+  /* Stop reading ahead, if finished early */
+  pthread_mutex_lock(&r.lock);
+  r.stopping = 1;
+  pthread_cond_broadcast(&r.changed);
+  pthread_mutex_unlock(&r.lock);
+  pthread_join(r.thread, NULL);
+
+finished:
+  pthread_mutex_destroy(&r.lock);
+  pthread_cond_destroy(&r.changed);
+  free(r.buffer[0]);
+  free(r.buffer[1]);
+  close(r.fd);
+
+  return failed;
+}
+
+/* Fold ******************************************************************/
+
+typedef struct {
+  rsFormat*   format;
+  rsPipeline* pipeline;
+  void*       accumulator;
+  tpPool*     pool;
+  size_t      pieces;
+  char*       data;
+  size_t*     at;
+  char*       partial;  /* An accumulator per piece */
+  char*       value;    /* A mapped value per worker */
+} folding;
+
+static void foldRecords(rsFormat* format, rsPipeline* pipeline, char* cursor, char* end, void* accumulator, void* value) {
+  while (cursor < end) {
+    char*  record = cursor;
+    size_t length;
+
+    cursor = nextRecord(format, cursor, end, &length);
+
+    if (pipeline->filter && !pipeline->filter(record, length, pipeline->context)) {
+      continue;
+    }
+
+    if (pipeline->map) {
+      pipeline->map(value, record, length, pipeline->context);
+      pipeline->fold(accumulator, value, pipeline->width, pipeline->context);
+    } else {
+      pipeline->fold(accumulator, record, length, pipeline->context);
+    }
+  }
+}
+
+static void foldPieces(size_t from, size_t to, size_t worker, void* context) {
+  folding*    f = (folding*)context;
+  rsPipeline* p = f->pipeline;
+
+  for (; from < to; from++) {
+    char* partial = f->partial + from * p->size;
+
+    memcpy(partial, p->identity, p->size);
+    foldRecords(f->format, p, f->data + f->at[from], f->data + f->at[from + 1], partial, f->value + worker * p->width);
+  }
+}
+
+static int foldChunk(char* data, size_t valid, void* context) {
+  folding*    f = (folding*)context;
+  rsPipeline* p = f->pipeline;
+  size_t      i;
+
+  if (f->pieces == 1) {
+    foldRecords(f->format, p, data, data + valid, f->accumulator, f->value);
+  } else {
+    f->data = data;
+    split(f->format, data, valid, f->pieces, f->at);
+    tpFor(f->pool, f->pieces, 1, &foldPieces, f);
+
+    for (i = 0; i < f->pieces; i++) {
+      p->combine(f->accumulator, f->partial + i * p->size, p->context);
+    }
+  }
+
+  return 0;
+}
+
+int rsFold(char* path, rsFormat* format, rsPipeline* pipeline, void* accumulator, tpPool* pool) {
+  folding f;
+  size_t  workers = tpWorkers(pool);
+  int     failed;
+
+  f.format      = format;
+  f.pipeline    = pipeline;
+  f.accumulator = accumulator;
+  f.pool        = pool;
+  f.pieces      = pool && pipeline->combine ? 4 * workers : 1;
+  f.at          = malloc(sizeof(size_t) * (f.pieces + 1));
+  f.partial     = malloc(f.pieces * pipeline->size + 1);
+  f.value       = malloc(workers * pipeline->width + 1);
+
+  if (!f.at || !f.partial || !f.value) {
+    /* Memory allocation failure :P */
+    failed = 1;
+  } else {
+    failed = drive(path, format, &foldChunk, &f);
+  }
+
+  free(f.at);
+  free(f.partial);
+  free(f.value);
+
+  return failed;
+}
+
+/* Filter ****************************************************************/
+
+typedef struct {
+  rsFormat*        format;
+  rsFilterCallback filter;
+  void*            context;
+  int              fd;
+  tpPool*          pool;
+  size_t           pieces;
+  char*            data;
+  size_t*          at;
+  size_t*          kept;  /* Bytes kept by each piece */
+} filtering;
+
+/* Move the kept records of each piece down to its start */
+static void filterPieces(size_t from, size_t to, size_t worker, void* context) {
+  filtering* f = (filtering*)context;
+
+  for (; from < to; from++) {
+    char* start  = f->data + f->at[from];
+    char* cursor = start;
+    char* end    = f->data + f->at[from + 1];
+    char* kept   = start;
+
+    while (cursor < end) {
+      char*  record = cursor;
+      size_t length;
+
+      cursor = nextRecord(f->format, cursor, end, &length);
+
+      if (f->filter(record, length, f->context)) {
+        if (kept != record) {
+          memmove(kept, record, (size_t)(cursor - record));
+        }
+
+        kept += cursor - record;
+      }
+    }
+
+    f->kept[from] = (size_t)(kept - start);
+  }
+}
+
+static int writeAll(int fd, char* data, size_t length) {
+  while (length) {
+    ssize_t n = write(fd, data, length);
+
+    if (n < 0) {
+      if (errno == EINTR) { continue; }
+      return -1;
+    }
+
+    data   += n;
+    length -= (size_t)n;
+  }
+
+  return 0;
+}
+
+static int filterChunk(char* data, size_t valid, void* context) {
+  filtering* f = (filtering*)context;
+  size_t     i;
+
+  f->data = data;
+  split(f->format, data, valid, f->pieces, f->at);
+  tpFor(f->pool, f->pieces, 1, &filterPieces, f);
+
+  for (i = 0; i < f->pieces; i++) {
+    if (writeAll(f->fd, data + f->at[i], f->kept[i])) { return -1; }
+  }
+
+  return 0;
+}
+
+int rsFilter(char* path, rsFormat* format, rsFilterCallback filter, void* context, int fd, tpPool* pool) {
+  filtering f;
+  int       failed;
+
+  f.format  = format;
+  f.filter  = filter;
+  f.context = context;
+  f.fd      = fd;
+  f.pool    = pool;
+  f.pieces  = pool ? 4 * tpWorkers(pool) : 1;
+  f.at      = malloc(sizeof(size_t) * (f.pieces + 1));
+  f.kept    = malloc(sizeof(size_t) * f.pieces);
+
+  if (!f.at || !f.kept) {
+    /* Memory allocation failure :P */
+    failed = 1;
+  } else {
+    failed = drive(path, format, &filterChunk, &f);
+  }
+
+  free(f.at);
+  free(f.kept);
+
+  return failed;
+}
@@ -0,0 +1,228 @@
+/**
+  @file       recordStream.h
+  @brief      Streaming record processing header file
+  @author     Christopher Harrison (Xophmeister)
+  @copyright  @ref license
+
+  Implements filtering and folding over the records of a file that is
+  too large to load into memory, in the manner of dynFilter() and
+  dynFold(). Records are either of a fixed width or terminated by a
+  delimiter (e.g., lines).
+
+  The file is read in large chunks into two buffers: while one is being
+  processed, a background thread reads ahead into the other, so the
+  computation and the reading overlap and memory use is constant, no
+  matter the size of the file. A record that straddles the end of a
+  chunk is carried over to the start of the next.
+
+  Given a thread pool, each chunk is further split at record boundaries
+  between the pool's workers. Filtering is always safe to parallelise;
+  folding is, only if the fold is associative, in which case each piece
+  is folded into its own accumulator and the pieces are then combined,
+  in order, into the result.
+*/
+
+#ifndef RECORDSTREAM_H
+#define RECORDSTREAM_H
+
+#include <stdlib.h>
+#include "../parallel/threadPool.h"
+
+/**
+  @struct     rsFormat
+  @brief      Record format
+  @var        rsFormat::width
+              Width of each record, in bytes; or zero if records are
+              delimited
+  @var        rsFormat::delimiter
+              The byte that ends each record, if delimited (e.g., `'\n'`)
+  @var        rsFormat::chunk
+              Size of each of the two buffers, in bytes; or zero for the
+              default (16MiB)
+
+  @note       A delimited file's last record need not be delimited; a
+              fixed width file's trailing partial record is ignored
+  @warning    Each record must fit in a chunk
+*/
+typedef struct {
+  size_t width;
+  char   delimiter;
+  size_t chunk;
+} rsFormat;
+
+/**
+  @typedef    rsFilterCallback
+  @brief      Function signature for record filters
+
+  A filter must have the following signature:
+
+  @code{.c}
+  int filter(char* const record, size_t length, void* context)
+  @endcode
+
+  ...and return non-zero for the records to keep. The record's length
+  excludes its delimiter and the record is not NUL terminated. For
+  example, the following would keep non-empty lines:
+
+  @code{.c}
+  int nonEmpty(char* const record, size_t length, void* context) {
+    return length > 0;
+  }
+  @endcode
+
+  @note       Given a thread pool, the filter is run concurrently, on
+              different records
+*/
+typedef int(*rsFilterCallback)(char* const, size_t, void*);
+
+/**
+  @typedef    rsMapCallback
+  @brief      Function signature for record maps
+
+  A map must have the following signature:
+
+  @code{.c}
+  void map(void* const value, char* const record, size_t length, void* context)
+  @endcode
+
+  ...and parse or transform the record into the value, which is a slot
+  of rsPipeline::width bytes. For example, the following would parse
+  each line as a `double`:
+
+  @code{.c}
+  void parse(void* const value, char* const record, size_t length, void* context) {
+    nmDouble(record, record + length, (double*)value);
+  }
+  @endcode
+
+  @note       Given a thread pool, the map is run concurrently, on
+              different records and slots
+*/
+typedef void(*rsMapCallback)(void* const, char* const, size_t, void*);
+
+/**
+  @typedef    rsFoldCallback
+  @brief      Function signature for record folds
+
+  A fold must have the following signature:
+
+  @code{.c}
+  void fold(void* const accumulator, void* const value, size_t length, void* context)
+  @endcode
+
+  ...and fold the value into the accumulator. The value is the mapped
+  slot, of rsPipeline::width bytes, or the record itself, of the given
+  length, if the pipeline has no map. For example, the following would
+  sum `double`s:
+
+  @code{.c}
+  void sum(void* const accumulator, void* const value, size_t length, void* context) {
+    *(double*)accumulator += *(double*)value;
+  }
+  @endcode
+*/
+typedef void(*rsFoldCallback)(void* const, void* const, size_t, void*);
+
+/**
+  @typedef    rsCombineCallback
+  @brief      Function signature for accumulator combiners
+
+  A combiner must have the following signature:
+
+  @code{.c}
+  void combine(void* const accumulator, void* const partial, void* context)
+  @endcode
+
+  ...and fold a partial accumulator, covering the records that directly
+  follow those already in the accumulator, into it. For the sum above,
+  this would be:
+
+  @code{.c}
+  void add(void* const accumulator, void* const partial, void* context) {
+    *(double*)accumulator += *(double*)partial;
+  }
+  @endcode
+
+  @note       Partials are combined in file order, so the fold need only
+              be associative, not commutative
+*/
+typedef void(*rsCombineCallback)(void* const, void* const, void*);
+
+/**
+  @struct     rsPipeline
+  @brief      Record processing pipeline
+  @var        rsPipeline::filter
+              The records to keep; or `NULL` to keep all of them
+  @var        rsPipeline::map
+              How to map each kept record to a value; or `NULL` to fold
+              the records themselves
+  @var        rsPipeline::width
+              Width of each mapped value, in bytes
+  @var        rsPipeline::fold
+              How to fold each value into the accumulator
+  @var        rsPipeline::combine
+              How to combine partial accumulators; or `NULL` if the fold
+              is not associative, in which case it is run serially
+  @var        rsPipeline::identity
+              Pointer to the value that each partial accumulator starts
+              from (e.g., zero for a sum); only needed with a combiner
+  @var        rsPipeline::size
+              Size of the accumulator, in bytes
+  @var        rsPipeline::context
+              Pointer passed through to each callback
+*/
+typedef struct {
+  rsFilterCallback  filter;
+  rsMapCallback     map;
+  size_t            width;
+  rsFoldCallback    fold;
+  rsCombineCallback combine;
+  void*             identity;
+  size_t            size;
+  void*             context;
+} rsPipeline;
+
+/**
+  @fn         int rsFold(char* path, rsFormat* format, rsPipeline* pipeline, void* accumulator, tpPool* pool)
+  @brief      Filter, map and fold the records of a file
+  @param      path         The file's path
+  @param      format       The record format
+  @param      pipeline     The callbacks to apply
+  @param      accumulator  Pointer to the accumulator, which holds the
+                           initial value and will receive the result
+  @param      pool         Thread pool to run on; or `NULL` to run
+                           serially
+  @return     Zero on success; non-zero if the file could not be read or
+              holds a record longer than a chunk, or in the event of an
+              allocation or thread creation failure
+
+  Stream the file through the pipeline, one chunk at a time, in the
+  order of its records. The pool is only used if the pipeline has a
+  combiner.
+
+  @note       On failure, the accumulator holds the fold of the records
+              that were processed before it
+*/
+extern int rsFold(char*, rsFormat*, rsPipeline*, void*, tpPool*);
+
+/**
+  @fn         int rsFilter(char* path, rsFormat* format, rsFilterCallback filter, void* context, int fd, tpPool* pool)
+  @brief      Filter the records of a file to a file descriptor
+  @param      path     The file's path
+  @param      format   The record format
+  @param      filter   The records to keep
+  @param      context  Pointer passed through to the filter
+  @param      fd       The file descriptor to write the kept records to
+  @param      pool     Thread pool to run on; or `NULL` to run serially
+  @return     Zero on success; non-zero if the file could not be read or
+              written or holds a record longer than a chunk, or in the
+              event of an allocation or thread creation failure
+
+  Stream the file through the filter, one chunk at a time, and write
+  the records that pass, with their delimiters, in their original order.
+  Kept records are compacted within the chunk's buffer, so nothing more
+  is allocated.
+*/
+extern int rsFilter(char*, rsFormat*, rsFilterCallback, void*, int, tpPool*);
+
+#endif
@@ -0,0 +1,159 @@
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "textFile.h"
+#include "../indexed/typedArray.h"
+
+/* Bytes of text per chunk, at least */
+#define txChunk (1 << 20)
+
+txFile* txOpen(char* path) {
+  txFile*     newFile;
+  struct stat status;
+  int         fd = open(path, O_RDONLY);
+
+  if (fd < 0) { return NULL; }
+
+  if (fstat(fd, &status) || !(newFile = malloc(sizeof(txFile)))) {
+    close(fd);
+    return NULL;
+  }
+
+  newFile->data   = NULL;
+  newFile->length = (size_t)status.st_size;
+
+  if (newFile->length) {
+    newFile->data = mmap(NULL, newFile->length, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if (newFile->data == MAP_FAILED) {
+      free(newFile);
+      newFile = NULL;
+    } else {
+      madvise(newFile->data, newFile->length, MADV_SEQUENTIAL);
+    }
+  }
+
+  /* The mapping outlives the descriptor */
+  close(fd);
+  return newFile;
+}
+
+void txClose(txFile* file) {
+  if (file) {
+    if (file->data) {
+      munmap(file->data, file->length);
+    }
+
+    free(file);
+  }
+}
+
+size_t txCount(char* data, size_t length, char byte) {
+  size_t count = 0, i = 0;
+
+#if defined(__AVX2__)
+  __m256i needle = _mm256_set1_epi8(byte);
+
+  for (; i + 32 <= length; i += 32) {
+    __m256i block = _mm256_loadu_si256((__m256i*)(data + i));
+    count += (size_t)__builtin_popcount((unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, needle)));
+  }
+#elif defined(__SSE2__)
+  __m128i needle = _mm_set1_epi8(byte);
+
+  for (; i + 16 <= length; i += 16) {
+    __m128i block = _mm_loadu_si128((__m128i*)(data + i));
+    count += (size_t)__builtin_popcount((unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(block, needle)));
+  }
+#endif
+
+  for (; i < length; i++) {
+    count += data[i] == byte;
+  }
+
+  return count;
+}
+
+size_t* txChunks(char* data, size_t length, size_t chunks) {
+  size_t* offset;
+  size_t  i;
+
+  if (!chunks) { chunks = 1; }
+
+  if ((offset = malloc(sizeof(size_t) * (chunks + 1)))) {
+    offset[0]      = 0;
+    offset[chunks] = length;
+
+    for (i = 1; i < chunks; i++) {
+      size_t at = (size_t)(((unsigned __int128)length * i) / chunks);
+      char*  newline;
+
+      if (at < offset[i - 1]) {
+        /* The previous boundary already passed this one */
+        at = offset[i - 1];
+      } else if (at) {
+        /* Just past the newline ending the line that contains at - 1 */
+        newline = memchr(data + at - 1, '\n', length - at + 1);
+        at      = newline ? (size_t)(newline - data) + 1 : length;
+      }
+
+      offset[i] = at;
+    }
+  }
+
+  return offset;
+}
+
+size_t txChunkCount(size_t length, size_t workers) {
+  size_t chunks = 4 * workers;
+
+  if (chunks > length / txChunk) { chunks = length / txChunk; }
+  return chunks ? chunks : 1;
+}
+
+size_t txSlots(size_t* slot, size_t chunks) {
+  size_t i;
+
+  slot[0] = 0;
+
+  for (i = 0; i < chunks; i++) {
+    slot[i + 1] += slot[i];
+  }
+
+  return slot[chunks];
+}
+
+size_t txCompact(tyArray** arrays, size_t count, size_t* slot, size_t* parsed, size_t chunks) {
+  size_t total = 0, i, a;
+
+  for (i = 0; i < chunks; i++) {
+    if (total != slot[i]) {
+      for (a = 0; a < count; a++) {
+        tyArray* array = arrays[a];
+
+        if (array) {
+          memmove((char*)array->buffer + total * array->width, (char*)array->buffer + slot[i] * array->width, parsed[i] * array->width);
+        }
+      }
+    }
+
+    total += parsed[i];
+  }
+
+  for (a = 0; a < count; a++) {
+    if (arrays[a]) {
+      tyResize(arrays[a], total ? total : 1);
+      arrays[a]->length = total;
+    }
+  }
+
+  return total;
+}
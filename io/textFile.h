@@ -0,0 +1,145 @@
+/**
+  @file       textFile.h
+  @brief      Memory mapped text file header file
+  @author     Christopher Harrison (Xophmeister)
+  @copyright  @ref license
+
+  Implements read only memory mapping of text files, together with the
+  primitives needed to parse them in parallel: fast counting of a given
+  byte (e.g., newlines), splitting into chunks at line boundaries and
+  gathering each chunk's output into typed arrays.
+
+  A parallel parser counts the records in each chunk, to give it a range
+  of output slots (txSlots()), parses every chunk into its own range at
+  once, then moves the parsed records down to close the gaps left by
+  blank or malformed ones (txCompact()).
+
+  Mapping a file avoids copying it through a read buffer and lets the
+  operating system page it in as it is parsed, so files larger than
+  memory can be processed.
+*/
+
+#ifndef TEXTFILE_H
+#define TEXTFILE_H
+
+#include <stdlib.h>
+#include "../indexed/typedArray.h"
+
+/**
+  @struct     txFile
+  @brief      Memory mapped text file
+  @var        txFile::data
+              Address at which the file is mapped; or `NULL` if it is
+              empty
+  @var        txFile::length
+              Length of the file, in bytes
+
+  @note       The file's contents are not NUL terminated
+*/
+typedef struct {
+  char*  data;
+  size_t length;
+} txFile;
+
+/**
+  @fn         txFile* txOpen(char* path)
+  @brief      Map a file into memory, read only
+  @param      path  The file's path
+  @return     Pointer to the mapped file; or `NULL` if it could not be
+              opened or mapped, or in the event of an allocation failure
+
+  @note       The kernel is advised that the file will be read
+              sequentially
+*/
+extern txFile* txOpen(char*);
+
+/**
+  @fn         void txClose(txFile* file)
+  @brief      Unmap a file and free its structure
+  @param      file  The mapped file
+*/
+extern void txClose(txFile*);
+
+/**
+  @fn         size_t txCount(char* data, size_t length, char byte)
+  @brief      Count the occurrences of a byte in a buffer
+  @param      data    The buffer
+  @param      length  Length of the buffer, in bytes
+  @param      byte    The byte to count
+  @return     The number of occurrences
+
+  Compare sixteen (or, with AVX2, thirty-two) bytes at a time and count
+  the matches from the comparison's bit mask.
+*/
+extern size_t txCount(char*, size_t, char);
+
+/**
+  @fn         size_t* txChunks(char* data, size_t length, size_t chunks)
+  @brief      Split a buffer into chunks at line boundaries
+  @param      data    The buffer
+  @param      length  Length of the buffer, in bytes
+  @param      chunks  Number of chunks
+  @return     Array of `chunks + 1` offsets into the buffer, where chunk
+              `i` is `[offset[i], offset[i + 1])`; or `NULL` in the event
+              of an allocation failure
+
+  Divide the buffer evenly, then move each boundary forward to just past
+  the next newline, so that no line is split between chunks.
+
+  @note       A chunk may be empty if a line spans more than one even
+              division
+  @note       The returned array must be freed by the caller
+*/
+extern size_t* txChunks(char*, size_t, size_t);
+
+/**
+  @fn         size_t txChunkCount(size_t length, size_t workers)
+  @brief      Choose how many chunks to parse a buffer in
+  @param      length   Length of the buffer, in bytes
+  @param      workers  Number of workers that will parse it
+  @return     Number of chunks, at least one
+
+  Four chunks per worker, so that uneven chunks still balance, but none
+  smaller than a megabyte, so that small buffers are not split for the
+  sake of it.
+*/
+extern size_t txChunkCount(size_t, size_t);
+
+/**
+  @fn         size_t txSlots(size_t* slot, size_t chunks)
+  @brief      Turn each chunk's record count into its first output slot
+  @param      slot    Array of `chunks + 1` counts, where `slot[i + 1]`
+                      is the most records that chunk `i` can produce
+  @param      chunks  Number of chunks
+  @return     Total number of slots
+
+  Replace the counts with their running total, so that chunk `i` owns
+  the slots `[slot[i], slot[i + 1])`.
+
+  @note       `slot[0]` is set to zero
+  @note       An unterminated last record needs a slot of its own, so a
+              chunk with `n` newlines should count `n + 1`
+*/
+extern size_t txSlots(size_t*, size_t);
+
+/**
+  @fn         size_t txCompact(tyArray** arrays, size_t count, size_t* slot, size_t* parsed, size_t chunks)
+  @brief      Gather each chunk's parsed records into a contiguous prefix
+  @param      arrays  Array of typed arrays, each with an element per
+                      slot; `NULL` entries are ignored
+  @param      count   Number of typed arrays
+  @param      slot    Each chunk's first slot, as from txSlots()
+  @param      parsed  Number of records each chunk actually parsed
+  @param      chunks  Number of chunks
+  @return     Total number of records parsed
+
+  Move each chunk's records, in every array, down to directly follow the
+  previous chunk's, then shrink the arrays and set their lengths to the
+  total.
+
+  @note       The arrays keep room for at least one element, so that an
+              empty result still has a buffer
+*/
+extern size_t txCompact(tyArray**, size_t, size_t*, size_t*, size_t);
+
+#endif
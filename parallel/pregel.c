@@ -0,0 +1,495 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "pregel.h"
+#include "../graph/compactGraph.h"
+#include "../graph/partition.h"
+#include "../shared/region.h"
+
+/* Messages each ring can hold before its sender has to wait */
+#define pgCapacity 1024
+
+/* State shared by all the workers */
+typedef struct {
+  pthread_barrier_t barrier;
+  atomic_size_t     finished[3];
+  atomic_size_t     active[3];
+  atomic_int        failed;
+  size_t            supersteps;
+} pgShared;
+
+/* Single producer, single consumer ring of messages, each stored with
+   its target; the head and tail only ever increase */
+typedef struct {
+  atomic_size_t head;
+  char          padHead[64 - sizeof(atomic_size_t)];
+  atomic_size_t tail;
+  char          padTail[64 - sizeof(atomic_size_t)];
+} pgRing;
+
+struct pgContext {
+  cgGraph*   graph;
+  pgProgram* program;
+  pgShared*  shared;
+  size_t*    part;
+  size_t     worker;
+  size_t     workers;
+  size_t     superstep;
+  size_t     vertex;
+  size_t     local;
+
+  /* The worker's vertices, and global to local identifiers */
+  size_t     owned;
+  size_t*    global;
+  size_t*    localOf;
+  char*      halted;
+
+  /* Rings, as a workers by workers matrix from sender to receiver */
+  char*      rings;
+  size_t     ringBytes;
+  size_t     record;
+
+  /* Messages for this superstep and the next: with a combiner, one per
+     vertex; otherwise, (local identifier, message) records that are
+     sorted into an inbox at the start of each superstep */
+  char*      current;
+  size_t*    count;
+  char*      next;
+  size_t*    nextCount;
+  size_t*    offset;
+  char*      records;
+  size_t     pending;
+  size_t     allocated;
+  int        failed;
+};
+
+static pgRing* ring(pgContext* context, size_t from, size_t to) {
+  return (pgRing*)(context->rings + (from * context->workers + to) * context->ringBytes);
+}
+
+/* Keep a message for one of this worker's vertices; once the worker has
+   failed, messages are just discarded so that senders aren't held up */
+static void deliver(pgContext* context, size_t target, void* message) {
+  size_t width = context->program->messageWidth;
+  size_t local;
+
+  if (context->failed) { return; }
+  local = context->localOf[target];
+
+  if (context->program->combine) {
+    if (context->nextCount[local]++) {
+      context->program->combine(context->next + local * width, message);
+    } else {
+      memcpy(context->next + local * width, message, width);
+    }
+  } else {
+    if (context->pending == context->allocated) {
+      size_t newAllocation = context->allocated ? context->allocated * 2 : 64;
+      char*  records = realloc(context->records, newAllocation * context->record);
+
+      if (!records) {
+        /* Memory reallocation failed :P */
+        context->failed = 1;
+        return;
+      }
+
+      context->records   = records;
+      context->allocated = newAllocation;
+    }
+
+    *(size_t*)(context->records + context->pending * context->record) = local;
+    memcpy(context->records + context->pending * context->record + sizeof(size_t), message, width);
+    ++context->pending;
+  }
+}
+
+/* Move everything waiting in this worker's incoming rings into its
+   inbox, returning the number of messages moved */
+static size_t drain(pgContext* context) {
+  size_t moved = 0;
+  size_t from;
+
+  for (from = 0; from < context->workers; from++) {
+    pgRing* r;
+    char*   data;
+    size_t  head, tail;
+
+    if (from == context->worker) { continue; }
+
+    r    = ring(context, from, context->worker);
+    data = (char*)(r + 1);
+    head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+
+    for (; head < tail; head++, moved++) {
+      char* slot = data + (head % pgCapacity) * context->record;
+      deliver(context, *(size_t*)slot, slot + sizeof(size_t));
+    }
+
+    atomic_store_explicit(&r->head, head, memory_order_release);
+  }
+
+  return moved;
+}
+
+void pgSend(pgContext* context, size_t target, void* message) {
+  size_t  to = context->part[target];
+  pgRing* r;
+  size_t  tail;
+  char*   slot;
+
+  if (to == context->worker) {
+    deliver(context, target, message);
+    return;
+  }
+
+  r    = ring(context, context->worker, to);
+  tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+
+  /* While the ring is full, drain our own so no one waits on us */
+  while (tail - atomic_load_explicit(&r->head, memory_order_acquire) == pgCapacity) {
+    if (!drain(context)) {
+      sched_yield();
+    }
+  }
+
+  slot = (char*)(r + 1) + (tail % pgCapacity) * context->record;
+  *(size_t*)slot = target;
+  memcpy(slot + sizeof(size_t), message, context->program->messageWidth);
+  atomic_store_explicit(&r->tail, tail + 1, memory_order_release);
+}
+
+void pgSendNeighbours(pgContext* context, void* message) {
+  cgGraph* graph = context->graph;
+  size_t   e;
+
+  for (e = graph->offset[context->vertex]; e < graph->offset[context->vertex + 1]; e++) {
+    pgSend(context, graph->target[e], message);
+  }
+}
+
+void pgHalt(pgContext* context) {
+  context->halted[context->local] = 1;
+}
+
+size_t pgSuperstep(pgContext* context) {
+  return context->superstep;
+}
+
+cgGraph* pgGraph(pgContext* context) {
+  return context->graph;
+}
+
+void* pgUser(pgContext* context) {
+  return context->program->user;
+}
+
+/* Turn the messages kept in the last superstep into this one's inbox */
+static void receive(pgContext* context) {
+  size_t width = context->program->messageWidth;
+  size_t i, l;
+
+  if (context->program->combine) {
+    char*   swap      = context->current;
+    size_t* swapCount = context->count;
+
+    context->current   = context->next;
+    context->count     = context->nextCount;
+    context->next      = swap;
+    context->nextCount = swapCount;
+
+    for (l = 0; l < context->owned; l++) {
+      context->nextCount[l] = 0;
+      if (context->count[l]) { context->count[l] = 1; }
+    }
+  } else {
+    char* inbox = realloc(context->current, (context->pending ? context->pending : 1) * width);
+
+    if (!inbox) {
+      /* Memory reallocation failed :P */
+      context->failed = 1;
+      context->pending = 0;
+      return;
+    }
+    context->current = inbox;
+
+    /* Counting sort the records by vertex */
+    for (l = 0; l <= context->owned; l++) {
+      context->offset[l] = 0;
+    }
+    for (i = 0; i < context->pending; i++) {
+      ++context->offset[*(size_t*)(context->records + i * context->record) + 1];
+    }
+    for (l = 0; l < context->owned; l++) {
+      context->offset[l + 1] += context->offset[l];
+    }
+    for (i = 0; i < context->pending; i++) {
+      char* record = context->records + i * context->record;
+      l = *(size_t*)record;
+      memcpy(context->current + context->offset[l]++ * width, record + sizeof(size_t), width);
+    }
+    for (l = context->owned; l; l--) {
+      context->offset[l] = context->offset[l - 1];
+    }
+    context->offset[0] = 0;
+
+    for (l = 0; l < context->owned; l++) {
+      context->count[l] = context->offset[l + 1] - context->offset[l];
+    }
+
+    context->pending = 0;
+  }
+}
+
+static int work(pgContext* context, char* values, size_t supersteps) {
+  pgShared* shared = context->shared;
+  size_t    width  = context->program->messageWidth;
+  size_t    n      = context->owned ? context->owned : 1;
+  size_t    s, l;
+
+  context->localOf = malloc(sizeof(size_t) * (context->graph->nodes ? context->graph->nodes : 1));
+  context->halted  = calloc(n, 1);
+  context->count   = calloc(n, sizeof(size_t));
+  context->offset  = malloc(sizeof(size_t) * (n + 1));
+
+  if (context->program->combine) {
+    context->current   = malloc(n * width);
+    context->next      = malloc(n * width);
+    context->nextCount = calloc(n, sizeof(size_t));
+    context->failed    = !context->current || !context->next || !context->nextCount;
+  }
+
+  context->failed = context->failed || !context->localOf || !context->halted || !context->count || !context->offset;
+
+  if (!context->failed) {
+    for (l = 0; l < context->owned; l++) {
+      context->localOf[context->global[l]] = l;
+    }
+  }
+
+  for (s = 0; !supersteps || s < supersteps; s++) {
+    size_t active = 0;
+
+    context->superstep = s;
+
+    if (!context->failed) {
+      if (s) {
+        receive(context);
+      }
+
+      for (l = 0; l < context->owned && !context->failed; l++) {
+        size_t count = s ? context->count[l] : 0;
+
+        if (!s || !context->halted[l] || count) {
+          char* messages = NULL;
+
+          if (count) {
+            messages = context->current + (context->program->combine ? l : context->offset[l]) * width;
+          }
+
+          context->halted[l] = 0;
+          context->vertex    = context->global[l];
+          context->local     = l;
+
+          context->program->compute(context, context->vertex, values + context->vertex * context->program->valueWidth, messages, count);
+        }
+      }
+    }
+
+    if (context->failed) {
+      atomic_store(&shared->failed, 1);
+    }
+
+    /* Keep draining until everyone has finished sending */
+    atomic_fetch_add(shared->finished + s % 3, 1);
+    while (atomic_load(shared->finished + s % 3) < context->workers) {
+      if (!drain(context)) {
+        sched_yield();
+      }
+    }
+    while (drain(context));
+
+    for (l = 0; l < context->owned && !context->failed; l++) {
+      active += !context->halted[l];
+      if (context->program->combine) {
+        active += context->nextCount[l];
+      }
+    }
+    active += context->pending;
+    atomic_fetch_add(shared->active + s % 3, active);
+
+    /* The counters for the next superstep were last read before the
+       previous barrier, so they're safe to reset now */
+    if (!context->worker) {
+      atomic_store(shared->finished + (s + 1) % 3, 0);
+      atomic_store(shared->active + (s + 1) % 3, 0);
+    }
+
+    pthread_barrier_wait(&shared->barrier);
+
+    if (atomic_load(&shared->failed)) {
+      return 1;
+    }
+
+    if (!atomic_load(shared->active + s % 3)) {
+      ++s;
+      break;
+    }
+  }
+
+  if (!context->worker) {
+    shared->supersteps = s;
+  }
+
+  return 0;
+}
+
+/* Rounded up size of an allocation from a region */
+static size_t footprint(size_t size) {
+  size_t rounded = 32;
+
+  while (rounded < size + 16) {
+    rounded *= 2;
+  }
+
+  return rounded;
+}
+
+size_t pgRun(cgGraph* graph, ptPartition* partition, pgProgram* program, void* values, size_t supersteps) {
+  size_t              workers = partition->parts;
+  size_t              n       = graph->nodes ? graph->nodes : 1;
+  size_t              record  = (sizeof(size_t) + program->messageWidth + 7) & ~(size_t)7;
+  size_t              ringBytes = sizeof(pgRing) + pgCapacity * record;
+  shRegion*           region;
+  pgShared*           shared;
+  char*               sharedValues;
+  char*               rings;
+  pid_t*              child;
+  pthread_barrierattr_t attributes;
+  size_t              i, running, result = cgNone;
+  int                 failed = 0;
+
+  if (!workers) { return cgNone; }
+
+  region = shCreate(NULL, 4096 + footprint(sizeof(pgShared)) + footprint(n * program->valueWidth) + footprint(workers * workers * ringBytes));
+  child  = calloc(workers, sizeof(pid_t));
+
+  if (!region || !child) {
+    /* Memory allocation failure :P */
+    shClose(region);
+    free(child);
+    return cgNone;
+  }
+
+  shared       = shAlloc(region, sizeof(pgShared));
+  sharedValues = shAlloc(region, n * program->valueWidth);
+  rings        = shAlloc(region, workers * workers * ringBytes);
+
+  if (!shared || !sharedValues || !rings) {
+    /* Region too small :P */
+    shClose(region);
+    free(child);
+    return cgNone;
+  }
+
+  memcpy(sharedValues, values, graph->nodes * program->valueWidth);
+
+  for (i = 0; i < 3; i++) {
+    atomic_init(shared->finished + i, 0);
+    atomic_init(shared->active + i, 0);
+  }
+  atomic_init(&shared->failed, 0);
+  shared->supersteps = 0;
+
+  for (i = 0; i < workers * workers; i++) {
+    pgRing* r = (pgRing*)(rings + i * ringBytes);
+    atomic_init(&r->head, 0);
+    atomic_init(&r->tail, 0);
+  }
+
+  if (pthread_barrierattr_init(&attributes)
+   || pthread_barrierattr_setpshared(&attributes, PTHREAD_PROCESS_SHARED)
+   || pthread_barrier_init(&shared->barrier, &attributes, (unsigned)workers)) {
+    shClose(region);
+    free(child);
+    return cgNone;
+  }
+  pthread_barrierattr_destroy(&attributes);
+
+  for (i = 0; i < workers && !failed; i++) {
+    child[i] = fork();
+
+    if (child[i] == 0) {
+      pgContext context;
+
+      memset(&context, 0, sizeof(pgContext));
+      context.graph     = graph;
+      context.program   = program;
+      context.shared    = shared;
+      context.part      = partition->part;
+      context.worker    = i;
+      context.workers   = workers;
+      context.owned     = partition->shard[i].owned;
+      context.global    = partition->shard[i].global;
+      context.rings     = rings;
+      context.ringBytes = ringBytes;
+      context.record    = record;
+
+      /* No need to tidy up; the process is about to end */
+      _exit(work(&context, sharedValues, supersteps));
+    }
+
+    if (child[i] < 0) {
+      failed = 1;
+      break;
+    }
+  }
+
+  /* Wait for the workers; if one dies, the rest can't finish, so poll
+     them all rather than block on any one */
+  for (running = i; running;) {
+    size_t done = 0;
+
+    for (i = 0; i < workers; i++) {
+      int status;
+
+      if (child[i] <= 0) { continue; }
+
+      if (failed) {
+        kill(child[i], SIGKILL);
+      }
+
+      if (waitpid(child[i], &status, failed ? 0 : WNOHANG) == child[i]) {
+        if (!WIFEXITED(status) || WEXITSTATUS(status)) {
+          failed = 1;
+        }
+
+        child[i] = 0;
+        --running;
+        ++done;
+      }
+    }
+
+    if (running && !done) {
+      usleep(1000);
+    }
+  }
+
+  if (!failed) {
+    memcpy(values, sharedValues, graph->nodes * program->valueWidth);
+    result = shared->supersteps;
+  }
+
+  pthread_barrier_destroy(&shared->barrier);
+  shClose(region);
+  free(child);
+
+  return result;
+}
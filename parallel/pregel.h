@@ -0,0 +1,209 @@
+/**
+  @file       pregel.h
+  @brief      Multi-process vertex program executor header file
+  @author     Christopher Harrison (Xophmeister)
+  @copyright  @ref license
+
+  Implements a bulk synchronous, "think like a vertex" executor (after
+  Google's Pregel) that runs a vertex program over a partitioned compact
+  graph in several local worker processes, one per partition.
+
+  Computation proceeds in supersteps. In each, every active vertex of
+  every partition runs the program, which can read and update its own
+  value, read the messages sent to it in the previous superstep, send
+  messages to any vertex for the next superstep and vote to halt. A
+  halted vertex is reactivated by any message sent to it. The run ends
+  when every vertex has halted and no messages are in flight, or after a
+  given number of supersteps.
+
+  Each worker is a separate process with its own heap, so workers never
+  contend over an allocator. Vertex values live in a shared memory
+  region, and messages between partitions travel through single
+  producer, single consumer ring buffers in the same region, one for
+  each ordered pair of workers; messages within a partition never leave
+  their worker. Supersteps are separated by process-shared barriers.
+*/
+
+#ifndef PREGEL_H
+#define PREGEL_H
+
+#include <stdlib.h>
+#include "../graph/compactGraph.h"
+#include "../graph/partition.h"
+
+/**
+  @struct     pgContext
+  @brief      Vertex program context
+
+  Passed to the vertex program on every call, to query and act on the
+  state of the run with pgSuperstep(), pgGraph(), pgUser(), pgSend(),
+  pgSendNeighbours() and pgHalt().
+
+  @note       The context's structure is private to the implementation
+*/
+typedef struct pgContext pgContext;
+
+/**
+  @typedef    pgComputeCallback
+  @brief      Function signature for vertex programs
+
+  The vertex program must have the following signature:
+
+  @code{.c}
+  void program(pgContext* context, size_t vertex, void* value, void* messages, size_t count)
+  @endcode
+
+  That is, on each active vertex, the program is called with the
+  following:
+
+  @param      context   The vertex program context
+  @param      vertex    The vertex's identifier, in the compact graph
+  @param      value     Pointer to the vertex's value, which it may
+                        update
+  @param      messages  Pointer to the messages sent to the vertex in the
+                        previous superstep, contiguously
+  @param      count     The number of messages
+
+  For example, the following program would label every vertex of a
+  symmetric graph with the smallest identifier in its component, with
+  `size_t` values and messages:
+
+  @code{.c}
+  void components(pgContext* context, size_t vertex, void* value, void* messages, size_t count) {
+    size_t* label = (size_t*)value;
+    size_t  i, least = pgSuperstep(context) ? *label : vertex;
+
+    for (i = 0; i < count; i++) {
+      if (((size_t*)messages)[i] < least) { least = ((size_t*)messages)[i]; }
+    }
+
+    if (!pgSuperstep(context) || least < *label) {
+      *label = least;
+      pgSendNeighbours(context, label);
+    }
+    pgHalt(context);
+  }
+  @endcode
+
+  @note       Programs run in forked worker processes, so changes they
+              make to ordinary memory are not seen by the caller
+*/
+typedef void(*pgComputeCallback)(pgContext*, size_t, void*, void*, size_t);
+
+/**
+  @typedef    pgCombineCallback
+  @brief      Function signature for message combiners
+
+  A combiner must have the following signature:
+
+  @code{.c}
+  void combine(void* accumulator, void* message)
+  @endcode
+
+  ...and fold the message into the accumulator, which holds a previous
+  message to the same vertex. It must be commutative and associative, as
+  messages arrive in no particular order; the vertex program then sees
+  at most one message per superstep.
+*/
+typedef void(*pgCombineCallback)(void*, void*);
+
+/**
+  @struct     pgProgram
+  @brief      Vertex program
+  @var        pgProgram::valueWidth
+              Width of each vertex's value, in bytes
+  @var        pgProgram::messageWidth
+              Width of each message, in bytes
+  @var        pgProgram::compute
+              The vertex program
+  @var        pgProgram::combine
+              The message combiner; or `NULL`
+  @var        pgProgram::user
+              Pointer available to the program through pgUser()
+*/
+typedef struct {
+  size_t            valueWidth;
+  size_t            messageWidth;
+  pgComputeCallback compute;
+  pgCombineCallback combine;
+  void*             user;
+} pgProgram;
+
+/**
+  @fn         size_t pgRun(cgGraph* graph, ptPartition* partition, pgProgram* program, void* values, size_t supersteps)
+  @brief      Run a vertex program over a partitioned compact graph
+  @param      graph       The compact graph
+  @param      partition   Partitioning of the compact graph, with one
+                          worker process per partition
+  @param      program     The vertex program
+  @param      values      Array of vertex values, by identifier, which
+                          holds the initial values and will receive the
+                          final ones
+  @param      supersteps  Maximum number of supersteps to run; or zero
+                          to run until every vertex has halted
+  @return     Number of supersteps run; or cgNone if a worker failed, or
+              in the event of an allocation failure
+
+  Fork a worker for each partition and run the program in supersteps
+  until it finishes, then copy the final vertex values back. Every
+  vertex is active in the first superstep. Within a worker, vertices run
+  in order of identifier.
+
+  When a worker's ring to another is full, it drains its own incoming
+  rings while it waits, so that workers blocked on each other always
+  make progress. The superstep ends once every worker has finished
+  sending and has drained its rings.
+
+  @note       Only the calling thread is forked, so the program must not
+              use thread pools created before the run
+*/
+extern size_t pgRun(cgGraph*, ptPartition*, pgProgram*, void*, size_t);
+
+/**
+  @fn         size_t pgSuperstep(pgContext* context)
+  @brief      The current superstep, counting from zero
+  @param      context  The vertex program context
+*/
+extern size_t pgSuperstep(pgContext*);
+
+/**
+  @fn         cgGraph* pgGraph(pgContext* context)
+  @brief      The compact graph being run over
+  @param      context  The vertex program context
+*/
+extern cgGraph* pgGraph(pgContext*);
+
+/**
+  @fn         void* pgUser(pgContext* context)
+  @brief      The program's user pointer
+  @param      context  The vertex program context
+*/
+extern void* pgUser(pgContext*);
+
+/**
+  @fn         void pgSend(pgContext* context, size_t target, void* message)
+  @brief      Send a message to a vertex for the next superstep
+  @param      context  The vertex program context
+  @param      target   The identifier of the vertex to send to
+  @param      message  Pointer to the message, which is copied
+*/
+extern void pgSend(pgContext*, size_t, void*);
+
+/**
+  @fn         void pgSendNeighbours(pgContext* context, void* message)
+  @brief      Send a message along every edge of the current vertex
+  @param      context  The vertex program context
+  @param      message  Pointer to the message, which is copied
+*/
+extern void pgSendNeighbours(pgContext*, void*);
+
+/**
+  @fn         void pgHalt(pgContext* context)
+  @brief      Vote to halt the current vertex
+  @param      context  The vertex program context
+
+  The vertex will not run again until it is sent a message.
+*/
+extern void pgHalt(pgContext*);
+
+#endif
@@ -0,0 +1,179 @@
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "threadPool.h"
+
+struct tpPool {
+  size_t          threads;
+  pthread_t*      thread;
+  pthread_mutex_t lock;
+  pthread_cond_t  wake;
+  pthread_cond_t  done;
+
+  /* Current loop */
+  size_t          generation;
+  size_t          busy;
+  int             stopping;
+  size_t          count;
+  size_t          grain;
+  tpForCallback   callback;
+  void*           context;
+  atomic_size_t   next;
+};
+
+/* Argument passed to each thread on start up */
+typedef struct {
+  tpPool* pool;
+  size_t  worker;
+} tpStart;
+
+/* Claim and run chunks until the range is exhausted */
+static void drain(tpPool* pool, size_t worker) {
+  size_t from;
+
+  while ((from = atomic_fetch_add(&pool->next, pool->grain)) < pool->count) {
+    size_t to = pool->count - from > pool->grain ? from + pool->grain : pool->count;
+    pool->callback(from, to, worker, pool->context);
+  }
+}
+
+static void* work(void* argument) {
+  tpPool* pool       = ((tpStart*)argument)->pool;
+  size_t  worker     = ((tpStart*)argument)->worker;
+  size_t  generation = 0;
+
+  free(argument);
+
+  pthread_mutex_lock(&pool->lock);
+
+  while (1) {
+    while (pool->generation == generation && !pool->stopping) {
+      pthread_cond_wait(&pool->wake, &pool->lock);
+    }
+
+    if (pool->stopping) { break; }
+
+    generation = pool->generation;
+    pthread_mutex_unlock(&pool->lock);
+
+    drain(pool, worker);
+
+    pthread_mutex_lock(&pool->lock);
+    if (--pool->busy == 0) {
+      pthread_cond_signal(&pool->done);
+    }
+  }
+
+  pthread_mutex_unlock(&pool->lock);
+  return NULL;
+}
+
+tpPool* tpCreate(size_t threads) {
+  tpPool* newPool = malloc(sizeof(tpPool));
+
+  if (!threads) {
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = online > 0 ? (size_t)online : 1;
+  }
+
+  if (newPool) {
+    newPool->threads    = 0;
+    newPool->generation = 0;
+    newPool->busy       = 0;
+    newPool->stopping   = 0;
+    newPool->thread     = malloc(sizeof(pthread_t) * threads);
+    atomic_init(&newPool->next, 0);
+
+    if (!newPool->thread) {
+      /* Memory allocation failure :P */
+      free(newPool);
+      return NULL;
+    }
+
+    pthread_mutex_init(&newPool->lock, NULL);
+    pthread_cond_init(&newPool->wake, NULL);
+    pthread_cond_init(&newPool->done, NULL);
+
+    /* Worker zero is whoever calls tpFor */
+    newPool->threads = 1;
+    while (newPool->threads < threads) {
+      tpStart* start = malloc(sizeof(tpStart));
+
+      if (!start) { tpNuke(newPool); return NULL; }
+
+      start->pool   = newPool;
+      start->worker = newPool->threads;
+
+      if (pthread_create(newPool->thread + newPool->threads, NULL, &work, start)) {
+        free(start);
+        tpNuke(newPool);
+        return NULL;
+      }
+
+      ++newPool->threads;
+    }
+  }
+
+  return newPool;
+}
+
+size_t tpWorkers(tpPool* pool) {
+  return pool ? pool->threads : 1;
+}
+
+void tpFor(tpPool* pool, size_t count, size_t grain, tpForCallback callback, void* context) {
+  if (!count) { return; }
+
+  if (!pool || pool->threads == 1) {
+    callback(0, count, 0, context);
+    return;
+  }
+
+  if (!grain) {
+    /* Aim for a few chunks per worker, to even out the load */
+    grain = count / (pool->threads * 8);
+    if (!grain) { grain = 1; }
+  }
+
+  pthread_mutex_lock(&pool->lock);
+  pool->count    = count;
+  pool->grain    = grain;
+  pool->callback = callback;
+  pool->context  = context;
+  pool->busy     = pool->threads - 1;
+  atomic_store(&pool->next, 0);
+  ++pool->generation;
+  pthread_cond_broadcast(&pool->wake);
+  pthread_mutex_unlock(&pool->lock);
+
+  drain(pool, 0);
+
+  pthread_mutex_lock(&pool->lock);
+  while (pool->busy) {
+    pthread_cond_wait(&pool->done, &pool->lock);
+  }
+  pthread_mutex_unlock(&pool->lock);
+}
+
+void tpNuke(tpPool* pool) {
+  if (pool) {
+    size_t i;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = 1;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (i = 1; i < pool->threads; i++) {
+      pthread_join(pool->thread[i], NULL);
+    }
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->wake);
+    pthread_cond_destroy(&pool->done);
+    free(pool->thread);
+    free(pool);
+  }
+}
@@ -0,0 +1,114 @@
+/**
+  @file       threadPool.h
+  @brief      Thread pool header file
+  @author     Christopher Harrison (Xophmeister)
+  @copyright  @ref license
+
+  Implements a fixed size pool of worker threads that cooperatively
+  execute data parallel loops over an index range.
+
+  Wherever a function in this library takes a pool, passing `NULL` is
+  always valid and simply runs the work serially on the calling thread.
+*/
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <stdlib.h>
+
+/**
+  @struct     tpPool
+  @brief      Thread pool
+
+  @note       The pool's structure is private to the implementation
+*/
+typedef struct tpPool tpPool;
+
+/**
+  @typedef    tpForCallback
+  @brief      Function signature for tpFor() callbacks
+
+  The callback function for tpFor() must have the following signature:
+
+  @code{.c}
+  void callback(size_t from, size_t to, size_t worker, void* context)
+  @endcode
+
+  That is, on each chunk of the range, the callback is called with the
+  following:
+
+  @param      from     The first index of the chunk
+  @param      to       One past the last index of the chunk
+  @param      worker   The identifier of the worker running the chunk,
+                       which is less than tpWorkers()
+  @param      context  The context pointer given to tpFor()
+
+  For example, the following callback would double every element of an
+  array of integers, passed as the context:
+
+  @code{.c}
+  void doubleInts(size_t from, size_t to, size_t worker, void* context) {
+    int* data = (int*)context;
+    while (from < to) {
+      data[from++] *= 2;
+    }
+  }
+  @endcode
+
+  @note       No two concurrent callbacks share a worker identifier, so
+              it can be used to index per-worker scratch space without
+              any locking
+*/
+typedef void(*tpForCallback)(size_t, size_t, size_t, void*);
+
+/**
+  @fn         tpPool* tpCreate(size_t threads)
+  @brief      Create a new thread pool
+  @param      threads  Number of workers; zero to use one per online
+                       processor
+  @return     Pointer to the newly created pool; or `NULL` in the event
+              of an allocation or thread creation failure
+
+  Create a pool with the given number of workers. The thread that calls
+  tpFor() always participates as worker zero, so only `threads - 1`
+  additional threads are actually started.
+*/
+extern tpPool* tpCreate(size_t);
+
+/**
+  @fn         size_t tpWorkers(tpPool* pool)
+  @brief      Number of workers in the pool
+  @param      pool  The thread pool
+  @return     Number of workers; one if the pool is `NULL`
+*/
+extern size_t tpWorkers(tpPool*);
+
+/**
+  @fn         void tpFor(tpPool* pool, size_t count, size_t grain, tpForCallback callback, void* context)
+  @brief      Execute a data parallel loop over the pool
+  @param      pool      The thread pool
+  @param      count     Size of the index range, starting from zero
+  @param      grain     Size of each chunk; zero to choose automatically
+  @param      callback  Pointer to callback function
+  @param      context   Pointer passed through to each callback
+
+  Split the range `[0, count)` into chunks of the given size and apply
+  the callback to each of them across the workers in the pool. Chunks
+  are claimed dynamically, so uneven work is balanced automatically.
+  This blocks until every chunk has been processed.
+
+  @note       The pool runs one loop at a time; calling tpFor() on the
+              same pool from within a callback will deadlock
+*/
+extern void tpFor(tpPool*, size_t, size_t, tpForCallback, void*);
+
+/**
+  @fn         void tpNuke(tpPool* pool)
+  @brief      Stop and free the thread pool
+  @param      pool  The thread pool to free
+
+  Join the pool's threads and free the memory allocated for it.
+*/
+extern void tpNuke(tpPool*);
+
+#endif
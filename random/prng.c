@@ -0,0 +1,57 @@
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "prng.h"
+
+#define golden UINT64_C(0x9E3779B97F4A7C15)
+
+/* SplitMix64 finaliser */
+static uint64_t mix(uint64_t z) {
+  z = (z ^ (z >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+  z = (z ^ (z >> 27)) * UINT64_C(0x94D049BB133111EB);
+  return z ^ (z >> 31);
+}
+
+rngState rngSeed(uint64_t seed) {
+  rngState rng;
+  rng.state = mix(seed + golden);
+  return rng;
+}
+
+rngState rngSplit(rngState* rng, uint64_t stream) {
+  rngState child;
+  child.state = mix(rng->state ^ mix((stream + 1) * golden));
+  return child;
+}
+
+uint64_t rngNext(rngState* rng) {
+  rng->state += golden;
+  return mix(rng->state);
+}
+
+uint64_t rngBelow(rngState* rng, uint64_t bound) {
+  uint64_t x, high, low, threshold;
+
+  if (!bound) { return 0; }
+
+  /* 128-bit product; the high word is the candidate */
+  x    = rngNext(rng);
+  low  = x * bound;
+  high = (uint64_t)(((unsigned __int128)x * bound) >> 64);
+
+  if (low < bound) {
+    threshold = -bound % bound;
+
+    while (low < threshold) {
+      x    = rngNext(rng);
+      low  = x * bound;
+      high = (uint64_t)(((unsigned __int128)x * bound) >> 64);
+    }
+  }
+
+  return high;
+}
+
+double rngDouble(rngState* rng) {
+  return (rngNext(rng) >> 11) * (1.0 / 9007199254740992.0);
+}
@@ -0,0 +1,84 @@
+/**
+  @file       prng.h
+  @brief      Pseudorandom number generator header file
+  @author     Christopher Harrison (Xophmeister)
+  @copyright  @ref license
+
+  Implements a fast, splittable pseudorandom number generator
+  (SplitMix64). Generators can be split into any number of independent
+  streams, each identified by an index, so parallel work can draw random
+  numbers deterministically regardless of how it is scheduled.
+
+  @warning    This is not suitable for cryptographic purposes
+*/
+
+#ifndef PRNG_H
+#define PRNG_H
+
+#include <stdlib.h>
+#include <stdint.h>
+
+/**
+  @struct     rngState
+  @brief      Pseudorandom number generator state
+  @var        rngState::state
+              Current state
+*/
+typedef struct {
+  uint64_t state;
+} rngState;
+
+/**
+  @fn         rngState rngSeed(uint64_t seed)
+  @brief      Seed a new generator
+  @param      seed  The seed
+  @return     The seeded generator state
+
+  Generators seeded identically produce identical sequences.
+*/
+extern rngState rngSeed(uint64_t);
+
+/**
+  @fn         rngState rngSplit(rngState* rng, uint64_t stream)
+  @brief      Derive an independent generator for a given stream
+  @param      rng     The parent generator
+  @param      stream  The stream index
+  @return     The derived generator state
+
+  Derive a new generator from the parent's current state and a stream
+  index. The parent is not advanced, so the same stream index always
+  yields the same generator; this is what makes parallel use
+  deterministic.
+*/
+extern rngState rngSplit(rngState*, uint64_t);
+
+/**
+  @fn         uint64_t rngNext(rngState* rng)
+  @brief      Draw the next 64 random bits
+  @param      rng  The generator
+  @return     Uniformly distributed 64-bit value
+*/
+extern uint64_t rngNext(rngState*);
+
+/**
+  @fn         uint64_t rngBelow(rngState* rng, uint64_t bound)
+  @brief      Draw a uniformly distributed integer below a bound
+  @param      rng    The generator
+  @param      bound  The exclusive upper bound
+  @return     Uniformly distributed value in `[0, bound)`; or zero if
+              the bound is zero
+
+  Draws are unbiased, using Lemire's multiply-and-reject method, which
+  avoids division in all but a vanishing fraction of cases.
+*/
+extern uint64_t rngBelow(rngState*, uint64_t);
+
+/**
+  @fn         double rngDouble(rngState* rng)
+  @brief      Draw a uniformly distributed real number
+  @param      rng  The generator
+  @return     Uniformly distributed value in `[0, 1)`
+*/
+extern double rngDouble(rngState*);
+
+#endif
@@ -0,0 +1,183 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "shuffle.h"
+#include "prng.h"
+#include "../indexed/dynamicArray.h"
+#include "../indexed/typedArray.h"
+#include "../parallel/threadPool.h"
+
+/* Largest number of elements shuffled directly, with Fisher-Yates */
+#define sfBlock (1 << 15)
+
+typedef struct {
+  char*    buffer;
+  size_t   length;
+  size_t   width;
+  size_t   blocks;
+  size_t   level;
+  rngState root;
+} shuffling;
+
+/* Swap two elements if asked to; words are swapped without branching */
+static inline void exchange(char* a, char* b, size_t width, uint64_t take) {
+  switch (width) {
+    case 4: {
+      uint32_t x, y, mask = -(uint32_t)take;
+      memcpy(&x, a, 4); memcpy(&y, b, 4);
+      mask &= x ^ y;
+      x ^= mask; y ^= mask;
+      memcpy(a, &x, 4); memcpy(b, &y, 4);
+      break;
+    }
+
+    case 8: {
+      uint64_t x, y, mask = -take;
+      memcpy(&x, a, 8); memcpy(&y, b, 8);
+      mask &= x ^ y;
+      x ^= mask; y ^= mask;
+      memcpy(a, &x, 8); memcpy(b, &y, 8);
+      break;
+    }
+
+    default:
+      if (take) {
+        while (width--) {
+          char x = a[width];
+          a[width] = b[width];
+          b[width] = x;
+        }
+      }
+  }
+}
+
+/* Start of the given block; blocks are as even as possible */
+static size_t boundary(shuffling* shuffle, size_t block) {
+  return (size_t)(((unsigned __int128)shuffle->length * block) / shuffle->blocks);
+}
+
+static inline void fisherYates(char* block, size_t n, size_t width, rngState* rng) {
+  for (; n > 1; n--) {
+    exchange(block + (n - 1) * width, block + rngBelow(rng, n) * width, width, 1);
+  }
+}
+
+/* Merge two shuffled runs, [0, j) and [j, n), into one */
+static inline void riffle(char* run, size_t j, size_t n, size_t width, rngState* rng) {
+  size_t   i = 0;
+  uint64_t bits = 0, take;
+  unsigned left = 0;
+
+  /* Each position takes the next element of either run, at random... */
+  while (i < j && j < n) {
+    if (!left) {
+      bits = rngNext(rng);
+      left = 64;
+    }
+
+    take   = bits & 1;
+    bits >>= 1;
+    --left;
+
+    exchange(run + i * width, run + j * width, width, take);
+    j += take;
+    ++i;
+  }
+
+  /* ...until it picks a run that is exhausted... */
+  for (;; i++) {
+    if (!left) {
+      bits = rngNext(rng);
+      left = 64;
+    }
+
+    take   = bits & 1;
+    bits >>= 1;
+    --left;
+
+    if (take) {
+      if (j == n) { break; }
+      exchange(run + i * width, run + j * width, width, 1);
+      ++j;
+    } else if (i == j) {
+      break;
+    }
+  }
+
+  /* ...then the rest of the other are inserted at random positions */
+  for (; i < n; i++) {
+    exchange(run + i * width, run + rngBelow(rng, i + 1) * width, width, 1);
+  }
+}
+
+static void shuffleBlocks(size_t from, size_t to, size_t worker, void* context) {
+  shuffling* shuffle = (shuffling*)context;
+  size_t     width   = shuffle->width;
+
+  for (; from < to; from++) {
+    rngState rng   = rngSplit(&shuffle->root, from);
+    size_t   start = boundary(shuffle, from);
+    size_t   n     = boundary(shuffle, from + 1) - start;
+    char*    block = shuffle->buffer + start * width;
+
+    /* Constant widths let the word swaps be inlined */
+    switch (width) {
+      case 4:  fisherYates(block, n, 4, &rng); break;
+      case 8:  fisherYates(block, n, 8, &rng); break;
+      default: fisherYates(block, n, width, &rng);
+    }
+  }
+}
+
+static void mergeBlocks(size_t from, size_t to, size_t worker, void* context) {
+  shuffling* shuffle = (shuffling*)context;
+  size_t     width   = shuffle->width;
+  size_t     span    = (size_t)1 << shuffle->level;
+
+  for (; from < to; from++) {
+    rngState rng   = rngSplit(&shuffle->root, shuffle->blocks * shuffle->level + from);
+    size_t   start = boundary(shuffle, from * span);
+    size_t   j     = boundary(shuffle, from * span + span / 2) - start;
+    size_t   n     = boundary(shuffle, (from + 1) * span) - start;
+    char*    run   = shuffle->buffer + start * width;
+
+    switch (width) {
+      case 4:  riffle(run, j, n, 4, &rng); break;
+      case 8:  riffle(run, j, n, 8, &rng); break;
+      default: riffle(run, j, n, width, &rng);
+    }
+  }
+}
+
+static void shuffleBuffer(void* buffer, size_t length, size_t width, uint64_t seed, tpPool* pool) {
+  shuffling shuffle;
+
+  if (length < 2) { return; }
+
+  shuffle.buffer = (char*)buffer;
+  shuffle.length = length;
+  shuffle.width  = width;
+  shuffle.root   = rngSeed(seed);
+
+  /* A power of two number of blocks, set by the length alone */
+  for (shuffle.blocks = 1; length / shuffle.blocks > sfBlock; shuffle.blocks *= 2);
+
+  tpFor(pool, shuffle.blocks, 1, &shuffleBlocks, &shuffle);
+
+  for (shuffle.level = 1; ((size_t)1 << shuffle.level) <= shuffle.blocks; shuffle.level++) {
+    tpFor(pool, shuffle.blocks >> shuffle.level, 1, &mergeBlocks, &shuffle);
+  }
+}
+
+void sfShuffle(dynArray* array, uint64_t seed, tpPool* pool) {
+  if (array && array->length) {
+    shuffleBuffer(array->buffer, array->length, sizeof(void*), seed, pool);
+  }
+}
+
+void sfShuffleTyped(tyArray* array, uint64_t seed, tpPool* pool) {
+  if (array && array->length) {
+    shuffleBuffer(array->buffer, array->length, array->width, seed, pool);
+  }
+}
@@ -0,0 +1,57 @@
+/**
+  @file       shuffle.h
+  @brief      Parallel shuffle header file
+  @author     Christopher Harrison (Xophmeister)
+  @copyright  @ref license
+
+  Implements an in place, uniformly random shuffle of arrays, which runs
+  in parallel (MergeShuffle; Bacher, Bodini, Hollender and Lumbroso,
+  2015). Fisher-Yates is inherently sequential and, on large arrays,
+  every swap is a cache miss; instead, the array is split into cache
+  sized blocks, which are shuffled independently, and then adjacent
+  blocks are merged by riffling them together at random, level by level.
+  Each merge streams through memory in order and merges at the same
+  level run concurrently.
+
+  The blocks and merges depend only on the array's length and each draws
+  from its own stream of the seeded generator (see rngSplit()), so the
+  result is deterministic for a given seed, whatever the number of
+  workers.
+*/
+
+#ifndef SHUFFLE_H
+#define SHUFFLE_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include "../indexed/dynamicArray.h"
+#include "../indexed/typedArray.h"
+#include "../parallel/threadPool.h"
+
+/**
+  @fn         void sfShuffle(dynArray* array, uint64_t seed, tpPool* pool)
+  @brief      Shuffle a dynamic array's elements
+  @param      array  The dynamic array
+  @param      seed   Seed for the pseudorandom number generator
+  @param      pool   Thread pool to run on; or `NULL` to run serially
+
+  Permute the element pointers uniformly at random, in place.
+*/
+extern void sfShuffle(dynArray*, uint64_t, tpPool*);
+
+/**
+  @fn         void sfShuffleTyped(tyArray* array, uint64_t seed, tpPool* pool)
+  @brief      Shuffle a typed array's elements
+  @param      array  The typed array
+  @param      seed   Seed for the pseudorandom number generator
+  @param      pool   Thread pool to run on; or `NULL` to run serially
+
+  Permute the elements uniformly at random, in place, moving each by
+  value.
+
+  @note       Elements of four or eight bytes are swapped as single
+              words; wider ones are swapped bytewise
+*/
+extern void sfShuffleTyped(tyArray*, uint64_t, tpPool*);
+
+#endif
@@ -0,0 +1,93 @@
+#include <stdlib.h>
+
+#include "offsetArray.h"
+#include "region.h"
+
+oaArray* oaCreate(shRegion* region, size_t length) {
+  oaArray* newArray = shAlloc(region, sizeof(oaArray));
+
+  if (newArray) {
+    newArray->length    = 0;
+    newArray->allocated = 0;
+    shSet(&newArray->buffer, NULL);
+
+    if (oaResize(region, newArray, length)) {
+      /* Region exhausted :P */
+      shFree(region, newArray);
+      newArray = NULL;
+    }
+  }
+
+  return newArray;
+}
+
+int oaResize(shRegion* region, oaArray* array, size_t length) {
+  shPointer* buffer = shGet(&array->buffer);
+  size_t     i;
+
+  if (length > array->allocated) {
+    shPointer* newBuffer = shAlloc(region, sizeof(shPointer) * length);
+
+    if (!newBuffer) { return 1; }
+
+    /* Re-encode each element for its new address */
+    for (i = 0; i < array->length; i++) {
+      shSet(newBuffer + i, shGet(buffer + i));
+    }
+
+    shFree(region, buffer);
+    shSet(&array->buffer, newBuffer);
+    array->allocated = length;
+    buffer = newBuffer;
+  }
+
+  /* NULLify newly created space */
+  for (i = array->length; i < length; i++) {
+    shSet(buffer + i, NULL);
+  }
+
+  array->length = length;
+  return 0;
+}
+
+int oaAppend(shRegion* region, oaArray* array, void* payload) {
+  size_t length = array->length;
+
+  if (array->allocated == length) {
+    /* Double buffer's allocation */
+    if (oaResize(region, array, length ? length * 2 : 1)) { return 1; }
+  }
+
+  array->length = length + 1;
+  oaSet(array, length, payload);
+
+  return 0;
+}
+
+shPointer* oaElement(oaArray* array, size_t index) {
+  if (index < array->length) {
+    return (shPointer*)shGet(&array->buffer) + index;
+  } else {
+    return NULL;
+  }
+}
+
+void* oaGet(oaArray* array, size_t index) {
+  shPointer* element = oaElement(array, index);
+  return element ? shGet(element) : NULL;
+}
+
+void oaSet(oaArray* array, size_t index, void* payload) {
+  shPointer* element = oaElement(array, index);
+
+  if (element) {
+    shSet(element, payload);
+  }
+}
+
+void oaNuke(shRegion* region, oaArray* array) {
+  if (array) {
+    shFree(region, shGet(&array->buffer));
+    shFree(region, array);
+  }
+}
@@ -0,0 +1,122 @@
+/**
+  @file       offsetArray.h
+  @brief      Offset dynamic array header file
+  @author     Christopher Harrison (Xophmeister)
+  @copyright  @ref license
+
+  Implements a dynamically allocated sparse array in a shared memory
+  region, where each element can point to arbitrary data in the same
+  region. It mirrors the dynArray dynamic array, but its buffer and
+  elements are self-relative pointers, so an array built by one process
+  can be read by any other that maps the region.
+*/
+
+#ifndef OFFSETARRAY_H
+#define OFFSETARRAY_H
+
+#include <stdlib.h>
+#include "region.h"
+
+/**
+  @struct     oaArray
+  @brief      Offset dynamic array
+  @var        oaArray::length
+              Number of elements in the array
+  @var        oaArray::allocated
+              Actual number of elements currently allocated
+  @var        oaArray::buffer
+              Self-relative pointer to the array's buffer of
+              self-relative element pointers
+
+  @warning    oaArray::length and oaArray::allocated are not write
+              protected
+*/
+typedef struct {
+  size_t    length;
+  size_t    allocated;
+  shPointer buffer;
+} oaArray;
+
+/**
+  @fn         oaArray* oaCreate(shRegion* region, size_t length)
+  @brief      Create an offset dynamic array of a given size
+  @param      region  The region to allocate from
+  @param      length  Number of elements to initially allocate
+  @return     Pointer to new offset dynamic array; or `NULL` if the
+              region is exhausted
+
+  Create an offset dynamic array of a given size, with all elements
+  initialised with `NULL` pointers.
+*/
+extern oaArray* oaCreate(shRegion*, size_t);
+
+/**
+  @fn         int oaResize(shRegion* region, oaArray* array, size_t length)
+  @brief      Resize the array to the given number of elements
+  @param      region  The region the array was allocated from
+  @param      array   The offset dynamic array to resize
+  @param      length  The new length
+  @return     Zero on success; non-zero if the region is exhausted, in
+              which case the array is left unchanged
+
+  @note       As moving a self-relative pointer changes its target, each
+              element is re-encoded when the buffer is moved
+*/
+extern int oaResize(shRegion*, oaArray*, size_t);
+
+/**
+  @fn         int oaAppend(shRegion* region, oaArray* array, void* payload)
+  @brief      Append the specified array with the given argument
+  @param      region   The region the array was allocated from
+  @param      array    The offset dynamic array to append to
+  @param      payload  Pointer to the new element, in the region
+  @return     Zero on success; non-zero if the region is exhausted, in
+              which case the array is left unchanged
+
+  @note       Memory will be over-allocated if there is not enough free
+              space in the buffer
+*/
+extern int oaAppend(shRegion*, oaArray*, void*);
+
+/**
+  @fn         shPointer* oaElement(oaArray* array, size_t index)
+  @brief      Get the self-relative pointer to the indexed element
+  @param      array  The offset dynamic array
+  @param      index  The index of the element
+  @return     Pointer to the element's self-relative pointer; or `NULL`
+              in the event of a bounds error
+*/
+extern shPointer* oaElement(oaArray*, size_t);
+
+/**
+  @fn         void* oaGet(oaArray* array, size_t index)
+  @brief      Get the indexed element
+  @param      array  The offset dynamic array
+  @param      index  The index of the element
+  @return     The element's address; or `NULL` if it is unset, or in the
+              event of a bounds error
+*/
+extern void* oaGet(oaArray*, size_t);
+
+/**
+  @fn         void oaSet(oaArray* array, size_t index, void* payload)
+  @brief      Set the indexed element
+  @param      array    The offset dynamic array
+  @param      index    The index of the element
+  @param      payload  Pointer to the element, in the region; or `NULL`
+
+  @note       Out of bounds indices are ignored
+*/
+extern void oaSet(oaArray*, size_t, void*);
+
+/**
+  @fn         void oaNuke(shRegion* region, oaArray* array)
+  @brief      Free the memory allocated by the offset dynamic array
+  @param      region  The region the array was allocated from
+  @param      array   The offset dynamic array
+
+  @note       The elements will not be freed
+*/
+extern void oaNuke(shRegion*, oaArray*);
+
+#endif
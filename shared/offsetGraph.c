@@ -0,0 +1,73 @@
+#include <stdlib.h>
+
+#include "offsetGraph.h"
+#include "offsetArray.h"
+#include "region.h"
+#include "../indexed/dynamicArray.h"
+
+ogNode* ogCreateNode(shRegion* region, void* payload, size_t links) {
+  ogNode*  newNode = shAlloc(region, sizeof(ogNode));
+  oaArray* newLinks;
+
+  if (newNode) {
+    shSet(&newNode->payload, payload);
+    newLinks = oaCreate(region, links);
+
+    if (newLinks) {
+      shSet(&newNode->links, newLinks);
+    } else {
+      /* Region exhausted :P */
+      shFree(region, newNode);
+      newNode = NULL;
+    }
+  }
+
+  return newNode;
+}
+
+void* ogPayload(ogNode* node) {
+  return shGet(&node->payload);
+}
+
+oaArray* ogLinks(ogNode* node) {
+  return shGet(&node->links);
+}
+
+void ogLink(ogNode* node, size_t index, ogNode* target) {
+  oaSet(ogLinks(node), index, target);
+}
+
+ogNode* ogTraverse(ogNode* node, size_t index, size_t depth) {
+  while (node && depth--) {
+    node = oaGet(ogLinks(node), index);
+  }
+
+  return node;
+}
+
+ogNode* ogRoute(ogNode* node, dynArray* route) {
+  size_t cursor;
+
+  for (cursor = 0; node && route && cursor < route->length; cursor++) {
+    size_t* nextTurn = *dynElement(route, cursor);
+
+    if (!nextTurn) { return NULL; }
+    node = oaGet(ogLinks(node), *nextTurn);
+  }
+
+  return node;
+}
+
+void ogNuke(shRegion* region, ogNode* node) {
+  if (node) {
+    oaArray* links = ogLinks(node);
+    size_t   i;
+
+    for (i = 0; i < links->length; i++) {
+      ogNuke(region, oaGet(links, i));
+    }
+
+    oaNuke(region, links);
+    shFree(region, node);
+  }
+}
@@ -0,0 +1,119 @@
+/**
+  @file       offsetGraph.h
+  @brief      Offset directed graph header file
+  @author     Christopher Harrison (Xophmeister)
+  @copyright  @ref license
+
+  Implements a directed graph in a shared memory region, where each node
+  can point to arbitrary data in the same region. It mirrors the dgNode
+  directed graph, with its links held in an offset dynamic array, so a
+  graph built by one process can be traversed by any other that maps the
+  region; for example, from the region's root:
+
+  @code{.c}
+  shRegion* region = shOpen("/myGraph");
+  ogNode*   root   = shRoot(region);
+  ogNode*   leaf   = ogTraverse(root, 0, 3);
+  @endcode
+*/
+
+#ifndef OFFSETGRAPH_H
+#define OFFSETGRAPH_H
+
+#include <stdlib.h>
+#include "region.h"
+#include "offsetArray.h"
+#include "../indexed/dynamicArray.h"
+
+/**
+  @struct     ogNode
+  @brief      Offset directed graph node
+  @var        ogNode::payload
+              Self-relative pointer to the current node's contents
+  @var        ogNode::links
+              Self-relative pointer to the offset dynamic array of links
+              to connected nodes
+*/
+typedef struct ogNode {
+  shPointer payload;
+  shPointer links;
+} ogNode;
+
+/**
+  @fn         ogNode* ogCreateNode(shRegion* region, void* payload, size_t links)
+  @brief      Create a new offset directed graph node
+  @param      region   The region to allocate from
+  @param      payload  Pointer to the node's contents, in the region
+  @param      links    Number of links to initialise
+  @return     Pointer to the newly created node; or `NULL` if the region
+              is exhausted
+*/
+extern ogNode* ogCreateNode(shRegion*, void*, size_t);
+
+/**
+  @fn         void* ogPayload(ogNode* node)
+  @brief      The contents of an offset directed graph node
+  @param      node  The node
+  @return     Pointer to the node's contents
+*/
+extern void* ogPayload(ogNode*);
+
+/**
+  @fn         oaArray* ogLinks(ogNode* node)
+  @brief      The links of an offset directed graph node
+  @param      node  The node
+  @return     Pointer to the node's offset dynamic array of links
+*/
+extern oaArray* ogLinks(ogNode*);
+
+/**
+  @fn         void ogLink(ogNode* node, size_t index, ogNode* target)
+  @brief      Set a link of an offset directed graph node
+  @param      node    The node
+  @param      index   The link index
+  @param      target  The node to link to; or `NULL` to unlink
+
+  @note       Out of bounds link indices are ignored; use oaResize() on
+              the node's links to add more
+*/
+extern void ogLink(ogNode*, size_t, ogNode*);
+
+/**
+  @fn         ogNode* ogTraverse(ogNode* node, size_t index, size_t depth)
+  @brief      Traverse the graph a given depth down a specified link index from the starting node
+  @param      node   The starting node
+  @param      index  The link index to traverse
+  @param      depth  The distance to traverse from the starting node
+  @return     Pointer to the resolved node; or `NULL` in the event of a
+              routing failure
+*/
+extern ogNode* ogTraverse(ogNode*, size_t, size_t);
+
+/**
+  @fn         ogNode* ogRoute(ogNode* node, dynArray* route)
+  @brief      Walk the graph from a given starting node following a specific route
+  @param      node   The starting node
+  @param      route  A dynamic array of link indices that describe the
+                     route, as taken by dgRoute()
+  @return     Pointer to the resolved node; or `NULL` in the event of a
+              routing failure
+
+  @note       The route is local to the calling process, so it need not
+              be in the region
+*/
+extern ogNode* ogRoute(ogNode*, dynArray*);
+
+/**
+  @fn         void ogNuke(shRegion* region, ogNode* node)
+  @brief      Free the memory allocated by the offset directed graph's nodes
+  @param      region  The region the graph was allocated from
+  @param      node    Node to traverse from
+  @warning    Running this against a graph containing cycles, or in
+              which any node is reachable by more than one route, will
+              result in a double free memory corruption error
+
+  @note       The nodes' contents will not be freed
+*/
+extern void ogNuke(shRegion*, ogNode*);
+
+#endif
@@ -0,0 +1,108 @@
+#include <stdlib.h>
+
+#include "offsetList.h"
+#include "region.h"
+
+olNode* olCreateNode(shRegion* region, void* payload) {
+  olNode* newNode = shAlloc(region, sizeof(olNode));
+
+  if (newNode) {
+    shSet(&newNode->payload, payload);
+    shSet(&newNode->next, NULL);
+  }
+
+  return newNode;
+}
+
+void* olPayload(olNode* node) {
+  return shGet(&node->payload);
+}
+
+olNode* olNext(olNode* node) {
+  return shGet(&node->next);
+}
+
+void olLink(olNode* alpha, olNode* beta) {
+  shSet(&alpha->next, beta);
+}
+
+size_t olLength(olNode* root) {
+  size_t length = 1;
+
+  while ((root = olNext(root))) {
+    ++length;
+  }
+
+  return length;
+}
+
+olNode* olTraverse(olNode* root, size_t index) {
+  while (root && index--) {
+    root = olNext(root);
+  }
+
+  return root;
+}
+
+void olAppend(shRegion* region, olNode* root, void* payload) {
+  olNode* next;
+
+  while ((next = olNext(root))) {
+    root = next;
+  }
+
+  olLink(root, olCreateNode(region, payload));
+}
+
+void olInsertAfter(shRegion* region, olNode* root, size_t index, void* payload) {
+  olNode* splice = olTraverse(root, index);
+
+  if (splice) {
+    olNode* newNode = olCreateNode(region, payload);
+
+    if (newNode) {
+      olLink(newNode, olNext(splice));
+      olLink(splice, newNode);
+    }
+  }
+}
+
+void olInsertBefore(shRegion* region, olNode** root, size_t index, void* payload) {
+  if (index == 0) {
+    olNode* newRoot = olCreateNode(region, payload);
+
+    if (newRoot) {
+      olLink(newRoot, *root);
+      *root = newRoot;
+    }
+  } else {
+    olInsertAfter(region, *root, index - 1, payload);
+  }
+}
+
+void olDelete(shRegion* region, olNode** root, size_t index) {
+  if (index == 0) {
+    olNode* newRoot = olNext(*root);
+    shFree(region, *root);
+    *root = newRoot;
+  } else {
+    olNode* splice = olTraverse(*root, index - 1);
+
+    if (splice) {
+      olNode* toDelete = olNext(splice);
+
+      if (toDelete) {
+        olLink(splice, olNext(toDelete));
+        shFree(region, toDelete);
+      }
+    }
+  }
+}
+
+void olNuke(shRegion* region, olNode* root) {
+  while (root) {
+    olNode* next = olNext(root);
+    shFree(region, root);
+    root = next;
+  }
+}
@@ -0,0 +1,145 @@
+/**
+  @file       offsetList.h
+  @brief      Offset linked list header file
+  @author     Christopher Harrison (Xophmeister)
+  @copyright  @ref license
+
+  Implements a singly linked list in a shared memory region, where each
+  node can point to arbitrary data in the same region. It mirrors the
+  llNode linked list, but links with self-relative pointers, so a list
+  built by one process can be walked by any other that maps the region.
+*/
+
+#ifndef OFFSETLIST_H
+#define OFFSETLIST_H
+
+#include <stdlib.h>
+#include "region.h"
+
+/**
+  @struct     olNode
+  @brief      Offset linked list node
+  @var        olNode::payload
+              Self-relative pointer to the current node's contents
+  @var        olNode::next
+              Self-relative pointer to the following node, if any
+*/
+typedef struct olNode {
+  shPointer payload;
+  shPointer next;
+} olNode;
+
+/**
+  @fn         olNode* olCreateNode(shRegion* region, void* payload)
+  @brief      Create a new offset linked list node
+  @param      region   The region to allocate from
+  @param      payload  Pointer to the node's contents, in the region
+  @return     Address of the newly created node; or `NULL` if the region
+              is exhausted
+*/
+extern olNode* olCreateNode(shRegion*, void*);
+
+/**
+  @fn         void* olPayload(olNode* node)
+  @brief      The contents of an offset linked list node
+  @param      node  The node
+  @return     Pointer to the node's contents
+*/
+extern void* olPayload(olNode*);
+
+/**
+  @fn         olNode* olNext(olNode* node)
+  @brief      The node following an offset linked list node
+  @param      node  The node
+  @return     Address of the following node; or `NULL`
+*/
+extern olNode* olNext(olNode*);
+
+/**
+  @fn         void olLink(olNode* alpha, olNode* beta)
+  @brief      Link two arbitrary offset linked list nodes
+  @param      alpha  Linker node
+  @param      beta   Linkee node; or `NULL` to unlink
+
+  @note       A node *can* link to itself
+*/
+extern void olLink(olNode*, olNode*);
+
+/**
+  @fn         size_t olLength(olNode* root)
+  @brief      Number of elements in an offset linked list
+  @param      root  Node to traverse from
+  @return     Length of list/sublist
+  @warning    Running this against a cyclic list will be non-terminating
+*/
+extern size_t olLength(olNode*);
+
+/**
+  @fn         olNode* olTraverse(olNode* root, size_t index)
+  @brief      Get the node at an offset down the offset linked list
+  @param      root   Node to traverse from
+  @param      index  Offset from the root node
+  @return     Address of the offset node; or `NULL` in the event of a
+              bounds error
+*/
+extern olNode* olTraverse(olNode*, size_t);
+
+/**
+  @fn         void olAppend(shRegion* region, olNode* root, void* payload)
+  @brief      Append data to an offset linked list
+  @param      region   The region to allocate from
+  @param      root     Node to traverse from
+  @param      payload  Pointer to the appended contents
+  @warning    Running this against a cyclic list will be non-terminating
+*/
+extern void olAppend(shRegion*, olNode*, void*);
+
+/**
+  @fn         void olInsertAfter(shRegion* region, olNode* root, size_t index, void* payload)
+  @brief      Insert a node into the offset linked list after a given offset
+  @param      region   The region to allocate from
+  @param      root     Node to traverse from
+  @param      index    Offset from the root node
+  @param      payload  Pointer to the inserted contents
+*/
+extern void olInsertAfter(shRegion*, olNode*, size_t, void*);
+
+/**
+  @fn         void olInsertBefore(shRegion* region, olNode** root, size_t index, void* payload)
+  @brief      Insert a node into the offset linked list before a given offset
+  @param      region   The region to allocate from
+  @param      root     Node to traverse from
+  @param      index    Offset from the root node
+  @param      payload  Pointer to the inserted contents
+
+  @note       If you insert before the starting node, the pointer to the
+              starting node will be updated appropriately
+*/
+extern void olInsertBefore(shRegion*, olNode**, size_t, void*);
+
+/**
+  @fn         void olDelete(shRegion* region, olNode** root, size_t index)
+  @brief      Delete the node of an offset linked list at a given offset
+  @param      region  The region the list was allocated from
+  @param      root    Node to traverse from
+  @param      index   Offset from the root node
+
+  @note       If you delete the starting node, the pointer to the
+              starting node will be updated appropriately
+  @note       The nodes' contents will not be freed
+*/
+extern void olDelete(shRegion*, olNode**, size_t);
+
+/**
+  @fn         void olNuke(shRegion* region, olNode* root)
+  @brief      Free the memory allocated by the offset linked list's nodes
+  @param      region  The region the list was allocated from
+  @param      root    Node to traverse from
+  @warning    Running this against a cyclic list will result in a double
+              free memory corruption error
+
+  @note       The nodes' contents will not be freed
+*/
+extern void olNuke(shRegion*, olNode*);
+
+#endif
@@ -0,0 +1,217 @@
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "region.h"
+
+#define shMagic   UINT64_C(0x6373313031736872)
+#define shClasses 64
+#define shMinimum 5
+
+/* Region header, at the start of every region */
+typedef struct {
+  uint64_t        magic;
+  size_t          size;
+  size_t          top;
+  size_t          free[shClasses];
+  shPointer       root;
+  pthread_mutex_t lock;
+} shHeader;
+
+/* Block header, before every allocation; keeps it 16 byte aligned */
+typedef struct {
+  size_t sizeClass;
+  size_t next;
+} shBlock;
+
+static shRegion* map(int fd, size_t size) {
+  shRegion* newRegion = malloc(sizeof(shRegion));
+
+  if (newRegion) {
+    newRegion->size = size;
+    newRegion->base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | (fd < 0 ? MAP_ANONYMOUS : 0), fd, 0);
+
+    if (newRegion->base == MAP_FAILED) {
+      free(newRegion);
+      newRegion = NULL;
+    }
+  }
+
+  return newRegion;
+}
+
+static int initialise(shRegion* region) {
+  shHeader*           header = (shHeader*)region->base;
+  pthread_mutexattr_t attributes;
+  size_t              c;
+  int                 failed;
+
+  header->magic = shMagic;
+  header->size  = region->size;
+  header->top   = (sizeof(shHeader) + 15) & ~(size_t)15;
+  header->root  = 0;
+
+  for (c = 0; c < shClasses; c++) {
+    header->free[c] = 0;
+  }
+
+  failed = pthread_mutexattr_init(&attributes);
+  if (!failed) {
+    failed = pthread_mutexattr_setpshared(&attributes, PTHREAD_PROCESS_SHARED)
+          || pthread_mutexattr_setrobust(&attributes, PTHREAD_MUTEX_ROBUST)
+          || pthread_mutex_init(&header->lock, &attributes);
+    pthread_mutexattr_destroy(&attributes);
+  }
+
+  return failed;
+}
+
+shRegion* shCreate(char* name, size_t size) {
+  shRegion* region;
+  int       fd = -1;
+
+  if (size < sizeof(shHeader) + sizeof(shBlock)) {
+    return NULL;
+  }
+
+  if (name) {
+    fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) { return NULL; }
+
+    if (ftruncate(fd, (off_t)size)) {
+      close(fd);
+      shm_unlink(name);
+      return NULL;
+    }
+  }
+
+  region = map(fd, size);
+  if (fd >= 0) { close(fd); }
+
+  if (region && initialise(region)) {
+    shClose(region);
+    region = NULL;
+  }
+
+  if (!region && name) {
+    shm_unlink(name);
+  }
+
+  return region;
+}
+
+shRegion* shOpen(char* name) {
+  shRegion*   region;
+  struct stat status;
+  int         fd = shm_open(name, O_RDWR, 0);
+
+  if (fd < 0) { return NULL; }
+
+  if (fstat(fd, &status) || (size_t)status.st_size < sizeof(shHeader)) {
+    close(fd);
+    return NULL;
+  }
+
+  region = map(fd, (size_t)status.st_size);
+  close(fd);
+
+  if (region && ((shHeader*)region->base)->magic != shMagic) {
+    /* Not one of ours */
+    shClose(region);
+    region = NULL;
+  }
+
+  return region;
+}
+
+static void lock(shHeader* header) {
+  /* Recover the lock if its holder died; the allocator's state is only
+     ever changed by single writes, so it is still consistent */
+  if (pthread_mutex_lock(&header->lock) == EOWNERDEAD) {
+    pthread_mutex_consistent(&header->lock);
+  }
+}
+
+void* shAlloc(shRegion* region, size_t size) {
+  shHeader* header    = (shHeader*)region->base;
+  size_t    sizeClass = shMinimum;
+  shBlock*  block     = NULL;
+
+  if (size > header->size) {
+    return NULL;
+  }
+
+  while (sizeClass < shClasses - 1 && ((size_t)1 << sizeClass) < size + sizeof(shBlock)) {
+    ++sizeClass;
+  }
+  if (((size_t)1 << sizeClass) < size + sizeof(shBlock)) {
+    return NULL;
+  }
+
+  lock(header);
+
+  if (header->free[sizeClass]) {
+    block = (shBlock*)((char*)region->base + header->free[sizeClass]);
+    header->free[sizeClass] = block->next;
+  } else if (header->size - header->top >= (size_t)1 << sizeClass) {
+    block = (shBlock*)((char*)region->base + header->top);
+    header->top += (size_t)1 << sizeClass;
+  }
+
+  pthread_mutex_unlock(&header->lock);
+
+  if (!block) {
+    /* Region exhausted :P */
+    return NULL;
+  }
+
+  block->sizeClass = sizeClass;
+  block->next      = 0;
+  return block + 1;
+}
+
+void shFree(shRegion* region, void* address) {
+  if (address) {
+    shHeader* header = (shHeader*)region->base;
+    shBlock*  block  = (shBlock*)address - 1;
+
+    lock(header);
+    block->next = header->free[block->sizeClass];
+    header->free[block->sizeClass] = (size_t)((char*)block - (char*)region->base);
+    pthread_mutex_unlock(&header->lock);
+  }
+}
+
+void* shGet(shPointer* pointer) {
+  return *pointer ? (char*)pointer + *pointer : NULL;
+}
+
+void shSet(shPointer* pointer, void* address) {
+  *pointer = address ? (char*)address - (char*)pointer : 0;
+}
+
+void* shRoot(shRegion* region) {
+  return shGet(&((shHeader*)region->base)->root);
+}
+
+void shSetRoot(shRegion* region, void* address) {
+  shSet(&((shHeader*)region->base)->root, address);
+}
+
+void shClose(shRegion* region) {
+  if (region) {
+    munmap(region->base, region->size);
+    free(region);
+  }
+}
+
+int shUnlink(char* name) {
+  return shm_unlink(name) != 0;
+}
@@ -0,0 +1,177 @@
+/**
+  @file       region.h
+  @brief      Shared memory region header file
+  @author     Christopher Harrison (Xophmeister)
+  @copyright  @ref license
+
+  Implements an allocator over a region of shared memory, which several
+  processes can map at the same time, together with self-relative
+  pointers for linking structures within it.
+
+  A region may be mapped at a different address in each process, so
+  ordinary pointers stored in it would only be meaningful to the process
+  that stored them. A self-relative pointer instead stores the distance
+  from itself to its target, which is the same wherever the region is
+  mapped. The offset containers (olNode, oaArray and ogNode) are built
+  from them, so a structure built by one process can be used directly by
+  any other that maps the same region.
+
+  Allocation is serialised by a process-shared mutex within the region
+  itself. Should a process die while holding it, the next process to
+  allocate recovers it.
+*/
+
+#ifndef REGION_H
+#define REGION_H
+
+#include <stdlib.h>
+#include <stddef.h>
+
+/**
+  @typedef    shPointer
+  @brief      Self-relative pointer
+
+  The signed distance, in bytes, from the pointer's own address to its
+  target; or zero for `NULL`. Use shGet() and shSet() to resolve and
+  assign them.
+
+  @warning    A self-relative pointer is only meaningful where it is
+              stored; copying one elsewhere (e.g., with `memcpy`) does
+              not copy its target
+*/
+typedef ptrdiff_t shPointer;
+
+/**
+  @struct     shRegion
+  @brief      Shared memory region, as mapped into this process
+  @var        shRegion::base
+              Address at which the region is mapped
+  @var        shRegion::size
+              Size of the region, in bytes
+*/
+typedef struct {
+  void*  base;
+  size_t size;
+} shRegion;
+
+/**
+  @fn         shRegion* shCreate(char* name, size_t size)
+  @brief      Create a new shared memory region
+  @param      name  The region's POSIX shared memory object name (e.g.,
+                    `"/myRegion"`); or `NULL` for an anonymous region
+  @param      size  The region's size, in bytes
+  @return     Pointer to the mapped region; or `NULL` if the region
+              already exists, or in the event of an allocation failure
+
+  Create, size and map a named shared memory object and initialise it
+  as an empty region. Other processes can then map it with shOpen().
+
+  An anonymous region has no name, so cannot be opened by other
+  processes, but is inherited by any processes forked after it is
+  created.
+
+  @note       A named region persists until it is removed with
+              shUnlink(), even after every process has closed it
+*/
+extern shRegion* shCreate(char*, size_t);
+
+/**
+  @fn         shRegion* shOpen(char* name)
+  @brief      Map an existing shared memory region
+  @param      name  The region's name, as given to shCreate()
+  @return     Pointer to the mapped region; or `NULL` if there is no
+              such region, or in the event of an allocation failure
+*/
+extern shRegion* shOpen(char*);
+
+/**
+  @fn         void* shAlloc(shRegion* region, size_t size)
+  @brief      Allocate memory from a shared memory region
+  @param      region  The region
+  @param      size    Number of bytes to allocate
+  @return     Pointer to the allocated memory; or `NULL` if the region
+              is exhausted
+
+  Allocate from the free list of the appropriate size class, or else
+  from the region's unallocated tail. Size classes are powers of two,
+  so no more than half of each block is wasted.
+
+  @note       The memory is aligned to 16 bytes
+*/
+extern void* shAlloc(shRegion*, size_t);
+
+/**
+  @fn         void shFree(shRegion* region, void* address)
+  @brief      Return memory to a shared memory region
+  @param      region   The region
+  @param      address  Pointer to the memory, as returned by shAlloc();
+                       or `NULL`
+
+  @note       Freed memory is kept for reuse by allocations of the same
+              size class; it is never returned to the tail
+*/
+extern void shFree(shRegion*, void*);
+
+/**
+  @fn         void* shGet(shPointer* pointer)
+  @brief      Resolve a self-relative pointer
+  @param      pointer  The self-relative pointer
+  @return     The address of its target; or `NULL`
+*/
+extern void* shGet(shPointer*);
+
+/**
+  @fn         void shSet(shPointer* pointer, void* address)
+  @brief      Assign a self-relative pointer
+  @param      pointer  The self-relative pointer
+  @param      address  The address of its target; or `NULL`
+
+  @note       Both the pointer and its target should lie within the same
+              region, or the pointer will not resolve correctly in other
+              processes
+*/
+extern void shSet(shPointer*, void*);
+
+/**
+  @fn         void* shRoot(shRegion* region)
+  @brief      Get the root of a shared memory region
+  @param      region  The region
+  @return     The address of the region's root structure; or `NULL` if
+              it has not been set
+
+  The root is the one well known location in a region, from which other
+  processes can find the structures built within it.
+*/
+extern void* shRoot(shRegion*);
+
+/**
+  @fn         void shSetRoot(shRegion* region, void* address)
+  @brief      Set the root of a shared memory region
+  @param      region   The region
+  @param      address  The address of the region's root structure; or
+                       `NULL`
+*/
+extern void shSetRoot(shRegion*, void*);
+
+/**
+  @fn         void shClose(shRegion* region)
+  @brief      Unmap a shared memory region from this process
+  @param      region  The region
+
+  @note       The region itself, and everything allocated within it, is
+              unaffected
+*/
+extern void shClose(shRegion*);
+
+/**
+  @fn         int shUnlink(char* name)
+  @brief      Remove a named shared memory region
+  @param      name  The region's name
+  @return     Zero on success; non-zero if there is no such region
+
+  Remove the region's name, so that it can no longer be opened. Its
+  memory is released once every process has closed it.
+*/
+extern int shUnlink(char*);
+
+#endif
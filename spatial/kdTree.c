@@ -0,0 +1,792 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "kdTree.h"
+#include "../indexed/typedArray.h"
+#include "../parallel/threadPool.h"
+
+#define kdDefaultBucket 16
+#define kdNone          ((size_t)-1)
+
+/* Smallest node to split across the workers, and its pivot sample */
+#define kdParallel      (1 << 16)
+#define kdSamples       31
+
+typedef struct {
+  kdTree* tree;
+  double* points;   /* The original points, by index */
+  size_t* order;    /* Point indices, being partitioned */
+  size_t  depth;
+
+  /* Splitting a single node across the workers */
+  tpPool* pool;
+  size_t  lo, hi;   /* Range being scanned or partitioned */
+  size_t  axis;
+  double  pivot;
+  double* least;    /* Spread seen by each worker */
+  double* most;
+  size_t  blocks;
+  size_t* at;       /* Each block's less, equal and greater positions */
+  size_t* scratch;  /* Partitioned order */
+} building;
+
+/* Per-query working memory */
+typedef struct {
+  kdTree* tree;
+  double* query;
+  double* distance;  /* One leaf's squared distances */
+  size_t  k;
+  size_t  length;    /* k-NN: max-heap of the nearest so far */
+  double* heapDistance;
+  size_t* heapId;
+  double  radius;    /* Radius, and its square */
+  double  limit;
+  double* lower;     /* Box */
+  double* upper;
+  tyArray* found;
+  int     failed;
+} query;
+
+/* First position of a leaf's points */
+static size_t start(kdTree* tree, size_t leaf) {
+  return (size_t)(((unsigned __int128)leaf * tree->points) / tree->leaves);
+}
+
+static double coordinateOf(building* build, size_t position, size_t axis) {
+  return build->points[build->order[position] * build->tree->dimension + axis];
+}
+
+/* Partition order[lo, hi) about its nth element on the given axis */
+static void quickselect(building* build, size_t lo, size_t hi, size_t nth, size_t axis) {
+  size_t* order = build->order;
+
+  while (hi - lo > 1) {
+    size_t mid = lo + (hi - lo) / 2, less = lo, more = hi, i = lo, swap;
+    double a = coordinateOf(build, lo, axis),
+           b = coordinateOf(build, mid, axis),
+           c = coordinateOf(build, hi - 1, axis),
+           pivot = a < b ? (b < c ? b : (a < c ? c : a)) : (a < c ? a : (b < c ? c : b));
+
+    /* Three way partition about the median of three */
+    while (i < more) {
+      double x = coordinateOf(build, i, axis);
+
+      if (x < pivot) {
+        swap = order[i]; order[i++] = order[less]; order[less++] = swap;
+      } else if (x > pivot) {
+        swap = order[i]; order[i] = order[--more]; order[more] = swap;
+      } else {
+        i++;
+      }
+    }
+
+    if (nth < less) {
+      hi = less;
+    } else if (nth >= more) {
+      lo = more;
+    } else {
+      return;
+    }
+  }
+}
+
+/* Widen each worker's spread by a range of points */
+static void spreadRange(size_t from, size_t to, size_t worker, void* context) {
+  building* build     = (building*)context;
+  size_t    dimension = build->tree->dimension, d;
+  double*   least     = build->least + worker * dimension;
+  double*   most      = build->most + worker * dimension;
+
+  for (from += build->lo, to += build->lo; from < to; from++) {
+    for (d = 0; d < dimension; d++) {
+      double x = coordinateOf(build, from, d);
+
+      if (x < least[d]) { least[d] = x; }
+      if (x > most[d])  { most[d] = x; }
+    }
+  }
+}
+
+/* The axis on which order[lo, hi) is most spread */
+static size_t widestAxis(building* build, size_t lo, size_t hi, int parallel) {
+  size_t dimension = build->tree->dimension, workers = tpWorkers(build->pool);
+  size_t axis = 0, d, p, w;
+  double widest = -1;
+
+  if (parallel) {
+    for (p = 0; p < workers * dimension; p++) {
+      build->least[p] = INFINITY;
+      build->most[p]  = -INFINITY;
+    }
+
+    build->lo = lo;
+    tpFor(build->pool, hi - lo, 4096, &spreadRange, build);
+
+    /* Combine the workers' spreads */
+    for (w = 1; w < workers; w++) {
+      for (d = 0; d < dimension; d++) {
+        if (build->least[w * dimension + d] < build->least[d]) { build->least[d] = build->least[w * dimension + d]; }
+        if (build->most[w * dimension + d] > build->most[d])   { build->most[d] = build->most[w * dimension + d]; }
+      }
+    }
+
+    for (d = 0; d < dimension; d++) {
+      if (build->most[d] - build->least[d] > widest) {
+        widest = build->most[d] - build->least[d];
+        axis   = d;
+      }
+    }
+
+    return axis;
+  }
+
+  for (d = 0; d < dimension && lo < hi; d++) {
+    double least = coordinateOf(build, lo, d), most = least;
+
+    for (p = lo + 1; p < hi; p++) {
+      double x = coordinateOf(build, p, d);
+
+      if (x < least) { least = x; }
+      if (x > most)  { most = x; }
+    }
+
+    if (most - least > widest) {
+      widest = most - least;
+      axis   = d;
+    }
+  }
+
+  return axis;
+}
+
+/* Median of evenly spaced samples of order[lo, hi) on the given axis */
+static double samplePivot(building* build, size_t lo, size_t hi, size_t axis) {
+  double sample[kdSamples];
+  size_t i, j;
+
+  for (i = 0; i < kdSamples; i++) {
+    double x = coordinateOf(build, lo + (size_t)(((unsigned __int128)(hi - lo) * (2 * i + 1)) / (2 * kdSamples)), axis);
+
+    for (j = i; j && sample[j - 1] > x; j--) {
+      sample[j] = sample[j - 1];
+    }
+    sample[j] = x;
+  }
+
+  return sample[kdSamples / 2];
+}
+
+static size_t blockStart(building* build, size_t block) {
+  return build->lo + (size_t)(((unsigned __int128)(build->hi - build->lo) * block) / build->blocks);
+}
+
+/* Count each block's points below, at and above the pivot */
+static void countBlock(size_t from, size_t to, size_t worker, void* context) {
+  building* build = (building*)context;
+
+  for (; from < to; from++) {
+    size_t* at = build->at + 3 * from;
+    size_t  p, end = blockStart(build, from + 1);
+
+    at[0] = at[1] = at[2] = 0;
+
+    for (p = blockStart(build, from); p < end; p++) {
+      double x = coordinateOf(build, p, build->axis);
+      ++at[x < build->pivot ? 0 : x > build->pivot ? 2 : 1];
+    }
+  }
+}
+
+/* Move each block's points to their positions in the partition */
+static void scatterBlock(size_t from, size_t to, size_t worker, void* context) {
+  building* build = (building*)context;
+
+  for (; from < to; from++) {
+    size_t* at = build->at + 3 * from;
+    size_t  p, end = blockStart(build, from + 1);
+
+    for (p = blockStart(build, from); p < end; p++) {
+      double x = coordinateOf(build, p, build->axis);
+      build->scratch[at[x < build->pivot ? 0 : x > build->pivot ? 2 : 1]++] = build->order[p];
+    }
+  }
+}
+
+static void gatherBlock(size_t from, size_t to, size_t worker, void* context) {
+  building* build = (building*)context;
+  size_t    lo    = blockStart(build, from);
+
+  memcpy(build->order + lo, build->scratch + lo, sizeof(size_t) * (blockStart(build, to) - lo));
+}
+
+/* Partition order[lo, hi) about its nth element, across the workers */
+static void parallelSelect(building* build, size_t lo, size_t hi, size_t nth, size_t axis) {
+  size_t less, more, at, b, k;
+
+  build->axis = axis;
+
+  while (hi - lo > kdParallel) {
+    build->lo    = lo;
+    build->hi    = hi;
+    build->pivot = samplePivot(build, lo, hi, axis);
+
+    tpFor(build->pool, build->blocks, 1, &countBlock, build);
+
+    /* All the less, then all the equal, then all the greater */
+    for (at = lo, k = 0; k < 3; k++) {
+      for (b = 0; b < build->blocks; b++) {
+        size_t count = build->at[3 * b + k];
+
+        build->at[3 * b + k] = at;
+        at += count;
+      }
+    }
+
+    less = build->at[1];
+    more = build->at[2];
+
+    tpFor(build->pool, build->blocks, 1, &scatterBlock, build);
+    tpFor(build->pool, build->blocks, 1, &gatherBlock, build);
+
+    if (nth < less) {
+      hi = less;
+    } else if (nth >= more) {
+      lo = more;
+    } else {
+      return;
+    }
+  }
+
+  quickselect(build, lo, hi, nth, axis);
+}
+
+/* Split one node on the axis of greatest spread, about its median */
+static void splitNode(building* build, size_t index, int parallel) {
+  kdTree* tree = build->tree;
+  size_t  span = tree->leaves >> build->depth;
+  size_t  node = ((size_t)1 << build->depth) - 1 + index;
+  size_t  lo   = start(tree, index * span);
+  size_t  hi   = start(tree, (index + 1) * span);
+  size_t  mid  = start(tree, index * span + span / 2);
+  size_t  axis;
+
+  parallel = parallel && hi - lo > kdParallel;
+  axis     = widestAxis(build, lo, hi, parallel);
+
+  tree->axis[node] = axis;
+
+  if (mid < hi) {
+    if (parallel) {
+      parallelSelect(build, lo, hi, mid, axis);
+    } else {
+      quickselect(build, lo, hi, mid, axis);
+    }
+
+    tree->split[node] = coordinateOf(build, mid, axis);
+  } else {
+    /* An empty right side is never entered from the left */
+    tree->split[node] = lo < hi ? coordinateOf(build, hi - 1, axis) : 0;
+  }
+}
+
+/* Split every node of one level */
+static void splitLevel(size_t from, size_t to, size_t worker, void* context) {
+  for (; from < to; from++) {
+    splitNode((building*)context, from, 0);
+  }
+}
+
+/* Lay each leaf's points out axis by axis */
+static void fillLeaves(size_t from, size_t to, size_t worker, void* context) {
+  building* build = (building*)context;
+  kdTree*   tree  = build->tree;
+  size_t    d, p;
+
+  for (; from < to; from++) {
+    size_t  lo    = start(tree, from);
+    size_t  m     = start(tree, from + 1) - lo;
+    double* block = tree->coordinate + lo * tree->dimension;
+
+    for (p = 0; p < m; p++) {
+      tree->id[lo + p] = build->order[lo + p];
+
+      for (d = 0; d < tree->dimension; d++) {
+        block[d * m + p] = coordinateOf(build, lo + p, d);
+      }
+    }
+  }
+}
+
+kdTree* kdBuild(tyArray* points, size_t bucket, tpPool* pool) {
+  kdTree*  newTree = malloc(sizeof(kdTree));
+  building build;
+  size_t   n = points->length, p, i, buckets;
+  size_t   workers = tpWorkers(pool);
+
+  if (!newTree) { return NULL; }
+
+  if (!bucket) { bucket = kdDefaultBucket; }
+
+  newTree->points    = n;
+  newTree->dimension = points->width / sizeof(double);
+  newTree->leaves    = 1;
+
+  buckets = (n + bucket - 1) / bucket;
+  while (newTree->leaves < buckets) {
+    newTree->leaves *= 2;
+  }
+  newTree->bucket = (n + newTree->leaves - 1) / newTree->leaves;
+
+  newTree->axis       = malloc(sizeof(size_t) * newTree->leaves);
+  newTree->split      = malloc(sizeof(double) * newTree->leaves);
+  newTree->coordinate = malloc(sizeof(double) * (n && newTree->dimension ? n * newTree->dimension : 1));
+  newTree->id         = malloc(sizeof(size_t) * (n ? n : 1));
+  build.order         = malloc(sizeof(size_t) * (n ? n : 1));
+
+  build.pool    = NULL;
+  build.least   = NULL;
+  build.most    = NULL;
+  build.at      = NULL;
+  build.scratch = NULL;
+
+  /* Space to split the top levels' nodes across the workers */
+  if (workers > 1 && n > kdParallel) {
+    build.pool    = pool;
+    build.blocks  = 4 * workers;
+    build.least   = malloc(sizeof(double) * workers * (newTree->dimension ? newTree->dimension : 1));
+    build.most    = malloc(sizeof(double) * workers * (newTree->dimension ? newTree->dimension : 1));
+    build.at      = malloc(sizeof(size_t) * 3 * build.blocks);
+    build.scratch = malloc(sizeof(size_t) * n);
+  }
+
+  if (!newTree->axis || !newTree->split || !newTree->coordinate || !newTree->id || !build.order
+   || (build.pool && (!build.least || !build.most || !build.at || !build.scratch))) {
+    /* Memory allocation failure :P */
+    free(build.order);
+    free(build.least);
+    free(build.most);
+    free(build.at);
+    free(build.scratch);
+    kdNuke(newTree);
+    return NULL;
+  }
+
+  build.tree   = newTree;
+  build.points = (double*)points->buffer;
+
+  for (p = 0; p < n; p++) {
+    build.order[p] = p;
+  }
+
+  for (build.depth = 0; ((size_t)1 << build.depth) < newTree->leaves; build.depth++) {
+    if (build.pool && ((size_t)1 << build.depth) < workers) {
+      /* Too few nodes to go round, so split each across the workers */
+      for (i = 0; i < ((size_t)1 << build.depth); i++) {
+        splitNode(&build, i, 1);
+      }
+    } else {
+      tpFor(pool, (size_t)1 << build.depth, 1, &splitLevel, &build);
+    }
+  }
+
+  tpFor(pool, newTree->leaves, 64, &fillLeaves, &build);
+
+  free(build.order);
+  free(build.least);
+  free(build.most);
+  free(build.at);
+  free(build.scratch);
+  return newTree;
+}
+
+/* Squared distances from the query to every point of a leaf */
+static size_t measure(query* q, size_t leaf) {
+  kdTree* tree  = q->tree;
+  size_t  lo    = start(tree, leaf);
+  size_t  m     = start(tree, leaf + 1) - lo;
+  double* block = tree->coordinate + lo * tree->dimension;
+  double* distance = q->distance;
+  size_t  d, p;
+
+  for (p = 0; p < m; p++) {
+    distance[p] = 0;
+  }
+
+  for (d = 0; d < tree->dimension; d++) {
+    double  x      = q->query[d];
+    double* column = block + d * m;
+
+    for (p = 0; p < m; p++) {
+      double delta = column[p] - x;
+      distance[p] += delta * delta;
+    }
+  }
+
+  return m;
+}
+
+/* Put a point at the root of the max-heap and sift it down */
+static void sink(query* q, double distance, size_t id) {
+  size_t at, child;
+
+  for (at = 0; (child = 2 * at + 1) < q->length; at = child) {
+    if (child + 1 < q->length && q->heapDistance[child + 1] > q->heapDistance[child]) { ++child; }
+    if (q->heapDistance[child] <= distance) { break; }
+
+    q->heapDistance[at] = q->heapDistance[child];
+    q->heapId[at]       = q->heapId[child];
+  }
+
+  q->heapDistance[at] = distance;
+  q->heapId[at]       = id;
+}
+
+/* Offer a point to the bounded max-heap */
+static void offer(query* q, double distance, size_t id) {
+  size_t at;
+
+  if (q->length < q->k) {
+    for (at = q->length++; at && q->heapDistance[(at - 1) / 2] < distance; at = (at - 1) / 2) {
+      q->heapDistance[at] = q->heapDistance[(at - 1) / 2];
+      q->heapId[at]       = q->heapId[(at - 1) / 2];
+    }
+
+    q->heapDistance[at] = distance;
+    q->heapId[at]       = id;
+  } else if (distance < q->heapDistance[0]) {
+    /* Replace the farthest */
+    sink(q, distance, id);
+  }
+}
+
+static void nearest(query* q, size_t node, size_t first, size_t span) {
+  kdTree* tree = q->tree;
+  double  delta;
+  size_t  near, p, m;
+
+  if (span == 1) {
+    size_t lo = start(tree, first);
+
+    for (m = measure(q, first), p = 0; p < m; p++) {
+      offer(q, q->distance[p], tree->id[lo + p]);
+    }
+    return;
+  }
+
+  delta = q->query[tree->axis[node]] - tree->split[node];
+  near  = delta < 0 ? 0 : 1;
+
+  nearest(q, 2 * node + 1 + near, first + near * span / 2, span / 2);
+
+  if (q->length < q->k || delta * delta < q->heapDistance[0]) {
+    nearest(q, 2 * node + 2 - near, first + (1 - near) * span / 2, span / 2);
+  }
+}
+
+static void queryNuke(query* q) {
+  free(q->distance);
+  free(q->heapDistance);
+  free(q->heapId);
+}
+
+static int queryCreate(kdTree* tree, query* q, size_t k) {
+  memset(q, 0, sizeof(query));
+
+  q->tree         = tree;
+  q->k            = k;
+  q->distance     = malloc(sizeof(double) * (tree->bucket ? tree->bucket : 1));
+  q->heapDistance = malloc(sizeof(double) * (k ? k : 1));
+  q->heapId       = malloc(sizeof(size_t) * (k ? k : 1));
+
+  if (!q->distance || !q->heapDistance || !q->heapId) {
+    /* Memory allocation failure :P */
+    queryNuke(q);
+    return 1;
+  }
+
+  return 0;
+}
+
+/* k-NN into the given outputs, nearest first */
+static size_t searchNearest(query* q, double* point, size_t* ids, double* distances) {
+  size_t found, i;
+
+  q->query  = point;
+  q->length = 0;
+
+  for (i = 0; i < q->k; i++) {
+    ids[i] = kdNone;
+  }
+
+  if (!q->k || !q->tree->points) { return 0; }
+
+  nearest(q, 0, 0, q->tree->leaves);
+
+  /* Unwind the heap from the farthest */
+  for (found = q->length, i = found; i; i--) {
+    ids[i - 1] = q->heapId[0];
+    if (distances) {
+      distances[i - 1] = sqrt(q->heapDistance[0]);
+    }
+
+    --q->length;
+    sink(q, q->heapDistance[q->length], q->heapId[q->length]);
+  }
+
+  return found;
+}
+
+size_t kdNearest(kdTree* tree, double* point, size_t k, size_t* ids, double* distances) {
+  query  q;
+  size_t found;
+
+  if (queryCreate(tree, &q, k)) { return kdNone; }
+
+  found = searchNearest(&q, point, ids, distances);
+  queryNuke(&q);
+
+  return found;
+}
+
+typedef struct {
+  kdTree* tree;
+  double* queries;
+  size_t  k;
+  size_t* ids;
+  double* distances;
+  double  radius;
+  query*  work;
+  tyArray** found;
+} batch;
+
+static void nearestChunk(size_t from, size_t to, size_t worker, void* context) {
+  batch* b = (batch*)context;
+
+  for (; from < to; from++) {
+    searchNearest(b->work + worker, b->queries + from * b->tree->dimension, b->ids + from * b->k,
+                  b->distances ? b->distances + from * b->k : NULL);
+  }
+}
+
+void kdNearestBatch(kdTree* tree, double* queries, size_t count, size_t k, size_t* ids, double* distances, tpPool* pool) {
+  size_t workers = tpWorkers(pool);
+  size_t ready, i;
+  batch  b;
+
+  b.tree      = tree;
+  b.queries   = queries;
+  b.k         = k;
+  b.ids       = ids;
+  b.distances = distances;
+  b.work      = malloc(sizeof(query) * workers);
+
+  for (ready = 0; b.work && ready < workers; ready++) {
+    if (queryCreate(tree, b.work + ready, k)) { break; }
+  }
+
+  if (b.work && ready == workers) {
+    tpFor(pool, count, 16, &nearestChunk, &b);
+  } else {
+    /* Memory allocation failure :P */
+    for (i = 0; i < count * k; i++) {
+      ids[i] = kdNone;
+    }
+  }
+
+  for (i = 0; b.work && i < ready; i++) {
+    queryNuke(b.work + i);
+  }
+  free(b.work);
+}
+
+/* Append a point's index, noting any failure */
+static void collect(query* q, size_t id) {
+  size_t length = q->found->length;
+
+  tyAppend(q->found, &id);
+  if (q->found->length != length + 1) { q->failed = 1; }
+}
+
+static void within(query* q, size_t node, size_t first, size_t span) {
+  kdTree* tree = q->tree;
+  double  x, split;
+  size_t  p, m;
+
+  if (q->failed) { return; }
+
+  if (span == 1) {
+    size_t lo = start(tree, first);
+
+    for (m = measure(q, first), p = 0; p < m; p++) {
+      if (q->distance[p] <= q->limit) {
+        collect(q, tree->id[lo + p]);
+      }
+    }
+    return;
+  }
+
+  x     = q->query[tree->axis[node]];
+  split = tree->split[node];
+
+  if (x - q->radius <= split) { within(q, 2 * node + 1, first, span / 2); }
+  if (x + q->radius >= split) { within(q, 2 * node + 2, first + span / 2, span / 2); }
+}
+
+static tyArray* searchRadius(query* q, double* point, double radius) {
+  q->query  = point;
+  q->radius = radius;
+  q->limit  = radius * radius;
+  q->failed = 0;
+  q->found  = tyCreate(0, sizeof(size_t));
+
+  if (!q->found) { return NULL; }
+
+  if (q->tree->points) {
+    within(q, 0, 0, q->tree->leaves);
+  }
+
+  if (q->failed) {
+    tyNuke(q->found);
+    return NULL;
+  }
+
+  return q->found;
+}
+
+tyArray* kdRadius(kdTree* tree, double* point, double radius) {
+  query    q;
+  tyArray* found;
+
+  if (queryCreate(tree, &q, 0)) { return NULL; }
+
+  found = searchRadius(&q, point, radius);
+  queryNuke(&q);
+
+  return found;
+}
+
+static void radiusChunk(size_t from, size_t to, size_t worker, void* context) {
+  batch* b = (batch*)context;
+
+  for (; from < to; from++) {
+    b->found[from] = searchRadius(b->work + worker, b->queries + from * b->tree->dimension, b->radius);
+  }
+}
+
+tyArray** kdRadiusBatch(kdTree* tree, double* queries, size_t count, double radius, tpPool* pool) {
+  size_t workers = tpWorkers(pool);
+  size_t ready, i;
+  int    failed = 0;
+  batch  b;
+
+  b.tree    = tree;
+  b.queries = queries;
+  b.radius  = radius;
+  b.found   = malloc(sizeof(tyArray*) * (count ? count : 1));
+  b.work    = malloc(sizeof(query) * workers);
+
+  for (ready = 0; b.work && ready < workers; ready++) {
+    if (queryCreate(tree, b.work + ready, 0)) { break; }
+  }
+
+  if (b.found && b.work && ready == workers) {
+    tpFor(pool, count, 16, &radiusChunk, &b);
+
+    for (i = 0; i < count; i++) {
+      if (!b.found[i]) { failed = 1; }
+    }
+
+    if (failed) {
+      /* Memory allocation failure :P */
+      for (i = 0; i < count; i++) {
+        tyNuke(b.found[i]);
+      }
+      free(b.found);
+      b.found = NULL;
+    }
+  } else {
+    free(b.found);
+    b.found = NULL;
+  }
+
+  for (i = 0; b.work && i < ready; i++) {
+    queryNuke(b.work + i);
+  }
+  free(b.work);
+
+  return b.found;
+}
+
+static void inside(query* q, size_t node, size_t first, size_t span) {
+  kdTree* tree = q->tree;
+  size_t  axis, d, p;
+
+  if (q->failed) { return; }
+
+  if (span == 1) {
+    size_t  lo    = start(tree, first);
+    size_t  m     = start(tree, first + 1) - lo;
+    double* block = tree->coordinate + lo * tree->dimension;
+    double* in    = q->distance;
+
+    /* Count the axes each point is within, as a double to vectorise */
+    for (p = 0; p < m; p++) {
+      in[p] = 0;
+    }
+
+    for (d = 0; d < tree->dimension; d++) {
+      double  low = q->lower[d], high = q->upper[d];
+      double* column = block + d * m;
+
+      for (p = 0; p < m; p++) {
+        in[p] += (column[p] >= low) & (column[p] <= high);
+      }
+    }
+
+    for (p = 0; p < m; p++) {
+      if (in[p] == tree->dimension) {
+        collect(q, tree->id[lo + p]);
+      }
+    }
+    return;
+  }
+
+  axis = tree->axis[node];
+
+  if (q->lower[axis] <= tree->split[node]) { inside(q, 2 * node + 1, first, span / 2); }
+  if (q->upper[axis] >= tree->split[node]) { inside(q, 2 * node + 2, first + span / 2, span / 2); }
+}
+
+tyArray* kdBox(kdTree* tree, double* lower, double* upper) {
+  query    q;
+  tyArray* found;
+
+  if (queryCreate(tree, &q, 0)) { return NULL; }
+
+  q.lower = lower;
+  q.upper = upper;
+  found   = q.found = tyCreate(0, sizeof(size_t));
+
+  if (found && tree->points) {
+    inside(&q, 0, 0, tree->leaves);
+
+    if (q.failed) {
+      tyNuke(found);
+      found = NULL;
+    }
+  }
+
+  queryNuke(&q);
+  return found;
+}
+
+void kdNuke(kdTree* tree) {
+  if (tree) {
+    free(tree->axis);
+    free(tree->split);
+    free(tree->coordinate);
+    free(tree->id);
+    free(tree);
+  }
+}
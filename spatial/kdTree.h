@@ -0,0 +1,179 @@
+/**
+  @file       kdTree.h
+  @brief      k-d tree header file
+  @author     Christopher Harrison (Xophmeister)
+  @copyright  @ref license
+
+  Implements a static k-d tree over low dimensional points, for nearest
+  neighbour, radius and box queries.
+
+  The tree has an implicit layout, without any pointers: it is complete,
+  with a power of two number of leaves, so the children of node `i` are
+  at `2i + 1` and `2i + 2` and only each internal node's splitting axis
+  and value need be stored. Each leaf is a contiguous bucket of points,
+  whose range is implied by its position, with their coordinates stored
+  axis by axis (i.e., structure of arrays) so that the distances to all
+  of a bucket's points are computed with vectorised loops.
+
+  The tree is bulk built by recursive median splits along each range's
+  widest axis, which balances it perfectly.
+*/
+
+#ifndef KDTREE_H
+#define KDTREE_H
+
+#include <stdlib.h>
+#include "../indexed/typedArray.h"
+#include "../parallel/threadPool.h"
+
+/**
+  @struct     kdTree
+  @brief      k-d tree
+  @var        kdTree::points
+              Number of points
+  @var        kdTree::dimension
+              Number of coordinates of each point
+  @var        kdTree::leaves
+              Number of leaves, which is a power of two
+  @var        kdTree::bucket
+              Largest number of points in a leaf
+  @var        kdTree::axis
+              Array of `leaves - 1` splitting axes, by internal node
+  @var        kdTree::split
+              Array of `leaves - 1` splitting values, by internal node;
+              points on the left are no greater and on the right no
+              less
+  @var        kdTree::coordinate
+              Array of the points' coordinates, by leaf; the `m` points
+              of a leaf starting at position `s` have their coordinates
+              on axis `c` at `coordinate[s * dimension + c * m]`, onwards
+  @var        kdTree::id
+              Array of the points' original indices, by position
+*/
+typedef struct {
+  size_t  points;
+  size_t  dimension;
+  size_t  leaves;
+  size_t  bucket;
+  size_t* axis;
+  double* split;
+  double* coordinate;
+  size_t* id;
+} kdTree;
+
+/**
+  @fn         kdTree* kdBuild(tyArray* points, size_t bucket, tpPool* pool)
+  @brief      Build a k-d tree from an array of points
+  @param      points  Typed array of points, each of which is an array of
+                      `double` coordinates (so the array's width sets
+                      the dimension)
+  @param      bucket  Largest number of points to hold in a leaf; or zero
+                      for the default (16)
+  @param      pool    Thread pool to run on; or `NULL` to run serially
+  @return     Pointer to the tree; or `NULL` in the event of an
+              allocation failure
+
+  Split the points level by level, choosing for every node the axis on
+  which its points are most spread and partitioning them about their
+  median with quickselect; all the nodes of a level are split in
+  parallel. The top levels have fewer nodes than workers, so each of
+  their nodes is instead split across the workers: its spread is
+  reduced from a scan per worker and it is partitioned, block by block,
+  about a sampled pivot. Expected `O(n log n)` time.
+
+  @note       The points are copied, so the array may be freed
+*/
+extern kdTree* kdBuild(tyArray*, size_t, tpPool*);
+
+/**
+  @fn         size_t kdNearest(kdTree* tree, double* query, size_t k, size_t* ids, double* distances)
+  @brief      Find the nearest neighbours of a query point
+  @param      tree       The k-d tree
+  @param      query      The query point
+  @param      k          Number of neighbours to find
+  @param      ids        Array of `k` elements that will receive the
+                         neighbours' indices, nearest first
+  @param      distances  Array of `k` elements that will receive the
+                         neighbours' Euclidean distances; or `NULL`
+  @return     Number of neighbours found, which is less than `k` only if
+              the tree has fewer points; or `(size_t)-1` in the event of
+              an allocation failure
+
+  Descend to the query's leaf, keeping the `k` nearest points seen in a
+  bounded max-heap, and only visit the far side of a split if it is
+  nearer than the farthest of them.
+
+  @note       Unfound neighbours' indices are set to `(size_t)-1`
+*/
+extern size_t kdNearest(kdTree*, double*, size_t, size_t*, double*);
+
+/**
+  @fn         void kdNearestBatch(kdTree* tree, double* queries, size_t count, size_t k, size_t* ids, double* distances, tpPool* pool)
+  @brief      Find the nearest neighbours of many query points in parallel
+  @param      tree       The k-d tree
+  @param      queries    Array of `count` query points, contiguously
+  @param      count      Number of queries
+  @param      k          Number of neighbours to find for each query
+  @param      ids        Array of `count * k` elements that will receive
+                         each query's neighbours' indices
+  @param      distances  Array of `count * k` elements that will receive
+                         each query's neighbours' distances; or `NULL`
+  @param      pool       Thread pool to run on; or `NULL` to run serially
+
+  As kdNearest(), for each query in turn.
+*/
+extern void kdNearestBatch(kdTree*, double*, size_t, size_t, size_t*, double*, tpPool*);
+
+/**
+  @fn         tyArray* kdRadius(kdTree* tree, double* query, double radius)
+  @brief      Find every point within a given distance of a query point
+  @param      tree    The k-d tree
+  @param      query   The query point
+  @param      radius  The Euclidean distance
+  @return     Typed array of the indices (`size_t`) of the points, in no
+              particular order; or `NULL` in the event of an allocation
+              failure
+
+  @note       The returned array must be freed with tyNuke()
+*/
+extern tyArray* kdRadius(kdTree*, double*, double);
+
+/**
+  @fn         tyArray** kdRadiusBatch(kdTree* tree, double* queries, size_t count, double radius, tpPool* pool)
+  @brief      Find every point within a given distance of many query points in parallel
+  @param      tree     The k-d tree
+  @param      queries  Array of `count` query points, contiguously
+  @param      count    Number of queries
+  @param      radius   The Euclidean distance
+  @param      pool     Thread pool to run on; or `NULL` to run serially
+  @return     Array of `count` typed arrays, as returned by kdRadius();
+              or `NULL` in the event of an allocation failure
+
+  @note       The returned array, and each of its typed arrays, must be
+              freed by the caller
+*/
+extern tyArray** kdRadiusBatch(kdTree*, double*, size_t, double, tpPool*);
+
+/**
+  @fn         tyArray* kdBox(kdTree* tree, double* lower, double* upper)
+  @brief      Find every point within an axis aligned box
+  @param      tree   The k-d tree
+  @param      lower  The box's lowest corner
+  @param      upper  The box's highest corner
+  @return     Typed array of the indices (`size_t`) of the points, in no
+              particular order; or `NULL` in the event of an allocation
+              failure
+
+  @note       The box is closed, so includes points on its boundary
+  @note       The returned array must be freed with tyNuke()
+*/
+extern tyArray* kdBox(kdTree*, double*, double*);
+
+/**
+  @fn         void kdNuke(kdTree* tree)
+  @brief      Free the memory allocated for the k-d tree
+  @param      tree  The k-d tree to free
+*/
+extern void kdNuke(kdTree*);
+
+#endif